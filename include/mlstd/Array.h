@@ -17,7 +17,7 @@ namespace mlstd {
 	 */
 	template <class T, size_t N>
 	struct Array {
-		constexpr size_t Size() {
+		constexpr size_t Size() const {
 			return N;
 		}
 
@@ -29,6 +29,14 @@ namespace mlstd {
 			return &_arr_notouchy[0];
 		}
 
+		constexpr T& operator[](size_t index) {
+			return _arr_notouchy[index];
+		}
+
+		constexpr const T& operator[](size_t index) const {
+			return _arr_notouchy[index];
+		}
+
 		// only public to keep POD contract true
 		T _arr_notouchy[N];
 	};
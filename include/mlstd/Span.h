@@ -0,0 +1,99 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef MLSTD_SPAN_H
+#define MLSTD_SPAN_H
+
+#include <mlstd/Assert.h>
+#include <stddef.h>
+
+namespace mlstd {
+
+	/**
+	 * A view of a contiguous run of objects. Does not own the memory,
+	 * and when copied, simply copies its pointer/size.
+	 */
+	template <class T>
+	struct Span {
+		using ValueType = T;
+		using SizeType = size_t;
+
+		constexpr Span() = default;
+
+		constexpr Span(T* ptr, SizeType size) noexcept
+			: data_ptr(ptr),
+			  size(size) {
+		}
+
+		template <SizeType N>
+		constexpr Span(T (&array)[N]) noexcept
+			: data_ptr(&array[0]),
+			  size(N) {
+		}
+
+		/**
+		 * Allow Span<T> to convert to Span<const T>.
+		 */
+		template <class U>
+		constexpr Span(const Span<U>& other) noexcept
+			requires(!__is_same(T, U))
+			: data_ptr(other.Data()),
+			  size(other.Size()) {
+		}
+
+		[[nodiscard]] constexpr SizeType Size() const noexcept {
+			return size;
+		}
+
+		[[nodiscard]] constexpr SizeType SizeBytes() const noexcept {
+			return size * sizeof(T);
+		}
+
+		[[nodiscard]] constexpr bool Empty() const noexcept {
+			return size == 0;
+		}
+
+		constexpr T* Data() const noexcept {
+			return data_ptr;
+		}
+
+		constexpr T& operator[](SizeType index) const noexcept {
+			MLSTD_ASSERT(index < size);
+			return data_ptr[index];
+		}
+
+		constexpr T* begin() const noexcept {
+			return data_ptr;
+		}
+
+		constexpr T* end() const noexcept {
+			return data_ptr + size;
+		}
+
+		/**
+		 * Get a view of part of this span.
+		 * Out of range parts are clamped to the end of the span.
+		 *
+		 * \param[in] offset Index to start at
+		 * \param[in] count Amount of objects. Defaults to the rest of the span.
+		 */
+		constexpr Span Subspan(SizeType offset, SizeType count = static_cast<SizeType>(-1)) const noexcept {
+			if(offset > size)
+				offset = size;
+			if(count > size - offset)
+				count = size - offset;
+			return { data_ptr + offset, count };
+		}
+
+	   private:
+		T* data_ptr { nullptr };
+		SizeType size { 0 };
+	};
+
+} // namespace mlstd
+
+#endif // MLSTD_SPAN_H
@@ -0,0 +1,150 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef ELFLDR_BUFFEREDFIOREADER_H
+#define ELFLDR_BUFFEREDFIOREADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/FioFile.h>
+
+namespace elfldr::util {
+
+	/**
+	 * A read-ahead buffered reader on top of a FioFile.
+	 *
+	 * Every fio call is a SIF RPC to the IOP (and for host:, on to the host),
+	 * so many small reads are far more expensive than one big one.
+	 * This reads a block at a time, and serves small reads out of it.
+	 * Seeking inside the current block doesn't touch the file at all.
+	 *
+	 * Reads at least as large as a block skip the buffer.
+	 */
+	struct BufferedFioReader {
+		constexpr static uint32_t DefaultBlockSize = 32 * 1024;
+
+		/**
+		 * Statistics, for measuring how many RPCs were saved.
+		 */
+		struct Stats {
+			/**
+			 * fio read and seek calls made.
+			 */
+			uint32_t rpcCalls;
+
+			/**
+			 * Reads served entirely from the buffer.
+			 */
+			uint32_t bufferHits;
+
+			/**
+			 * Bytes read from the file.
+			 */
+			uint32_t bytesRead;
+		};
+
+		/**
+		 * Constructor.
+		 *
+		 * \param[in] file The file to read. Must outlive the reader.
+		 * 					Its position is assumed to be 0.
+		 * \param[in] blockSize Read-ahead block size.
+		 */
+		explicit BufferedFioReader(FioFile& file, uint32_t blockSize = DefaultBlockSize);
+		~BufferedFioReader();
+
+		BufferedFioReader(const BufferedFioReader&) = delete;
+		BufferedFioReader& operator=(const BufferedFioReader&) = delete;
+
+		/**
+		 * Get if the reader (and its file) is usable.
+		 */
+		bool Good() const;
+
+		/**
+		 * Read up to length bytes.
+		 *
+		 * \return Amount of bytes read (less than length at the end of the file),
+		 * 			or -1 on error.
+		 */
+		int Read(void* buffer, size_t length);
+
+		/**
+		 * Read exactly length bytes.
+		 *
+		 * \return True if all of the bytes were read.
+		 */
+		bool ReadExact(void* buffer, size_t length);
+
+		/**
+		 * Look at the next length bytes without consuming them.
+		 *
+		 * \return A pointer to the bytes, valid until the next call on the reader,
+		 * 			or nullptr if they couldn't be read (or length is larger than the block size).
+		 */
+		const uint8_t* Peek(size_t length);
+
+		/**
+		 * Seek to an absolute position.
+		 */
+		void Seek(uint32_t position);
+
+		/**
+		 * Skip bytes.
+		 */
+		void Skip(uint32_t length);
+
+		uint32_t Tell() const;
+
+		/**
+		 * Get the size of the file. This asks the file every time, but it
+		 * doesn't move the file back; the next read that needs it does that.
+		 *
+		 * \return The size, or -1 on error.
+		 */
+		int Size();
+
+		const Stats& GetStats() const;
+
+	   private:
+		/**
+		 * Refill the block from the current position.
+		 *
+		 * \param[in] minimum How many bytes the block needs, unless the file ends first.
+		 * \return False on error.
+		 */
+		bool Fill(uint32_t minimum);
+
+		/**
+		 * Move the file position to the current position, if it isn't already there.
+		 */
+		bool SyncFilePosition();
+
+		FioFile& file;
+
+		void* rawBuffer { nullptr };
+		uint8_t* buffer { nullptr };
+		uint32_t blockSize;
+
+		/**
+		 * File offset of buffer[0], and how many bytes of the buffer are valid.
+		 */
+		uint32_t bufferStart {};
+		uint32_t bufferLength {};
+
+		/**
+		 * Logical position, and the position of the fd itself.
+		 */
+		uint32_t position {};
+		uint32_t filePosition {};
+
+		Stats stats {};
+	};
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_BUFFEREDFIOREADER_H
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <utils/PatchJournal.h>
 #include <utils/Utils.h>
 
 #pragma GCC diagnostic push
@@ -102,6 +103,7 @@ namespace elfldr::util {
 
 	/**
 	 * Fill an aligned section with MIPS nop (all zeros.)
+	 * The original instructions are saved in the patch journal.
 	 *
 	 * \tparam N Instruction count
 	 * \param[in] start Start address.
@@ -109,7 +111,7 @@ namespace elfldr::util {
 	template <size_t N>
 	constexpr void NopFill(void* start) {
 		MLSTD_ASSERT(IsInstructionAligned(start));
-		memset(start, 0x0, N * sizeof(uint32_t));
+		FillMemory(start, 0x0, N * sizeof(uint32_t));
 	}
 
 	/**
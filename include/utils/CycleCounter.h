@@ -0,0 +1,32 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef ELFLDR_CYCLECOUNTER_H
+#define ELFLDR_CYCLECOUNTER_H
+
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Read COP0 Count, which counts EE core cycles (EeClockHz),
+	 * and wraps around about every 14.5 seconds.
+	 */
+#ifdef _EE
+	inline uint32_t ReadCycleCounter() {
+		uint32_t count;
+		asm volatile("mfc0 %0, $9" : "=r"(count));
+		return count;
+	}
+#else
+	// Host builds (the tests) bring their own clock.
+	uint32_t ReadCycleCounter();
+#endif
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_CYCLECOUNTER_H
@@ -0,0 +1,186 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// An in-memory index of host directories.
+//
+// Every fio call is an RPC (and for host:, a trip to the host), so checking
+// for files one at a time gets slow. A directory tree is walked once instead,
+// and after that, existence and size checks are a hash lookup.
+//
+// AddRoot() walks directories through the fio backend (DirectoryIndexWalk.cpp),
+// so inside the game it needs UseGameFileIo() first. GetHostIndex() is ELF only.
+// The rest builds anywhere, the host tests included.
+
+#ifndef ELFLDR_DIRECTORYINDEX_H
+#define ELFLDR_DIRECTORYINDEX_H
+
+#include <mlstd/Span.h>
+#include <mlstd/String.h>
+#include <stdint.h>
+#include <utils/PathHash.h>
+
+namespace elfldr::util {
+
+	struct FioDirectory;
+
+	struct DirectoryIndex {
+		/**
+		 * A file or directory in the index.
+		 */
+		struct Entry {
+			constexpr static uint8_t DirectoryFlag = 1;
+
+			/**
+			 * Path, relative to the root, with '/' separators and as the host spelled it.
+			 * nullptr if this slot is empty.
+			 */
+			const char* path;
+
+			uint32_t hash;
+			uint32_t size;
+			uint16_t pathLength;
+			uint8_t root;
+			uint8_t flags;
+
+			bool Directory() const {
+				return flags & DirectoryFlag;
+			}
+
+			mlstd::StringView Path() const {
+				return { const_cast<char*>(path), pathLength };
+			}
+		};
+
+		constexpr static uint32_t MaxRoots = 8;
+		constexpr static uint32_t NoRoot = static_cast<uint32_t>(-1);
+
+		/**
+		 * How deep AddRoot() goes by default.
+		 */
+		constexpr static uint32_t DefaultMaxDepth = 8;
+
+		/**
+		 * Create an index in the given memory (which it doesn't own).
+		 *
+		 * \param[in] slots Hash table slots. The amount must be a power of 2;
+		 *					the index takes up to 3/4 of that many entries.
+		 * \param[in] strings Where paths are kept.
+		 */
+		DirectoryIndex(mlstd::Span<Entry> slots, mlstd::Span<char> strings);
+
+		/**
+		 * Walk a directory, and add everything in it.
+		 *
+		 * \param[in] path Directory to index, e.g. "host:" or "host:mods/foo".
+		 * \param[in] maxDepth How many levels of subdirectories to go into. 0 only indexes the directory itself.
+		 * \return The new root's number, or NoRoot if the directory couldn't be opened
+		 *		   (or there isn't room for it). If the index ran out of room partway
+		 *		   through, what fit is kept.
+		 */
+		uint32_t AddRoot(const char* path, uint32_t maxDepth = DefaultMaxDepth);
+
+		/**
+		 * Add a root without walking anything; fill it in with Insert().
+		 *
+		 * \param[in] path What the root is, e.g. "host:mods/foo".
+		 * \return The new root's number, or NoRoot if there isn't room for it.
+		 */
+		uint32_t AddEmptyRoot(const char* path);
+
+		/**
+		 * Add one entry. AddRoot() uses this; it's here for building indexes by hand.
+		 *
+		 * \return False if the index is out of room. (An entry which is already there is left alone.)
+		 */
+		bool Insert(uint32_t root, mlstd::StringView path, uint32_t size, uint8_t flags);
+
+		/**
+		 * Look up a path in a root. Case and separators don't matter,
+		 * and leading separators are ignored.
+		 *
+		 * \return The entry, or nullptr if there's no such thing.
+		 */
+		const Entry* Find(uint32_t root, mlstd::StringView path) const;
+
+		bool Exists(uint32_t root, mlstd::StringView path) const {
+			return Find(root, path) != nullptr;
+		}
+
+		/**
+		 * Get the size of a file.
+		 * \return The size, or -1 if it isn't in the index.
+		 */
+		int Size(uint32_t root, mlstd::StringView path) const;
+
+		uint32_t RootCount() const {
+			return rootCount;
+		}
+
+		const char* RootPath(uint32_t root) const {
+			return roots[root];
+		}
+
+		uint32_t Count() const {
+			return count;
+		}
+
+		/**
+		 * Call a function with every entry (in no particular order).
+		 */
+		template <class Fn>
+		void ForEach(Fn&& fn) const {
+			for(auto& entry : slots)
+				if(entry.path)
+					fn(entry);
+		}
+
+		/**
+		 * Forget everything.
+		 */
+		void Clear();
+
+	   private:
+		const char* CopyString(const char* string, uint32_t length);
+
+		/**
+		 * Undo the last AddEmptyRoot(), when there turned out to be nothing to walk.
+		 */
+		void RemoveLastRoot();
+
+		bool Walk(FioDirectory& dir, uint32_t root, char* path, uint32_t length, uint32_t relativeStart, uint32_t depth, uint32_t maxDepth);
+
+		uint32_t SlotFor(uint32_t root, uint32_t hash) const {
+			return (hash + root * 0x9e3779b9) & (slots.Size() - 1);
+		}
+
+		mlstd::Span<Entry> slots;
+		mlstd::Span<char> strings;
+		uint32_t stringsUsed {};
+		uint32_t count {};
+
+		const char* roots[MaxRoots] {};
+		uint32_t rootCount {};
+	};
+
+	/**
+	 * The root GetHostIndex() indexes the top level of host: as.
+	 */
+	constexpr uint32_t HostIndexRoot = 0;
+
+	/**
+	 * A shared index of host:, so everything checking for files there
+	 * shares one walk of it. The top level is indexed on the first call
+	 * (as HostIndexRoot); if that fails, it has no roots.
+	 *
+	 * It's used before the allocator is set up, so it lives in a fixed buffer.
+	 * Only the ELF has it.
+	 */
+	DirectoryIndex& GetHostIndex();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_DIRECTORYINDEX_H
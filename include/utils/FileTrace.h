@@ -0,0 +1,110 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The game file access tracer.
+//
+// The game file hooks (GameFileHooks.h) report every open, read, seek and
+// close the game does here, with when it started and how long it took.
+// Records go in a ring in memory. The hooks flush it to the end of the trace
+// file (see FileTraceFormat.h for the format) when it's getting full, when
+// the game has been idle for half a second, and at least every 5 seconds;
+// the tracereport host tool makes sense of it.
+//
+// The trace is written with the game's own file functions, since fio
+// doesn't work once the game has rebooted the IOP.
+//
+// Timestamps are COP0 Count, extended to 64 bits. That can only tell how
+// long a gap between two calls was if it's under about 7 seconds.
+
+#ifndef ELFLDR_FILETRACE_H
+#define ELFLDR_FILETRACE_H
+
+#include <stdint.h>
+#include <utils/FileTraceFormat.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Records in the ring.
+	 */
+	constexpr uint32_t FileTraceCapacity = 8192;
+
+	/**
+	 * Distinct files the trace can name, and room for their paths.
+	 */
+	constexpr uint32_t FileTraceMaxNames = 4096;
+	constexpr uint32_t FileTracePathsSize = 128 * 1024;
+
+	/**
+	 * The game's file functions, to write the trace with.
+	 * They have to be the originals, not the hooks.
+	 */
+	struct FileTraceIo {
+		int (*open)(const char* path, int flags, int mode);
+		int (*write)(int fd, const void* buffer, int length);
+		int (*close)(int fd);
+	};
+
+	/**
+	 * Start tracing. Needs the allocator to be set up.
+	 *
+	 * \param[in] path The trace file, e.g. "host:filetrace.bin". Anything already there
+	 *				   is replaced, the first time the trace is flushed.
+	 * \return True if tracing started.
+	 */
+	bool StartFileTrace(const char* path);
+
+	/**
+	 * Set the functions the trace is written with. The game file hooks do this.
+	 * Until they're set, flushing does nothing, and records stay in the ring.
+	 */
+	void SetFileTraceIo(const FileTraceIo& io);
+
+	bool FileTraceEnabled();
+
+	/**
+	 * Trace an open.
+	 *
+	 * \param[in] path The path the game opened.
+	 * \param[in] source Where the file really came from.
+	 * \param[in] fd What the open returned.
+	 * \param[in] start Cycle counter when the call started.
+	 * \param[in] end Cycle counter when it returned.
+	 */
+	void TraceFileOpen(const char* path, FileTraceSource source, int fd, uint32_t start, uint32_t end);
+
+	/**
+	 * Trace a read, seek or close of a file.
+	 *
+	 * \param[in] op What the call was.
+	 * \param[in] fd The file.
+	 * \param[in] length Bytes asked for (reads), or the offset asked for (seeks).
+	 * \param[in] result What the call returned.
+	 * \param[in] start Cycle counter when the call started.
+	 * \param[in] end Cycle counter when it returned.
+	 */
+	void TraceFileOp(FileTraceOp op, int fd, uint32_t length, int result, uint32_t start, uint32_t end);
+
+	/**
+	 * If the ring should be flushed: it's getting full, or the game was
+	 * idle for a while, or it's been a while since the last flush.
+	 */
+	bool FileTraceWantsFlush();
+
+	/**
+	 * Write what's in the ring to the end of the trace file.
+	 */
+	void FlushFileTrace();
+
+	/**
+	 * Flush, and stop tracing.
+	 */
+	void StopFileTrace();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_FILETRACE_H
@@ -0,0 +1,117 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The file trace format.
+//
+// A file trace (host:filetrace.bin) is a stream of chunks, one per flush
+// of the tracer's ring, appended as the game runs:
+//
+//	FileTraceChunkHeader
+//	FileTraceRecord[recordCount]
+//	FileTraceName[nameCount]
+//	the names' paths, NUL terminated (pathsSize bytes)
+//
+// A chunk only has the names of files first opened since the last chunk.
+// Everything's little endian. The tracereport host tool reads traces,
+// so this has no dependencies on the PS2 SDK.
+
+#ifndef ELFLDR_FILETRACEFORMAT_H
+#define ELFLDR_FILETRACEFORMAT_H
+
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	enum class FileTraceOp : uint8_t {
+		Open,
+		Read,
+		Seek,
+		Close
+	};
+
+	/**
+	 * Where an opened file really came from.
+	 */
+	enum class FileTraceSource : uint8_t {
+		Game,
+		Overlay,
+		Pack
+	};
+
+	struct FileTraceChunkHeader {
+		constexpr static uint32_t Magic = 0x43525446; // 'FTRC'
+		constexpr static uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+
+		/**
+		 * Rate of the record timestamps (the EE core clock).
+		 */
+		uint32_t clockHz;
+
+		uint32_t recordCount;
+		uint32_t nameCount;
+		uint32_t pathsSize;
+
+		/**
+		 * Records that didn't fit in the ring since the last chunk.
+		 */
+		uint32_t dropped;
+		uint32_t reserved;
+	};
+
+	struct FileTraceRecord {
+		/**
+		 * When the call started, in cycles since tracing started.
+		 */
+		uint64_t time;
+
+		/**
+		 * How long the call took, in cycles.
+		 */
+		uint32_t cycles;
+
+		/**
+		 * PathHash() of the path, relative to the device.
+		 */
+		uint32_t hash;
+
+		/**
+		 * Position in the file the call started at.
+		 */
+		uint32_t offset;
+
+		/**
+		 * Bytes asked for (reads), or the offset asked for (seeks).
+		 */
+		uint32_t length;
+
+		/**
+		 * What the call returned.
+		 */
+		int32_t result;
+
+		FileTraceOp op;
+		FileTraceSource source;
+		uint16_t reserved;
+	};
+
+	struct FileTraceName {
+		uint32_t hash;
+
+		/**
+		 * Offset of the path, from the start of the chunk's paths.
+		 */
+		uint32_t pathOffset;
+	};
+
+	static_assert(sizeof(FileTraceChunkHeader) == 32 && sizeof(FileTraceRecord) == 32 && sizeof(FileTraceName) == 8);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_FILETRACEFORMAT_H
@@ -0,0 +1,120 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef ELFLDR_FIOASYNC_H
+#define ELFLDR_FIOASYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * An asynchronous read, started with FioFile::ReadAsync().
+	 *
+	 * The caller owns this (and the buffer); both have to stay alive
+	 * until the read is done. fio can only have one operation in flight,
+	 * so reads are queued, and issued one at a time as earlier ones complete.
+	 */
+	struct FioReadRequest {
+		enum class State : uint8_t {
+			Idle,
+			Queued,
+			InFlight,
+			Done
+		};
+
+		FioReadRequest() = default;
+
+		FioReadRequest(const FioReadRequest&) = delete;
+		FioReadRequest& operator=(const FioReadRequest&) = delete;
+
+		/**
+		 * Waits for the read, if it's still pending;
+		 * the buffer is about to go away.
+		 */
+		~FioReadRequest();
+
+		/**
+		 * Check if the read is done, without waiting.
+		 * This also moves the queue along.
+		 */
+		bool Done();
+
+		/**
+		 * Wait for the read to be done.
+		 * \return The amount of bytes read, or -1 on error.
+		 */
+		int Wait();
+
+		/**
+		 * Is this request queued or in flight?
+		 */
+		bool Pending() const {
+			return state == State::Queued || state == State::InFlight;
+		}
+
+		int fd { -1 };
+		void* buffer { nullptr };
+		size_t length { 0 };
+
+		/**
+		 * fioRead()'s result, once the state is Done.
+		 */
+		int result { -1 };
+
+		State state { State::Idle };
+
+		FioReadRequest* next { nullptr };
+	};
+
+	/**
+	 * Queue a read. FioFile::ReadAsync() is the nicer way to do this.
+	 *
+	 * \return False if the request is already pending.
+	 */
+	bool FioQueueRead(FioReadRequest& request, int fd, void* buffer, size_t length);
+
+	/**
+	 * Check on the read in flight (without waiting), and start the next one
+	 * if it's done. Call this every so often while doing other work.
+	 */
+	void FioPoll();
+
+	/**
+	 * Wait for a request, and any queued before it.
+	 * \return The request's result.
+	 */
+	int FioWait(FioReadRequest& request);
+
+	/**
+	 * Wait for every queued read.
+	 */
+	void FioWaitAll();
+
+	/**
+	 * Is a read in flight right now?
+	 * Other fio calls will wait for it to complete first.
+	 */
+	bool FioReadInFlight();
+
+	namespace detail {
+
+		/**
+		 * Wait for the read in flight (if any), and keep its result.
+		 *
+		 * fio keeps the result of only the last operation,
+		 * so this has to be called before any other fio call.
+		 * FioFile and FioDirectory do this themselves.
+		 */
+		void FioSettle();
+
+	} // namespace detail
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_FIOASYNC_H
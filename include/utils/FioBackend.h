@@ -0,0 +1,110 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef ELFLDR_FIOBACKEND_H
+#define ELFLDR_FIOBACKEND_H
+
+#ifdef _EE
+	#include <fileio.h>
+#else
+	// The bits of the PS2SDK's fileio.h the file code uses, so it (and mock
+	// backends) can be built for the host tests. Values match the PS2SDK.
+	#include <stdint.h>
+
+	#define FIO_O_RDONLY 0x0001
+	#define FIO_O_WRONLY 0x0002
+	#define FIO_O_RDWR 0x0003
+	#define FIO_O_APPEND 0x0100
+	#define FIO_O_CREAT 0x0200
+	#define FIO_O_TRUNC 0x0400
+
+	#define FIO_SEEK_SET 0
+	#define FIO_SEEK_CUR 1
+	#define FIO_SEEK_END 2
+
+	#define FIO_WAIT 0
+	#define FIO_NOWAIT 1
+	#define FIO_COMPLETE 1
+	#define FIO_INCOMPLETE 0
+
+typedef struct {
+	uint32_t mode;
+	uint32_t attr;
+	uint32_t size;
+	uint8_t ctime[8];
+	uint8_t atime[8];
+	uint8_t mtime[8];
+	uint32_t hisize;
+} io_stat_t;
+
+typedef struct {
+	io_stat_t stat;
+	char name[256];
+	void* unknown;
+} io_dirent_t;
+#endif
+
+namespace elfldr::util {
+
+	/**
+	 * The fio functions FioFile, FioDirectory and the async read queue use.
+	 *
+	 * Normally these are the PS2SDK's. Swapping them out lets the file code
+	 * (and especially the async read scheduling) run on a host, against
+	 * a mock which can simulate RPC latency.
+	 */
+	struct FioBackend {
+		int (*open)(const char* path, int flags);
+		int (*close)(int fd);
+		int (*read)(int fd, void* buffer, int length);
+		int (*write)(int fd, const void* buffer, int length);
+		int (*lseek)(int fd, int offset, int whence);
+
+		int (*dopen)(const char* path);
+		int (*dclose)(int fd);
+		int (*dread)(int fd, io_dirent_t* entry);
+
+		/**
+		 * FIO_WAIT or FIO_NOWAIT. In FIO_NOWAIT mode, calls return as soon as
+		 * they're sent; sync() gets the result.
+		 */
+		void (*setBlockMode)(int mode);
+
+		/**
+		 * Check on (FIO_NOWAIT), or wait for (FIO_WAIT), the last operation.
+		 * \return FIO_COMPLETE or FIO_INCOMPLETE.
+		 */
+		int (*sync)(int mode, int* result);
+	};
+
+	namespace detail {
+		extern const FioBackend* gFioBackend;
+	}
+
+	/**
+	 * Get the current fio backend.
+	 */
+	inline const FioBackend& Fio() {
+		return *detail::gFioBackend;
+	}
+
+	/**
+	 * Replace the fio backend. The backend must outlive its use.
+	 * Don't do this with reads in flight.
+	 */
+	void SetFioBackend(const FioBackend& backend);
+
+#ifdef _EE
+	/**
+	 * The PS2SDK's fio.
+	 */
+	const FioBackend& NativeFioBackend();
+#endif
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_FIOBACKEND_H
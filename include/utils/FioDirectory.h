@@ -8,8 +8,9 @@
 #ifndef ELFLDR_FIODIRECTORY_H
 #define ELFLDR_FIODIRECTORY_H
 
-#include <fileio.h>
 #include <mlstd/String.h>
+#include <utils/FioAsync.h>
+#include <utils/FioBackend.h>
 
 namespace elfldr::util {
 
@@ -71,7 +72,12 @@ namespace elfldr::util {
 				return;
 			io_dirent_t dirent{};
 
-			while(fioDread(fd, &dirent)) {
+			while(true) {
+				// The callback might have started a read.
+				detail::FioSettle();
+				if(!Fio().dread(fd, &dirent))
+					return;
+
 				if(!callback(dirent))
 					return;
 			}
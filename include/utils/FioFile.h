@@ -8,10 +8,18 @@
 #ifndef ELFLDR_FIOFILE_H
 #define ELFLDR_FIOFILE_H
 
-#include <fileio.h>
+#include <mlstd/Allocator.h>
+#include <mlstd/Span.h>
+#include <mlstd/String.h>
+#include <stdint.h>
+#include <utils/FioAsync.h>
+#include <utils/FioBackend.h>
 
 namespace elfldr::util {
 
+	template <class Allocator>
+	struct FileBuffer;
+
 	/**
 	 * Helper class for using PS2SDK FIO in a way which isn't garbage.
 	 * Automatically closes, provides sane state management, all that.
@@ -59,6 +67,38 @@ namespace elfldr::util {
 		 */
 		int Read(void* buffer, size_t length);
 
+		/**
+		 * Read length bytes, unless the file ends first.
+		 * fio can return less than was asked for; this keeps reading until it's done.
+		 *
+		 * \return Amount of bytes read, or -1 on error.
+		 */
+		int ReadFully(void* buffer, size_t length);
+
+		/**
+		 * Start reading some bytes from the file, without waiting for them.
+		 * Other work can go on while the IOP (or host) does the read;
+		 * wait on the request when the data is needed.
+		 *
+		 * Like Read(), this can read less than was asked for.
+		 *
+		 * \param[in] request Completion handle. Must outlive the read, as must the buffer.
+		 * \return True if the read was queued.
+		 */
+		bool ReadAsync(FioReadRequest& request, void* buffer, size_t length);
+
+		/**
+		 * Read the whole file (from the start) into memory.
+		 *
+		 * The file is sized once, and read into a single buffer
+		 * with one large read (so, one RPC) in the common case.
+		 *
+		 * \param[in] allocator Allocator for the buffer. Must outlive the returned buffer.
+		 * \return The file's contents. Check Good() on it.
+		 */
+		template <class Allocator>
+		FileBuffer<Allocator> ReadAll(Allocator& allocator);
+
 		/**
 		 * Write some bytes to the file.
 		 */
@@ -79,6 +119,8 @@ namespace elfldr::util {
 		/**
 		 * Convinence function to return the size of the file.
 		 * Only use this for real files you baka!!!!!!!!!
+		 *
+		 * \return The size, or -1 on error. The file position is left alone.
 		 */
 		int Size();
 
@@ -91,6 +133,120 @@ namespace elfldr::util {
 		int fd { -1 };
 	};
 
+	/**
+	 * A whole file in memory, from FioFile::ReadAll(). Frees it when destroyed.
+	 *
+	 * The contents are aligned for SIF DMA, and followed by a NUL terminator,
+	 * so text files can be used as C strings.
+	 */
+	template <class Allocator = mlstd::StdAllocator<uint8_t>>
+	struct FileBuffer {
+		static_assert(sizeof(typename Allocator::ValueType) == 1, "FileBuffer needs a byte allocator");
+
+		/**
+		 * SIF DMA works in 64-byte cache lines; an aligned buffer
+		 * saves the IOP side from bouncing the misaligned ends.
+		 */
+		constexpr static uintptr_t Alignment = 64;
+
+		FileBuffer() = default;
+
+		FileBuffer(const FileBuffer&) = delete;
+		FileBuffer& operator=(const FileBuffer&) = delete;
+
+		FileBuffer(FileBuffer&& move) noexcept
+			: allocator(move.allocator),
+			  raw(move.raw),
+			  bytes(move.bytes) {
+			move.raw = nullptr;
+			move.bytes = {};
+		}
+
+		FileBuffer& operator=(FileBuffer&& move) noexcept {
+			if(this != &move) {
+				Free();
+				allocator = move.allocator;
+				raw = move.raw;
+				bytes = move.bytes;
+				move.raw = nullptr;
+				move.bytes = {};
+			}
+			return *this;
+		}
+
+		~FileBuffer() {
+			Free();
+		}
+
+		/**
+		 * Get if the file was read.
+		 */
+		bool Good() const {
+			return raw != nullptr;
+		}
+
+		operator bool() const {
+			return Good();
+		}
+
+		/**
+		 * The file's contents.
+		 */
+		mlstd::Span<const uint8_t> Bytes() const {
+			return bytes;
+		}
+
+		/**
+		 * The file's contents, as text.
+		 */
+		mlstd::StringView Text() const {
+			return { reinterpret_cast<char*>(bytes.Data()), bytes.Size() };
+		}
+
+	   private:
+		friend struct FioFile;
+
+		void Free() {
+			if(raw)
+				allocator->Deallocate(raw);
+			raw = nullptr;
+			bytes = {};
+		}
+
+		Allocator* allocator { nullptr };
+		typename Allocator::ValueType* raw { nullptr };
+		mlstd::Span<uint8_t> bytes;
+	};
+
+	template <class Allocator>
+	inline FileBuffer<Allocator> FioFile::ReadAll(Allocator& allocator) {
+		FileBuffer<Allocator> buffer;
+
+		const auto size = Size();
+		if(size < 0 || Seek(0, FIO_SEEK_SET) != 0)
+			return buffer;
+
+		// Room to align the start, plus the terminator.
+		auto* raw = allocator.Allocate(static_cast<uint32_t>(size) + FileBuffer<Allocator>::Alignment);
+		if(raw == nullptr)
+			return buffer;
+
+		const auto alignment = FileBuffer<Allocator>::Alignment;
+		auto* data = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(raw) + alignment - 1) & ~(alignment - 1));
+
+		if(ReadFully(data, static_cast<size_t>(size)) != size) {
+			allocator.Deallocate(raw);
+			return buffer;
+		}
+
+		data[size] = '\0';
+
+		buffer.allocator = &allocator;
+		buffer.raw = raw;
+		buffer.bytes = { data, static_cast<size_t>(size) };
+		return buffer;
+	}
+
 } // namespace elfldr::util
 
 #endif // ELFLDR_FIOFILE_H
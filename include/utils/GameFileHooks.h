@@ -0,0 +1,53 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Hooks on the game's file functions.
+//
+// Every file the game opens (ASYNCFILE and all) goes through the Sony libc's
+// sceOpen(), so that's hooked. Its address comes from the symbol database
+// ("sceOpen"); if it isn't known for the running game, nothing is hooked,
+// and the game opens files like it always did.
+//
+// When packs are mounted, sceClose(), sceRead() and sceLseek() are hooked too
+// ("sceClose", "sceRead" and "sceLseek"), and files in packs get fds of their own,
+// which read a range of the pack. If those aren't known, packs aren't used.
+// They're hooked for file tracing (FileTrace.h) as well, and the trace is
+// written with the game's own sceOpen(), sceWrite() ("sceWrite") and sceClose().
+//
+// The hooks run on the game's threads, for as long as the game runs, so
+// whatever installs them (and the overlay) has to stay resident. The lock
+// the pack hooks share is made the first time the game takes it (see
+// LazyLock.h), as semaphores made before ExecPS2() don't survive it.
+
+#ifndef ELFLDR_GAMEFILEHOOKS_H
+#define ELFLDR_GAMEFILEHOOKS_H
+
+#include <utils/OverlayFs.h>
+#include <utils/PackFile.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Redirect the game's opens through a mod overlay, then some packs.
+	 * Loose files in the overlay win over files in packs.
+	 *
+	 * If file tracing has been started, the game's file calls are traced too.
+	 *
+	 * \param[in] overlay The overlay. It has to outlive the hooks.
+	 * \param[in] packs The packs. They have to outlive the hooks.
+	 * \return True if the hooks were installed.
+	 */
+	bool InstallGameFileHooks(const OverlayFs& overlay, const PackSet& packs);
+
+	/**
+	 * Remove the hooks. The game opens its own files again.
+	 */
+	void RemoveGameFileHooks();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_GAMEFILEHOOKS_H
@@ -0,0 +1,57 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The game's own file functions (the Sony libc's sceOpen() and friends).
+//
+// The game reboots the IOP first thing, after which fio's bindings are stale.
+// Code which runs inside the game (codehooks) does its file access through
+// the game's functions instead. Their addresses come from the symbol database
+// ("sceOpen", "sceClose", "sceRead", "sceWrite", "sceLseek", "sceDopen",
+// "sceDclose" and "sceDread").
+//
+// Sony's open flags, seek modes and directory entries are the same as fio's,
+// so UseGameFileIo() can put them behind FioFile and FioDirectory as they are.
+
+#ifndef ELFLDR_GAMEFILEIO_H
+#define ELFLDR_GAMEFILEIO_H
+
+#include <utils/FioBackend.h>
+
+namespace elfldr::util {
+
+	struct GameFileIo {
+		int (*open)(const char* path, int flags, int mode);
+		int (*close)(int fd);
+		int (*read)(int fd, void* buffer, int length);
+		int (*write)(int fd, const void* buffer, int length);
+		int (*lseek)(int fd, int offset, int whence);
+
+		int (*dopen)(const char* path);
+		int (*dclose)(int fd);
+		int (*dread)(int fd, io_dirent_t* entry);
+	};
+
+	/**
+	 * Find the game's file functions for the running game version.
+	 * The ones which aren't known are nullptr.
+	 */
+	GameFileIo FindGameFileIo();
+
+	/**
+	 * Send fio calls (FioFile, FioDirectory and the async read queue) to the
+	 * game's file functions. Calls to ones which are nullptr fail.
+	 *
+	 * The game's functions don't have a no-wait mode, so async reads
+	 * are done by the time they're queued.
+	 *
+	 * \param[in] io The functions. They're copied.
+	 */
+	void UseGameFileIo(const GameFileIo& io);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_GAMEFILEIO_H
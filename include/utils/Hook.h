@@ -8,8 +8,12 @@
 #ifndef ELFLDR_HOOK_H
 #define ELFLDR_HOOK_H
 
+#include <stdint.h>
+
 namespace elfldr::util {
 
+	struct GnuVtablePointer;
+
 	namespace detail {
 		/**
 		 * Detail base helper for hooking a function.
@@ -21,14 +25,29 @@ namespace elfldr::util {
 		 * \param[in] hook Hook function pointer.
 		 */
 		void* HookFunctionBase(void* dest, const void* hook);
+
+		/**
+		 * Flush the caches after writing code, or defer it
+		 * to the end of the current hook batch.
+		 */
+		void FlushHookedCode();
+
+		/**
+		 * Detail base helper for hooking a virtual function.
+		 * Use the typed HookVirtual() API.
+		 *
+		 * \return The original function pointer.
+		 */
+		void* HookVirtualBase(void* vtable, uint32_t slot, const void* hook);
 	} // namespace detail
 
 	/**
 	 * Hook a function.
 	 * \tparam HookT Hook function pointer type. Also determines trampoline type.
 	 * \return The trampoline. You can use this to call the original routine
-	 * 			from your hook.
-	 * \param[out] funcptr Function to hook. This function must be at least 5*sizeof(uint32_t) bytes long.
+	 * 			from your hook. nullptr if the function's prologue can't be relocated safely.
+	 * \param[out] funcptr Function to hook. This function must be at least 4 instructions long
+	 * 					(2, if the hook is in the same 256MB segment, which it usually is).
 	 * \param[in] hook The hook routine.
 	 */
 	template <class HookT>
@@ -36,6 +55,71 @@ namespace elfldr::util {
 		return reinterpret_cast<HookT>(detail::HookFunctionBase(funcptr, reinterpret_cast<void*>(hook)));
 	}
 
+	/**
+	 * Begin a batch of hooks. Until the matching EndHookBatch(),
+	 * hooking doesn't flush the caches; the batch flushes once at the end.
+	 * Hooked functions must not be called while a batch is open.
+	 *
+	 * Batches can be nested.
+	 */
+	void BeginHookBatch();
+
+	/**
+	 * End a batch of hooks, flushing the caches if anything was hooked.
+	 */
+	void EndHookBatch();
+
+	/**
+	 * Unhook a function hooked with HookFunction(), restoring the original
+	 * instructions and freeing the trampoline.
+	 *
+	 * This will fail if the hooked instructions were patched again after hooking
+	 * (e.g, by another hook), which would need to be reverted first.
+	 *
+	 * \param[in] funcptr Hooked function.
+	 * \return True if the function was unhooked.
+	 */
+	bool UnhookFunction(void* funcptr);
+
+	/**
+	 * Hook a virtual function, by swapping its vtable entry.
+	 *
+	 * This doesn't touch any code, so there's nothing to relocate, no trampoline,
+	 * and no cache flush. The entry is swapped with a single store, so it's safe
+	 * to do while other threads are calling through the vtable.
+	 *
+	 * The hook is called with the same (adjusted) this pointer the original is,
+	 * so it can call the original directly.
+	 *
+	 * \tparam HookT Hook function pointer type. Also determines the original's type.
+	 * \param[in] vtable The vtable (a GnuVtablePointer array, e.g. a cNode::vtable).
+	 * \param[in] slot Index of the entry in the vtable, counting the padding entry at the start.
+	 * \param[in] hook The hook routine.
+	 * \return The original function.
+	 */
+	template <class HookT>
+	inline HookT HookVirtual(void* vtable, uint32_t slot, const HookT hook) {
+		return reinterpret_cast<HookT>(detail::HookVirtualBase(vtable, slot, reinterpret_cast<const void*>(hook)));
+	}
+
+	/**
+	 * Hook a virtual function, given its vtable entry.
+	 *
+	 * \see HookVirtual(void*, uint32_t, const HookT)
+	 */
+	template <class HookT>
+	inline HookT HookVirtual(GnuVtablePointer& entry, const HookT hook) {
+		return HookVirtual(&entry, 0, hook);
+	}
+
+	/**
+	 * Unhook a virtual function hooked with HookVirtual(), restoring
+	 * the original vtable entry.
+	 *
+	 * \return True if the function was unhooked.
+	 */
+	bool UnhookVirtual(void* vtable, uint32_t slot);
+
 } // namespace elfldr
 
 #endif // ELFLDR_HOOK_H
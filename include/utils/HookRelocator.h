@@ -0,0 +1,258 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Relocation of instructions stolen from a function prologue by a hook.
+//
+// The instructions overwritten by a hook are run from the trampoline instead,
+// which lives somewhere else in memory. Most instructions don't care, but
+// PC-relative branches do: they're rewritten to branch to a small stub
+// in the trampoline which jumps to the original target.
+//
+// The one exception is the position independent code idiom for getting the
+// PC, "bal .+8" (a linking branch to the instruction after its own delay
+// slot). Code after it uses ra to find its data, so ra has to be the
+// original address; it's loaded with lui/ori instead.
+//
+// Prologues which can't be moved safely are refused, instead of
+// producing a trampoline which runs garbage.
+
+#ifndef ELFLDR_HOOKRELOCATOR_H
+#define ELFLDR_HOOKRELOCATOR_H
+
+#include <stdint.h>
+#include <utils/MipsIDecoder.h>
+#include <utils/MipsIEncoder.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Why relocating a prologue failed.
+	 */
+	enum class RelocateError : uint8_t {
+		None,
+
+		/**
+		 * A jr in the stolen instructions; the function is
+		 * too short to be hooked.
+		 */
+		FunctionTooShort,
+
+		/**
+		 * The last stolen instruction is a branch or jump,
+		 * so its delay slot would not be stolen along with it.
+		 */
+		DelaySlotOutside,
+
+		/**
+		 * A branch or jump sits in the delay slot of another.
+		 */
+		BranchInDelaySlot,
+
+		/**
+		 * A branch targets the stolen instructions themselves,
+		 * which are replaced by the hook.
+		 */
+		BranchIntoStolen,
+
+		/**
+		 * A jump target is not reachable from the trampoline.
+		 */
+		OutOfSegment,
+
+		/**
+		 * The relocated code doesn't fit in MaxRelocatedLength.
+		 */
+		TooLarge
+	};
+
+	/**
+	 * Max length of relocated code, in instructions.
+	 * This matches a large trampoline slot.
+	 */
+	constexpr uint32_t MaxRelocatedLength = 16;
+
+	struct RelocatedCode {
+		RelocateError error;
+
+		/**
+		 * Length of the code, in instructions.
+		 */
+		uint32_t length;
+
+		uint32_t code[MaxRelocatedLength];
+	};
+
+	namespace detail {
+
+		/**
+		 * Check if a j/jal at pc can reach target.
+		 */
+		constexpr bool JumpReaches(uintptr_t pc, uintptr_t target) {
+			return ((pc + 4) & 0xf0000000) == (target & 0xf0000000);
+		}
+
+		/**
+		 * Check if an instruction is "bal .+8", or any other linking
+		 * branch which ends up after its delay slot either way.
+		 */
+		constexpr bool IsGetPc(const mips::Instruction& insn, uintptr_t pc) {
+			return insn.opClass == mips::OpClass::Branch && (insn.flags & mips::OpFlag_Link) && !(insn.flags & mips::OpFlag_Likely) && insn.target == pc + 8;
+		}
+
+	} // namespace detail
+
+	/**
+	 * Relocate stolen prologue instructions to a new address, and add a jump
+	 * back to the rest of the function after them.
+	 *
+	 * \param[in] stolen The stolen instructions.
+	 * \param[in] count Amount of stolen instructions.
+	 * \param[in] source Address the instructions were stolen from.
+	 * \param[in] destination Address the relocated code will run from.
+	 */
+	constexpr RelocatedCode RelocatePrologue(const uint32_t* stolen, uint32_t count, uintptr_t source, uintptr_t destination) {
+		using namespace detail;
+
+		RelocatedCode result {};
+		const uintptr_t stolenEnd = source + count * sizeof(uint32_t);
+
+		auto Fail = [&](RelocateError error) {
+			result.error = error;
+			result.length = 0;
+			return result;
+		};
+
+		// First pass: validate, and find out where everything goes.
+		// The relocated instructions map 1:1 (besides get-PC branches,
+		// which take two), then the jump back, then the stubs.
+		uint32_t bodyLength = count;
+		uint32_t stubCount = 0;
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto pc = source + i * sizeof(uint32_t);
+			const auto insn = mips::Decode(stolen[i], pc);
+
+			if(!insn.HasDelaySlot())
+				continue;
+
+			if(insn.op == mips::Op::Jr)
+				return Fail(RelocateError::FunctionTooShort);
+
+			if(i + 1 == count)
+				return Fail(RelocateError::DelaySlotOutside);
+
+			if(mips::Decode(stolen[i + 1]).HasDelaySlot())
+				return Fail(RelocateError::BranchInDelaySlot);
+
+			if(IsGetPc(insn, pc)) {
+				++bodyLength;
+				++i;
+				continue;
+			}
+
+			if(insn.opClass == mips::OpClass::Branch || insn.opClass == mips::OpClass::Jump) {
+				if(insn.target >= source && insn.target < stolenEnd)
+					return Fail(RelocateError::BranchIntoStolen);
+			}
+
+			if(insn.opClass == mips::OpClass::Branch)
+				++stubCount;
+			else if(insn.opClass == mips::OpClass::Jump && !JumpReaches(destination + (i + bodyLength - count) * sizeof(uint32_t), insn.target))
+				return Fail(RelocateError::OutOfSegment);
+
+			// The delay slot has been checked; skip it.
+			++i;
+		}
+
+		// The jump back is a plain j if it reaches, which doesn't clobber anything.
+		// Otherwise, it's the same lui/ori/jr sequence hooks use.
+		const auto jumpBackPc = destination + bodyLength * sizeof(uint32_t);
+		const bool shortJumpBack = JumpReaches(jumpBackPc, stolenEnd);
+		const uint32_t jumpBackLength = shortJumpBack ? 2 : 4;
+
+		// Every stub is a j + delay slot.
+		const auto stubsStart = bodyLength + jumpBackLength;
+		if(stubsStart + stubCount * 2 > MaxRelocatedLength)
+			return Fail(RelocateError::TooLarge);
+
+		// Second pass: emit.
+		uint32_t out = 0;
+		uint32_t stub = stubsStart;
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto pc = source + i * sizeof(uint32_t);
+			const auto insn = mips::Decode(stolen[i], pc);
+
+			if(IsGetPc(insn, pc)) {
+				// ra is written before the delay slot runs, so it goes first.
+				const auto link = pc + 8;
+				result.code[out++] = mips::lui(mips::Reg::RA, link >> 16);
+				result.code[out++] = mips::ori(mips::Reg::RA, mips::Reg::RA, link & 0xffff);
+				result.code[out++] = stolen[++i];
+				continue;
+			}
+
+			if(insn.opClass != mips::OpClass::Branch) {
+				result.code[out++] = insn.word;
+				continue;
+			}
+
+			const auto stubPc = destination + stub * sizeof(uint32_t);
+			const auto target = insn.target;
+
+			if(!JumpReaches(stubPc, target))
+				return Fail(RelocateError::OutOfSegment);
+
+			// Branch (with the same condition, and the same delay slot) to the stub,
+			// which jumps to the real target. Likely branches still only run the
+			// delay slot if taken, and -al branches still link to after the
+			// delay slot, which is in the trampoline, and so returns into it.
+			const auto offset = static_cast<int32_t>(stubPc - (destination + out * sizeof(uint32_t) + 4)) / 4;
+			result.code[out++] = (insn.word & 0xffff0000) | (static_cast<uint32_t>(offset) & 0xffff);
+			result.code[stub++] = mips::j(target);
+			result.code[stub++] = mips::nop();
+		}
+
+		if(shortJumpBack) {
+			result.code[out] = mips::j(stolenEnd);
+			result.code[out + 1] = mips::nop();
+		} else {
+			result.code[out] = mips::lui(mips::Reg::T0, stolenEnd >> 16);
+			result.code[out + 1] = mips::ori(mips::Reg::T0, mips::Reg::T0, stolenEnd & 0xffff);
+			result.code[out + 2] = mips::jr(mips::Reg::T0);
+			result.code[out + 3] = mips::nop();
+		}
+
+		result.error = RelocateError::None;
+		result.length = stub;
+		return result;
+	}
+
+	/**
+	 * Get a string for a relocation error, for logging.
+	 */
+	constexpr const char* RelocateErrorString(RelocateError error) {
+		switch(error) {
+			case RelocateError::None:
+				return "None";
+			case RelocateError::FunctionTooShort:
+				return "Function too short (jr in stolen instructions)";
+			case RelocateError::DelaySlotOutside:
+				return "Stolen instructions end inside a delay slot";
+			case RelocateError::BranchInDelaySlot:
+				return "Branch in a delay slot";
+			case RelocateError::BranchIntoStolen:
+				return "Branch into the stolen instructions";
+			case RelocateError::OutOfSegment:
+				return "Jump target out of segment";
+			case RelocateError::TooLarge:
+				return "Relocated code too large";
+		}
+		return "?";
+	}
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_HOOKRELOCATOR_H
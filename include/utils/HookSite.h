@@ -0,0 +1,88 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The code HookFunction() writes over the start of a hooked function,
+// and how it picks which one. This is all constexpr, with no dependencies
+// on the PS2 SDK, so it's also tested on the host.
+
+#ifndef ELFLDR_HOOKSITE_H
+#define ELFLDR_HOOKSITE_H
+
+#include <stdint.h>
+#include <utils/HookRelocator.h>
+#include <utils/MipsAssembler.h>
+
+namespace elfldr::util::detail {
+
+	// Relocation slot 0 is the hook address.
+
+	// Used when the hook is in the same 256MB segment as the function
+	// (which is basically always). Doesn't clobber anything.
+	inline constexpr auto jumpTemplate = mips::Assemble<[](mips::Assembler& a) {
+		a.JumpTo(0);
+	}>();
+
+	// Used otherwise.
+	inline constexpr auto callTemplate = mips::Assemble<[](mips::Assembler& a) {
+		a.LoadAddress(mips::Reg::T0, 0);
+		a.Jr(mips::Reg::T0); // (wasting an instruction on the delay slot...)
+	}>();
+
+	enum class HookSite : uint8_t {
+		Jump,
+		LoadJump
+	};
+
+	constexpr uint32_t HookSiteLength(HookSite site) {
+		return site == HookSite::Jump ? jumpTemplate.Length : callTemplate.Length;
+	}
+
+	/**
+	 * Select the shortest hook site encoding which can reach the hook.
+	 */
+	constexpr HookSite SelectHookSite(uintptr_t dest, uintptr_t hook) {
+		if(!(hook & 3) && detail::JumpReaches(dest, hook))
+			return HookSite::Jump;
+		return HookSite::LoadJump;
+	}
+
+	struct HookPlan {
+		HookSite site;
+
+		/**
+		 * The stolen instructions, relocated to the trampoline.
+		 */
+		RelocatedCode relocated;
+	};
+
+	/**
+	 * Pick the hook site for a function, and relocate the instructions it steals.
+	 *
+	 * \param[in] prologue The start of the function; at least 4 instructions.
+	 * \param[in] dest Address of the function.
+	 * \param[in] hook Address of the hook.
+	 * \param[in] trampoline Address the relocated instructions will run from.
+	 */
+	constexpr HookPlan PlanHook(const uint32_t* prologue, uintptr_t dest, uintptr_t hook, uintptr_t trampoline) {
+		HookPlan plan { SelectHookSite(dest, hook), {} };
+		plan.relocated = RelocatePrologue(prologue, HookSiteLength(plan.site), dest, trampoline);
+
+		// A short hook site can split a branch from its delay slot, where a
+		// long one wouldn't; if so, give the long one a shot.
+		if(plan.relocated.error == RelocateError::DelaySlotOutside && plan.site == HookSite::Jump) {
+			plan.site = HookSite::LoadJump;
+			plan.relocated = RelocatePrologue(prologue, HookSiteLength(plan.site), dest, trampoline);
+		}
+
+		return plan;
+	}
+
+	static_assert(HookSiteLength(HookSite::Jump) == 2 && HookSiteLength(HookSite::LoadJump) == 4);
+
+} // namespace elfldr::util::detail
+
+#endif // ELFLDR_HOOKSITE_H
@@ -0,0 +1,67 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#ifndef ELFLDR_LAZYLOCK_H
+#define ELFLDR_LAZYLOCK_H
+
+namespace elfldr::util {
+
+	/**
+	 * A lock for state hooks share between the game's threads.
+	 *
+	 * The kernel deletes every semaphore when ExecPS2() starts the game,
+	 * so one made when the hooks are installed could be gone by the time
+	 * they run. This makes its semaphore the first time it's taken instead,
+	 * which is always on one of the game's threads.
+	 */
+	struct LazyLock {
+		/**
+		 * Take the lock, making it first if need be.
+		 * \return False if the semaphore couldn't be made.
+		 */
+		bool Lock();
+
+		void Unlock();
+
+		/**
+		 * Delete the semaphore, if it's been made. Don't hold the lock.
+		 */
+		void Destroy();
+
+	   private:
+		volatile int sema { -1 };
+	};
+
+	/**
+	 * Holds a LazyLock for a scope. Check it; if the lock couldn't be made, it isn't held.
+	 */
+	struct LazyLockGuard {
+		explicit LazyLockGuard(LazyLock& lock)
+			: lock(lock),
+			  held(lock.Lock()) {
+		}
+
+		~LazyLockGuard() {
+			if(held)
+				lock.Unlock();
+		}
+
+		LazyLockGuard(const LazyLockGuard&) = delete;
+		LazyLockGuard& operator=(const LazyLockGuard&) = delete;
+
+		explicit operator bool() const {
+			return held;
+		}
+
+	   private:
+		LazyLock& lock;
+		bool held;
+	};
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_LAZYLOCK_H
@@ -0,0 +1,282 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Leveled, per-channel logging.
+//
+// Which levels and channels exist at all is decided at compile time
+// (see ELFLDR_LOG_MIN_LEVEL and ELFLDR_LOG_CHANNELS below, set from CMake).
+// A log statement for a level or channel which isn't compiled in is discarded
+// entirely; its format string and arguments never make it into the binary.
+//
+// The rest can be switched at runtime with LogConfigure(). That costs one load,
+// and one branch, per log statement.
+//
+// With ELFLDR_LOG_BINARY (the ELFLDR_LOG_BINARY CMake option) defined, log statements
+// aren't formatted at all; see LogFormat.h. This is only available in the ELF.
+
+#ifndef ELFLDR_LOG_H
+#define ELFLDR_LOG_H
+
+#include <stdint.h>
+
+#if defined(ELFLDR_LOG_BINARY) && !defined(ERL)
+	#define ELFLDR_LOG_TOKENIZED
+	#include <mlstd/Bit.h>
+	#include <mlstd/TypeTraits.h>
+	#include <utils/LogFormat.h>
+#endif
+
+#define ELFLDR_LOG_LEVEL_TRACE 0
+#define ELFLDR_LOG_LEVEL_DEBUG 1
+#define ELFLDR_LOG_LEVEL_INFO 2
+#define ELFLDR_LOG_LEVEL_WARNING 3
+#define ELFLDR_LOG_LEVEL_ERROR 4
+
+// The lowest level which is compiled in.
+#ifndef ELFLDR_LOG_MIN_LEVEL
+	#ifdef NDEBUG
+		#define ELFLDR_LOG_MIN_LEVEL ELFLDR_LOG_LEVEL_INFO
+	#else
+		#define ELFLDR_LOG_MIN_LEVEL ELFLDR_LOG_LEVEL_DEBUG
+	#endif
+#endif
+
+// Mask of the channels which are compiled in (bit n is LogChannel n).
+#ifndef ELFLDR_LOG_CHANNELS
+	#define ELFLDR_LOG_CHANNELS 0xffffffff
+#endif
+
+namespace elfldr::util {
+
+	enum class LogLevel : uint8_t {
+		Trace = ELFLDR_LOG_LEVEL_TRACE,
+		Debug = ELFLDR_LOG_LEVEL_DEBUG,
+		Info = ELFLDR_LOG_LEVEL_INFO,
+		Warning = ELFLDR_LOG_LEVEL_WARNING,
+		Error = ELFLDR_LOG_LEVEL_ERROR,
+
+		Count
+	};
+
+	enum class LogChannel : uint8_t {
+		General,
+		Loader, // ELF loading
+		Erl,
+		Hook,
+		Patch,
+		Fio,
+		Profiler,
+
+		Count
+	};
+
+	static_assert(static_cast<uint32_t>(LogChannel::Count) <= 32, "Channels must fit in a 32-bit mask");
+
+	/**
+	 * Get if a level and channel are compiled in.
+	 */
+	constexpr bool LogCompiledIn(LogChannel channel, LogLevel level) {
+		return static_cast<uint32_t>(level) >= ELFLDR_LOG_MIN_LEVEL && (static_cast<uint32_t>(ELFLDR_LOG_CHANNELS) & (1u << static_cast<uint32_t>(channel))) != 0;
+	}
+
+	namespace detail {
+		/**
+		 * Per-level masks of the channels enabled at runtime.
+		 */
+		extern uint32_t gLogMasks[static_cast<uint32_t>(LogLevel::Count)];
+
+		void LogWrite(LogChannel channel, LogLevel level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#ifdef ELFLDR_LOG_TOKENIZED
+		/**
+		 * Never defined; only used in sizeof() so tokenized log statements
+		 * still get their format strings checked.
+		 */
+		int LogCheckFormat(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+		template <class T>
+		constexpr LogArgCode LogArgCodeFor() {
+			using Arg = mlstd::RemoveCvRefT<T>;
+
+			if constexpr(mlstd::IsSame<Arg, mlstd::RemoveCvPtrT<Arg>>::value) {
+				if constexpr(mlstd::IsSame<Arg, float>::value || mlstd::IsSame<Arg, double>::value)
+					return LogArgCode::Double;
+				else if constexpr(sizeof(Arg) <= sizeof(uint32_t))
+					return LogArgCode::Int32;
+				else
+					return LogArgCode::Int64;
+			} else if constexpr(mlstd::IsSame<mlstd::RemoveCvPtrT<Arg>, char>::value) {
+				return LogArgCode::String;
+			} else {
+				return LogArgCode::Pointer;
+			}
+		}
+
+		template <class... Args>
+		struct LogArgTypes {
+			constexpr static char Signature[] = { static_cast<char>(LogArgCodeFor<Args>())..., '\0' };
+		};
+
+		/**
+		 * Never defined; decltype(LogArgTypesOf(args...)) gets the (decayed) argument types.
+		 */
+		template <class... Args>
+		LogArgTypes<Args...> LogArgTypesOf(Args...);
+
+		/**
+		 * A format record, as placed in the elfldr_logfmt section.
+		 */
+		template <uint32_t SignatureSize, uint32_t FormatSize>
+		struct alignas(4) LogRecord {
+			constexpr LogRecord(LogChannel channel, LogLevel level, uint32_t line, const char (&sig)[SignatureSize], const char (&fmt)[FormatSize])
+				: header { sizeof(LogRecord), static_cast<uint16_t>(line), static_cast<uint8_t>(channel), static_cast<uint8_t>(level), static_cast<uint8_t>(SignatureSize - 1), 0 } {
+				for(uint32_t i = 0; i < SignatureSize; ++i)
+					signature[i] = sig[i];
+				for(uint32_t i = 0; i < FormatSize; ++i)
+					format[i] = fmt[i];
+			}
+
+			LogRecordHeader header;
+			char signature[SignatureSize] {};
+			char format[FormatSize] {};
+		};
+
+		/**
+		 * Builds a frame's payload.
+		 */
+		struct LogFrame {
+			void Put32(uint32_t value);
+			void Put64(uint64_t value);
+			void PutString(const char* string);
+
+			uint8_t data[LogFrameHeaderSize + LogMaxPayloadSize];
+			uint32_t length { LogFrameHeaderSize };
+		};
+
+		/**
+		 * Finish a frame and write it to the log.
+		 */
+		void LogWriteFrame(uint32_t id, LogFrame& frame);
+
+		template <class T>
+		inline void LogPutArg(LogFrame& frame, T arg) {
+			constexpr auto code = LogArgCodeFor<T>();
+
+			if constexpr(code == LogArgCode::Double)
+				frame.Put64(mlstd::BitCast<uint64_t>(static_cast<double>(arg)));
+			else if constexpr(code == LogArgCode::Int64)
+				frame.Put64(static_cast<uint64_t>(arg));
+			else if constexpr(code == LogArgCode::String)
+				frame.PutString(arg);
+			else if constexpr(code == LogArgCode::Pointer)
+				frame.Put32(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg)));
+			else
+				frame.Put32(static_cast<uint32_t>(arg));
+		}
+
+		template <class... Args>
+		inline void LogWriteTokenized(const void* record, Args... args) {
+			LogFrame frame;
+			(LogPutArg(frame, args), ...);
+
+			// The record's address is its offset in the (unloaded) section.
+			LogWriteFrame(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(record)), frame);
+		}
+#endif
+	} // namespace detail
+
+	/**
+	 * Get if a level and channel are enabled at runtime.
+	 */
+	inline bool LogEnabled(LogChannel channel, LogLevel level) {
+		return (detail::gLogMasks[static_cast<uint32_t>(level)] & (1u << static_cast<uint32_t>(channel))) != 0;
+	}
+
+	/**
+	 * Set the lowest level a channel logs at, at runtime.
+	 * Levels which aren't compiled in stay off regardless.
+	 */
+	void LogSetLevel(LogChannel channel, LogLevel level);
+
+	/**
+	 * Turn a channel off entirely.
+	 */
+	void LogDisable(LogChannel channel);
+
+	/**
+	 * Configure channels from text, e.g. from a config file.
+	 *
+	 * The text is a list of `channel=level` or `channel=off` settings, separated by
+	 * commas, spaces or newlines. A channel of `*` sets every channel.
+	 * Names aren't case sensitive. For example: `*=info, erl=trace, profiler=off`.
+	 *
+	 * \param[in] config The configuration.
+	 * \return False if anything in it wasn't understood (the rest is still applied).
+	 */
+	bool LogConfigure(const char* config);
+
+	/**
+	 * Get the name of a channel.
+	 */
+	constexpr const char* LogChannelName(LogChannel channel) {
+		constexpr const char* names[] {
+			"general",
+			"loader",
+			"erl",
+			"hook",
+			"patch",
+			"fio",
+			"profiler"
+		};
+
+		static_assert(sizeof(names) / sizeof(names[0]) == static_cast<uint32_t>(LogChannel::Count), "Name every channel");
+
+		if(static_cast<uint32_t>(channel) >= static_cast<uint32_t>(LogChannel::Count))
+			return "?";
+		return names[static_cast<uint32_t>(channel)];
+	}
+
+} // namespace elfldr::util
+
+#ifdef ELFLDR_LOG_TOKENIZED
+	#define ELFLDR_LOG_STRINGIFY_(x) #x
+	#define ELFLDR_LOG_STRINGIFY(x) ELFLDR_LOG_STRINGIFY_(x)
+
+	// Each record gets its own section (gathered into elfldr_logfmt by the linker script);
+	// GCC refuses to mix records from inline functions (which go in COMDAT groups)
+	// and ones from regular functions in a single section.
+	#define ELFLDR_LOG_WRITE(channel, level, format, ...)                                                                                                   \
+		do {                                                                                                                                                \
+			static_cast<void>(sizeof(::elfldr::util::detail::LogCheckFormat(format, ##__VA_ARGS__)));                                                      \
+			using ElfldrLogArgs_ = decltype(::elfldr::util::detail::LogArgTypesOf(__VA_ARGS__));                                                          \
+			__attribute__((section("elfldr_logfmt." ELFLDR_LOG_STRINGIFY(__COUNTER__)), used)) static constexpr ::elfldr::util::detail::LogRecord<sizeof(ElfldrLogArgs_::Signature), sizeof(format)> \
+				elfldrLogRecord_ { channel, level, __LINE__, ElfldrLogArgs_::Signature, format };                                                          \
+			::elfldr::util::detail::LogWriteTokenized(&elfldrLogRecord_, ##__VA_ARGS__);                                                                  \
+		} while(0)
+#else
+	#define ELFLDR_LOG_WRITE(channel, level, format, ...) ::elfldr::util::detail::LogWrite(channel, level, format, ##__VA_ARGS__)
+#endif
+
+/**
+ * Log a message on a channel, at a level.
+ * The channel is the name of a LogChannel enumerator, e.g. `ELFLDR_LOG(Erl, Debug, "...")`.
+ */
+#define ELFLDR_LOG(channel, level, format, ...)                                                                                    \
+	do {                                                                                                                           \
+		if constexpr(::elfldr::util::LogCompiledIn(::elfldr::util::LogChannel::channel, ::elfldr::util::LogLevel::level)) {        \
+			if(::elfldr::util::LogEnabled(::elfldr::util::LogChannel::channel, ::elfldr::util::LogLevel::level))                   \
+				ELFLDR_LOG_WRITE(::elfldr::util::LogChannel::channel, ::elfldr::util::LogLevel::level, format, ##__VA_ARGS__);     \
+		}                                                                                                                          \
+	} while(0)
+
+#define ELFLDR_LOG_TRACE(channel, format, ...) ELFLDR_LOG(channel, Trace, format, ##__VA_ARGS__)
+#define ELFLDR_LOG_DEBUG(channel, format, ...) ELFLDR_LOG(channel, Debug, format, ##__VA_ARGS__)
+#define ELFLDR_LOG_INFO(channel, format, ...) ELFLDR_LOG(channel, Info, format, ##__VA_ARGS__)
+#define ELFLDR_LOG_WARNING(channel, format, ...) ELFLDR_LOG(channel, Warning, format, ##__VA_ARGS__)
+#define ELFLDR_LOG_ERROR(channel, format, ...) ELFLDR_LOG(channel, Error, format, ##__VA_ARGS__)
+
+#endif // ELFLDR_LOG_H
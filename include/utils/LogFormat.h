@@ -0,0 +1,96 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The binary log format.
+//
+// With ELFLDR_LOG_BINARY enabled, a log statement doesn't format anything.
+// Instead, every call site gets a record in the elfldr_logfmt section with
+// its format string and argument types, and the log just gets the address
+// of that record (its format ID), and the raw arguments.
+//
+// The linker script makes elfldr_logfmt a non-loaded section starting at 0,
+// so a record's address is its offset in the section, and none of it takes
+// up memory on the PS2. The build dumps the section to elfldr.logfmt, which
+// the logdecode host tool uses to turn a binary log back into text.
+//
+// Like the patch tables, this has no dependencies on the PS2 SDK, so
+// host tools share it.
+
+#ifndef ELFLDR_LOGFORMAT_H
+#define ELFLDR_LOGFORMAT_H
+
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	// A binary log is a stream of frames (all little endian):
+	//
+	//	uint32_t id;		// Format ID, or one of the special IDs below
+	//	uint16_t length;	// Length of the payload
+	//	uint8_t payload[length];
+	//
+	// A record's payload is its arguments, packed back to back, encoded
+	// as described by the record's signature (see LogArgCode).
+	constexpr uint32_t LogFrameHeaderSize = 6;
+
+	/**
+	 * Largest payload a frame can have. Longer strings are truncated to fit.
+	 */
+	constexpr uint32_t LogMaxPayloadSize = 256;
+
+	/**
+	 * A text line (from DebugOut(), which isn't tokenized).
+	 * The payload is the text, with no terminator.
+	 */
+	constexpr uint32_t LogTextFrameId = 0xffffffff;
+
+	/**
+	 * Written when logging starts, so a decoder can tell boots apart.
+	 * The payload is a LogBootPayload.
+	 */
+	constexpr uint32_t LogBootFrameId = 0xfffffffe;
+
+	struct LogBootPayload {
+		constexpr static uint32_t Magic = 0x474f4c4d; // 'MLOG'
+		constexpr static uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+	};
+
+	/**
+	 * How an argument is encoded in a frame.
+	 */
+	enum class LogArgCode : char {
+		Int32 = 'i',   // 4 bytes
+		Int64 = 'l',   // 8 bytes
+		Double = 'd',  // 8 bytes (floats are promoted, like varargs)
+		String = 's',  // 1-byte length, then the characters
+		Pointer = 'p', // 4 bytes
+	};
+
+	/**
+	 * Header of a format record in the elfldr_logfmt section. It's followed by the
+	 * signature (one LogArgCode per argument, and a terminator), and the format string.
+	 */
+	struct LogRecordHeader {
+		/**
+		 * Size of the whole record, including padding.
+		 */
+		uint16_t size;
+		uint16_t line;
+		uint8_t channel; // LogChannel
+		uint8_t level;	 // LogLevel
+		uint8_t argCount;
+		uint8_t reserved;
+	};
+
+	static_assert(sizeof(LogRecordHeader) == 8, "LogRecordHeader layout is part of the format");
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_LOGFORMAT_H
@@ -0,0 +1,338 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// A small constexpr assembler on top of MipsIEncoder.h, for building
+// hook stubs and other generated code at compile time.
+//
+// Usage:
+//
+//	constexpr auto stub = mips::Assemble<[](mips::Assembler& a) {
+//		auto loop = a.NewLabel();
+//		a.LoadAddress(Reg::T0, 0);		// relocation slot 0
+//		a.Bind(loop);
+//		a.Emit(addiu(Reg::A0, Reg::A0, -1));
+//		a.Branch(bne(Reg::A0, Reg::R0, 0), loop);	// delay slot gets a nop
+//		a.Jr(Reg::T0);
+//	}>();
+//
+//	stub.Link(destination, { runtimeAddress });
+//
+// Branches can target labels, forwards or backwards. Runtime addresses
+// (which aren't known at compile time) go through relocation slots, which
+// Link() fills in when the stub is copied to where it will run.
+
+#ifndef ELFLDR_MIPSASSEMBLER_H
+#define ELFLDR_MIPSASSEMBLER_H
+
+#include <mlstd/Array.h>
+#include <mlstd/Assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/MipsIEncoder.h>
+
+namespace elfldr::util::mips {
+
+	/**
+	 * Max length of a stub the assembler can build, in instructions.
+	 */
+	constexpr uint32_t MaxAssemblerLength = 256;
+	constexpr uint32_t MaxAssemblerLabels = 16;
+	constexpr uint32_t MaxAssemblerRelocs = 16;
+
+	/**
+	 * A label.
+	 */
+	struct Label {
+		uint32_t id;
+	};
+
+	enum class RelocKind : uint8_t {
+		/**
+		 * lui/ori pair loading the slot value into a register.
+		 */
+		Address,
+
+		/**
+		 * j/jal to the slot value. Checked to be reachable at link time.
+		 */
+		Jump
+	};
+
+	/**
+	 * A relocation: an instruction (or lui/ori pair) to patch with a runtime value.
+	 */
+	struct Reloc {
+		RelocKind kind;
+		uint8_t slot;
+		uint16_t index;
+	};
+
+	/**
+	 * The assembler. Only used through Assemble().
+	 */
+	struct Assembler {
+		/**
+		 * Emit a single instruction.
+		 */
+		constexpr void Emit(uint32_t insn) {
+			MLSTD_VERIFY(length < MaxAssemblerLength && "Stub too long");
+			code[length++] = insn;
+		}
+
+		constexpr Label NewLabel() {
+			MLSTD_VERIFY(labelCount < MaxAssemblerLabels && "Too many labels");
+			labels[labelCount] = Unbound;
+			return { labelCount++ };
+		}
+
+		/**
+		 * Bind a label to the next instruction.
+		 */
+		constexpr void Bind(Label label) {
+			MLSTD_VERIFY(labels[label.id] == Unbound && "Label bound twice");
+			labels[label.id] = length;
+		}
+
+		/**
+		 * Emit a branch to a label, with its delay slot.
+		 *
+		 * \param[in] branch The branch, from one of the encoders. The offset is ignored.
+		 * \param[in] target Label to branch to.
+		 * \param[in] delaySlot Delay slot instruction. Defaults to nop.
+		 */
+		constexpr void Branch(uint32_t branch, Label target, uint32_t delaySlot = nop()) {
+			MLSTD_VERIFY(fixupCount < MaxAssemblerLabels * 2 && "Too many label references");
+			fixups[fixupCount++] = { target.id, length };
+			Emit(branch & 0xffff0000);
+			Emit(delaySlot);
+		}
+
+		/**
+		 * Load a relocation slot's value into a register (lui/ori).
+		 */
+		constexpr void LoadAddress(Reg reg, uint8_t slot) {
+			AddReloc(RelocKind::Address, slot);
+			Emit(lui(reg, 0));
+			Emit(ori(reg, reg, 0));
+		}
+
+		/**
+		 * j to a relocation slot's value, with its delay slot.
+		 */
+		constexpr void JumpTo(uint8_t slot, uint32_t delaySlot = nop()) {
+			AddReloc(RelocKind::Jump, slot);
+			Emit(j(0));
+			Emit(delaySlot);
+		}
+
+		/**
+		 * jal to a relocation slot's value, with its delay slot.
+		 */
+		constexpr void CallTo(uint8_t slot, uint32_t delaySlot = nop()) {
+			AddReloc(RelocKind::Jump, slot);
+			Emit(jal(0));
+			Emit(delaySlot);
+		}
+
+		/**
+		 * jr, with its delay slot.
+		 */
+		constexpr void Jr(Reg reg, uint32_t delaySlot = nop()) {
+			Emit(jr(reg));
+			Emit(delaySlot);
+		}
+
+		/**
+		 * jalr, with its delay slot.
+		 */
+		constexpr void Jalr(Reg reg, uint32_t delaySlot = nop()) {
+			Emit(jalr(reg));
+			Emit(delaySlot);
+		}
+
+		/**
+		 * Resolve label references. Called by Assemble().
+		 */
+		constexpr void Finish() {
+			for(uint32_t i = 0; i < fixupCount; ++i) {
+				const auto& fixup = fixups[i];
+				const auto target = labels[fixup.label];
+				MLSTD_VERIFY(target != Unbound && "Branch to unbound label");
+				code[fixup.index] |= branchOffset(fixup.index * sizeof(uint32_t), target * sizeof(uint32_t));
+			}
+		}
+
+		constexpr static uint32_t Unbound = ~0u;
+
+		struct Fixup {
+			uint32_t label;
+			uint32_t index;
+		};
+
+		constexpr void AddReloc(RelocKind kind, uint8_t slot) {
+			MLSTD_VERIFY(relocCount < MaxAssemblerRelocs && "Too many relocations");
+			relocs[relocCount++] = { kind, slot, static_cast<uint16_t>(length) };
+			if(slot >= slotCount)
+				slotCount = slot + 1u;
+		}
+
+		uint32_t code[MaxAssemblerLength] {};
+		uint32_t length {};
+
+		uint32_t labels[MaxAssemblerLabels] {};
+		uint32_t labelCount {};
+
+		Fixup fixups[MaxAssemblerLabels * 2] {};
+		uint32_t fixupCount {};
+
+		Reloc relocs[MaxAssemblerRelocs] {};
+		uint32_t relocCount {};
+
+		/**
+		 * Highest relocation slot used, plus one.
+		 */
+		uint32_t slotCount {};
+	};
+
+	/**
+	 * An assembled stub.
+	 *
+	 * \tparam N Length, in instructions.
+	 * \tparam R Amount of relocations.
+	 * \tparam S Amount of relocation slots (highest slot used, plus one).
+	 */
+	template <size_t N, size_t R, size_t S>
+	struct AssembledStub {
+		constexpr static size_t Length = N;
+
+		/**
+		 * Slot values Link() needs.
+		 */
+		constexpr static size_t Slots = S;
+
+		/**
+		 * Size in bytes.
+		 */
+		constexpr static size_t Size = N * sizeof(uint32_t);
+
+		mlstd::Array<uint32_t, N> code;
+		mlstd::Array<Reloc, R ? R : 1> relocs;
+
+		/**
+		 * Patch relocations in a copy of the stub.
+		 *
+		 * \param[out] dest A copy of the code.
+		 * \param[in] address Address the stub will run from.
+		 * \param[in] slots Relocation slot values. Needs at least Slots of them.
+		 */
+		void Relocate(uint32_t* dest, uintptr_t address, const uintptr_t* slots) const {
+			for(size_t i = 0; i < R; ++i) {
+				const auto& reloc = relocs[i];
+				const auto value = static_cast<uint32_t>(slots[reloc.slot]);
+
+				switch(reloc.kind) {
+					case RelocKind::Address:
+						dest[reloc.index] = (code[reloc.index] & 0xffff0000) | (value >> 16);
+						dest[reloc.index + 1] = (code[reloc.index + 1] & 0xffff0000) | (value & 0xffff);
+						break;
+					case RelocKind::Jump: {
+						const auto pc = static_cast<uint32_t>(address + reloc.index * sizeof(uint32_t));
+						dest[reloc.index] = (code[reloc.index] & 0xfc000000) | ((checkedJumpTarget(pc, value) >> 2) & 0x03ffffff);
+					} break;
+				}
+			}
+		}
+
+		/**
+		 * Copy the stub into a buffer, and patch its relocations for
+		 * running from a different address (e.g. for writing it through the patch journal).
+		 */
+		template <size_t SlotCount>
+		void LinkAt(uint32_t* dest, uintptr_t address, const uintptr_t (&slots)[SlotCount]) const {
+			static_assert(SlotCount >= Slots, "Pass a value for every relocation slot the stub uses");
+			for(size_t i = 0; i < N; ++i)
+				dest[i] = code[i];
+			Relocate(dest, address, &slots[0]);
+		}
+
+		/**
+		 * Copy the stub to where it will run, and patch its relocations.
+		 * This doesn't flush any caches.
+		 */
+		template <size_t SlotCount>
+		void Link(uint32_t* dest, const uintptr_t (&slots)[SlotCount]) const {
+			LinkAt(dest, reinterpret_cast<uintptr_t>(dest), slots);
+		}
+
+		void Link(uint32_t* dest) const {
+			static_assert(R == 0, "Stub has relocations; pass slot values");
+			for(size_t i = 0; i < N; ++i)
+				dest[i] = code[i];
+		}
+	};
+
+	namespace detail {
+		template <auto Build>
+		constexpr Assembler RunAssembler() {
+			Assembler a {};
+			Build(a);
+			a.Finish();
+			return a;
+		}
+	} // namespace detail
+
+	/**
+	 * Assemble a stub at compile time.
+	 *
+	 * \tparam Build A constexpr callable taking an Assembler&.
+	 */
+	template <auto Build>
+	constexpr auto Assemble() {
+		constexpr auto assembler = detail::RunAssembler<Build>();
+
+		AssembledStub<assembler.length, assembler.relocCount, assembler.slotCount> stub {};
+		for(uint32_t i = 0; i < assembler.length; ++i)
+			stub.code[i] = assembler.code[i];
+		for(uint32_t i = 0; i < assembler.relocCount; ++i)
+			stub.relocs[i] = assembler.relocs[i];
+		return stub;
+	}
+
+	// clang-format off
+	namespace assembler_checks {
+		constexpr auto loop = Assemble<[](Assembler& a) {
+			auto top = a.NewLabel();
+			auto out = a.NewLabel();
+			a.Bind(top);
+			a.Branch(beq(Reg::A0, Reg::R0, 0), out);
+			a.Emit(addiu(Reg::A0, Reg::A0, -1));
+			a.Branch(b(0), top, addiu(Reg::V0, Reg::V0, 1));
+			a.Bind(out);
+			a.Jr(Reg::RA);
+		}>();
+
+		static_assert(loop.Length == 7);
+		static_assert(loop.code[0] == beq(Reg::A0, Reg::R0, 4 * 4)); // forward, to index 5
+		static_assert(loop.code[1] == nop());
+		static_assert(loop.code[3] == b(-4 * 4));					 // backward, to index 0
+		static_assert(loop.code[4] == addiu(Reg::V0, Reg::V0, 1));
+		static_assert(loop.code[5] == jr(Reg::RA) && loop.code[6] == nop());
+
+		constexpr auto reloc = Assemble<[](Assembler& a) {
+			a.LoadAddress(Reg::T0, 1);
+			a.JumpTo(0);
+		}>();
+
+		static_assert(reloc.Length == 4 && reloc.relocs[0].kind == RelocKind::Address && reloc.relocs[0].slot == 1);
+		static_assert(reloc.relocs[1].kind == RelocKind::Jump && reloc.relocs[1].index == 2);
+		static_assert(reloc.Slots == 2 && loop.Slots == 0);
+	} // namespace assembler_checks
+	// clang-format on
+
+} // namespace elfldr::util::mips
+
+#endif // ELFLDR_MIPSASSEMBLER_H
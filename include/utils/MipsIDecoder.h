@@ -0,0 +1,691 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// MIPS instruction decoder; the other half of MipsIEncoder.h.
+//
+// Covers MIPS I/II/III as implemented by the R5900 (the EE core), plus the
+// R5900 specific bits: MMI (the 128-bit multimedia instructions), the
+// pipeline 1 multiply/divide instructions, lq/sq, and the COP0/COP1/COP2
+// forms the EE has.
+//
+// Decoding is a couple of lookups in constexpr tables, keyed by the
+// opcode fields, so it's cheap enough to run over a whole .text section,
+// and usable at compile time.
+
+#ifndef ELFLDR_MIPSIDECODER_H
+#define ELFLDR_MIPSIDECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/MipsIEncoder.h>
+
+namespace elfldr::util::mips {
+
+	// clang-format off
+
+	// X(identifier, mnemonic)
+#define ELFLDR_MIPS_OPS(X) \
+	X(Invalid, "invalid") \
+	/* Primary opcodes */ \
+	X(J, "j") X(Jal, "jal") X(Beq, "beq") X(Bne, "bne") X(Blez, "blez") X(Bgtz, "bgtz") \
+	X(Addi, "addi") X(Addiu, "addiu") X(Slti, "slti") X(Sltiu, "sltiu") X(Andi, "andi") X(Ori, "ori") X(Xori, "xori") X(Lui, "lui") \
+	X(Beql, "beql") X(Bnel, "bnel") X(Blezl, "blezl") X(Bgtzl, "bgtzl") X(Daddi, "daddi") X(Daddiu, "daddiu") X(Ldl, "ldl") X(Ldr, "ldr") \
+	X(Lq, "lq") X(Sq, "sq") X(Lb, "lb") X(Lh, "lh") X(Lwl, "lwl") X(Lw, "lw") X(Lbu, "lbu") X(Lhu, "lhu") X(Lwr, "lwr") X(Lwu, "lwu") \
+	X(Sb, "sb") X(Sh, "sh") X(Swl, "swl") X(Sw, "sw") X(Sdl, "sdl") X(Sdr, "sdr") X(Swr, "swr") X(Cache, "cache") \
+	X(Lwc1, "lwc1") X(Pref, "pref") X(Lqc2, "lqc2") X(Ld, "ld") X(Swc1, "swc1") X(Sqc2, "sqc2") X(Sd, "sd") \
+	/* SPECIAL */ \
+	X(Sll, "sll") X(Srl, "srl") X(Sra, "sra") X(Sllv, "sllv") X(Srlv, "srlv") X(Srav, "srav") X(Jr, "jr") X(Jalr, "jalr") \
+	X(Movz, "movz") X(Movn, "movn") X(Syscall, "syscall") X(Break, "break") X(Sync, "sync") \
+	X(Mfhi, "mfhi") X(Mthi, "mthi") X(Mflo, "mflo") X(Mtlo, "mtlo") X(Dsllv, "dsllv") X(Dsrlv, "dsrlv") X(Dsrav, "dsrav") \
+	X(Mult, "mult") X(Multu, "multu") X(Div, "div") X(Divu, "divu") \
+	X(Add, "add") X(Addu, "addu") X(Sub, "sub") X(Subu, "subu") X(And, "and") X(Or, "or") X(Xor, "xor") X(Nor, "nor") \
+	X(Mfsa, "mfsa") X(Mtsa, "mtsa") X(Slt, "slt") X(Sltu, "sltu") X(Dadd, "dadd") X(Daddu, "daddu") X(Dsub, "dsub") X(Dsubu, "dsubu") \
+	X(Tge, "tge") X(Tgeu, "tgeu") X(Tlt, "tlt") X(Tltu, "tltu") X(Teq, "teq") X(Tne, "tne") \
+	X(Dsll, "dsll") X(Dsrl, "dsrl") X(Dsra, "dsra") X(Dsll32, "dsll32") X(Dsrl32, "dsrl32") X(Dsra32, "dsra32") \
+	/* REGIMM */ \
+	X(Bltz, "bltz") X(Bgez, "bgez") X(Bltzl, "bltzl") X(Bgezl, "bgezl") \
+	X(Tgei, "tgei") X(Tgeiu, "tgeiu") X(Tlti, "tlti") X(Tltiu, "tltiu") X(Teqi, "teqi") X(Tnei, "tnei") \
+	X(Bltzal, "bltzal") X(Bgezal, "bgezal") X(Bltzall, "bltzall") X(Bgezall, "bgezall") X(Mtsab, "mtsab") X(Mtsah, "mtsah") \
+	/* MMI */ \
+	X(Madd, "madd") X(Maddu, "maddu") X(Plzcw, "plzcw") X(Mfhi1, "mfhi1") X(Mthi1, "mthi1") X(Mflo1, "mflo1") X(Mtlo1, "mtlo1") \
+	X(Mult1, "mult1") X(Multu1, "multu1") X(Div1, "div1") X(Divu1, "divu1") X(Madd1, "madd1") X(Maddu1, "maddu1") \
+	X(Pmfhl, "pmfhl") X(Pmthl, "pmthl") X(Psllh, "psllh") X(Psrlh, "psrlh") X(Psrah, "psrah") X(Psllw, "psllw") X(Psrlw, "psrlw") X(Psraw, "psraw") \
+	/* MMI0 */ \
+	X(Paddw, "paddw") X(Psubw, "psubw") X(Pcgtw, "pcgtw") X(Pmaxw, "pmaxw") X(Paddh, "paddh") X(Psubh, "psubh") X(Pcgth, "pcgth") X(Pmaxh, "pmaxh") \
+	X(Paddb, "paddb") X(Psubb, "psubb") X(Pcgtb, "pcgtb") X(Paddsw, "paddsw") X(Psubsw, "psubsw") X(Pextlw, "pextlw") X(Ppacw, "ppacw") \
+	X(Paddsh, "paddsh") X(Psubsh, "psubsh") X(Pextlh, "pextlh") X(Ppach, "ppach") X(Paddsb, "paddsb") X(Psubsb, "psubsb") X(Pextlb, "pextlb") X(Ppacb, "ppacb") \
+	X(Pext5, "pext5") X(Ppac5, "ppac5") \
+	/* MMI1 */ \
+	X(Pabsw, "pabsw") X(Pceqw, "pceqw") X(Pminw, "pminw") X(Padsbh, "padsbh") X(Pabsh, "pabsh") X(Pceqh, "pceqh") X(Pminh, "pminh") X(Pceqb, "pceqb") \
+	X(Padduw, "padduw") X(Psubuw, "psubuw") X(Pextuw, "pextuw") X(Padduh, "padduh") X(Psubuh, "psubuh") X(Pextuh, "pextuh") \
+	X(Paddub, "paddub") X(Psubub, "psubub") X(Pextub, "pextub") X(Qfsrv, "qfsrv") \
+	/* MMI2 */ \
+	X(Pmaddw, "pmaddw") X(Psllvw, "psllvw") X(Psrlvw, "psrlvw") X(Pmsubw, "pmsubw") X(Pmfhi, "pmfhi") X(Pmflo, "pmflo") X(Pinth, "pinth") \
+	X(Pmultw, "pmultw") X(Pdivw, "pdivw") X(Pcpyld, "pcpyld") X(Pmaddh, "pmaddh") X(Phmadh, "phmadh") X(Pand, "pand") X(Pxor, "pxor") \
+	X(Pmsubh, "pmsubh") X(Phmsbh, "phmsbh") X(Pexeh, "pexeh") X(Prevh, "prevh") X(Pmulth, "pmulth") X(Pdivbw, "pdivbw") X(Pexew, "pexew") X(Prot3w, "prot3w") \
+	/* MMI3 */ \
+	X(Pmadduw, "pmadduw") X(Psravw, "psravw") X(Pmthi, "pmthi") X(Pmtlo, "pmtlo") X(Pinteh, "pinteh") X(Pmultuw, "pmultuw") X(Pdivuw, "pdivuw") \
+	X(Pcpyud, "pcpyud") X(Por, "por") X(Pnor, "pnor") X(Pexch, "pexch") X(Pcpyh, "pcpyh") X(Pexcw, "pexcw") \
+	/* COP0 */ \
+	X(Mfc0, "mfc0") X(Mtc0, "mtc0") X(Bc0f, "bc0f") X(Bc0t, "bc0t") X(Bc0fl, "bc0fl") X(Bc0tl, "bc0tl") \
+	X(Tlbr, "tlbr") X(Tlbwi, "tlbwi") X(Tlbwr, "tlbwr") X(Tlbp, "tlbp") X(Eret, "eret") X(Ei, "ei") X(Di, "di") \
+	/* COP1 */ \
+	X(Mfc1, "mfc1") X(Cfc1, "cfc1") X(Mtc1, "mtc1") X(Ctc1, "ctc1") X(Bc1f, "bc1f") X(Bc1t, "bc1t") X(Bc1fl, "bc1fl") X(Bc1tl, "bc1tl") \
+	X(AddS, "add.s") X(SubS, "sub.s") X(MulS, "mul.s") X(DivS, "div.s") X(SqrtS, "sqrt.s") X(AbsS, "abs.s") X(MovS, "mov.s") X(NegS, "neg.s") \
+	X(RsqrtS, "rsqrt.s") X(AddaS, "adda.s") X(SubaS, "suba.s") X(MulaS, "mula.s") X(MaddS, "madd.s") X(MsubS, "msub.s") X(MaddaS, "madda.s") X(MsubaS, "msuba.s") \
+	X(CvtWS, "cvt.w.s") X(MaxS, "max.s") X(MinS, "min.s") X(CFS, "c.f.s") X(CEqS, "c.eq.s") X(CLtS, "c.lt.s") X(CLeS, "c.le.s") X(CvtSW, "cvt.s.w") \
+	/* COP2 (VU0 macro mode) */ \
+	X(Qmfc2, "qmfc2") X(Cfc2, "cfc2") X(Qmtc2, "qmtc2") X(Ctc2, "ctc2") X(Bc2f, "bc2f") X(Bc2t, "bc2t") X(Bc2fl, "bc2fl") X(Bc2tl, "bc2tl") \
+	X(Vu0Macro, "vu0macro")
+
+	// clang-format on
+
+	/**
+	 * Decoded opcodes.
+	 */
+	enum class Op : uint16_t {
+#define X(id, name) id,
+		ELFLDR_MIPS_OPS(X)
+#undef X
+		Count
+	};
+
+	/**
+	 * Get the mnemonic for an opcode.
+	 */
+	constexpr const char* OpName(Op op) {
+		constexpr const char* names[] {
+#define X(id, name) name,
+			ELFLDR_MIPS_OPS(X)
+#undef X
+		};
+		return static_cast<uint16_t>(op) < static_cast<uint16_t>(Op::Count) ? names[static_cast<uint16_t>(op)] : "invalid";
+	}
+
+#undef ELFLDR_MIPS_OPS
+
+	/**
+	 * Broad instruction classes.
+	 */
+	enum class OpClass : uint8_t {
+		Invalid,
+		Alu,
+		Shift,
+
+		/**
+		 * Multiply/divide, and HI/LO (and HI1/LO1, SA) moves.
+		 */
+		MulDiv,
+		Load,
+		Store,
+
+		/**
+		 * PC-relative conditional branch.
+		 */
+		Branch,
+
+		/**
+		 * j/jal: absolute within the current 256MB segment.
+		 */
+		Jump,
+
+		/**
+		 * jr/jalr.
+		 */
+		JumpRegister,
+		Trap,
+
+		/**
+		 * syscall, break, sync, cache, pref, and COP0 control.
+		 */
+		System,
+
+		/**
+		 * MMI parallel (128-bit) operations.
+		 */
+		Parallel,
+		Cop0,
+		Fpu,
+		Cop2
+	};
+
+	/**
+	 * Decoded instruction flags.
+	 */
+	enum OpFlags : uint8_t {
+		/**
+		 * Has a delay slot (all branches and jumps).
+		 */
+		OpFlag_DelaySlot = 0x1,
+
+		/**
+		 * Branch likely; the delay slot only runs if the branch is taken.
+		 */
+		OpFlag_Likely = 0x2,
+
+		/**
+		 * Writes a return address (jal, jalr, b*al).
+		 */
+		OpFlag_Link = 0x4,
+
+		/**
+		 * The immediate is sign extended.
+		 */
+		OpFlag_SignedImm = 0x8,
+
+		/**
+		 * The immediate is zero extended.
+		 */
+		OpFlag_UnsignedImm = 0x10,
+	};
+
+	/**
+	 * A decoded instruction.
+	 *
+	 * The raw register fields are always filled out. For FPU instructions,
+	 * fs is in rd, ft is in rt, and fd is in sa.
+	 */
+	struct Instruction {
+		uint32_t word;
+		Op op;
+		OpClass opClass;
+		uint8_t flags;
+
+		Reg rs;
+		Reg rt;
+		Reg rd;
+		uint8_t sa;
+
+		/**
+		 * The immediate, extended according to the flags. 0 if there is none.
+		 */
+		int32_t imm;
+
+		/**
+		 * The branch or jump target, for Branch and Jump instructions.
+		 */
+		uint32_t target;
+
+		constexpr bool Valid() const {
+			return op != Op::Invalid;
+		}
+
+		constexpr bool HasDelaySlot() const {
+			return flags & OpFlag_DelaySlot;
+		}
+	};
+
+	namespace detail {
+
+		struct OpInfo {
+			Op op;
+			OpClass opClass;
+			uint8_t flags;
+		};
+
+		template <uint32_t N>
+		struct OpTable {
+			OpInfo entries[N];
+		};
+
+		constexpr uint8_t Imm = OpFlag_SignedImm;
+		constexpr uint8_t UImm = OpFlag_UnsignedImm;
+		constexpr uint8_t Br = OpFlag_DelaySlot | OpFlag_SignedImm;
+		constexpr uint8_t BrL = Br | OpFlag_Likely;
+		constexpr uint8_t BrAl = Br | OpFlag_Link;
+
+		// Escapes into the sub-tables. These never make it out of Decode().
+		enum class Escape : uint16_t {
+			Special = static_cast<uint16_t>(Op::Count) + 1,
+			Regimm,
+			Mmi,
+			Mmi0,
+			Mmi1,
+			Mmi2,
+			Mmi3,
+			Cop0,
+			Cop1,
+			Cop2
+		};
+
+		constexpr OpInfo EscapeTo(Escape escape) {
+			return { static_cast<Op>(escape), OpClass::Invalid, 0 };
+		}
+
+		constexpr auto MakePrimaryTable() {
+			OpTable<64> t {};
+			auto* e = &t.entries[0];
+			e[0x00] = EscapeTo(Escape::Special);
+			e[0x01] = EscapeTo(Escape::Regimm);
+			e[0x02] = { Op::J, OpClass::Jump, OpFlag_DelaySlot };
+			e[0x03] = { Op::Jal, OpClass::Jump, OpFlag_DelaySlot | OpFlag_Link };
+			e[0x04] = { Op::Beq, OpClass::Branch, Br };
+			e[0x05] = { Op::Bne, OpClass::Branch, Br };
+			e[0x06] = { Op::Blez, OpClass::Branch, Br };
+			e[0x07] = { Op::Bgtz, OpClass::Branch, Br };
+			e[0x08] = { Op::Addi, OpClass::Alu, Imm };
+			e[0x09] = { Op::Addiu, OpClass::Alu, Imm };
+			e[0x0a] = { Op::Slti, OpClass::Alu, Imm };
+			e[0x0b] = { Op::Sltiu, OpClass::Alu, Imm }; // Sign extended, then compared unsigned.
+			e[0x0c] = { Op::Andi, OpClass::Alu, UImm };
+			e[0x0d] = { Op::Ori, OpClass::Alu, UImm };
+			e[0x0e] = { Op::Xori, OpClass::Alu, UImm };
+			e[0x0f] = { Op::Lui, OpClass::Alu, UImm };
+			e[0x10] = EscapeTo(Escape::Cop0);
+			e[0x11] = EscapeTo(Escape::Cop1);
+			e[0x12] = EscapeTo(Escape::Cop2);
+			e[0x14] = { Op::Beql, OpClass::Branch, BrL };
+			e[0x15] = { Op::Bnel, OpClass::Branch, BrL };
+			e[0x16] = { Op::Blezl, OpClass::Branch, BrL };
+			e[0x17] = { Op::Bgtzl, OpClass::Branch, BrL };
+			e[0x18] = { Op::Daddi, OpClass::Alu, Imm };
+			e[0x19] = { Op::Daddiu, OpClass::Alu, Imm };
+			e[0x1a] = { Op::Ldl, OpClass::Load, Imm };
+			e[0x1b] = { Op::Ldr, OpClass::Load, Imm };
+			e[0x1c] = EscapeTo(Escape::Mmi);
+			e[0x1e] = { Op::Lq, OpClass::Load, Imm };
+			e[0x1f] = { Op::Sq, OpClass::Store, Imm };
+			e[0x20] = { Op::Lb, OpClass::Load, Imm };
+			e[0x21] = { Op::Lh, OpClass::Load, Imm };
+			e[0x22] = { Op::Lwl, OpClass::Load, Imm };
+			e[0x23] = { Op::Lw, OpClass::Load, Imm };
+			e[0x24] = { Op::Lbu, OpClass::Load, Imm };
+			e[0x25] = { Op::Lhu, OpClass::Load, Imm };
+			e[0x26] = { Op::Lwr, OpClass::Load, Imm };
+			e[0x27] = { Op::Lwu, OpClass::Load, Imm };
+			e[0x28] = { Op::Sb, OpClass::Store, Imm };
+			e[0x29] = { Op::Sh, OpClass::Store, Imm };
+			e[0x2a] = { Op::Swl, OpClass::Store, Imm };
+			e[0x2b] = { Op::Sw, OpClass::Store, Imm };
+			e[0x2c] = { Op::Sdl, OpClass::Store, Imm };
+			e[0x2d] = { Op::Sdr, OpClass::Store, Imm };
+			e[0x2e] = { Op::Swr, OpClass::Store, Imm };
+			e[0x2f] = { Op::Cache, OpClass::System, Imm };
+			e[0x31] = { Op::Lwc1, OpClass::Load, Imm };
+			e[0x33] = { Op::Pref, OpClass::System, Imm };
+			e[0x36] = { Op::Lqc2, OpClass::Load, Imm };
+			e[0x37] = { Op::Ld, OpClass::Load, Imm };
+			e[0x39] = { Op::Swc1, OpClass::Store, Imm };
+			e[0x3e] = { Op::Sqc2, OpClass::Store, Imm };
+			e[0x3f] = { Op::Sd, OpClass::Store, Imm };
+			return t;
+		}
+
+		// SPECIAL, keyed by funct.
+		constexpr auto MakeSpecialTable() {
+			OpTable<64> t {};
+			auto* e = &t.entries[0];
+			e[0x00] = { Op::Sll, OpClass::Shift, 0 };
+			e[0x02] = { Op::Srl, OpClass::Shift, 0 };
+			e[0x03] = { Op::Sra, OpClass::Shift, 0 };
+			e[0x04] = { Op::Sllv, OpClass::Shift, 0 };
+			e[0x06] = { Op::Srlv, OpClass::Shift, 0 };
+			e[0x07] = { Op::Srav, OpClass::Shift, 0 };
+			e[0x08] = { Op::Jr, OpClass::JumpRegister, OpFlag_DelaySlot };
+			e[0x09] = { Op::Jalr, OpClass::JumpRegister, OpFlag_DelaySlot | OpFlag_Link };
+			e[0x0a] = { Op::Movz, OpClass::Alu, 0 };
+			e[0x0b] = { Op::Movn, OpClass::Alu, 0 };
+			e[0x0c] = { Op::Syscall, OpClass::System, 0 };
+			e[0x0d] = { Op::Break, OpClass::System, 0 };
+			e[0x0f] = { Op::Sync, OpClass::System, 0 };
+			e[0x10] = { Op::Mfhi, OpClass::MulDiv, 0 };
+			e[0x11] = { Op::Mthi, OpClass::MulDiv, 0 };
+			e[0x12] = { Op::Mflo, OpClass::MulDiv, 0 };
+			e[0x13] = { Op::Mtlo, OpClass::MulDiv, 0 };
+			e[0x14] = { Op::Dsllv, OpClass::Shift, 0 };
+			e[0x16] = { Op::Dsrlv, OpClass::Shift, 0 };
+			e[0x17] = { Op::Dsrav, OpClass::Shift, 0 };
+			e[0x18] = { Op::Mult, OpClass::MulDiv, 0 };
+			e[0x19] = { Op::Multu, OpClass::MulDiv, 0 };
+			e[0x1a] = { Op::Div, OpClass::MulDiv, 0 };
+			e[0x1b] = { Op::Divu, OpClass::MulDiv, 0 };
+			e[0x20] = { Op::Add, OpClass::Alu, 0 };
+			e[0x21] = { Op::Addu, OpClass::Alu, 0 };
+			e[0x22] = { Op::Sub, OpClass::Alu, 0 };
+			e[0x23] = { Op::Subu, OpClass::Alu, 0 };
+			e[0x24] = { Op::And, OpClass::Alu, 0 };
+			e[0x25] = { Op::Or, OpClass::Alu, 0 };
+			e[0x26] = { Op::Xor, OpClass::Alu, 0 };
+			e[0x27] = { Op::Nor, OpClass::Alu, 0 };
+			e[0x28] = { Op::Mfsa, OpClass::MulDiv, 0 };
+			e[0x29] = { Op::Mtsa, OpClass::MulDiv, 0 };
+			e[0x2a] = { Op::Slt, OpClass::Alu, 0 };
+			e[0x2b] = { Op::Sltu, OpClass::Alu, 0 };
+			e[0x2c] = { Op::Dadd, OpClass::Alu, 0 };
+			e[0x2d] = { Op::Daddu, OpClass::Alu, 0 };
+			e[0x2e] = { Op::Dsub, OpClass::Alu, 0 };
+			e[0x2f] = { Op::Dsubu, OpClass::Alu, 0 };
+			e[0x30] = { Op::Tge, OpClass::Trap, 0 };
+			e[0x31] = { Op::Tgeu, OpClass::Trap, 0 };
+			e[0x32] = { Op::Tlt, OpClass::Trap, 0 };
+			e[0x33] = { Op::Tltu, OpClass::Trap, 0 };
+			e[0x34] = { Op::Teq, OpClass::Trap, 0 };
+			e[0x36] = { Op::Tne, OpClass::Trap, 0 };
+			e[0x38] = { Op::Dsll, OpClass::Shift, 0 };
+			e[0x3a] = { Op::Dsrl, OpClass::Shift, 0 };
+			e[0x3b] = { Op::Dsra, OpClass::Shift, 0 };
+			e[0x3c] = { Op::Dsll32, OpClass::Shift, 0 };
+			e[0x3e] = { Op::Dsrl32, OpClass::Shift, 0 };
+			e[0x3f] = { Op::Dsra32, OpClass::Shift, 0 };
+			return t;
+		}
+
+		// REGIMM, keyed by rt.
+		constexpr auto MakeRegimmTable() {
+			OpTable<32> t {};
+			auto* e = &t.entries[0];
+			e[0x00] = { Op::Bltz, OpClass::Branch, Br };
+			e[0x01] = { Op::Bgez, OpClass::Branch, Br };
+			e[0x02] = { Op::Bltzl, OpClass::Branch, BrL };
+			e[0x03] = { Op::Bgezl, OpClass::Branch, BrL };
+			e[0x08] = { Op::Tgei, OpClass::Trap, Imm };
+			e[0x09] = { Op::Tgeiu, OpClass::Trap, Imm };
+			e[0x0a] = { Op::Tlti, OpClass::Trap, Imm };
+			e[0x0b] = { Op::Tltiu, OpClass::Trap, Imm };
+			e[0x0c] = { Op::Teqi, OpClass::Trap, Imm };
+			e[0x0e] = { Op::Tnei, OpClass::Trap, Imm };
+			e[0x10] = { Op::Bltzal, OpClass::Branch, BrAl };
+			e[0x11] = { Op::Bgezal, OpClass::Branch, BrAl };
+			e[0x12] = { Op::Bltzall, OpClass::Branch, BrAl | OpFlag_Likely };
+			e[0x13] = { Op::Bgezall, OpClass::Branch, BrAl | OpFlag_Likely };
+			e[0x18] = { Op::Mtsab, OpClass::MulDiv, UImm };
+			e[0x19] = { Op::Mtsah, OpClass::MulDiv, UImm };
+			return t;
+		}
+
+		// MMI, keyed by funct.
+		constexpr auto MakeMmiTable() {
+			OpTable<64> t {};
+			auto* e = &t.entries[0];
+			e[0x00] = { Op::Madd, OpClass::MulDiv, 0 };
+			e[0x01] = { Op::Maddu, OpClass::MulDiv, 0 };
+			e[0x04] = { Op::Plzcw, OpClass::Parallel, 0 };
+			e[0x08] = EscapeTo(Escape::Mmi0);
+			e[0x09] = EscapeTo(Escape::Mmi2);
+			e[0x10] = { Op::Mfhi1, OpClass::MulDiv, 0 };
+			e[0x11] = { Op::Mthi1, OpClass::MulDiv, 0 };
+			e[0x12] = { Op::Mflo1, OpClass::MulDiv, 0 };
+			e[0x13] = { Op::Mtlo1, OpClass::MulDiv, 0 };
+			e[0x18] = { Op::Mult1, OpClass::MulDiv, 0 };
+			e[0x19] = { Op::Multu1, OpClass::MulDiv, 0 };
+			e[0x1a] = { Op::Div1, OpClass::MulDiv, 0 };
+			e[0x1b] = { Op::Divu1, OpClass::MulDiv, 0 };
+			e[0x20] = { Op::Madd1, OpClass::MulDiv, 0 };
+			e[0x21] = { Op::Maddu1, OpClass::MulDiv, 0 };
+			e[0x28] = EscapeTo(Escape::Mmi1);
+			e[0x29] = EscapeTo(Escape::Mmi3);
+			e[0x30] = { Op::Pmfhl, OpClass::Parallel, 0 };
+			e[0x31] = { Op::Pmthl, OpClass::Parallel, 0 };
+			e[0x34] = { Op::Psllh, OpClass::Parallel, 0 };
+			e[0x36] = { Op::Psrlh, OpClass::Parallel, 0 };
+			e[0x37] = { Op::Psrah, OpClass::Parallel, 0 };
+			e[0x3c] = { Op::Psllw, OpClass::Parallel, 0 };
+			e[0x3e] = { Op::Psrlw, OpClass::Parallel, 0 };
+			e[0x3f] = { Op::Psraw, OpClass::Parallel, 0 };
+			return t;
+		}
+
+		struct ParallelOp {
+			uint8_t sa;
+			Op op;
+		};
+
+		// MMI0-3 are all keyed by the sa field. Everything in them is a parallel op.
+		template <size_t N>
+		constexpr auto MakeParallelTable(const ParallelOp (&ops)[N]) {
+			OpTable<32> t {};
+			for(size_t i = 0; i < N; ++i)
+				t.entries[ops[i].sa] = { ops[i].op, OpClass::Parallel, 0 };
+			return t;
+		}
+
+		// clang-format off
+		constexpr ParallelOp mmi0Ops[] {
+			{ 0x00, Op::Paddw }, { 0x01, Op::Psubw }, { 0x02, Op::Pcgtw }, { 0x03, Op::Pmaxw },
+			{ 0x04, Op::Paddh }, { 0x05, Op::Psubh }, { 0x06, Op::Pcgth }, { 0x07, Op::Pmaxh },
+			{ 0x08, Op::Paddb }, { 0x09, Op::Psubb }, { 0x0a, Op::Pcgtb },
+			{ 0x10, Op::Paddsw }, { 0x11, Op::Psubsw }, { 0x12, Op::Pextlw }, { 0x13, Op::Ppacw },
+			{ 0x14, Op::Paddsh }, { 0x15, Op::Psubsh }, { 0x16, Op::Pextlh }, { 0x17, Op::Ppach },
+			{ 0x18, Op::Paddsb }, { 0x19, Op::Psubsb }, { 0x1a, Op::Pextlb }, { 0x1b, Op::Ppacb },
+			{ 0x1e, Op::Pext5 }, { 0x1f, Op::Ppac5 }
+		};
+
+		constexpr ParallelOp mmi1Ops[] {
+			{ 0x01, Op::Pabsw }, { 0x02, Op::Pceqw }, { 0x03, Op::Pminw }, { 0x04, Op::Padsbh },
+			{ 0x05, Op::Pabsh }, { 0x06, Op::Pceqh }, { 0x07, Op::Pminh }, { 0x0a, Op::Pceqb },
+			{ 0x10, Op::Padduw }, { 0x11, Op::Psubuw }, { 0x12, Op::Pextuw },
+			{ 0x14, Op::Padduh }, { 0x15, Op::Psubuh }, { 0x16, Op::Pextuh },
+			{ 0x18, Op::Paddub }, { 0x19, Op::Psubub }, { 0x1a, Op::Pextub }, { 0x1b, Op::Qfsrv }
+		};
+
+		constexpr ParallelOp mmi2Ops[] {
+			{ 0x00, Op::Pmaddw }, { 0x02, Op::Psllvw }, { 0x03, Op::Psrlvw }, { 0x04, Op::Pmsubw },
+			{ 0x08, Op::Pmfhi }, { 0x09, Op::Pmflo }, { 0x0a, Op::Pinth }, { 0x0c, Op::Pmultw },
+			{ 0x0d, Op::Pdivw }, { 0x0e, Op::Pcpyld }, { 0x10, Op::Pmaddh }, { 0x11, Op::Phmadh },
+			{ 0x12, Op::Pand }, { 0x13, Op::Pxor }, { 0x14, Op::Pmsubh }, { 0x15, Op::Phmsbh },
+			{ 0x1a, Op::Pexeh }, { 0x1b, Op::Prevh }, { 0x1c, Op::Pmulth }, { 0x1d, Op::Pdivbw },
+			{ 0x1e, Op::Pexew }, { 0x1f, Op::Prot3w }
+		};
+
+		constexpr ParallelOp mmi3Ops[] {
+			{ 0x00, Op::Pmadduw }, { 0x03, Op::Psravw }, { 0x08, Op::Pmthi }, { 0x09, Op::Pmtlo },
+			{ 0x0a, Op::Pinteh }, { 0x0c, Op::Pmultuw }, { 0x0d, Op::Pdivuw }, { 0x0e, Op::Pcpyud },
+			{ 0x12, Op::Por }, { 0x13, Op::Pnor }, { 0x1a, Op::Pexch }, { 0x1b, Op::Pcpyh },
+			{ 0x1e, Op::Pexcw }
+		};
+		// clang-format on
+
+		// COP1 S format, keyed by funct.
+		constexpr auto MakeFpuTable() {
+			OpTable<64> t {};
+			auto* e = &t.entries[0];
+			e[0x00] = { Op::AddS, OpClass::Fpu, 0 };
+			e[0x01] = { Op::SubS, OpClass::Fpu, 0 };
+			e[0x02] = { Op::MulS, OpClass::Fpu, 0 };
+			e[0x03] = { Op::DivS, OpClass::Fpu, 0 };
+			e[0x04] = { Op::SqrtS, OpClass::Fpu, 0 };
+			e[0x05] = { Op::AbsS, OpClass::Fpu, 0 };
+			e[0x06] = { Op::MovS, OpClass::Fpu, 0 };
+			e[0x07] = { Op::NegS, OpClass::Fpu, 0 };
+			e[0x16] = { Op::RsqrtS, OpClass::Fpu, 0 };
+			e[0x18] = { Op::AddaS, OpClass::Fpu, 0 };
+			e[0x19] = { Op::SubaS, OpClass::Fpu, 0 };
+			e[0x1a] = { Op::MulaS, OpClass::Fpu, 0 };
+			e[0x1c] = { Op::MaddS, OpClass::Fpu, 0 };
+			e[0x1d] = { Op::MsubS, OpClass::Fpu, 0 };
+			e[0x1e] = { Op::MaddaS, OpClass::Fpu, 0 };
+			e[0x1f] = { Op::MsubaS, OpClass::Fpu, 0 };
+			e[0x24] = { Op::CvtWS, OpClass::Fpu, 0 };
+			e[0x28] = { Op::MaxS, OpClass::Fpu, 0 };
+			e[0x29] = { Op::MinS, OpClass::Fpu, 0 };
+			e[0x30] = { Op::CFS, OpClass::Fpu, 0 };
+			e[0x32] = { Op::CEqS, OpClass::Fpu, 0 };
+			e[0x34] = { Op::CLtS, OpClass::Fpu, 0 };
+			e[0x36] = { Op::CLeS, OpClass::Fpu, 0 };
+			return t;
+		}
+
+		constexpr auto primaryTable = MakePrimaryTable();
+		constexpr auto specialTable = MakeSpecialTable();
+		constexpr auto regimmTable = MakeRegimmTable();
+		constexpr auto mmiTable = MakeMmiTable();
+		constexpr auto mmi0Table = MakeParallelTable(mmi0Ops);
+		constexpr auto mmi1Table = MakeParallelTable(mmi1Ops);
+		constexpr auto mmi2Table = MakeParallelTable(mmi2Ops);
+		constexpr auto mmi3Table = MakeParallelTable(mmi3Ops);
+		constexpr auto fpuTable = MakeFpuTable();
+
+		// BCx branches, keyed by rt, per coprocessor.
+		constexpr Op copBranchOps[3][4] {
+			{ Op::Bc0f, Op::Bc0t, Op::Bc0fl, Op::Bc0tl },
+			{ Op::Bc1f, Op::Bc1t, Op::Bc1fl, Op::Bc1tl },
+			{ Op::Bc2f, Op::Bc2t, Op::Bc2fl, Op::Bc2tl }
+		};
+
+		/**
+		 * Decode the coprocessor opcodes, which are keyed by rs and then
+		 * something else depending on rs. Not worth a table per coprocessor.
+		 */
+		constexpr OpInfo DecodeCop(uint32_t cop, uint32_t word) {
+			const auto rs = (word >> 21) & 0x1f;
+			const auto rt = (word >> 16) & 0x1f;
+			const auto funct = word & 0x3f;
+
+			if(rs == 0x08) {
+				if(rt > 3)
+					return {};
+				return { copBranchOps[cop][rt], OpClass::Branch, static_cast<uint8_t>((rt & 2) ? BrL : Br) };
+			}
+
+			switch(cop) {
+				case 0:
+					if(rs == 0x00)
+						return { Op::Mfc0, OpClass::Cop0, 0 };
+					if(rs == 0x04)
+						return { Op::Mtc0, OpClass::Cop0, 0 };
+					if(rs == 0x10) {
+						switch(funct) {
+							case 0x01: return { Op::Tlbr, OpClass::System, 0 };
+							case 0x02: return { Op::Tlbwi, OpClass::System, 0 };
+							case 0x06: return { Op::Tlbwr, OpClass::System, 0 };
+							case 0x08: return { Op::Tlbp, OpClass::System, 0 };
+							case 0x18: return { Op::Eret, OpClass::System, 0 };
+							case 0x38: return { Op::Ei, OpClass::System, 0 };
+							case 0x39: return { Op::Di, OpClass::System, 0 };
+							default: return {};
+						}
+					}
+					return {};
+
+				case 1:
+					switch(rs) {
+						case 0x00: return { Op::Mfc1, OpClass::Fpu, 0 };
+						case 0x02: return { Op::Cfc1, OpClass::Fpu, 0 };
+						case 0x04: return { Op::Mtc1, OpClass::Fpu, 0 };
+						case 0x06: return { Op::Ctc1, OpClass::Fpu, 0 };
+						case 0x10: return fpuTable.entries[funct];
+						case 0x14: return funct == 0x20 ? OpInfo { Op::CvtSW, OpClass::Fpu, 0 } : OpInfo {};
+						default: return {};
+					}
+
+				default:
+					switch(rs) {
+						case 0x01: return { Op::Qmfc2, OpClass::Cop2, 0 };
+						case 0x02: return { Op::Cfc2, OpClass::Cop2, 0 };
+						case 0x05: return { Op::Qmtc2, OpClass::Cop2, 0 };
+						case 0x06: return { Op::Ctc2, OpClass::Cop2, 0 };
+						default:
+							// rs >= 0x10 is a VU0 macro mode instruction. Not decoded further.
+							return rs >= 0x10 ? OpInfo { Op::Vu0Macro, OpClass::Cop2, 0 } : OpInfo {};
+					}
+			}
+		}
+
+		constexpr OpInfo Lookup(uint32_t word) {
+			const auto funct = word & 0x3f;
+			const auto sa = (word >> 6) & 0x1f;
+
+			auto info = primaryTable.entries[word >> 26];
+			switch(static_cast<Escape>(info.op)) {
+				case Escape::Special:
+					return specialTable.entries[funct];
+				case Escape::Regimm:
+					return regimmTable.entries[(word >> 16) & 0x1f];
+				case Escape::Cop0:
+					return DecodeCop(0, word);
+				case Escape::Cop1:
+					return DecodeCop(1, word);
+				case Escape::Cop2:
+					return DecodeCop(2, word);
+				case Escape::Mmi:
+					info = mmiTable.entries[funct];
+					switch(static_cast<Escape>(info.op)) {
+						case Escape::Mmi0: return mmi0Table.entries[sa];
+						case Escape::Mmi1: return mmi1Table.entries[sa];
+						case Escape::Mmi2: return mmi2Table.entries[sa];
+						case Escape::Mmi3: return mmi3Table.entries[sa];
+						default: return info;
+					}
+				default:
+					return info;
+			}
+		}
+
+	} // namespace detail
+
+	/**
+	 * Decode an instruction.
+	 *
+	 * \param[in] word The instruction word.
+	 * \param[in] pc Address of the instruction, for computing branch targets.
+	 */
+	constexpr Instruction Decode(uint32_t word, uint32_t pc = 0) {
+		const auto info = detail::Lookup(word);
+
+		Instruction insn {};
+		insn.word = word;
+		insn.op = info.op;
+		insn.opClass = info.opClass;
+		insn.flags = info.flags;
+		insn.rs = static_cast<Reg>((word >> 21) & 0x1f);
+		insn.rt = static_cast<Reg>((word >> 16) & 0x1f);
+		insn.rd = static_cast<Reg>((word >> 11) & 0x1f);
+		insn.sa = static_cast<uint8_t>((word >> 6) & 0x1f);
+
+		if(info.flags & OpFlag_SignedImm)
+			insn.imm = static_cast<int16_t>(word & 0xffff);
+		else if(info.flags & OpFlag_UnsignedImm)
+			insn.imm = static_cast<int32_t>(word & 0xffff);
+
+		if(info.opClass == OpClass::Branch)
+			insn.target = pc + 4 + static_cast<uint32_t>(insn.imm * 4);
+		else if(info.opClass == OpClass::Jump)
+			insn.target = ((pc + 4) & 0xf0000000) | ((word & 0x03ffffff) << 2);
+
+		return insn;
+	}
+
+	// Round trips against the encoder.
+	static_assert(Decode(nop()).op == Op::Sll);
+	static_assert(Decode(addiu(Reg::SP, Reg::SP, -0x30)).op == Op::Addiu && Decode(addiu(Reg::SP, Reg::SP, -0x30)).imm == -0x30);
+	static_assert(Decode(addiu(Reg::SP, Reg::SP, -0x30)).rt == Reg::SP && Decode(addiu(Reg::SP, Reg::SP, -0x30)).rs == Reg::SP);
+	static_assert(Decode(ori(Reg::T0, Reg::T0, 0x8000)).imm == 0x8000);
+	static_assert(Decode(lui(Reg::T0, 0x0020)).op == Op::Lui);
+	static_assert(Decode(lw(Reg::V0, 0x10, Reg::GP)).opClass == OpClass::Load && Decode(lw(Reg::V0, 0x10, Reg::GP)).rs == Reg::GP);
+	static_assert(Decode(sw(Reg::RA, -4, Reg::SP)).opClass == OpClass::Store && Decode(sw(Reg::RA, -4, Reg::SP)).imm == -4);
+	static_assert(Decode(addu(Reg::V0, Reg::A0, Reg::A1)).op == Op::Addu && Decode(addu(Reg::V0, Reg::A0, Reg::A1)).rd == Reg::V0);
+	static_assert(Decode(sra(Reg::V0, Reg::V0, 3)).op == Op::Sra && Decode(sra(Reg::V0, Reg::V0, 3)).sa == 3);
+	static_assert(Decode(mult(Reg::A0, Reg::A1)).opClass == OpClass::MulDiv);
+	static_assert(Decode(jr(Reg::RA)).op == Op::Jr && Decode(jr(Reg::RA)).HasDelaySlot());
+	static_assert(Decode(jalr(Reg::T9)).op == Op::Jalr && (Decode(jalr(Reg::T9)).flags & OpFlag_Link));
+	static_assert(Decode(beq(Reg::A0, Reg::R0, 0x40), 0x00100000).target == 0x00100044);
+	static_assert(Decode(bne(Reg::A0, Reg::R0, -8), 0x00100000).target == 0x00100000 - 4);
+	static_assert(Decode(bgezal(Reg::R0, 0x100)).op == Op::Bgezal && (Decode(bgezal(Reg::R0, 0x100)).flags & OpFlag_Link));
+	static_assert(Decode(bltz(Reg::A0, 8)).op == Op::Bltz);
+	static_assert(Decode(j(0x00123450), 0x00100000).target == 0x00123450);
+	static_assert(Decode(jal(0x00123450), 0x00100000).op == Op::Jal);
+	static_assert(Decode(syscall()).op == Op::Syscall);
+	static_assert(Decode(brk(0)).op == Op::Break);
+
+	// R5900 specific encodings, from the EE core instruction set manual.
+	static_assert(Decode(0x7c000000).op == Op::Sq);		// sq zero, 0(zero)
+	static_assert(Decode(0x78000000).op == Op::Lq);		// lq zero, 0(zero)
+	static_assert(Decode(0x70000488).op == Op::Pextlw); // pextlw zero, zero, zero
+	static_assert(Decode(0x700004a9).op == Op::Por);	// por zero, zero, zero
+	static_assert(Decode(0x70000018).op == Op::Mult1);	// mult1 zero, zero
+	static_assert(Decode(0x70000004).op == Op::Plzcw);	// plzcw zero, zero
+	static_assert(Decode(0x70000209).op == Op::Pmfhi);	// pmfhi zero
+	static_assert(Decode(0x40094800).op == Op::Mfc0);	// mfc0 t1, $9 (Count)
+	static_assert(Decode(0x42000039).op == Op::Di);
+	static_assert(Decode(0x45000004).op == Op::Bc1f && Decode(0x45000004).opClass == OpClass::Branch);
+	static_assert(Decode(0x46000000).op == Op::AddS);
+	static_assert(Decode(0xfc000000).op == Op::Sd);
+	static_assert(Decode(0x4c000000).op == Op::Invalid); // COP3 doesn't exist on the EE
+
+} // namespace elfldr::util::mips
+
+#endif // ELFLDR_MIPSIDECODER_H
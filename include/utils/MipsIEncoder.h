@@ -14,6 +14,7 @@
 #ifndef ELFLDR_MIPSIENCODER_H
 #define ELFLDR_MIPSIENCODER_H
 
+#include <mlstd/Assert.h>
 #include <stdint.h>
 
 namespace elfldr::util::mips {
@@ -344,6 +345,318 @@ namespace elfldr::util::mips {
 		return 0x0;
 	}
 
+	// Jumps and branches with computed targets.
+	//
+	// These check that the target is reachable, and fail to compile if it isn't
+	// (or MLSTD_VERIFY, if they're run at runtime).
+
+	/**
+	 * Check that a j/jal at pc can reach target.
+	 */
+	constexpr uint32_t checkedJumpTarget(uint32_t pc, uint32_t target) {
+		MLSTD_VERIFY(!(target & 3) && "Jump target is not instruction aligned");
+		MLSTD_VERIFY(((pc + 4) & 0xf0000000) == (target & 0xf0000000) && "Jump target is outside of the 256MB segment");
+		return target;
+	}
+
+	/**
+	 * j from pc to target.
+	 */
+	constexpr uint32_t jTo(uint32_t pc, uint32_t target) {
+		return j(checkedJumpTarget(pc, target));
+	}
+
+	/**
+	 * jal from pc to target.
+	 */
+	constexpr uint32_t jalTo(uint32_t pc, uint32_t target) {
+		return jal(checkedJumpTarget(pc, target));
+	}
+
+	/**
+	 * Compute the offset field for a branch at pc to target.
+	 */
+	constexpr uint32_t branchOffset(uint32_t pc, uint32_t target) {
+		const auto delta = static_cast<int32_t>(target - (pc + 4));
+		MLSTD_VERIFY(!(delta & 3) && "Branch target is not instruction aligned");
+		MLSTD_VERIFY(delta >= -0x20000 && delta <= 0x1fffc && "Branch target is out of range");
+		return static_cast<uint32_t>(delta >> 2) & 0xffff;
+	}
+
+	/**
+	 * Retarget an encoded branch (any of the encoders above, with any offset)
+	 * at pc to target. e.g:
+	 *
+	 * 	branchTo(bne(Reg::A0, Reg::R0, 0), pc, loopTop)
+	 */
+	constexpr uint32_t branchTo(uint32_t branch, uint32_t pc, uint32_t target) {
+		return (branch & 0xffff0000) | branchOffset(pc, target);
+	}
+
+	constexpr uint32_t b(int16_t offset) {
+		return beq(Reg::R0, Reg::R0, offset);
+	}
+
+	constexpr uint32_t bal(int16_t offset) {
+		return bgezal(Reg::R0, offset);
+	}
+
+	// Branch likely
+
+	constexpr uint32_t beql(Reg src, Reg tgt, int16_t offset) {
+		return iclass(0b010100) | tgtVal(tgt) | srcVal(src) | ((offset >> 2) & 0xffff);
+	}
+
+	constexpr uint32_t bnel(Reg src, Reg tgt, int16_t offset) {
+		return iclass(0b010101) | tgtVal(tgt) | srcVal(src) | ((offset >> 2) & 0xffff);
+	}
+
+	constexpr uint32_t bltzl(Reg src, int16_t offset) {
+		return iclass(0b000001) | tgtVal(Reg(0b00010)) | srcVal(src) | ((offset >> 2) & 0xffff);
+	}
+
+	constexpr uint32_t bgezl(Reg src, int16_t offset) {
+		return iclass(0b000001) | tgtVal(Reg(0b00011)) | srcVal(src) | ((offset >> 2) & 0xffff);
+	}
+
+	// 64-bit ALU/shifts (the EE's GPRs are 64 bits, or 128 for MMI)
+
+	constexpr uint32_t daddu(Reg dst, Reg src, Reg tgt) {
+		return dstVal(dst) | tgtVal(tgt) | srcVal(src) | 0b101101;
+	}
+
+	constexpr uint32_t dsll(Reg dst, Reg tgt, uint16_t sa) {
+		MLSTD_VERIFY(sa < 32 && "Shift amount out of range");
+		return dstVal(dst) | tgtVal(tgt) | (sa << 6) | 0b111000;
+	}
+
+	constexpr uint32_t dsrl(Reg dst, Reg tgt, uint16_t sa) {
+		MLSTD_VERIFY(sa < 32 && "Shift amount out of range");
+		return dstVal(dst) | tgtVal(tgt) | (sa << 6) | 0b111010;
+	}
+
+	constexpr uint32_t dsll32(Reg dst, Reg tgt, uint16_t sa) {
+		MLSTD_VERIFY(sa < 32 && "Shift amount out of range");
+		return dstVal(dst) | tgtVal(tgt) | (sa << 6) | 0b111100;
+	}
+
+	constexpr uint32_t dsrl32(Reg dst, Reg tgt, uint16_t sa) {
+		MLSTD_VERIFY(sa < 32 && "Shift amount out of range");
+		return dstVal(dst) | tgtVal(tgt) | (sa << 6) | 0b111110;
+	}
+
+	// 64/128-bit load/store
+
+	constexpr uint32_t ld(Reg tgt, int16_t offset, Reg src) {
+		MLSTD_VERIFY(!(offset & 7) && "ld offset must be 8 byte aligned");
+		return iclass(0b110111) | tgtVal(tgt) | srcVal(src) | (offset & 0xffff);
+	}
+
+	constexpr uint32_t sd(Reg tgt, int16_t offset, Reg src) {
+		MLSTD_VERIFY(!(offset & 7) && "sd offset must be 8 byte aligned");
+		return iclass(0b111111) | tgtVal(tgt) | srcVal(src) | (offset & 0xffff);
+	}
+
+	/**
+	 * Load quadword. The EE ignores the low 4 bits of the address,
+	 * so a misaligned offset would silently load the wrong thing.
+	 */
+	constexpr uint32_t lq(Reg tgt, int16_t offset, Reg src) {
+		MLSTD_VERIFY(!(offset & 15) && "lq offset must be 16 byte aligned");
+		return iclass(0b011110) | tgtVal(tgt) | srcVal(src) | (offset & 0xffff);
+	}
+
+	/**
+	 * Store quadword. Same alignment rules as lq().
+	 */
+	constexpr uint32_t sq(Reg tgt, int16_t offset, Reg src) {
+		MLSTD_VERIFY(!(offset & 15) && "sq offset must be 16 byte aligned");
+		return iclass(0b011111) | tgtVal(tgt) | srcVal(src) | (offset & 0xffff);
+	}
+
+	// R5900 MMI (multimedia) instructions.
+
+	constexpr uint32_t mmi(uint32_t funct) {
+		return iclass(0b011100) | funct;
+	}
+
+	constexpr uint32_t mmiSub(uint32_t group, uint32_t sa, Reg dst, Reg src, Reg tgt) {
+		return mmi(group) | dstVal(dst) | tgtVal(tgt) | srcVal(src) | (sa << 6);
+	}
+
+	constexpr uint32_t MMI0 = 0b001000;
+	constexpr uint32_t MMI1 = 0b101000;
+	constexpr uint32_t MMI2 = 0b001001;
+	constexpr uint32_t MMI3 = 0b101001;
+
+	constexpr uint32_t paddw(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI0, 0b00000, dst, src, tgt);
+	}
+
+	constexpr uint32_t psubw(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI0, 0b00001, dst, src, tgt);
+	}
+
+	/**
+	 * Interleave the lower words of src and tgt.
+	 */
+	constexpr uint32_t pextlw(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI0, 0b10010, dst, src, tgt);
+	}
+
+	constexpr uint32_t pand(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI2, 0b10010, dst, src, tgt);
+	}
+
+	constexpr uint32_t pxor(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI2, 0b10011, dst, src, tgt);
+	}
+
+	/**
+	 * dst = { lower doubleword of tgt, lower doubleword of src }
+	 */
+	constexpr uint32_t pcpyld(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI2, 0b01110, dst, src, tgt);
+	}
+
+	constexpr uint32_t pcpyud(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI3, 0b01110, dst, src, tgt);
+	}
+
+	/**
+	 * 128-bit or. por dst, src, zero is a 128-bit move.
+	 */
+	constexpr uint32_t por(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI3, 0b10010, dst, src, tgt);
+	}
+
+	constexpr uint32_t pnor(Reg dst, Reg src, Reg tgt) {
+		return mmiSub(MMI3, 0b10011, dst, src, tgt);
+	}
+
+	constexpr uint32_t pmfhi(Reg dst) {
+		return mmiSub(MMI2, 0b01000, dst, Reg::R0, Reg::R0);
+	}
+
+	constexpr uint32_t pmflo(Reg dst) {
+		return mmiSub(MMI2, 0b01001, dst, Reg::R0, Reg::R0);
+	}
+
+	constexpr uint32_t pmthi(Reg src) {
+		return mmiSub(MMI3, 0b01000, Reg::R0, src, Reg::R0);
+	}
+
+	constexpr uint32_t pmtlo(Reg src) {
+		return mmiSub(MMI3, 0b01001, Reg::R0, src, Reg::R0);
+	}
+
+	/**
+	 * Count leading zero/one bits of both words of src.
+	 */
+	constexpr uint32_t plzcw(Reg dst, Reg src) {
+		return mmi(0b000100) | dstVal(dst) | srcVal(src);
+	}
+
+	// Pipeline 1 multiply/divide. These run in parallel with the pipeline 0 versions,
+	// and use HI1/LO1.
+
+	constexpr uint32_t mult1(Reg dst, Reg src, Reg tgt) {
+		return mmi(0b011000) | dstVal(dst) | tgtVal(tgt) | srcVal(src);
+	}
+
+	constexpr uint32_t multu1(Reg dst, Reg src, Reg tgt) {
+		return mmi(0b011001) | dstVal(dst) | tgtVal(tgt) | srcVal(src);
+	}
+
+	constexpr uint32_t div1(Reg src, Reg tgt) {
+		return mmi(0b011010) | tgtVal(tgt) | srcVal(src);
+	}
+
+	constexpr uint32_t divu1(Reg src, Reg tgt) {
+		return mmi(0b011011) | tgtVal(tgt) | srcVal(src);
+	}
+
+	constexpr uint32_t mfhi1(Reg dst) {
+		return mmi(0b010000) | dstVal(dst);
+	}
+
+	constexpr uint32_t mthi1(Reg src) {
+		return mmi(0b010001) | srcVal(src);
+	}
+
+	constexpr uint32_t mflo1(Reg dst) {
+		return mmi(0b010010) | dstVal(dst);
+	}
+
+	constexpr uint32_t mtlo1(Reg src) {
+		return mmi(0b010011) | srcVal(src);
+	}
+
+	// COP0
+
+	/**
+	 * Move from a COP0 register (e.g. 9, Count).
+	 */
+	constexpr uint32_t mfc0(Reg tgt, uint32_t cop0Reg) {
+		MLSTD_VERIFY(cop0Reg < 32 && "Invalid COP0 register");
+		return iclass(0b010000) | tgtVal(tgt) | (cop0Reg << 11);
+	}
+
+	constexpr uint32_t mtc0(Reg tgt, uint32_t cop0Reg) {
+		MLSTD_VERIFY(cop0Reg < 32 && "Invalid COP0 register");
+		return iclass(0b010000) | srcVal(Reg(0b00100)) | tgtVal(tgt) | (cop0Reg << 11);
+	}
+
+	constexpr uint32_t sync() {
+		return 0b001111;
+	}
+
+	// SA (the funnel shift amount register)
+
+	constexpr uint32_t mfsa(Reg dst) {
+		return dstVal(dst) | 0b101000;
+	}
+
+	constexpr uint32_t mtsa(Reg src) {
+		return srcVal(src) | 0b101001;
+	}
+
+	// COP1 load/store. FPU registers are plain numbers, there's no enum for them.
+
+	constexpr uint32_t lwc1(uint32_t ft, int16_t offset, Reg src) {
+		MLSTD_VERIFY(ft < 32 && "Invalid FPU register");
+		return iclass(0b110001) | (ft << 16) | srcVal(src) | (offset & 0xffff);
+	}
+
+	constexpr uint32_t swc1(uint32_t ft, int16_t offset, Reg src) {
+		MLSTD_VERIFY(ft < 32 && "Invalid FPU register");
+		return iclass(0b111001) | (ft << 16) | srcVal(src) | (offset & 0xffff);
+	}
+
+	// Known machine words for the above, hand assembled from the EE Core
+	// Instruction Set Manual field layouts.
+	static_assert(jTo(0x00100000, 0x00123450) == 0x08048d14);
+	static_assert(jalTo(0x00100000, 0x00123450) == 0x0c048d14);
+	static_assert(branchTo(bne(Reg::A0, Reg::R0, 0), 0x00100000, 0x00100000) == 0x1480ffff);
+	static_assert(branchTo(beq(Reg::R0, Reg::R0, 0), 0x00100000, 0x00100000 + 4 + 0x1fffc) == 0x10007fff);
+	static_assert(branchTo(beq(Reg::R0, Reg::R0, 0), 0x00100000, 0x00100000 + 4 - 0x20000) == 0x10008000);
+	static_assert(lq(Reg::T0, 0, Reg::A1) == 0x78a80000);
+	static_assert(sq(Reg::T0, 0x10, Reg::A0) == 0x7c880010);
+	static_assert(ld(Reg::T0, -8, Reg::SP) == 0xdfa8fff8);
+	static_assert(sd(Reg::RA, 0x20, Reg::SP) == 0xffbf0020);
+	static_assert(pextlw(Reg::V0, Reg::A0, Reg::A1) == 0x70851488);
+	static_assert(por(Reg::V0, Reg::A0, Reg::R0) == 0x708014a9);
+	static_assert(pcpyld(Reg::V0, Reg::A0, Reg::A1) == 0x70851389);
+	static_assert(mult1(Reg::V0, Reg::A0, Reg::A1) == 0x70851018);
+	static_assert(div1(Reg::A0, Reg::A1) == 0x7085001a);
+	static_assert(mflo1(Reg::V0) == 0x70001012);
+	static_assert(pmfhi(Reg::V0) == 0x70001209);
+	static_assert(plzcw(Reg::V0, Reg::A0) == 0x70801004);
+	static_assert(mfc0(Reg::T1, 9) == 0x40094800);
+	static_assert(daddu(Reg::S0, Reg::A0, Reg::R0) == 0x0080802d);
+	static_assert(mfsa(Reg::T0) == 0x00004028);
+	static_assert(swc1(20, 0x10, Reg::SP) == 0xe7b40010);
+
 } // namespace elfldr::mips
 
 #endif // ELFLDR_MIPSIENCODER_H
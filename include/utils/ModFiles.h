@@ -0,0 +1,42 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Setting up the mod overlay and packs (OverlayFs.h, PackFile.h) for the game.
+//
+// Mods can't be loaded before the game runs, since the hooks serving them have
+// to read them with the game's own file functions, and those only work once the
+// game has started its file system. So InstallModFiles() only hooks sceOpen;
+// the first time the game opens a file, that hook loads host:mods.txt and what
+// it lists through the game's file functions (GameFileIo.h), installs the game
+// file hooks (GameFileHooks.h), and hands the open over to them. If
+// host:filetrace.txt is there, it also traces the game's file access to
+// host:filetrace.bin (FileTrace.h), with or without mods.
+//
+// All of this has to stay resident for as long as the game runs, so it's
+// installed from a codehook (src/modfiles), not the ELF.
+
+#ifndef ELFLDR_MODFILES_H
+#define ELFLDR_MODFILES_H
+
+namespace elfldr::util {
+
+	/**
+	 * Load mods the first time the game opens a file.
+	 * Needs "sceOpen" in the symbol database, and the allocator to be set up.
+	 *
+	 * \return True if sceOpen was hooked.
+	 */
+	bool InstallModFiles();
+
+	/**
+	 * Remove the hooks, unload the mods, and stop the file trace.
+	 */
+	void RemoveModFiles();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_MODFILES_H
@@ -0,0 +1,184 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The mod overlay filesystem.
+//
+// Mods live in their own folders (host:mods/<name>), laid out like the game's
+// data. host:mods.txt lists the ones to use, highest priority first. When the
+// game first opens a file (see ModFiles.h), the mod folders are indexed once,
+// and merged into one table of
+// (game path -> mod folder); when the game opens a file, the hooks in
+// GameFileHooks.h look the path up there, and open the mod's copy instead
+// if there is one. There's no host access per open to find out.
+
+#ifndef ELFLDR_OVERLAYFS_H
+#define ELFLDR_OVERLAYFS_H
+
+#include <mlstd/Span.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/DirectoryIndex.h>
+#include <utils/PackFile.h>
+
+namespace elfldr::util {
+
+	struct OverlayFs {
+		/**
+		 * A file some mod overrides.
+		 */
+		struct Entry {
+			/**
+			 * Path relative to the mod's root. nullptr if this slot is empty.
+			 */
+			const char* path;
+			uint32_t hash;
+			uint16_t pathLength;
+
+			/**
+			 * Which root has the file (index into the roots Build() was given).
+			 */
+			uint8_t root;
+		};
+
+		/**
+		 * How lookups went. Misses are expected to be by far the most common,
+		 * and should mostly end at the bloom filter.
+		 */
+		struct Stats {
+			uint32_t lookups;
+			uint32_t bloomRejects;
+			uint32_t negativeCacheHits;
+			uint32_t tableLookups;
+			uint32_t found;
+		};
+
+		/**
+		 * Bloom filter bits per overridden file. With 4 bits set per file,
+		 * this gives well under a 1% false positive rate.
+		 */
+		constexpr static uint32_t BloomBitsPerFile = 12;
+
+		/**
+		 * The bloom filter is split into blocks the size of an EE cache line;
+		 * a file's bits are all in one block, so a check touches one line.
+		 */
+		constexpr static uint32_t BloomBlockBytes = 64;
+
+		/**
+		 * How many recent misses which got past the bloom filter are remembered.
+		 */
+		constexpr static uint32_t NegativeCacheSize = 16;
+
+		OverlayFs() = default;
+		OverlayFs(const OverlayFs&) = delete;
+		OverlayFs& operator=(const OverlayFs&) = delete;
+
+		~OverlayFs();
+
+		/**
+		 * Build the overlay from the files in some roots of an index.
+		 * If more than one root has a file, the earliest one in the list wins.
+		 *
+		 * The overlay is allocated in one block, and doesn't refer to the index afterwards.
+		 *
+		 * \param[in] index Index with the roots in it.
+		 * \param[in] roots Root numbers in the index, highest priority first.
+		 * \return False if there wasn't memory for it.
+		 */
+		bool Build(const DirectoryIndex& index, mlstd::Span<const uint32_t> roots);
+
+		/**
+		 * Find the file overriding a game path (with or without a device).
+		 * \return The entry, or nullptr if no mod has the file.
+		 */
+		const Entry* Find(const char* path) const;
+
+		/**
+		 * Work out where a game path should really be opened from.
+		 *
+		 * Only host paths are redirected; anything on another device is left alone.
+		 *
+		 * \param[in] path Path the game asked for, e.g. "host:data\\models\\alaska.big".
+		 * \param[out] out Where to put the mod's path, e.g. "host:mods/foo/data/models/alaska.big".
+		 * \param[in] outSize Size of out.
+		 * \return True if a mod has the file (and it fit in out).
+		 */
+		bool Resolve(const char* path, char* out, size_t outSize) const;
+
+		uint32_t Count() const {
+			return count;
+		}
+
+		uint32_t RootCount() const {
+			return rootCount;
+		}
+
+		const char* RootPath(uint32_t root) const {
+			return roots[root];
+		}
+
+		const Stats& GetStats() const {
+			return stats;
+		}
+
+		/**
+		 * Free the overlay; everything goes back to the game's files.
+		 */
+		void Clear();
+
+	   private:
+		bool BloomMayContain(uint32_t hash) const;
+		void BloomAdd(uint32_t hash);
+
+		bool NegativeCached(uint32_t hash) const;
+		void CacheNegative(uint32_t hash) const;
+
+		Entry* slots { nullptr };
+		uint32_t slotMask { 0 };
+		uint32_t count { 0 };
+
+		const char* roots[DirectoryIndex::MaxRoots] {};
+		uint32_t rootCount { 0 };
+
+		uint32_t* bloom { nullptr };
+		uint32_t bloomBlockMask { 0 };
+
+		// Hashes which no file in the table has, most recently seen first.
+		//
+		// Lookups change this (and the stats) without a lock, so it isn't
+		// thread-safe as such. Lookups on other threads can only lose or
+		// duplicate entries, though: every entry is a hash which missed in the
+		// (unchanging) table, and the count is clamped where it's used. The
+		// stats can lose counts the same way.
+		mutable uint32_t negativeCache[NegativeCacheSize] {};
+		mutable uint32_t negativeCount { 0 };
+
+		mutable Stats stats {};
+
+		void* block { nullptr };
+	};
+
+	/**
+	 * Index the mods listed in a mods list, and build an overlay from them.
+	 * Needs the allocator to be set up. Files are read through the fio backend,
+	 * so inside the game, call UseGameFileIo() first (InstallModFiles() does).
+	 *
+	 * The list has a mod folder name (under host:mods/) per line,
+	 * highest priority first. Lines ending in ".pak" name packs
+	 * (under host:mods/ too) instead, which are mounted in the order listed.
+	 * Lines starting with '#' are comments.
+	 *
+	 * \param[out] overlay The overlay to build.
+	 * \param[out] packs Where to mount the packs.
+	 * \param[in] listPath The list, e.g. "host:mods.txt".
+	 * \return True if any mod overrides anything.
+	 */
+	bool LoadModOverlay(OverlayFs& overlay, PackSet& packs, const char* listPath);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_OVERLAYFS_H
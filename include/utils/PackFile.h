@@ -0,0 +1,113 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Mod packs (see PackFormat.h).
+//
+// A pack's table of contents is loaded once (through the fio backend, so inside
+// the game, through the game's own file functions; see GameFileIo.h), and kept in memory.
+// Opening a file in it is then just a lookup there; the game's reads
+// become reads of a range of the pack, through the hooks in GameFileHooks.h.
+
+#ifndef ELFLDR_PACKFILE_H
+#define ELFLDR_PACKFILE_H
+
+#include <stdint.h>
+#include <utils/PackFormat.h>
+
+namespace elfldr::util {
+
+	struct PackFile {
+		PackFile() = default;
+		PackFile(const PackFile&) = delete;
+		PackFile& operator=(const PackFile&) = delete;
+
+		~PackFile();
+
+		/**
+		 * Load a pack's table of contents. Needs the allocator to be set up.
+		 *
+		 * \param[in] path Path to the pack, e.g. "host:mods/foo.pak".
+		 * \return True if the pack was loaded.
+		 */
+		bool Open(const char* path);
+
+		/**
+		 * Find a file in the pack, by game path (with or without a device).
+		 * \return The entry, or nullptr if the pack doesn't have the file.
+		 */
+		const PackEntry* Find(const char* path) const;
+
+		/**
+		 * Path of the pack itself.
+		 */
+		const char* Path() const {
+			return path;
+		}
+
+		uint32_t Count() const {
+			return count;
+		}
+
+		/**
+		 * Free the table of contents.
+		 */
+		void Close();
+
+	   private:
+		const PackEntry* entries { nullptr };
+		const char* paths { nullptr };
+		uint32_t count { 0 };
+
+		const char* path { nullptr };
+
+		void* block { nullptr };
+	};
+
+	/**
+	 * The packs in use, highest priority first.
+	 */
+	struct PackSet {
+		constexpr static uint32_t MaxPacks = 8;
+
+		/**
+		 * Open a pack, with a lower priority than the ones already there.
+		 *
+		 * \param[in] path Path to the pack.
+		 * \return True if the pack was opened.
+		 */
+		bool Mount(const char* path);
+
+		/**
+		 * Find the file a game path should be read from.
+		 *
+		 * \param[in] path Game path.
+		 * \param[out] pack Which pack has the file.
+		 * \return The entry, or nullptr if no pack has the file.
+		 */
+		const PackEntry* Find(const char* path, uint32_t& pack) const;
+
+		uint32_t Count() const {
+			return count;
+		}
+
+		const PackFile& Pack(uint32_t index) const {
+			return packs[index];
+		}
+
+		/**
+		 * Close all the packs.
+		 */
+		void Clear();
+
+	   private:
+		PackFile packs[MaxPacks];
+		uint32_t count { 0 };
+	};
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PACKFILE_H
@@ -0,0 +1,132 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The mod pack format.
+//
+// A pack is a folder of files in one host file, so opening one of them
+// doesn't cost a host round trip. It's laid out as:
+//
+//	PackHeader
+//	PackEntry[count], sorted by hash (then path)
+//	the paths, NUL terminated
+//	(padding to PackAlignment)
+//	the files, each starting on a PackAlignment boundary
+//
+// Everything's little endian. The modpack host tool writes packs,
+// and shares this with the loader, so it has no dependencies on the PS2 SDK.
+
+#ifndef ELFLDR_PACKFORMAT_H
+#define ELFLDR_PACKFORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/PathHash.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Files in a pack start on a boundary of this, so reading one
+	 * never starts in the middle of a sector.
+	 */
+	constexpr uint32_t PackAlignment = 2048;
+
+	struct PackHeader {
+		constexpr static uint32_t Magic = 0x4b415045; // 'EPAK'
+		constexpr static uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t count;
+
+		/**
+		 * Size of the entries and paths after the header.
+		 */
+		uint32_t tocSize;
+	};
+
+	struct PackEntry {
+		/**
+		 * PathHash() of the path.
+		 */
+		uint32_t hash;
+
+		/**
+		 * Offset of the path, from the start of the paths.
+		 * Paths are relative to the pack's root, with '/' separators.
+		 */
+		uint32_t pathOffset;
+
+		/**
+		 * Offset of the file from the start of the pack.
+		 */
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	static_assert(sizeof(PackHeader) == 16 && sizeof(PackEntry) == 16);
+
+	/**
+	 * Round up to PackAlignment.
+	 */
+	constexpr uint32_t PackAlign(uint32_t offset) {
+		return (offset + PackAlignment - 1) & ~(PackAlignment - 1);
+	}
+
+	/**
+	 * Find a file in a pack's table of contents, with a binary search on the hash.
+	 *
+	 * \param[in] entries The entries.
+	 * \param[in] count How many entries there are.
+	 * \param[in] paths The paths.
+	 * \param[in] path Path to find, relative to the pack's root.
+	 * \param[in] length Length of path.
+	 * \return The entry, or nullptr if the pack doesn't have the file.
+	 */
+	constexpr const PackEntry* FindPackEntry(const PackEntry* entries, uint32_t count, const char* paths, const char* path, size_t length) {
+		const auto hash = PathHash(path, length);
+		uint32_t low = 0;
+		uint32_t high = count;
+
+		while(low < high) {
+			const auto mid = low + (high - low) / 2;
+			if(entries[mid].hash < hash)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		// Paths with the same hash are next to each other.
+		for(; low < count && entries[low].hash == hash; ++low) {
+			auto* entryPath = &paths[entries[low].pathOffset];
+			size_t entryLength = 0;
+			while(entryPath[entryLength])
+				++entryLength;
+
+			if(PathEquals(entryPath, entryLength, path, length))
+				return &entries[low];
+		}
+
+		return nullptr;
+	}
+
+	namespace packformat_checks {
+		constexpr char paths[] = "a\0data/b.big\0c";
+		constexpr PackEntry entries[] {
+			{ PathHash("data/b.big", 10), 2, 2048, 1 },
+			{ PathHash("a", 1), 0, 4096, 1 },
+			{ PathHash("c", 1), 13, 6144, 1 }
+		};
+		static_assert(entries[0].hash < entries[1].hash && entries[1].hash < entries[2].hash);
+		static_assert(FindPackEntry(&entries[0], 3, &paths[0], "DATA\\B.BIG", 10) == &entries[0]);
+		static_assert(FindPackEntry(&entries[0], 3, &paths[0], "a", 1) == &entries[1] && FindPackEntry(&entries[0], 3, &paths[0], "c", 1) == &entries[2]);
+		static_assert(FindPackEntry(&entries[0], 3, &paths[0], "b", 1) == nullptr && FindPackEntry(&entries[0], 0, &paths[0], "a", 1) == nullptr);
+		static_assert(PackAlign(0) == 0 && PackAlign(1) == 2048 && PackAlign(2048) == 2048);
+	} // namespace packformat_checks
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PACKFORMAT_H
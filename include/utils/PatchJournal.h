@@ -0,0 +1,121 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The patch journal.
+//
+// Every write made through the patch and hook APIs goes through WriteMemory(),
+// which saves the bytes it overwrites into an arena-backed log before writing.
+// Any span of the journal (a single patch, a hook, or everything an ERL did)
+// can then be reverted with one call.
+
+#ifndef ELFLDR_PATCHJOURNAL_H
+#define ELFLDR_PATCHJOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * A position in the journal. Every entry gets the next position,
+	 * so a span of entries is just a begin/end pair.
+	 */
+	using JournalPosition = uint32_t;
+
+	/**
+	 * A range of journal entries, [begin, end).
+	 */
+	struct JournalSpan {
+		JournalPosition begin;
+		JournalPosition end;
+
+		constexpr uint32_t Count() const {
+			return end - begin;
+		}
+	};
+
+	/**
+	 * Something a journal entry owns, which is released when the entry is reverted.
+	 * Used by hooks to free their trampoline when unhooked.
+	 */
+	struct JournalOwnedBlock {
+		void* block;
+		void (*release)(void* block);
+	};
+
+	/**
+	 * Get the position the next journal entry will have.
+	 */
+	JournalPosition GetJournalPosition();
+
+	/**
+	 * Get the span of entries made since a position.
+	 */
+	inline JournalSpan JournalSpanSince(JournalPosition begin) {
+		return { begin, GetJournalPosition() };
+	}
+
+	/**
+	 * Write memory, saving the original bytes into the journal.
+	 * This does not flush any caches; callers writing code need to do that.
+	 *
+	 * \param[out] dest Address to write to.
+	 * \param[in] src Bytes to write.
+	 * \param[in] length Amount of bytes to write.
+	 * \param[in] owned Optional block released when this write is reverted.
+	 */
+	void WriteMemory(void* dest, const void* src, uint32_t length, JournalOwnedBlock owned = {});
+
+	/**
+	 * Write an aligned word with a single store, saving the original into the journal.
+	 * Other threads (and interrupt handlers) see either the old or the new value,
+	 * never a mix; reverting the write is a single store too.
+	 *
+	 * \param[out] dest Address to write to. Must be word aligned.
+	 * \param[in] value Value to write.
+	 */
+	void WriteMemory32(uint32_t* dest, uint32_t value);
+
+	/**
+	 * Fill memory with a byte, saving the original bytes into the journal.
+	 */
+	void FillMemory(void* dest, uint8_t value, uint32_t length);
+
+	/**
+	 * Revert a span of journal entries, newest first.
+	 *
+	 * If any entry in the span was overwritten by a newer, still applied entry
+	 * outside of the span, reverting it would clobber that write; in that case
+	 * nothing is reverted.
+	 *
+	 * \return True if the span was reverted (or already was).
+	 */
+	bool RevertJournal(JournalSpan span);
+
+	/**
+	 * Revert the newest applied entry which wrote to exactly this address.
+	 * Same rules as RevertJournal().
+	 *
+	 * \return True if an entry was found and reverted.
+	 */
+	bool RevertJournalAt(void* dest);
+
+	/**
+	 * Journal statistics, for logging.
+	 */
+	struct JournalStats {
+		uint32_t entries;
+		uint32_t revertedEntries;
+		uint32_t savedBytes;
+		uint32_t arenaBytes;
+	};
+
+	JournalStats GetJournalStats();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PATCHJOURNAL_H
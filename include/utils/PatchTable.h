@@ -0,0 +1,317 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Declarative patch tables.
+//
+// Patches which just poke bytes at fixed addresses are described as
+// constexpr arrays of PatchRecord, keyed by the game version they apply to.
+// The tables have no dependencies on the PS2 SDK, so host tools can include
+// the exact same tables the loader uses to dump or verify them.
+
+#ifndef ELFLDR_PATCHTABLE_H
+#define ELFLDR_PATCHTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/GameVersion.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Operations a patch record can perform.
+	 */
+	enum class PatchOp : uint8_t {
+		/**
+		 * Write a string (including the null terminator) at the address.
+		 */
+		WriteString,
+
+		/**
+		 * Write a string over an existing one. Identical to WriteString,
+		 * except the string being replaced gets logged.
+		 */
+		ReplaceString,
+
+		/**
+		 * Write a single byte.
+		 */
+		Write8,
+
+		/**
+		 * Write a single word (usually an instruction).
+		 */
+		Write32,
+
+		/**
+		 * Fill [value] instructions with nop.
+		 */
+		NopFill
+	};
+
+	/**
+	 * Record flags.
+	 */
+	enum PatchRecordFlags : uint8_t {
+		/**
+		 * The record has a digest of the original bytes it overwrites,
+		 * which are checked before the table is applied.
+		 */
+		PatchFlag_HasDigest = 0x1
+	};
+
+	/**
+	 * A single patch record.
+	 */
+	struct PatchRecord {
+		uint32_t address;
+		PatchOp op;
+		uint8_t flags;
+
+		/**
+		 * How many bytes of the range the digest covers, if not all of it.
+		 * For when only the start of the original bytes is known.
+		 */
+		uint16_t digestSize;
+
+		/**
+		 * Payload for Write8/Write32, or the instruction count for NopFill.
+		 */
+		uint32_t value;
+
+		/**
+		 * Payload for WriteString/ReplaceString.
+		 */
+		const char* string;
+
+		/**
+		 * PatchDigest() of the original bytes in the range this record writes to.
+		 * Only valid if PatchFlag_HasDigest is set.
+		 */
+		uint32_t digest;
+
+		/**
+		 * Return a copy of this record which expects the original
+		 * bytes to have the given digest.
+		 */
+		constexpr PatchRecord Expect(uint32_t expectedDigest) const {
+			auto record = *this;
+			record.flags |= PatchFlag_HasDigest;
+			record.digest = expectedDigest;
+			return record;
+		}
+
+		/**
+		 * Return a copy of this record which expects the first
+		 * size bytes of the original bytes to have the given digest.
+		 */
+		constexpr PatchRecord Expect(uint32_t expectedDigest, uint16_t size) const {
+			auto record = Expect(expectedDigest);
+			record.digestSize = size;
+			return record;
+		}
+	};
+
+	/**
+	 * Get the size of the range a record writes to.
+	 */
+	constexpr uint32_t PatchRecordSize(const PatchRecord& record) {
+		switch(record.op) {
+			case PatchOp::WriteString:
+			case PatchOp::ReplaceString: {
+				uint32_t length = 0;
+				while(record.string[length] != '\0')
+					++length;
+				return length + 1;
+			}
+			case PatchOp::Write8:
+				return sizeof(uint8_t);
+			case PatchOp::Write32:
+				return sizeof(uint32_t);
+			case PatchOp::NopFill:
+				return record.value * sizeof(uint32_t);
+		}
+		return 0;
+	}
+
+	/**
+	 * Get the size of the range a record's digest covers.
+	 */
+	constexpr uint32_t PatchRecordDigestSize(const PatchRecord& record) {
+		return record.digestSize ? record.digestSize : PatchRecordSize(record);
+	}
+
+	/**
+	 * Digest a range of bytes for patch verification.
+	 *
+	 * This is FNV-1a, but run over 32-bit little endian lanes instead of bytes
+	 * (the tail is zero-padded), so it's one load and one multiply per word on the EE.
+	 * Word aligned ranges (the usual case) take a fast path.
+	 *
+	 * This is inline so host tools generate digests with the exact same code.
+	 */
+	inline uint32_t PatchDigest(const void* data, uint32_t length) {
+		constexpr uint32_t FNV_PRIME = 0x01000193;
+		uint32_t hash = 0x811c9dc5 ^ length;
+
+		auto* bytes = static_cast<const uint8_t*>(data);
+		uint32_t words = length / sizeof(uint32_t);
+
+		if(!(reinterpret_cast<uintptr_t>(bytes) & 3) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) {
+			auto* wordPtr = reinterpret_cast<const uint32_t*>(bytes);
+			for(uint32_t i = 0; i < words; ++i)
+				hash = (hash ^ wordPtr[i]) * FNV_PRIME;
+		} else {
+			for(uint32_t i = 0; i < words; ++i) {
+				auto* p = &bytes[i * sizeof(uint32_t)];
+				hash = (hash ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24))) * FNV_PRIME;
+			}
+		}
+
+		if(auto tail = length & 3; tail) {
+			auto* p = &bytes[words * sizeof(uint32_t)];
+			uint32_t last = 0;
+			for(uint32_t i = 0; i < tail; ++i)
+				last |= static_cast<uint32_t>(p[i]) << (i * 8);
+			hash = (hash ^ last) * FNV_PRIME;
+		}
+
+		return hash;
+	}
+
+	/**
+	 * Helpers to build patch records.
+	 */
+	namespace patch {
+
+		constexpr PatchRecord String(uint32_t address, const char* string) {
+			return { address, PatchOp::WriteString, 0, 0, 0, string, 0 };
+		}
+
+		constexpr PatchRecord Replace(uint32_t address, const char* string) {
+			return { address, PatchOp::ReplaceString, 0, 0, 0, string, 0 };
+		}
+
+		constexpr PatchRecord Byte(uint32_t address, uint8_t value) {
+			return { address, PatchOp::Write8, 0, 0, value, nullptr, 0 };
+		}
+
+		constexpr PatchRecord Word(uint32_t address, uint32_t value) {
+			return { address, PatchOp::Write32, 0, 0, value, nullptr, 0 };
+		}
+
+		constexpr PatchRecord Nop(uint32_t address, uint32_t count) {
+			return { address, PatchOp::NopFill, 0, 0, count, nullptr, 0 };
+		}
+
+	} // namespace patch
+
+	/**
+	 * A list of patch records, keyed by the game version they apply to.
+	 */
+	struct PatchTable {
+		Game game;
+		GameRegion region;
+		GameVersion version;
+
+		const PatchRecord* records;
+		uint32_t recordCount;
+	};
+
+	/**
+	 * Make a PatchTable from a record array.
+	 */
+	template <size_t N>
+	constexpr PatchTable MakePatchTable(Game game, GameRegion region, GameVersion version, const PatchRecord (&records)[N]) {
+		return { game, region, version, &records[0], N };
+	}
+
+	/**
+	 * Find the table for a given game version.
+	 *
+	 * \param[in] tables Table list.
+	 * \param[in] count Amount of tables in the list.
+	 * \param[in] data Game version to find.
+	 * \return The table, or nullptr if none of the tables apply.
+	 */
+	constexpr const PatchTable* FindPatchTable(const PatchTable* tables, uint32_t count, const GameVersionData& data) {
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto& table = tables[i];
+			if(table.game == data.game && table.region == data.region && table.version == data.version)
+				return &table;
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * Verify the original bytes of every record which has a digest,
+	 * against a copy of memory (host tools use this on a game ELF).
+	 *
+	 * \param[in] image The copy of memory.
+	 * \param[in] imageAddress The address the copy starts at. Every record has to be inside of it.
+	 * \return The index of the first mismatching record, or count if all records matched.
+	 */
+	inline uint32_t VerifyPatchRecords(const PatchRecord* records, uint32_t count, const uint8_t* image, uint32_t imageAddress) {
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto& record = records[i];
+			if(!(record.flags & PatchFlag_HasDigest))
+				continue;
+
+			// Worked out as an integer, since the loader's image of memory starts at 0.
+			auto* bytes = reinterpret_cast<const uint8_t*>(reinterpret_cast<uintptr_t>(image) + (record.address - imageAddress));
+			if(PatchDigest(bytes, PatchRecordDigestSize(record)) != record.digest)
+				return i;
+		}
+
+		return count;
+	}
+
+	/**
+	 * Verify the original bytes of every record which has a digest.
+	 *
+	 * \return The index of the first mismatching record, or count if all records matched.
+	 */
+	uint32_t VerifyPatchRecords(const PatchRecord* records, uint32_t count);
+
+	/**
+	 * Apply a list of patch records, in order.
+	 * This does not verify the records; see ApplyPatchTable().
+	 */
+	void ApplyPatchRecords(const PatchRecord* records, uint32_t count);
+
+	/**
+	 * Result of ApplyPatchTable().
+	 */
+	enum class PatchTableResult : uint8_t {
+		Applied,
+
+		/**
+		 * There was no table for the given game version.
+		 */
+		NoTable,
+
+		/**
+		 * The original bytes did not match the table, so
+		 * nothing was applied.
+		 */
+		Mismatch
+	};
+
+	/**
+	 * Find, verify, and apply the table for a given game version.
+	 * If any record in the table fails verification, none of the table is applied.
+	 */
+	PatchTableResult ApplyPatchTable(const PatchTable* tables, uint32_t count, const GameVersionData& data);
+
+	template <size_t N>
+	inline PatchTableResult ApplyPatchTable(const PatchTable (&tables)[N], const GameVersionData& data) {
+		return ApplyPatchTable(&tables[0], N, data);
+	}
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PATCHTABLE_H
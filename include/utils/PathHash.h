@@ -0,0 +1,92 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Path hashing and comparison.
+//
+// Host paths are compared without regard to case or separator style,
+// like the game (and Windows hosts) do. This has no dependencies
+// on the PS2 SDK, so host tools share it.
+
+#ifndef ELFLDR_PATHHASH_H
+#define ELFLDR_PATHHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Fold a path character: lower case, and '/' for either separator.
+	 */
+	constexpr char PathFold(char c) {
+		if(c >= 'A' && c <= 'Z')
+			return static_cast<char>(c - 'A' + 'a');
+		if(c == '\\')
+			return '/';
+		return c;
+	}
+
+	/**
+	 * Hash a path (32-bit FNV-1a over the folded characters).
+	 */
+	constexpr uint32_t PathHash(const char* path, size_t length) {
+		uint32_t hash = 0x811c9dc5;
+		for(size_t i = 0; i < length; ++i) {
+			hash ^= static_cast<uint8_t>(PathFold(path[i]));
+			hash *= 0x01000193;
+		}
+		return hash;
+	}
+
+	/**
+	 * Compare two paths, folding both.
+	 */
+	constexpr bool PathEquals(const char* a, size_t aLength, const char* b, size_t bLength) {
+		if(aLength != bLength)
+			return false;
+
+		for(size_t i = 0; i < aLength; ++i)
+			if(PathFold(a[i]) != PathFold(b[i]))
+				return false;
+		return true;
+	}
+
+	constexpr bool IsPathSeparator(char c) {
+		return c == '/' || c == '\\';
+	}
+
+	/**
+	 * Strip the device (if it's a host one) and any leading separators off a game path.
+	 *
+	 * \return The path, relative to the root of host:, or nullptr if it's on another device.
+	 */
+	constexpr const char* HostRelativePath(const char* path) {
+		for(auto* c = path; *c; ++c) {
+			if(*c != ':')
+				continue;
+
+			if(c - path < 4 || PathFold(path[0]) != 'h' || PathFold(path[1]) != 'o' || PathFold(path[2]) != 's' || PathFold(path[3]) != 't')
+				return nullptr;
+			path = c + 1;
+			break;
+		}
+
+		while(IsPathSeparator(*path))
+			++path;
+		return path;
+	}
+
+	static_assert(PathHash("", 0) == 0x811c9dc5);
+	static_assert(PathHash("a", 1) == 0xe40c292c);
+	static_assert(PathHash("Data\\Models", 11) == PathHash("data/models", 11));
+	static_assert(PathEquals("Data\\Models", 11, "data/models", 11) && !PathEquals("data/model", 10, "data/models", 11));
+	static_assert(HostRelativePath("host0:\\data\\a.big")[0] == 'd' && HostRelativePath("data/a.big")[0] == 'd');
+	static_assert(HostRelativePath("cdrom0:\\DATA\\A.BIG;1") == nullptr);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PATHHASH_H
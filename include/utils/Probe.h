@@ -0,0 +1,110 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Mid-function probes.
+//
+// A probe calls a callback when execution reaches an arbitrary instruction,
+// with the full register state of the EE core at that point. The callback can
+// inspect and change registers, and execution then continues as if nothing
+// happened.
+//
+// The two instructions at the probe address are replaced by a j to a
+// per-probe thunk (from the trampoline pool), which calls a shared dispatcher
+// that saves and restores everything. The displaced instructions are relocated
+// into the thunk, and run after the callback returns.
+
+#ifndef ELFLDR_PROBE_H
+#define ELFLDR_PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * A 128-bit EE register.
+	 */
+	struct alignas(16) ProbeRegister {
+		uint64_t lower;
+		uint64_t upper;
+	};
+
+	/**
+	 * Register state at a probe.
+	 * Changes made by the callback are written back to the registers,
+	 * except for sp, k0 and k1, and pc.
+	 *
+	 * The FPU accumulator and control registers aren't saved; callbacks
+	 * shouldn't be built to use madd.s and friends, or change the rounding mode.
+	 */
+	struct alignas(16) ProbeContext {
+		/**
+		 * GPRs, by number. ra is the value at the probe.
+		 */
+		ProbeRegister gpr[32];
+
+		/**
+		 * hi/lo. The upper halves are hi1/lo1 (the second multiply pipeline).
+		 */
+		ProbeRegister hi;
+		ProbeRegister lo;
+
+		/**
+		 * The funnel shift amount register.
+		 */
+		uint32_t sa;
+
+		/**
+		 * Probe address.
+		 */
+		uint32_t pc;
+
+		uint32_t pad[2];
+
+		float fpr[32];
+	};
+
+	static_assert(offsetof(ProbeContext, hi) == 0x200);
+	static_assert(offsetof(ProbeContext, sa) == 0x220);
+	static_assert(offsetof(ProbeContext, fpr) == 0x230);
+	static_assert(sizeof(ProbeContext) == 0x2b0);
+
+	/**
+	 * A probe callback.
+	 *
+	 * \param[in,out] context Register state.
+	 * \param[in] user User data passed to InstallProbe().
+	 */
+	using ProbeCallback = void (*)(ProbeContext* context, void* user);
+
+	/**
+	 * Install a probe.
+	 *
+	 * The two instructions at the address must not be a branch target
+	 * from elsewhere (the second one is replaced), and the address must not be
+	 * in a delay slot. The latter is checked; the former can't be.
+	 * The stack pointer must be 16-byte aligned at the probe, as EE GCC keeps it.
+	 *
+	 * \param[in] address Instruction to probe.
+	 * \param[in] callback Callback.
+	 * \param[in] user User data for the callback.
+	 * \return True if the probe was installed; false if the instructions
+	 * 			at the address can't be relocated.
+	 */
+	bool InstallProbe(void* address, ProbeCallback callback, void* user = nullptr);
+
+	/**
+	 * Remove a probe installed with InstallProbe(), freeing its thunk.
+	 *
+	 * \param[in] address Probe address.
+	 * \return True if the probe was removed.
+	 */
+	bool RemoveProbe(void* address);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PROBE_H
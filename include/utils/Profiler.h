@@ -0,0 +1,180 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// A function-level cycle profiler.
+//
+// ProfileFunction() hooks a function with a small entry thunk, which pushes
+// the return address and the COP0 Count register onto a shadow stack, and
+// returns into an exit stub which pops it and records the call in a fixed
+// table. Times are inclusive (callees count towards their callers).
+//
+// Limitations:
+// 	- The shadow stack is shared, so profile functions which run on one thread.
+// 	- Functions which don't return normally (longjmp) leave a frame behind.
+// 	- Calls longer than 2^32 cycles (about 14.5 seconds) wrap around.
+//
+// The aggregation (RecordProfiledCall()), the report (FormatProfileReport())
+// and dumping it (DumpProfile()) don't touch the hardware, so they can be run
+// on the host with a simulated counter.
+
+#ifndef ELFLDR_PROFILER_H
+#define ELFLDR_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	constexpr uint32_t MaxProfiledFunctions = 256;
+
+	/**
+	 * One bucket per power of two of cycles per call.
+	 */
+	constexpr uint32_t ProfileHistogramBuckets = 32;
+
+	/**
+	 * EE core clock, which is what COP0 Count counts.
+	 */
+	constexpr uint32_t EeClockHz = 294912000;
+
+	struct ProfileEntry {
+		const char* name;
+		void* function;
+
+		/**
+		 * Trampoline to the original function. Read by the entry thunk.
+		 */
+		void* trampoline;
+
+		uint32_t calls;
+		uint32_t maxCycles;
+		uint64_t cycles;
+		uint32_t histogram[ProfileHistogramBuckets];
+	};
+
+	/**
+	 * Get the histogram bucket for a call (floor(log2(cycles))).
+	 */
+	constexpr uint32_t ProfileBucket(uint32_t cycles) {
+		return cycles ? 31 - __builtin_clz(cycles) : 0;
+	}
+
+	/**
+	 * Record a call in a profile entry.
+	 *
+	 * \param[in] start Counter value on entry.
+	 * \param[in] end Counter value on exit. Allowed to have wrapped around.
+	 */
+	constexpr void RecordProfiledCall(ProfileEntry& entry, uint32_t start, uint32_t end) {
+		const uint32_t cycles = end - start;
+
+		++entry.calls;
+		entry.cycles += cycles;
+		++entry.histogram[ProfileBucket(cycles)];
+		if(cycles > entry.maxCycles)
+			entry.maxCycles = cycles;
+	}
+
+	/**
+	 * Get an upper bound of a percentile of cycles per call,
+	 * from the histogram.
+	 *
+	 * \param[in] percent Percentile (0-100).
+	 */
+	constexpr uint32_t ProfilePercentileBound(const ProfileEntry& entry, uint32_t percent) {
+		if(entry.calls == 0)
+			return 0;
+
+		const uint64_t needed = (static_cast<uint64_t>(entry.calls) * percent + 99) / 100;
+		uint64_t seen = 0;
+
+		for(uint32_t i = 0; i < ProfileHistogramBuckets; ++i) {
+			seen += entry.histogram[i];
+			if(seen >= needed)
+				return i == 31 ? ~0u : (2u << i) - 1;
+		}
+
+		return ~0u;
+	}
+
+	// Simulated counter checks
+	namespace profiler_checks {
+		constexpr ProfileEntry Simulate() {
+			ProfileEntry entry {};
+			RecordProfiledCall(entry, 100, 110);				// 10 cycles
+			RecordProfiledCall(entry, 1000, 1012);				// 12 cycles
+			RecordProfiledCall(entry, 0xfffffff0, 0x00000010); // wrapped, 32 cycles
+			RecordProfiledCall(entry, 5, 5);					// 0 cycles
+			return entry;
+		}
+
+		constexpr auto simulated = Simulate();
+		static_assert(simulated.calls == 4 && simulated.cycles == 54 && simulated.maxCycles == 32);
+		static_assert(simulated.histogram[0] == 1 && simulated.histogram[3] == 2 && simulated.histogram[5] == 1);
+		static_assert(ProfilePercentileBound(simulated, 50) == 15 && ProfilePercentileBound(simulated, 90) == 63);
+		static_assert(ProfileBucket(1) == 0 && ProfileBucket(0x80000000) == 31);
+	} // namespace profiler_checks
+
+	/**
+	 * Start profiling a function.
+	 *
+	 * \param[in] function The function.
+	 * \param[in] name Name for the report. Must stay alive.
+	 * \return True if the function is being profiled; false if the table is full,
+	 * 			or the function couldn't be hooked.
+	 */
+	bool ProfileFunction(void* function, const char* name);
+
+	/**
+	 * Clear the counts of every profiled function.
+	 */
+	void ResetProfile();
+
+	/**
+	 * Get the profile table.
+	 *
+	 * \param[out] count Amount of entries in use.
+	 */
+	const ProfileEntry* GetProfileEntries(uint32_t& count);
+
+	/**
+	 * Format a report of profile entries, sorted by total cycles.
+	 *
+	 * \param[in] entries Entries to report.
+	 * \param[in] count Amount of entries.
+	 * \param[out] buffer Output buffer. Always terminated.
+	 * \param[in] size Size of the output buffer.
+	 * \return Length of the report, not counting the terminator.
+	 */
+	size_t FormatProfileReport(const ProfileEntry* entries, uint32_t count, char* buffer, size_t size);
+
+	/**
+	 * Write a report of the profile to a file, and to the debug output.
+	 * The file is written with the game's own sceOpen/sceWrite/sceClose
+	 * (GameFileIo.h), since fio doesn't work once the game has rebooted the IOP.
+	 *
+	 * \param[in] path Path to write to.
+	 */
+	void DumpProfile(const char* path = "host:profile.txt");
+
+	/**
+	 * Dump the profile to host:profile.txt whenever Select, L3 and R3 are pressed
+	 * together on the first pad. This hooks the game's scePadRead; ProfileFunction()
+	 * does it for the first function it profiles.
+	 *
+	 * \return True if scePadRead was hooked.
+	 */
+	bool InstallProfileDumpCombo();
+
+	/**
+	 * Remove the scePadRead hook.
+	 */
+	void RemoveProfileDumpCombo();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_PROFILER_H
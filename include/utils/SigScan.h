@@ -0,0 +1,202 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Byte signature scanning, for locating game code without hardcoding
+// addresses for every single game version.
+//
+// Signatures are written as IDA-style byte patterns:
+//
+//	"3C 02 ?? ?? 8C 42 ?? ?? 10 4? 00 05"
+//
+// where "??" (or a lone "?") matches any byte, and a single "?" nibble
+// matches anything in that nibble. Patterns are compiled (at compile time
+// if possible) into a Horspool skip table which understands the masks.
+//
+// Code signatures are full of wildcards, which keep Horspool's shifts to a
+// byte or two, so scans for word aligned matches (code) instead test one
+// word of the signature at every word, and only use the skip table if
+// there's no word with anything to match.
+
+#ifndef ELFLDR_SIGSCAN_H
+#define ELFLDR_SIGSCAN_H
+
+#include <mlstd/Assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Max length of a signature, in bytes.
+	 */
+	constexpr static uint32_t MaxSignatureLength = 64;
+
+	/**
+	 * A byte signature: bytes to match, and which bits of each byte matter.
+	 */
+	struct Signature {
+		constexpr Signature(const char* pattern) { // NOLINT
+			auto Nibble = [](char c, uint8_t& value, uint8_t& mask) {
+				if(c == '?') {
+					value = 0;
+					mask = 0;
+				} else if(c >= '0' && c <= '9') {
+					value = c - '0';
+					mask = 0xf;
+				} else if(c >= 'a' && c <= 'f') {
+					value = c - 'a' + 10;
+					mask = 0xf;
+				} else if(c >= 'A' && c <= 'F') {
+					value = c - 'A' + 10;
+					mask = 0xf;
+				} else {
+					// Not constexpr, so invalid patterns fail to compile
+					// if they're being compiled at compile time.
+					MLSTD_VERIFY(false && "Invalid character in signature pattern");
+				}
+			};
+
+			while(*pattern != '\0') {
+				if(*pattern == ' ') {
+					++pattern;
+					continue;
+				}
+
+				MLSTD_VERIFY(length < MaxSignatureLength && "Signature pattern is too long");
+
+				uint8_t hiValue {}, hiMask {}, loValue {}, loMask {};
+				Nibble(pattern[0], hiValue, hiMask);
+
+				// A lone "?" is a full wildcard.
+				if(pattern[1] == ' ' || pattern[1] == '\0') {
+					MLSTD_VERIFY(pattern[0] == '?' && "Signature bytes must be two hex digits");
+					loValue = 0;
+					loMask = 0;
+					pattern += 1;
+				} else {
+					Nibble(pattern[1], loValue, loMask);
+					pattern += 2;
+				}
+
+				bytes[length] = static_cast<uint8_t>((hiValue << 4) | loValue);
+				masks[length] = static_cast<uint8_t>((hiMask << 4) | loMask);
+				++length;
+			}
+
+			MLSTD_VERIFY(length != 0 && "Empty signature pattern");
+		}
+
+		constexpr bool MatchesAt(uint32_t index, uint8_t byte) const {
+			return (byte & masks[index]) == bytes[index];
+		}
+
+		uint8_t bytes[MaxSignatureLength] {};
+		uint8_t masks[MaxSignatureLength] {};
+		uint32_t length {};
+	};
+
+	/**
+	 * A compiled signature, ready for scanning.
+	 */
+	struct SignatureScanner {
+		constexpr SignatureScanner(const Signature& signature) // NOLINT
+			: signature(signature) {
+			// Trailing wildcards are useless for skipping (they'd cap every
+			// shift to a byte or two), so the window only extends to the
+			// last byte which has any bits to match. The rest of the
+			// signature is still checked when a window matches.
+			anchorLength = signature.length;
+			while(anchorLength > 1 && signature.masks[anchorLength - 1] == 0)
+				--anchorLength;
+
+			for(auto& shift : skip)
+				shift = static_cast<uint8_t>(anchorLength);
+
+			// Horspool, but a masked byte may match more than one value,
+			// so every value it matches gets the shift.
+			for(uint32_t i = 0; i + 1 < anchorLength; ++i)
+				for(uint32_t c = 0; c < 256; ++c)
+					if(signature.MatchesAt(i, static_cast<uint8_t>(c)))
+						skip[c] = static_cast<uint8_t>(anchorLength - 1 - i);
+
+			// The word (little endian, like the EE) with the most bits to match.
+			uint32_t bestBits = 0;
+			for(uint32_t i = 0; i + sizeof(uint32_t) <= signature.length; i += sizeof(uint32_t)) {
+				uint32_t mask = 0;
+				uint32_t value = 0;
+				uint32_t bits = 0;
+
+				for(uint32_t j = 0; j < sizeof(uint32_t); ++j) {
+					mask |= static_cast<uint32_t>(signature.masks[i + j]) << (j * 8);
+					value |= static_cast<uint32_t>(signature.bytes[i + j]) << (j * 8);
+				}
+
+				for(auto m = mask; m; m &= m - 1)
+					++bits;
+
+				if(bits > bestBits) {
+					bestBits = bits;
+					wordOffset = i;
+					wordMask = mask;
+					wordValue = value;
+				}
+			}
+		}
+
+		/**
+		 * Check if the full signature matches at a given address.
+		 */
+		constexpr bool MatchesAt(const uint8_t* ptr) const {
+			for(uint32_t i = signature.length; i-- > 0;)
+				if(!signature.MatchesAt(i, ptr[i]))
+					return false;
+			return true;
+		}
+
+		Signature signature;
+		uint32_t anchorLength {};
+		uint8_t skip[256] {};
+
+		/**
+		 * The word tested by word aligned scans. A mask of 0 means
+		 * there's no word worth testing, so the skip table is used.
+		 */
+		uint32_t wordOffset {};
+		uint32_t wordMask {};
+		uint32_t wordValue {};
+	};
+
+	/**
+	 * Scan a range of memory for a signature.
+	 *
+	 * \param[in] begin Start of the range (e.g. the start of the game's .text).
+	 * \param[in] end End of the range.
+	 * \param[in] scanner Compiled signature.
+	 * \param[out] matches Match addresses. May be nullptr if maxMatches is 0, to just count matches.
+	 * \param[in] maxMatches Max amount of matches to write.
+	 * \param[in] alignment Required alignment of a match; 4 for instructions.
+	 * \return The total amount of matches, which may be more than maxMatches.
+	 */
+	uint32_t SigScan(const void* begin, const void* end, const SignatureScanner& scanner, uintptr_t* matches, uint32_t maxMatches, uint32_t alignment = 4);
+
+	/**
+	 * Find the first match of a signature.
+	 *
+	 * \return The address of the first match, or 0 if there was no match.
+	 */
+	uintptr_t SigScanFirst(const void* begin, const void* end, const SignatureScanner& scanner, uint32_t alignment = 4);
+
+	/**
+	 * Find a signature which is expected to match exactly once.
+	 *
+	 * \return The address of the match, or 0 if there were no matches, or more than one.
+	 */
+	uintptr_t SigScanUnique(const void* begin, const void* end, const SignatureScanner& scanner, uint32_t alignment = 4);
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_SIGSCAN_H
@@ -0,0 +1,196 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The symbol database.
+//
+// Addresses of game functions and data, per game version, live in
+// src/utils/Symbols/Symbols.csv. The symdbgen host tool turns it into
+// tables of (name hash, address) pairs sorted by hash, which are compiled in;
+// it can also write a binary database, which can be loaded from host: to
+// override the compiled-in one without rebuilding.
+//
+// Like the patch tables, this has no dependencies on the PS2 SDK, so
+// host tools share it.
+
+#ifndef ELFLDR_SYMBOLDB_H
+#define ELFLDR_SYMBOLDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/GameVersion.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Hash a symbol name (32-bit FNV-1a).
+	 */
+	constexpr uint32_t SymbolHash(const char* name) {
+		uint32_t hash = 0x811c9dc5;
+		while(*name) {
+			hash ^= static_cast<uint8_t>(*name++);
+			hash *= 0x01000193;
+		}
+		return hash;
+	}
+
+	static_assert(SymbolHash("") == 0x811c9dc5);
+	static_assert(SymbolHash("a") == 0xe40c292c);
+
+	struct SymbolEntry {
+		uint32_t hash;
+		uint32_t address;
+	};
+
+	/**
+	 * Symbols for a game version. Entries are sorted by hash.
+	 */
+	struct SymbolTable {
+		Game game;
+		GameRegion region;
+		GameVersion version;
+
+		const SymbolEntry* entries;
+		uint32_t count;
+	};
+
+	/**
+	 * Header of a binary symbol database, followed by the entries (sorted by hash).
+	 */
+	struct SymbolDbHeader {
+		constexpr static uint32_t Magic = 0x444d5953; // 'SYMD'
+		constexpr static uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t count;
+		uint32_t reserved;
+	};
+
+	/**
+	 * Find a symbol in a sorted table, with a binary search.
+	 *
+	 * \return The address, or 0 if the symbol isn't in the table.
+	 */
+	constexpr uint32_t FindSymbolIn(const SymbolEntry* entries, uint32_t count, uint32_t hash) {
+		uint32_t low = 0;
+		uint32_t high = count;
+
+		while(low < high) {
+			const auto mid = low + (high - low) / 2;
+			if(entries[mid].hash < hash)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		if(low < count && entries[low].hash == hash)
+			return entries[low].address;
+		return 0;
+	}
+
+	namespace symboldb_checks {
+		constexpr SymbolEntry entries[] { { 0x10, 1 }, { 0x20, 2 }, { 0x30, 3 } };
+		static_assert(FindSymbolIn(&entries[0], 3, 0x10) == 1 && FindSymbolIn(&entries[0], 3, 0x30) == 3);
+		static_assert(FindSymbolIn(&entries[0], 3, 0x25) == 0 && FindSymbolIn(&entries[0], 3, 0x40) == 0);
+		static_assert(FindSymbolIn(&entries[0], 0, 0x10) == 0);
+	} // namespace symboldb_checks
+
+	/**
+	 * Find the compiled-in symbol table for a game version.
+	 *
+	 * \return The table, or nullptr if there isn't one.
+	 */
+	const SymbolTable* FindSymbolTable(Game game, GameRegion region, GameVersion version);
+
+	/**
+	 * Load a binary symbol database, which overrides the compiled-in table
+	 * for the running game version. Only the ELF can load one.
+	 *
+	 * \param[in] path Path to the database, e.g. "host:symbols.symdb".
+	 * \return True if the database was loaded.
+	 */
+	bool LoadSymbolDatabase(const char* path);
+
+	/**
+	 * Start loading a symbol database, without waiting for it.
+	 * Finish it with FinishLoadSymbolDatabase() before looking up symbols.
+	 *
+	 * \param[in] path Path to the database. Must stay valid until it's finished.
+	 * \return True if the database is being read.
+	 */
+	bool BeginLoadSymbolDatabase(const char* path);
+
+	/**
+	 * Wait for the database started by BeginLoadSymbolDatabase(), and check it.
+	 * \return True if the database was loaded.
+	 */
+	bool FinishLoadSymbolDatabase();
+
+	/**
+	 * Find a symbol for the running game version.
+	 *
+	 * \return The address, or 0 if the symbol isn't known for this version.
+	 */
+	uintptr_t FindSymbol(uint32_t hash);
+
+	inline uintptr_t FindSymbol(const char* name) {
+		return FindSymbol(SymbolHash(name));
+	}
+
+	/**
+	 * Binds a function wrapper (or anything else with a SetFunctionAddress())
+	 * to a symbol.
+	 */
+	struct SymbolBinding {
+		const char* name;
+		uint32_t hash;
+		void* target;
+		void (*bind)(void* target, uintptr_t address);
+
+		/**
+		 * Whether it's worth a warning when the symbol isn't known.
+		 */
+		bool required;
+	};
+
+	/**
+	 * Make a binding for a function wrapper.
+	 */
+	template <class T>
+	constexpr SymbolBinding BindSymbol(const char* name, T& target) {
+		return { name, SymbolHash(name), &target, [](void* target, uintptr_t address) {
+					static_cast<T*>(target)->SetFunctionAddress(address);
+				}, true };
+	}
+
+	/**
+	 * Make a binding for a function wrapper which can do without the function.
+	 */
+	template <class T>
+	constexpr SymbolBinding BindOptionalSymbol(const char* name, T& target) {
+		auto binding = BindSymbol(name, target);
+		binding.required = false;
+		return binding;
+	}
+
+	/**
+	 * Bind a set of function wrappers for the running game version.
+	 * Symbols which aren't known for this version are left alone; only
+	 * required ones are warned about.
+	 *
+	 * \return Amount of bindings which were bound.
+	 */
+	uint32_t BindFunctions(const SymbolBinding* bindings, uint32_t count);
+
+	template <size_t N>
+	inline uint32_t BindFunctions(const SymbolBinding (&bindings)[N]) {
+		return BindFunctions(&bindings[0], N);
+	}
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_SYMBOLDB_H
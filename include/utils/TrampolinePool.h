@@ -0,0 +1,56 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// A pool for small pieces of generated code (hook trampolines and such).
+//
+// Code is carved out of 8KB slabs, instead of allocating every trampoline
+// from the game heap, so trampolines stay packed together in memory (better
+// for the I-cache), and hooking hundreds of functions costs a handful of
+// allocations.
+
+#ifndef ELFLDR_TRAMPOLINEPOOL_H
+#define ELFLDR_TRAMPOLINEPOOL_H
+
+#include <stdint.h>
+
+namespace elfldr::util {
+
+	/**
+	 * Slot sizes the pool can hand out.
+	 * Large slots are aligned to an EE cache line.
+	 */
+	enum class TrampolineSlot : uint8_t {
+		Small, // 32 bytes
+		Large  // 64 bytes
+	};
+
+	constexpr uint32_t TrampolineSlotSize(TrampolineSlot slot) {
+		return slot == TrampolineSlot::Small ? 32 : 64;
+	}
+
+	/**
+	 * Allocate a trampoline slot.
+	 * The contents are undefined. Never returns nullptr.
+	 */
+	uint32_t* AllocTrampolineSlot(TrampolineSlot slot);
+
+	/**
+	 * Return a trampoline slot to the pool.
+	 * Slabs themselves are never freed.
+	 */
+	void FreeTrampolineSlot(void* ptr, TrampolineSlot slot);
+
+	struct TrampolinePoolStats {
+		uint32_t slabs;
+		uint32_t slotsInUse;
+	};
+
+	TrampolinePoolStats GetTrampolinePoolStats();
+
+} // namespace elfldr::util
+
+#endif // ELFLDR_TRAMPOLINEPOOL_H
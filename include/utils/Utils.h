@@ -20,11 +20,10 @@ namespace elfldr::util {
 	constexpr static size_t MaxPath = 260;
 
 	// TODO for utils:
-	//  	- Logger with format
-	//		- Separate log channels (that can be enabled/disabled in cfg file?)
-	//		- Verbose setting?
 	//		- asserts always blast?
 	//		- Uhh.. that's about it
+	//
+	// For leveled/per-channel logging, see utils/Log.h.
 
 	void DebugInit();
 
@@ -33,6 +32,25 @@ namespace elfldr::util {
 	 */
 	void DebugOut(const char* format, ...);
 
+	/**
+	 * DebugOut(), with the arguments in a va_list, and some text (e.g. "[erl] warning: ")
+	 * put in front of the message. The message is formatted once, straight into the line;
+	 * a line too long to fit ends in "...".
+	 */
+	void DebugOutV(const char* prefix, const char* format, __builtin_va_list val);
+
+	/**
+	 * Write any buffered log lines to the log file, and wait for them to be written.
+	 * Log lines are otherwise written in batches.
+	 */
+	void DebugFlush();
+
+	/**
+	 * Enable or disable crash-safe logging. In this mode, every line
+	 * is written to the log file (synchronously) as it's logged.
+	 */
+	void DebugSetSyncMode(bool sync);
+
 	void DebugClose();
 
 } // namespace elfldr::util
@@ -14,6 +14,7 @@
 #include <loadfile.h>
 #include <mlstd/Assert.h>
 #include <sifrpc.h>
+#include <utils/Log.h>
 #include <utils/Utils.h>
 
 namespace elfldr {
@@ -56,7 +57,7 @@ namespace elfldr {
 	}
 
 	bool ElfLoader::LoadElf(const char* inputPath) {
-		util::DebugOut("[ElfLoader] Loading ELF File \"%s\"...", inputPath);
+		ELFLDR_LOG_INFO(Loader, "Loading ELF File \"%s\"...", inputPath);
 
 		SifLoadElf(inputPath, &gExecData);
 
@@ -38,6 +38,20 @@ namespace elfldr {
 		return *patch;
 	}
 
+	void ApplyPatch(ElfPatch* patch) {
+		auto begin = util::GetJournalPosition();
+		patch->Apply();
+		patch->journalSpan = util::JournalSpanSince(begin);
+	}
+
+	bool RevertPatch(ElfPatch* patch) {
+		if(!util::RevertJournal(patch->journalSpan))
+			return false;
+
+		patch->journalSpan = {};
+		return true;
+	}
+
 	/*
 	ElfPatch* GetPatchByIdentifier(const char* ident) {
 		// ident must be a valid string pointer
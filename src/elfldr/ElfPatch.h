@@ -9,6 +9,7 @@
 #define PATCH_H
 
 #include <stdint.h>
+#include <utils/PatchJournal.h>
 
 namespace elfldr {
 
@@ -29,8 +30,26 @@ namespace elfldr {
 		 * with the current game.
 		 */
 		virtual void Apply() = 0;
+
+		/**
+		 * The journal entries made by the last ApplyPatch() of this patch.
+		 */
+		util::JournalSpan journalSpan {};
 	};
 
+	/**
+	 * Apply a patch, recording the span of journal entries it made.
+	 */
+	void ApplyPatch(ElfPatch* patch);
+
+	/**
+	 * Revert everything a patch wrote when it was applied.
+	 *
+	 * \return True if the patch was reverted; false if something
+	 * 			applied after it wrote over the same memory.
+	 */
+	bool RevertPatch(ElfPatch* patch);
+
 	// TODO: might be scrapping patch ids
 	// in place for identifiers
 
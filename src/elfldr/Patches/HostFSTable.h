@@ -0,0 +1,231 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Patch data for the HostFS patch.
+// This header is also used by the host patchtool, so keep it free of PS2 SDK includes.
+
+#ifndef ELFLDR_PATCHES_HOSTFSTABLE_H
+#define ELFLDR_PATCHES_HOSTFSTABLE_H
+
+#include <utils/PatchTable.h>
+
+namespace elfldr::patches {
+
+	namespace hostfs {
+		using namespace util::patch;
+
+		// Only records whose original bytes follow from the patch itself have
+		// digests (.Expect()). The others are left unchecked on purpose: the strings
+		// are written over slack space or over paths whose old contents aren't
+		// known, and the code patches replace instructions nobody has a dump of.
+		// Run patchtool digest on a dump of the game to add the rest.
+
+		inline constexpr util::PatchRecord SSXOG_NTSC_10[] {
+			// ASYNCFILE_init usually gets "cd:".
+			// We replace this with a string which will match "host",
+			// after we..
+			//
+			// (Only "cd:" is known to be there, so only that is checked.
+			// Digests are from patchtool hash.)
+			Replace(0x002c4e70, "host").Expect(0xf25afa06, 4),
+
+			// replace the strncmp length param constant in ASYNCFILE_init
+			// from 6 to 4, so we can just use "host".
+			Byte(0x00238550, 0x4).Expect(0x020c5866),
+
+			// Write a new string in some slack space.
+			String(0x002c5cc4, "host:"),
+
+			// Overwrite the pointer that the path "beautification" function uses to strcat()
+			// "host0:" pointing it to our HostFS path instead.
+			Word(0x002c59c8, 0x002c5cc4),
+
+			// Write new IOP module paths
+			String(0x002b3ab0, "host:data/modules/ioprp16.img"),
+			String(0x002b3b08, "host:data/modules/sio2man.irx"),
+			String(0x002b3b48, "host:data/modules/padman.irx"),
+			String(0x002b3b88, "host:data/modules/libsd.irx"),
+			String(0x002b3bc8, "host:data/modules/sdrdrv.irx"),
+			String(0x002b3c08, "host:data/modules/snddrv.irx"), // eac custom!!!
+			String(0x002b3c48, "host:data/modules/mcman.irx"),
+			String(0x002b3c88, "host:data/modules/mcserv.irx"),
+
+			// This will completely disable loading worlds from BIG files.
+			// Only enable this if you've extracted everything!!!
+			Nop(0x00187704, 3), // nop TheApp.MountWorld(...) in cGame::cGame()
+			Nop(0x001879f4, 2), // nop TheApp.UnmountWorld() in cGame::~cGame()
+
+			// you know what? fuck you
+			// *unbigs your files*
+			// (i could patch bxMain() but cApplication::Run() never returns in release.)
+			// Nop(0x00183b68, 36),
+
+			// replace beq with bne, i hope this works LUL
+			// Word(0x00238800, 0x14400017),
+
+			// replace li 0x2 with 0x0
+			// Word(0x00238770, 0x24120000),
+
+			// Rewrite most of the cWorld path strings to remove the |.
+			// This allows world files to either be loose or inside of the venue BIG files
+			// (as long as the above code is not enabled).
+
+			// I don't think this is ever used cause the game mounts the big
+			// before calling cWorld::Load(). Maybe older versions of the function
+			// mounted the BIG file from this path itself? We may never know
+			// (unless said older builds leak of course..)
+			String(0x002bdfc0, "data/models/%s.big"),
+
+			// Actually used paths.
+			String(0x002bdfd8, "data/models/%s.wdx"),
+			String(0x002bdff0, "data/models/%s.wdf"),
+			String(0x002be008, "data/models/%s.wdr"),
+			String(0x002be020, "data/models/%s.wdv"),
+			String(0x002be038, "data/models/%s.wds"),
+			String(0x002be050, "data/models/%s.wfx"),
+			String(0x002be068, "data/models/%s.aip"),
+			String(0x002be080, "data/models/%s.ssh"),
+			String(0x002be098, "data/models/%sl.ssh"),
+			String(0x002b6d10, "data/models/%s_sky")
+		};
+
+		inline constexpr util::PatchRecord SSXDVD_NTSC_10[] {
+			// The new REAL library version introduced here onwards
+			// doesn't hardcode the length of the host0 string, and trying to hardcode
+			// the length results in crashing.
+			// So we admit defeat and just give it what it wants, to a point.
+			Replace(0x00387468, "host0:"),
+			String(0x003b9130, "host:"),
+
+			// Write new IOP module paths
+			String(0x00387258, "host:data/modules/ioprp224.img"),
+			String(0x003872b0, "host:data/modules/sio2man.irx"),
+			String(0x003872f0, "host:data/modules/padman.irx"),
+			String(0x00387330, "host:data/modules/libsd.irx"),
+			String(0x00387370, "host:data/modules/snddrv.irx"),
+			String(0x003873b0, "host:data/modules/mcman.irx"),
+			String(0x003873f0, "host:data/modules/mcserv.irx"),
+
+			// Bigless Characters
+			String(0x0039B420, "data/char/eddie_body.mpf"),
+			String(0x0039B440, "data/char/kaori_body.mpf"),
+			String(0x0039B460, "data/char/luther_body.mpf"),
+			String(0x0039B480, "data/char/mac_body.mpf"),
+			String(0x0039B498, "data/char/moby_body.mpf"),
+			String(0x0039B4B8, "data/char/zoe_body.mpf"),
+			String(0x0039B4D0, "data/char/jp_body.mpf"),
+			String(0x0039B4E8, "data/char/elise_body.mpf"),
+			String(0x0039B508, "data/char/psymon_body.mpf"),
+			String(0x0039B528, "data/char/seeiah_body.mpf"),
+			String(0x0039B548, "data/char/brodi_body.mpf"),
+			String(0x0039B568, "data/char/marisol_body.mpf"),
+			String(0x0039B588, "data/char/zz_mmm_body.mpf"),
+			String(0x0039B5A8, "data/char/eddie_head.mpf"),
+			String(0x0039B5C8, "data/char/kaori_head.mpf"),
+			String(0x0039B5E8, "data/char/luther_head.mpf"),
+			String(0x0039B608, "data/char/mac_head.mpf"),
+			String(0x0039B620, "data/char/moby_head.mpf"),
+			String(0x0039B640, "data/char/zoe_head.mpf"),
+			String(0x0039B658, "data/char/jp_head.mpf"),
+			String(0x0039B670, "data/char/elise_head.mpf"),
+			String(0x0039B690, "data/char/psymon_head.mpf"),
+			String(0x0039B6B0, "data/char/seeiah_head.mpf"),
+			String(0x0039B6D0, "data/char/brodi_head.mpf"),
+			String(0x0039B6F0, "data/char/marisol_head.mpf"),
+			String(0x0039B710, "data/char/zz_mmm_head.mpf"),
+			// String(0x0039B440, "data/char/board.mpf"),
+
+			// Eddie's alternate suits; 32 byte slots, suit then boot.
+			String(0x0039B730, "data/char/eddie1_suit.ssh"),
+			String(0x0039B750, "data/char/eddie1_boot.ssh"),
+			String(0x0039B770, "data/char/eddie2_suit.ssh"),
+			String(0x0039B790, "data/char/eddie2_boot.ssh"),
+			String(0x0039B7B0, "data/char/eddie3_suit.ssh"),
+			String(0x0039B7D0, "data/char/eddie3_boot.ssh"),
+			String(0x0039B7F0, "data/char/eddie4_suit.ssh"),
+			String(0x0039B810, "data/char/eddie4_boot.ssh"),
+			String(0x0039B830, "data/char/eddie5_suit.ssh"),
+			String(0x0039B850, "data/char/eddie5_boot.ssh"),
+			String(0x0039B870, "data/char/eddie6_suit.ssh"),
+			String(0x0039B890, "data/char/eddie6_boot.ssh"),
+
+			// BIGless worlds
+			// You'll need bigfile's bigextract to extract the world archives,
+			// since they're c0fb BIG archives.
+
+			// It seems they got a little mad at the mound of paths and made paths composed
+			// via sprintf(), so this is actually quite a bit easier to do than OG.
+			Replace(0x003a7bb8, "data/models/%s%s"),
+
+			// NOP world BIG file mounts, both for hardcoded SSXFE and the world's mounting
+			Nop(0x001862dc, 4),
+			Word(0x00263e1c, 0x00000000)
+		};
+
+		inline constexpr util::PatchRecord SSXDVD_JAMPACK_DEMO[] {
+			Nop(0x001803ec, 84),
+
+			Replace(0x00381db8, ""),
+			Replace(0x00381dc0, "host:"),
+
+			Replace(0x00381b10, "host:data/modules/ioprp224.img"),
+
+			String(0x00381bd0, "host:data/modules/sio2man.irx"),
+
+			// String(0x00381bd0, ""),
+			String(0x00381c00, "host:data/modules/padman.irx"),
+			String(0x00381c90, "host:data/modules/libsd.irx"),
+
+			// FIXME: These two share an address; the mcman write wins.
+			String(0x00381ca8, "host:data/modules/snddrv.irx"),
+			String(0x00381ca8, "host:data/modules/mcman.irx"),
+			String(0x00381d38, "host:data/modules/mcserv.irx")
+		};
+
+		// TODO: Bigless
+		// (maybe as an ERL, we can patch loading chunks)
+
+		// TODO: The game still passes some cdrom0: paths,
+		// but it's only to some network module garbage,
+		// so it's probably fine. if not we can fix it later!
+		inline constexpr util::PatchRecord SSX3_NTSC_10[] {
+			Replace(0x004a3ed8, "host0:"),
+			Replace(0x0048d9c8, "host:"),
+
+			// null terminate the ';1' so it isn't concatenated
+			// to paths (HostFS doesn't need it)
+			Byte(0x004a3ea0, 0x0).Expect(0x3f0cb86d), // ';'
+
+			String(0x00495828, "host:")
+		};
+
+		// doesn't work yet :( idk why
+		inline constexpr util::PatchRecord SSX3_KR_DEMO[] {
+			Replace(0x004be1e8, "host0:"),
+			Replace(0x004b1580, "host:"),
+			Replace(0x004b0f88, "host:"),
+			Replace(0x0049efb8, "host:"),
+
+			Byte(0x004be190, 0x0),
+
+			// 0049efc8
+			Replace(0x0049efc8, "%sdata/modules/")
+		};
+
+	} // namespace hostfs
+
+	inline constexpr util::PatchTable HostFsTables[] {
+		util::MakePatchTable(util::Game::SSXOG, util::GameRegion::NTSC, util::GameVersion::SSXOG_10, hostfs::SSXOG_NTSC_10),
+		util::MakePatchTable(util::Game::SSXDVD, util::GameRegion::NTSC, util::GameVersion::SSXDVD_10, hostfs::SSXDVD_NTSC_10),
+		util::MakePatchTable(util::Game::SSXDVD, util::GameRegion::NotApplicable, util::GameVersion::SSXDVD_JAMPACK_DEMO, hostfs::SSXDVD_JAMPACK_DEMO),
+		util::MakePatchTable(util::Game::SSX3, util::GameRegion::NTSC, util::GameVersion::SSX3_10, hostfs::SSX3_NTSC_10),
+		util::MakePatchTable(util::Game::SSX3, util::GameRegion::NotApplicable, util::GameVersion::SSX3_KR_DEMO, hostfs::SSX3_KR_DEMO)
+	};
+
+} // namespace elfldr::patches
+
+#endif // ELFLDR_PATCHES_HOSTFSTABLE_H
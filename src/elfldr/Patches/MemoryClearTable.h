@@ -0,0 +1,63 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Patch data for the MemoryClear patch.
+// This header is also used by the host patchtool, so keep it free of PS2 SDK includes.
+
+#ifndef ELFLDR_PATCHES_MEMORYCLEARTABLE_H
+#define ELFLDR_PATCHES_MEMORYCLEARTABLE_H
+
+#include <utils/PatchTable.h>
+
+namespace elfldr::patches {
+
+	namespace memclr {
+		using namespace util::patch;
+
+		// These have no original-bytes digests, on purpose: every record replaces
+		// instructions, and what they were isn't known without a dump of the game
+		// to run patchtool digest on. Guessing them would make a correct game fail
+		// verification.
+
+		inline constexpr util::PatchRecord SSXOG_NTSC_10[] {
+			// NOP fill the direct memory clearing loop in bxPreInit()
+			Nop(0x0018a6d8, 10),
+
+			// initheapdebug()
+			Word(0x0018a2a0, 0x10000016), // b to the jr ra once the needed logic for the game not to crash is done
+			Word(0x0018a2a4, 0x00000000), // clear out the newly created delay slot to avoid side effects
+
+			// Disable MEM_init and initheapdebug
+			Nop(0x0018a704, 6)
+		};
+
+		inline constexpr util::PatchRecord SSXDVD_NTSC_10[] {
+			// bxPreInit
+			Word(0x00182b08, 0x00000000),
+
+			// initheapdebug()
+			// nopping out the writes themselves seems to be the best here.
+			Word(0x001826c8, 0x00000000),
+			Word(0x00182700, 0x00000000)
+
+			// still need to nop out MEM_init and initheapdebug()
+		};
+
+		// SSX3 release does not actually clear the memory,
+		// so patch data for it isn't needed!
+		// go EA
+
+	} // namespace memclr
+
+	inline constexpr util::PatchTable MemoryClearTables[] {
+		util::MakePatchTable(util::Game::SSXOG, util::GameRegion::NTSC, util::GameVersion::SSXOG_10, memclr::SSXOG_NTSC_10),
+		util::MakePatchTable(util::Game::SSXDVD, util::GameRegion::NTSC, util::GameVersion::SSXDVD_10, memclr::SSXDVD_NTSC_10)
+	};
+
+} // namespace elfldr::patches
+
+#endif // ELFLDR_PATCHES_MEMORYCLEARTABLE_H
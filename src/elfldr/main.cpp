@@ -15,14 +15,34 @@
 // Autogenerated version header
 #include <mlstd/DynamicArray.h>
 #include <stdio.h>
+#include <utils/DirectoryIndex.h>
+#include <utils/FioFile.h>
 #include <utils/GameVersion.h>
+#include <utils/Log.h>
+#include <utils/SymbolDb.h>
 #include <utils/VersionProbe.h>
 #include <Version.h>
 
 elfldr::ElfLoader gLoader;
 
+/**
+ * Configure log channels from host:logconfig.txt, if it exists.
+ * See elfldr::util::LogConfigure() for the format.
+ */
+static void LoadLogConfig() {
+	elfldr::util::FioFile file;
+	file.Open("host:logconfig.txt", FIO_O_RDONLY);
+	if(!file)
+		return;
+
+	char config[512] {};
+	if(auto read = file.Read(&config[0], sizeof(config) - 1); read > 0)
+		elfldr::util::LogConfigure(&config[0]);
+}
+
 int main() {
 	elfldr::util::DebugInit();
+	LoadLogConfig();
 
 #ifndef NDEBUG
 	elfldr::util::DebugOut("SSX-ElfLdr version " ELFLDR_VERSION_TAG " (" __DATE__ " " __TIME__ ")");
@@ -48,6 +68,14 @@ int main() {
 	// TODO: only display if auto-detecting the game
 	elfldr::util::DebugOut("GameID: \"%s\"", gdata.GameID().CStr());
 
+	// A symbol database on the host overrides the built-in addresses,
+	// so new addresses can be tried without rebuilding.
+	//
+	// Loading the ELF is a LOADFILE RPC, which doesn't need fio,
+	// so the database is read while that goes on.
+	if(elfldr::util::GetHostIndex().Exists(elfldr::util::HostIndexRoot, "symbols.symdb"))
+		elfldr::util::BeginLoadSymbolDatabase("host:symbols.symdb");
+
 	// Load the ELF int memory. This won't clobber us because we load very high in memory,
 	// at least compared to the normal PS2 linker scripts
 	{
@@ -59,6 +87,8 @@ int main() {
 		}
 	}
 
+	elfldr::util::FinishLoadSymbolDatabase();
+
 	// Set up the mlstd memory allocator automagically.
 	//
 	// Once this is called we can use pretty much all the fun things
@@ -72,9 +102,9 @@ int main() {
 		if(patch == nullptr)
 			return;
 
-		elfldr::util::DebugOut("[Patch %s] Applying patch...", patch->GetName());
-		patch->Apply();
-		elfldr::util::DebugOut("[Patch %s] Finished applying.", patch->GetName());
+		ELFLDR_LOG_INFO(Patch, "%s: Applying patch...", patch->GetName());
+		elfldr::ApplyPatch(patch);
+		ELFLDR_LOG_INFO(Patch, "%s: Finished applying (%u journaled writes).", patch->GetName(), patch->journalSpan.Count());
 	};
 
 	// Apply the basic ELF patches, HostFS and MemoryClear.
@@ -82,6 +112,10 @@ int main() {
 	ApplyElfPatch(elfldr::GetPatchById(0x01));
 
 	// Load codehooks into memory and initialize them.
+	//
+	// TODO: Nothing loads codehooks yet. The mod overlay, packs and file tracer
+	// 		are set up by the modfiles codehook (src/modfiles, ModFiles.h), not here:
+	// 		this ELF sits in the game's heap and is gone once the game runs.
 
 	// Execute the game ELF.
 	char* argv[3];
@@ -91,6 +125,7 @@ int main() {
 
 	elfldr::util::DebugOut("Executing game ELF (end of resident execution)\n");
 
+	// Also flushes the log buffer, since nothing will after this.
 	elfldr::util::DebugClose();
 	gLoader.ExecElf(sizeof(argv) / sizeof(char**), argv);
 
@@ -11,23 +11,14 @@
 #include <mlstd/DynamicArray.h>
 #include <mlstd/HashTable.h>
 #include <mlstd/ScopeExitGuard.h>
+#include <mlstd/Span.h>
 #include <mlstd/String.h>
 #include <utils/CodeUtils.h>
 #include <utils/FioFile.h>
+#include <utils/Log.h>
 
 #include "../elfldr/ElfLoader.h"
 
-#define DEBUG
-
-#define ERL_RELEASE_PRINTF(format, ...) elfldr::util::DebugOut("[ERL] " format, ##__VA_ARGS__)
-
-// if building debug, then we can afford to be a bit more chatty.
-#ifdef DEBUG
-	#define ERL_DEBUG_PRINTF(format, ...) elfldr::util::DebugOut("[ERL] " format, ##__VA_ARGS__)
-#else
-	#define ERL_DEBUG_PRINTF(format, ...)
-#endif
-
 namespace elfldr::erl {
 
 	constexpr uint32_t Align(uint32_t alignment_value, int align) {
@@ -62,7 +53,7 @@ namespace elfldr::erl {
 	 */
 	struct ImageImpl {
 		~ImageImpl() {
-			ERL_DEBUG_PRINTF("~ImageImpl()");
+			ELFLDR_LOG_DEBUG(Erl, "~ImageImpl()");
 		}
 
 		Symbol ResolveSymbol(const char* symbolName) {
@@ -118,6 +109,14 @@ namespace elfldr::erl {
 			if(!file)
 				return ErlLoadError::FileNotFound;
 
+			// ERLs are small, and parsing them touches most of the file
+			// in lots of small pieces, so read it all in one go and work from memory.
+			contents = file.ReadAll(allocator);
+			if(!contents)
+				return ErlLoadError::ErrorReading;
+
+			file.Close();
+
 			// load the header
 			if(auto res = LoadHeader(); res.HasError())
 				return res.Error();
@@ -126,27 +125,32 @@ namespace elfldr::erl {
 			if(auto res = LoadSectionHeaders(); res.HasError())
 				return res.Error();
 
+			ELFLDR_LOG_DEBUG(Erl, "Read %u bytes", static_cast<uint32_t>(contents.Bytes().Size()));
 			return {};
 		}
 
 		LoadResult<> LoadHeader() {
-			if(file.Read(reinterpret_cast<void*>(&header_), sizeof(header_)) != sizeof(header_))
+			const auto bytes = contents.Bytes();
+			if(bytes.Size() < sizeof(Elf32_Ehdr))
 				return ErlLoadError::ErrorReading;
 
+			// The buffer is aligned, so the headers can be used in place.
+			header_ = reinterpret_cast<const Elf32_Ehdr*>(bytes.Data());
+
 			// Validate elf header, return error condition
 
-			if(memcmp(header_.e_ident, ELFMAG, sizeof(ELFMAG) - 1)) // NOLINT (we want this to branch if it's not exact)
+			if(memcmp(header_->e_ident, ELFMAG, sizeof(ELFMAG) - 1)) // NOLINT (we want this to branch if it's not exact)
 				return ErlLoadError::NotElf;
 
-			if(header_.e_machine != EM_MIPS)
+			if(header_->e_machine != EM_MIPS)
 				return ErlLoadError::NotMips;
 
-			if(header_.e_type != ET_REL)
+			if(header_->e_type != ET_REL)
 				return ErlLoadError::NotRelocatable;
 
 			// Do some size sanity checks
 
-			if(sizeof(Elf32_Shdr) != header_.e_shentsize)
+			if(sizeof(Elf32_Shdr) != header_->e_shentsize)
 				return ErlLoadError::SizeMismatch;
 
 			// Now we're good.
@@ -154,21 +158,27 @@ namespace elfldr::erl {
 		}
 
 		LoadResult<void> LoadSectionHeaders() {
-			shdrs_.Resize(header_.e_shnum);
+			const auto size = header_->e_shnum * sizeof(Elf32_Shdr);
+			const auto table = contents.Bytes().Subspan(header_->e_shoff, size);
 
-			file.Seek(header_.e_shoff, SEEK_SET);
-
-			if(auto count = header_.e_shnum * sizeof(Elf32_Shdr); file.Read(reinterpret_cast<void*>(&shdrs_[0]), count) != static_cast<int>(count))
+			if(table.Size() != size || header_->e_shoff % alignof(Elf32_Shdr) != 0)
 				return ErlLoadError::ErrorReading;
 
+			shdrs_ = { reinterpret_cast<const Elf32_Shdr*>(table.Data()), header_->e_shnum };
 			return {};
 		}
 
 	   private:
 		util::FioFile file;
+
+		mlstd::StdAllocator<uint8_t> allocator;
+		util::FileBuffer<> contents;
+
 		ImageImpl* image;
-		Elf32_Ehdr header_ {};
-		mlstd::DynamicArray<Elf32_Shdr> shdrs_;
+
+		// Views into contents.
+		const Elf32_Ehdr* header_ {};
+		mlstd::Span<const Elf32_Shdr> shdrs_;
 	};
 
 	// helper to reduce the boilerplate.
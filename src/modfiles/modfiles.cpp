@@ -0,0 +1,26 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The mod files codehook.
+//
+// It stays loaded while the game runs, so the game file hooks, and the
+// mod overlay and packs behind them, live here (see utils/ModFiles.h).
+
+#include <sdk/ErlAbi.h>
+#include <utils/GameVersion.h>
+#include <utils/ModFiles.h>
+#include <utils/VersionProbe.h>
+
+ELFLDR_CODEHOOK_EXPORT void elfldr_codehook_init(elfldr::CodehookInitData* codehookInitData) {
+	// This ERL has its own copy of the utils, so it needs telling what game is running.
+	elfldr::util::GetGameVersionData() = codehookInitData->verData;
+	elfldr::util::SetupAllocator();
+
+	elfldr::util::InstallModFiles();
+}
+
+ELFLDR_ERL("modfiles");
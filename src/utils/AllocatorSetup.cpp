@@ -9,65 +9,24 @@
 #include <mlstd/Optional.h>
 #include <sdk/GameApi.h>
 #include <utils/GameVersion.h>
+#include <utils/SymbolDb.h>
 
 namespace elfldr::util {
 
 	void SetupAllocator() {
 		const auto& verData = GetGameVersionData();
 
-		// This sets the addresses of functions we need to use
+		// This sets the addresses of functions we need to use.
+		// The addresses live in the symbol database.
+		const SymbolBinding bindings[] {
+			BindSymbol("MEM_init", bx::real::MEM_init),
+			BindSymbol("initheapdebug", bx::real::initheapdebug),
+			BindSymbol("MEM_alloc", bx::real::MEM_alloc),
+			BindSymbol("MEM_free", bx::real::MEM_free),
 
-		switch(verData.game) {
-			case Game::SSXOG: {
-				switch(verData.version) {
-					case GameVersion::SSXOG_10:
-
-						switch(verData.region) {
-							case GameRegion::NTSC:
-								bx::real::MEM_init.SetFunctionAddress(0x0023b2a0);
-								bx::real::initheapdebug.SetFunctionAddress(0x0018a280);
-
-								bx::real::MEM_alloc.SetFunctionAddress(0x0023a448);
-								bx::real::MEM_free.SetFunctionAddress(0x0023a998);
-
-								// We don't really need to set this, it's just a curiosity.
-								bx::printf.SetFunctionAddress(0x0018ac08);
-								break;
-							case GameRegion::NTSCJ:
-								break;
-							default:
-								break;
-						}
-						break;
-
-					default:
-						break;
-				}
-			} break;
-
-			case Game::SSXDVD:
-				switch(verData.version) {
-					case GameVersion::SSXDVD_10:
-						switch(verData.region) {
-							case GameRegion::NTSC:
-								bx::real::MEM_init.SetFunctionAddress(0x002cd798);
-								bx::real::initheapdebug.SetFunctionAddress(0x002cd798);
-
-								bx::real::MEM_alloc.SetFunctionAddress(0x002ccf70);
-								bx::real::MEM_free.SetFunctionAddress(0x002ccfc0);
-								break;
-							default:
-								break;
-						}
-						break;
-					default:
-						break;
-				}
-				break;
-
-			default:
-				break;
-		}
+			// We don't really need to set this, it's just a curiosity.
+			BindOptionalSymbol("printf", bx::printf)
+		};
 
 		// seems like all regions and versions use the same exact params, so I guess I can wing it this time
 
@@ -87,6 +46,10 @@ namespace elfldr::util {
 					oldreal_unk_before_memstart = oldreal_memstart - 0x800;
 				}
 
+				// Only bind for the games this knows how to set up;
+				// there's no point warning about the others' symbols.
+				BindFunctions(bindings);
+
 
 				// Initialize the allocator if we're not the ERL.
 				// If we are the ERL then the main ML ELF has done the work
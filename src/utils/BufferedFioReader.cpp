@@ -0,0 +1,185 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <string.h>
+#include <utils/BufferedFioReader.h>
+
+namespace elfldr::util {
+
+	namespace {
+		// SIF DMA works in 64-byte cache lines; an aligned buffer
+		// saves the IOP side from bouncing the misaligned ends.
+		constexpr uintptr_t BufferAlignment = 64;
+	} // namespace
+
+	BufferedFioReader::BufferedFioReader(FioFile& file, uint32_t blockSize)
+		: file(file),
+		  blockSize(blockSize) {
+		rawBuffer = mlstd::Alloc(blockSize + BufferAlignment);
+		if(rawBuffer)
+			buffer = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(rawBuffer) + BufferAlignment - 1) & ~(BufferAlignment - 1));
+	}
+
+	BufferedFioReader::~BufferedFioReader() {
+		if(rawBuffer)
+			mlstd::Free(rawBuffer);
+	}
+
+	bool BufferedFioReader::Good() const {
+		return buffer != nullptr && file.Good();
+	}
+
+	bool BufferedFioReader::SyncFilePosition() {
+		if(filePosition == position)
+			return true;
+
+		++stats.rpcCalls;
+		if(file.Seek(static_cast<int>(position), FIO_SEEK_SET) < 0)
+			return false;
+
+		filePosition = position;
+		return true;
+	}
+
+	bool BufferedFioReader::Fill(uint32_t minimum) {
+		if(!SyncFilePosition())
+			return false;
+
+		bufferStart = position;
+		bufferLength = 0;
+
+		// fio can come up short; keep going until there's enough, or the file ends.
+		while(bufferLength < minimum) {
+			++stats.rpcCalls;
+			const auto read = file.Read(&buffer[bufferLength], blockSize - bufferLength);
+			if(read < 0) {
+				bufferLength = 0;
+				return false;
+			}
+
+			if(read == 0)
+				break;
+
+			bufferLength += static_cast<uint32_t>(read);
+			filePosition += static_cast<uint32_t>(read);
+			stats.bytesRead += static_cast<uint32_t>(read);
+		}
+
+		return true;
+	}
+
+	int BufferedFioReader::Read(void* dest, size_t length) {
+		if(!Good())
+			return -1;
+
+		auto* out = static_cast<uint8_t*>(dest);
+		size_t done = 0;
+		bool touchedFile = false;
+
+		while(done < length) {
+			// Serve what we can from the buffer.
+			if(position >= bufferStart && position < bufferStart + bufferLength) {
+				const auto offset = position - bufferStart;
+				auto count = bufferLength - offset;
+				if(count > length - done)
+					count = length - done;
+
+				memcpy(&out[done], &buffer[offset], count);
+				done += count;
+				position += count;
+				continue;
+			}
+
+			touchedFile = true;
+
+			// Big reads go straight to the destination.
+			if(length - done >= blockSize) {
+				if(!SyncFilePosition())
+					return -1;
+
+				++stats.rpcCalls;
+				const auto read = file.Read(&out[done], length - done);
+				if(read < 0)
+					return -1;
+
+				// End of file.
+				if(read == 0)
+					break;
+
+				done += read;
+				position += read;
+				filePosition += read;
+				stats.bytesRead += read;
+				continue;
+			}
+
+			if(!Fill(1))
+				return -1;
+
+			// End of file.
+			if(bufferLength == 0)
+				break;
+		}
+
+		if(!touchedFile)
+			++stats.bufferHits;
+
+		return static_cast<int>(done);
+	}
+
+	bool BufferedFioReader::ReadExact(void* dest, size_t length) {
+		return Read(dest, length) == static_cast<int>(length);
+	}
+
+	const uint8_t* BufferedFioReader::Peek(size_t length) {
+		if(!Good() || length > blockSize)
+			return nullptr;
+
+		// Refill if the bytes aren't all in the buffer already.
+		if(position < bufferStart || position + length > bufferStart + bufferLength) {
+			if(!Fill(static_cast<uint32_t>(length)))
+				return nullptr;
+		}
+
+		if(position + length > bufferStart + bufferLength)
+			return nullptr;
+
+		return &buffer[position - bufferStart];
+	}
+
+	void BufferedFioReader::Seek(uint32_t newPosition) {
+		// Nothing happens to the file until the next read needs it.
+		position = newPosition;
+	}
+
+	void BufferedFioReader::Skip(uint32_t length) {
+		position += length;
+	}
+
+	uint32_t BufferedFioReader::Tell() const {
+		return position;
+	}
+
+	int BufferedFioReader::Size() {
+		if(!Good())
+			return -1;
+
+		++stats.rpcCalls;
+		const auto size = file.Seek(0, FIO_SEEK_END);
+		if(size < 0)
+			return -1;
+
+		filePosition = static_cast<uint32_t>(size);
+		return size;
+	}
+
+	const BufferedFioReader::Stats& BufferedFioReader::GetStats() const {
+		return stats;
+	}
+
+} // namespace elfldr::util
@@ -10,18 +10,20 @@
 
 #include <mlstd/Assert.h>
 #include <utils/CodeUtils.h>
+#include <utils/Log.h>
+#include <utils/PatchJournal.h>
 #include <utils/Utils.h>
 
 namespace elfldr::util {
 
 	void ReplaceString(void* addr, const char* string) {
-		DebugOut("Replacing string \"%s\" at %p: \"%s\"...", reinterpret_cast<char*>(addr), addr, string);
-		memcpy(addr, string, strlen(string) + 1);
+		ELFLDR_LOG_DEBUG(Patch, "Replacing string \"%s\" at %p: \"%s\"...", reinterpret_cast<char*>(addr), addr, string);
+		WriteMemory(addr, string, strlen(string) + 1);
 	}
 
 	void WriteString(void* addr, const char* string) {
-		DebugOut("Writing string at %p: \"%s\"...", addr, string);
-		memcpy(addr, string, strlen(string) + 1);
+		ELFLDR_LOG_DEBUG(Patch, "Writing string at %p: \"%s\"...", addr, string);
+		WriteMemory(addr, string, strlen(string) + 1);
 	}
 
 } // namespace elfldr::util
\ No newline at end of file
@@ -0,0 +1,120 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Assert.h>
+#include <string.h>
+#include <utils/DirectoryIndex.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		constexpr bool IsSeparator(char c) {
+			return c == '/' || c == '\\';
+		}
+
+	} // namespace
+
+	DirectoryIndex::DirectoryIndex(mlstd::Span<Entry> slots, mlstd::Span<char> strings)
+		: slots(slots),
+		  strings(strings) {
+		MLSTD_ASSERT(slots.Size() != 0 && (slots.Size() & (slots.Size() - 1)) == 0);
+		Clear();
+	}
+
+	const char* DirectoryIndex::CopyString(const char* string, uint32_t length) {
+		if(stringsUsed + length + 1 > strings.Size())
+			return nullptr;
+
+		auto* copy = &strings[stringsUsed];
+		memcpy(copy, string, length);
+		copy[length] = '\0';
+		stringsUsed += length + 1;
+		return copy;
+	}
+
+	uint32_t DirectoryIndex::AddEmptyRoot(const char* path) {
+		if(rootCount == MaxRoots)
+			return NoRoot;
+
+		roots[rootCount] = CopyString(path, static_cast<uint32_t>(strlen(path)));
+		if(!roots[rootCount])
+			return NoRoot;
+
+		return rootCount++;
+	}
+
+	void DirectoryIndex::RemoveLastRoot() {
+		const auto root = --rootCount;
+		stringsUsed = static_cast<uint32_t>(roots[root] - &strings[0]);
+		roots[root] = nullptr;
+	}
+
+	bool DirectoryIndex::Insert(uint32_t root, mlstd::StringView path, uint32_t size, uint8_t flags) {
+		// Keep the table at most 3/4 full, so misses end quickly.
+		if((count + 1) * 4 > slots.Size() * 3)
+			return false;
+
+		const auto hash = PathHash(path.Data(), path.Length());
+		auto slot = SlotFor(root, hash);
+
+		while(slots[slot].path) {
+			const auto& entry = slots[slot];
+			if(entry.root == root && entry.hash == hash && PathEquals(entry.path, entry.pathLength, path.Data(), path.Length()))
+				return true;
+			slot = (slot + 1) & (slots.Size() - 1);
+		}
+
+		auto* copy = CopyString(path.Data(), path.Length());
+		if(!copy)
+			return false;
+
+		slots[slot] = { copy, hash, size, static_cast<uint16_t>(path.Length()), static_cast<uint8_t>(root), flags };
+		++count;
+		return true;
+	}
+
+	const DirectoryIndex::Entry* DirectoryIndex::Find(uint32_t root, mlstd::StringView path) const {
+		auto* data = path.Data();
+		auto length = path.Length();
+		while(length != 0 && IsSeparator(*data)) {
+			++data;
+			--length;
+		}
+
+		const auto hash = PathHash(data, length);
+		auto slot = SlotFor(root, hash);
+
+		while(slots[slot].path) {
+			const auto& entry = slots[slot];
+			if(entry.root == root && entry.hash == hash && PathEquals(entry.path, entry.pathLength, data, length))
+				return &entry;
+			slot = (slot + 1) & (slots.Size() - 1);
+		}
+
+		return nullptr;
+	}
+
+	int DirectoryIndex::Size(uint32_t root, mlstd::StringView path) const {
+		if(auto* entry = Find(root, path); entry)
+			return static_cast<int>(entry->size);
+		return -1;
+	}
+
+	void DirectoryIndex::Clear() {
+		for(auto& entry : slots)
+			entry = {};
+
+		stringsUsed = 0;
+		count = 0;
+
+		for(auto& root : roots)
+			root = nullptr;
+		rootCount = 0;
+	}
+
+} // namespace elfldr::util
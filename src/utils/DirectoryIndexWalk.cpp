@@ -0,0 +1,99 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The parts of DirectoryIndex which walk directories, through the fio backend.
+
+#include <string.h>
+#include <utils/DirectoryIndex.h>
+#include <utils/FioDirectory.h>
+#include <utils/Log.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		constexpr bool IsSeparator(char c) {
+			return c == '/' || c == '\\';
+		}
+
+	} // namespace
+
+	uint32_t DirectoryIndex::AddRoot(const char* path, uint32_t maxDepth) {
+		const auto length = static_cast<uint32_t>(strlen(path));
+		if(length >= MaxPath)
+			return NoRoot;
+
+		// One buffer for the whole walk; names are appended,
+		// and the end moved back after each.
+		char buffer[MaxPath];
+		memcpy(&buffer[0], path, length + 1);
+
+		// Paths are stored relative to the root, without the separator after it.
+		// "host:" doesn't need one at all.
+		auto relativeStart = length;
+		if(length != 0 && buffer[length - 1] != ':' && !IsSeparator(buffer[length - 1]))
+			++relativeStart;
+
+		const auto root = AddEmptyRoot(path);
+		if(root == NoRoot)
+			return NoRoot;
+
+		FioDirectory dir { mlstd::StringView(&buffer[0]) };
+		if(!dir) {
+			RemoveLastRoot();
+			return NoRoot;
+		}
+
+		if(!Walk(dir, root, &buffer[0], length, relativeStart, 0, maxDepth))
+			ELFLDR_LOG_WARNING(Fio, "Directory index is full; %s is only partly indexed", path);
+
+		return root;
+	}
+
+	bool DirectoryIndex::Walk(FioDirectory& dir, uint32_t root, char* path, uint32_t length, uint32_t relativeStart, uint32_t depth, uint32_t maxDepth) {
+		bool ok = true;
+
+		dir.Iterate([&](io_dirent_t& entry) {
+			const auto nameLength = static_cast<uint32_t>(strlen(&entry.name[0]));
+			if(nameLength == 0 || !strcmp(&entry.name[0], ".") || !strcmp(&entry.name[0], ".."))
+				return true;
+
+			// The root's own path doesn't get a separator, if it doesn't need one.
+			auto entryLength = length;
+			if(entryLength != relativeStart)
+				++entryLength;
+
+			if(entryLength + nameLength >= MaxPath) {
+				ELFLDR_LOG_WARNING(Fio, "Path \"%s/%s\" is too long to index", path, &entry.name[0]);
+				return true;
+			}
+
+			if(entryLength != length)
+				path[length] = '/';
+			memcpy(&path[entryLength], &entry.name[0], nameLength + 1);
+			entryLength += nameLength;
+
+			const bool directory = ELFLDR_FIO_ISDIR(entry);
+			const mlstd::StringView relative { &path[relativeStart], entryLength - relativeStart };
+
+			if(!Insert(root, relative, entry.stat.size, directory ? Entry::DirectoryFlag : 0))
+				ok = false;
+			else if(directory && depth < maxDepth) {
+				FioDirectory subdirectory { mlstd::StringView(&path[0]) };
+				if(subdirectory)
+					ok = Walk(subdirectory, root, path, entryLength, relativeStart, depth + 1, maxDepth);
+			}
+
+			path[length] = '\0';
+			return ok;
+		});
+
+		return ok;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,360 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <string.h>
+#include <utils/CycleCounter.h>
+#include <utils/FileTrace.h>
+#include <utils/LazyLock.h>
+#include <utils/Log.h>
+#include <utils/PathHash.h>
+#include <utils/Profiler.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		static_assert((FileTraceCapacity & (FileTraceCapacity - 1)) == 0, "FileTraceCapacity must be a power of two");
+
+		/**
+		 * Open files, so reads can be traced with the file and where in it they were.
+		 */
+		constexpr uint32_t MaxTracedFiles = 64;
+
+		struct TracedFile {
+			int fd;
+			uint32_t hash;
+			uint32_t position;
+		};
+
+		// Sony's sceOpen() flags.
+		constexpr int SceWriteOnly = 0x0002;
+		constexpr int SceAppend = 0x0100;
+		constexpr int SceCreate = 0x0200;
+		constexpr int SceTruncate = 0x0400;
+
+		/**
+		 * Flush when the game hasn't touched a file for this long (the same gap
+		 * tracereport splits load phases at), or every this often regardless.
+		 */
+		constexpr uint32_t FileTraceIdleFlushCycles = EeClockHz / 2;
+		constexpr uint32_t FileTraceFlushIntervalCycles = EeClockHz * 5;
+
+		char gPath[MaxPath] {};
+
+		// Made the first time it's taken, so on the game's side of ExecPS2().
+		LazyLock gLock;
+		FileTraceIo gIo {};
+
+		// The first flush replaces whatever was in the trace file.
+		bool gFileCreated = false;
+
+		// The ring. Records from gTail up to gHead haven't been flushed yet;
+		// both only ever count up.
+		FileTraceRecord* gRecords = nullptr;
+		uint32_t gHead = 0;
+		uint32_t gTail = 0;
+		uint32_t gDropped = 0;
+		bool gFlushing = false;
+
+		// Names of every file opened. The ones from gFlushedNames on
+		// haven't been written yet.
+		FileTraceName* gNames = nullptr;
+		char* gPaths = nullptr;
+		uint32_t gNameCount = 0;
+		uint32_t gPathsSize = 0;
+		uint32_t gFlushedNames = 0;
+		uint32_t gFlushedPathsSize = 0;
+
+		TracedFile gFiles[MaxTracedFiles] {};
+
+		// For extending the cycle counter.
+		uint32_t gLastCount = 0;
+		uint64_t gLastTime = 0;
+
+		// Cycle counter when the ring was last flushed.
+		uint32_t gFlushCount = 0;
+
+		/**
+		 * The path, relative to its device.
+		 */
+		const char* DeviceRelativePath(const char* path) {
+			if(auto* colon = strchr(path, ':'); colon)
+				path = colon + 1;
+			while(IsPathSeparator(*path))
+				++path;
+			return path;
+		}
+
+		/**
+		 * Turn a cycle counter value into a time since tracing started. Call with the lock held.
+		 *
+		 * Calls on other threads can be traced a little out of order,
+		 * so the counter is allowed to go backwards a bit.
+		 */
+		uint64_t Extend(uint32_t count) {
+			const auto delta = static_cast<int32_t>(count - gLastCount);
+			if(delta < 0)
+				return static_cast<uint64_t>(-static_cast<int64_t>(delta)) > gLastTime ? 0 : gLastTime + delta;
+
+			gLastCount = count;
+			gLastTime += static_cast<uint32_t>(delta);
+			return gLastTime;
+		}
+
+		/**
+		 * Call with the lock held.
+		 */
+		void Record(const FileTraceRecord& record) {
+			if(gHead - gTail == FileTraceCapacity) {
+				++gDropped;
+				return;
+			}
+
+			gRecords[gHead & (FileTraceCapacity - 1)] = record;
+			++gHead;
+		}
+
+		/**
+		 * Remember a file's name, if it's new. Call with the lock held.
+		 *
+		 * This is a linear search, but opens are rare, and each is a host round trip anyway.
+		 */
+		void AddName(uint32_t hash, const char* path, size_t length) {
+			for(uint32_t i = 0; i < gNameCount; ++i)
+				if(gNames[i].hash == hash)
+					return;
+
+			if(gNameCount == FileTraceMaxNames || gPathsSize + length + 1 > FileTracePathsSize)
+				return;
+
+			memcpy(&gPaths[gPathsSize], path, length);
+			gPaths[gPathsSize + length] = '\0';
+			gNames[gNameCount++] = { hash, gPathsSize };
+			gPathsSize += static_cast<uint32_t>(length) + 1;
+		}
+
+		TracedFile* FindFile(int fd) {
+			for(auto& file : gFiles)
+				if(file.fd == fd)
+					return &file;
+			return nullptr;
+		}
+
+	} // namespace
+
+	bool StartFileTrace(const char* path) {
+		if(gRecords)
+			StopFileTrace();
+
+		auto* records = static_cast<FileTraceRecord*>(mlstd::Alloc(FileTraceCapacity * sizeof(FileTraceRecord)));
+		auto* names = static_cast<FileTraceName*>(mlstd::Alloc(FileTraceMaxNames * sizeof(FileTraceName)));
+		auto* paths = static_cast<char*>(mlstd::Alloc(FileTracePathsSize));
+
+		if(!records || !names || !paths) {
+			ELFLDR_LOG_ERROR(Fio, "Not enough memory to trace files");
+			if(records)
+				mlstd::Free(records);
+			if(names)
+				mlstd::Free(names);
+			if(paths)
+				mlstd::Free(paths);
+			return false;
+		}
+
+		strncpy(&gPath[0], path, sizeof(gPath) - 1);
+		gFileCreated = false;
+		gHead = gTail = gDropped = 0;
+		gFlushing = false;
+		gNameCount = gPathsSize = gFlushedNames = gFlushedPathsSize = 0;
+		for(auto& traced : gFiles)
+			traced.fd = -1;
+
+		gLastCount = gFlushCount = ReadCycleCounter();
+		gLastTime = 0;
+
+		gNames = names;
+		gPaths = paths;
+		gRecords = records;
+
+		ELFLDR_LOG_INFO(Fio, "Tracing file access to %s", path);
+		return true;
+	}
+
+	void SetFileTraceIo(const FileTraceIo& io) {
+		gIo = io;
+	}
+
+	bool FileTraceEnabled() {
+		return gRecords != nullptr;
+	}
+
+	void TraceFileOpen(const char* path, FileTraceSource source, int fd, uint32_t start, uint32_t end) {
+		if(!gRecords)
+			return;
+
+		path = path ? DeviceRelativePath(path) : "";
+		const auto length = strlen(path);
+		const auto hash = PathHash(path, length);
+
+		LazyLockGuard lock(gLock);
+		if(!lock || !gRecords)
+			return;
+
+		AddName(hash, path, length);
+		Record({ Extend(start), end - start, hash, 0, 0, fd, FileTraceOp::Open, source, 0 });
+
+		if(fd < 0)
+			return;
+
+		// An fd is only open once at a time, so a stale one (from a close which wasn't seen) is reused.
+		auto* file = FindFile(fd);
+		if(!file)
+			file = FindFile(-1);
+		if(file)
+			*file = { fd, hash, 0 };
+	}
+
+	void TraceFileOp(FileTraceOp op, int fd, uint32_t length, int result, uint32_t start, uint32_t end) {
+		if(!gRecords)
+			return;
+
+		LazyLockGuard lock(gLock);
+		if(!lock || !gRecords)
+			return;
+
+		// Files opened before tracing started have no name (a hash of 0).
+		auto* file = fd >= 0 ? FindFile(fd) : nullptr;
+		Record({ Extend(start), end - start, file ? file->hash : 0, file ? file->position : 0, length, result, op, FileTraceSource::Game, 0 });
+
+		if(!file)
+			return;
+
+		switch(op) {
+			case FileTraceOp::Read:
+				if(result > 0)
+					file->position += result;
+				break;
+			case FileTraceOp::Seek:
+				if(result >= 0)
+					file->position = result;
+				break;
+			case FileTraceOp::Close: file->fd = -1; break;
+			default: break;
+		}
+	}
+
+	bool FileTraceWantsFlush() {
+		if(!gRecords || gFlushing || gHead == gTail)
+			return false;
+
+		if(gHead - gTail >= FileTraceCapacity / 4 * 3)
+			return true;
+
+		// Otherwise, write what there is when the game's been idle for a bit
+		// (so between load phases), or it's been a while, so the trace file is
+		// never far behind, even if the ring never fills or tracing never stops.
+		// These are 32-bit differences, so a gap longer than the counter
+		// wraps around in might not be noticed; the next call will be.
+		const auto now = ReadCycleCounter();
+		return now - gLastCount >= FileTraceIdleFlushCycles || now - gFlushCount >= FileTraceFlushIntervalCycles;
+	}
+
+	void FlushFileTrace() {
+		if(!gRecords)
+			return;
+
+		FileTraceChunkHeader header { FileTraceChunkHeader::Magic, FileTraceChunkHeader::CurrentVersion, EeClockHz, 0, 0, 0, 0, 0 };
+		uint32_t head;
+		uint32_t tail;
+		uint32_t nameCount;
+		uint32_t pathsSize;
+
+		// Without the game's file functions there's no way to write it; keep it for later.
+		if(!gIo.open || !gIo.write || !gIo.close)
+			return;
+
+		// Take what's there now. Anything traced while it's written goes after it,
+		// so none of this needs the lock while it's written.
+		{
+			LazyLockGuard lock(gLock);
+			if(!lock || gFlushing)
+				return;
+
+			gFlushing = true;
+			head = gHead;
+			tail = gTail;
+			nameCount = gNameCount;
+			pathsSize = gPathsSize;
+			header.dropped = gDropped;
+			gDropped = 0;
+		}
+
+		header.recordCount = head - tail;
+		header.nameCount = nameCount - gFlushedNames;
+		header.pathsSize = pathsSize - gFlushedPathsSize;
+
+		// Names are written with offsets from the start of this chunk's paths.
+		for(auto i = gFlushedNames; i < nameCount; ++i)
+			gNames[i].pathOffset -= gFlushedPathsSize;
+
+		// fio's bindings are stale once the game has rebooted the IOP,
+		// so this goes through the game's own (unhooked) file functions.
+		const auto fd = gIo.open(&gPath[0], SceWriteOnly | (gFileCreated ? SceAppend : SceCreate | SceTruncate), 0644);
+		if(fd >= 0) {
+			gFileCreated = true;
+
+			// Every write is a host round trip, so skip empty ones.
+			auto Write = [&](const void* data, size_t size) {
+				if(size != 0)
+					gIo.write(fd, data, static_cast<int>(size));
+			};
+
+			Write(&header, sizeof(header));
+
+			// The records might wrap around the end of the ring.
+			const auto first = tail & (FileTraceCapacity - 1);
+			const auto firstCount = header.recordCount < FileTraceCapacity - first ? header.recordCount : FileTraceCapacity - first;
+			Write(&gRecords[first], firstCount * sizeof(FileTraceRecord));
+			Write(&gRecords[0], (header.recordCount - firstCount) * sizeof(FileTraceRecord));
+
+			Write(&gNames[gFlushedNames], header.nameCount * sizeof(FileTraceName));
+			Write(&gPaths[gFlushedPathsSize], header.pathsSize);
+			gIo.close(fd);
+		} else {
+			ELFLDR_LOG_ERROR(Fio, "Couldn't write to file trace %s (%d); %u records lost", &gPath[0], fd, header.recordCount);
+		}
+
+		LazyLockGuard lock(gLock);
+		gFlushCount = ReadCycleCounter();
+		gTail = head;
+		gFlushedNames = nameCount;
+		gFlushedPathsSize = pathsSize;
+		gFlushing = false;
+	}
+
+	void StopFileTrace() {
+		if(!gRecords)
+			return;
+
+		FlushFileTrace();
+
+		{
+			LazyLockGuard lock(gLock);
+			mlstd::Free(gRecords);
+			mlstd::Free(gNames);
+			mlstd::Free(gPaths);
+			gRecords = nullptr;
+			gNames = nullptr;
+			gPaths = nullptr;
+		}
+
+		gLock.Destroy();
+	}
+
+} // namespace elfldr::util
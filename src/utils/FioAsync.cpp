@@ -0,0 +1,155 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/FioAsync.h>
+#include <utils/FioBackend.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		/**
+		 * The read fio is working on. Only one at a time.
+		 */
+		FioReadRequest* gInFlight = nullptr;
+
+		/**
+		 * Reads waiting for their turn, oldest first.
+		 */
+		FioReadRequest* gQueueHead = nullptr;
+		FioReadRequest* gQueueTail = nullptr;
+
+		void Complete(int result) {
+			gInFlight->result = result;
+			gInFlight->state = FioReadRequest::State::Done;
+			gInFlight = nullptr;
+		}
+
+		void StartNext() {
+			auto* request = gQueueHead;
+			gQueueHead = request->next;
+			if(gQueueHead == nullptr)
+				gQueueTail = nullptr;
+
+			request->next = nullptr;
+			request->state = FioReadRequest::State::InFlight;
+			gInFlight = request;
+
+			// In no-wait mode, fio returns as soon as the RPC is sent.
+			// It goes straight back to waiting mode, so nothing else is surprised by it.
+			Fio().setBlockMode(FIO_NOWAIT);
+			const auto result = Fio().read(request->fd, request->buffer, static_cast<int>(request->length));
+			Fio().setBlockMode(FIO_WAIT);
+
+			// The RPC couldn't even be sent.
+			if(result < 0)
+				Complete(result);
+		}
+
+		/**
+		 * Check on, or wait for, the read in flight.
+		 *
+		 * \param[in] mode FIO_NOWAIT to check, FIO_WAIT to wait.
+		 */
+		void SyncInFlight(int mode) {
+			int result = -1;
+
+			// fioSync() only works in no-wait mode.
+			Fio().setBlockMode(FIO_NOWAIT);
+			const auto status = Fio().sync(mode, &result);
+			Fio().setBlockMode(FIO_WAIT);
+
+			if(status == FIO_COMPLETE)
+				Complete(result);
+		}
+
+	} // namespace
+
+	FioReadRequest::~FioReadRequest() {
+		if(Pending())
+			FioWait(*this);
+	}
+
+	bool FioReadRequest::Done() {
+		FioPoll();
+		return !Pending();
+	}
+
+	int FioReadRequest::Wait() {
+		return FioWait(*this);
+	}
+
+	bool FioQueueRead(FioReadRequest& request, int fd, void* buffer, size_t length) {
+		if(request.Pending())
+			return false;
+
+		request.fd = fd;
+		request.buffer = buffer;
+		request.length = length;
+		request.result = -1;
+		request.next = nullptr;
+
+		if(fd <= 0) {
+			request.state = FioReadRequest::State::Done;
+			return false;
+		}
+
+		request.state = FioReadRequest::State::Queued;
+		if(gQueueTail)
+			gQueueTail->next = &request;
+		else
+			gQueueHead = &request;
+		gQueueTail = &request;
+
+		// Get it going now if fio is free, so it overlaps with whatever comes next.
+		if(gInFlight == nullptr)
+			StartNext();
+		return true;
+	}
+
+	void FioPoll() {
+		if(gInFlight)
+			SyncInFlight(FIO_NOWAIT);
+
+		if(gInFlight == nullptr && gQueueHead)
+			StartNext();
+	}
+
+	int FioWait(FioReadRequest& request) {
+		while(request.Pending()) {
+			if(gInFlight)
+				SyncInFlight(FIO_WAIT);
+			else
+				StartNext();
+		}
+
+		return request.result;
+	}
+
+	void FioWaitAll() {
+		while(gInFlight || gQueueHead) {
+			if(gInFlight)
+				SyncInFlight(FIO_WAIT);
+			else
+				StartNext();
+		}
+	}
+
+	bool FioReadInFlight() {
+		return gInFlight != nullptr;
+	}
+
+	namespace detail {
+
+		void FioSettle() {
+			if(gInFlight)
+				SyncInFlight(FIO_WAIT);
+		}
+
+	} // namespace detail
+
+} // namespace elfldr::util
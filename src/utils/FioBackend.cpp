@@ -0,0 +1,52 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/FioBackend.h>
+
+namespace elfldr::util {
+
+#ifdef _EE
+	namespace {
+
+		const FioBackend gNativeFioBackend {
+			.open = fioOpen,
+			.close = fioClose,
+			.read = fioRead,
+			.write = fioWrite,
+			.lseek = fioLseek,
+
+			.dopen = fioDopen,
+			.dclose = fioDclose,
+			.dread = fioDread,
+
+			.setBlockMode = fioSetBlockMode,
+			.sync = fioSync
+		};
+
+	} // namespace
+
+	namespace detail {
+		const FioBackend* gFioBackend = &gNativeFioBackend;
+	}
+#else
+	namespace detail {
+		// Host builds have no native fio; set a backend first.
+		const FioBackend* gFioBackend = nullptr;
+	}
+#endif
+
+	void SetFioBackend(const FioBackend& backend) {
+		detail::gFioBackend = &backend;
+	}
+
+#ifdef _EE
+	const FioBackend& NativeFioBackend() {
+		return gNativeFioBackend;
+	}
+#endif
+
+} // namespace elfldr::util
@@ -5,6 +5,8 @@
  * under the terms of the MIT license.
  */
 
+#include <utils/FioAsync.h>
+#include <utils/FioBackend.h>
 #include <utils/FioDirectory.h>
 
 namespace elfldr::util {
@@ -14,12 +16,15 @@ namespace elfldr::util {
 	}
 
 	FioDirectory::~FioDirectory() {
-		if(Good())
-			fioDclose(fd);
+		if(Good()) {
+			detail::FioSettle();
+			Fio().dclose(fd);
+		}
 	}
 
 	bool FioDirectory::Open(mlstd::StringView path) {
-		fd = fioDopen(path.CStr());
+		detail::FioSettle();
+		fd = Fio().dopen(path.CStr());
 		if(!Good())
 			return false;
 
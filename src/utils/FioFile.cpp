@@ -6,6 +6,7 @@
  */
 
 #include <mlstd/Assert.h>
+#include <utils/FioBackend.h>
 #include <utils/FioFile.h>
 #include <utils/Utils.h>
 #include <string.h>
@@ -25,20 +26,50 @@ namespace elfldr::util {
 	}
 
 	void FioFile::Close() {
-		if(Good())
-			fioClose(fd);
+		if(Good()) {
+			detail::FioSettle();
+			Fio().close(fd);
+		}
+		fd = -1;
 	}
 
 	int FioFile::Read(void* buffer, size_t length) {
-		if(Good())
-			return fioRead(fd, buffer, length);
+		if(Good()) {
+			detail::FioSettle();
+			return Fio().read(fd, buffer, length);
+		}
 
 		return -1;
 	}
 
+	bool FioFile::ReadAsync(FioReadRequest& request, void* buffer, size_t length) {
+		return FioQueueRead(request, fd, buffer, length);
+	}
+
+	int FioFile::ReadFully(void* buffer, size_t length) {
+		auto* out = static_cast<uint8_t*>(buffer);
+		size_t done = 0;
+
+		while(done < length) {
+			const auto read = Read(&out[done], length - done);
+			if(read < 0)
+				return -1;
+
+			// End of file.
+			if(read == 0)
+				break;
+
+			done += read;
+		}
+
+		return static_cast<int>(done);
+	}
+
 	int FioFile::Write(const void* buffer, size_t length) {
-		if(Good())
-			return fioWrite(fd, buffer, length);
+		if(Good()) {
+			detail::FioSettle();
+			return Fio().write(fd, buffer, length);
+		}
 
 		return -1;
 	}
@@ -52,8 +83,10 @@ namespace elfldr::util {
 
 	int FioFile::Seek(int offset, int whence) {
 		MLSTD_ASSERT(Good());
-		if(Good())
-			return fioLseek(fd, offset, whence);
+		if(Good()) {
+			detail::FioSettle();
+			return Fio().lseek(fd, offset, whence);
+		}
 
 		return -1;
 	}
@@ -61,19 +94,32 @@ namespace elfldr::util {
 	int FioFile::Tell() {
 		// are you kidding me? No tell?
 		// whatever, this works
-		if(Good())
-			return fioLseek(fd, 0, FIO_SEEK_CUR);
+		if(Good()) {
+			detail::FioSettle();
+			return Fio().lseek(fd, 0, FIO_SEEK_CUR);
+		}
 
 		return -1;
 	}
 
+	int FioFile::Size() {
+		const auto position = Tell();
+		if(position < 0)
+			return -1;
+
+		const auto size = Seek(0, FIO_SEEK_END);
+		Seek(position, FIO_SEEK_SET);
+		return size;
+	}
+
 	void FioFile::Open(const char* path, int openflags) {
 		// If there's already a file managed by this object,
 		// close it to prevent fd leaks.
 		if(Good())
 			Close();
 
-		fd = fioOpen(path, openflags);
+		detail::FioSettle();
+		fd = Fio().open(path, openflags);
 	}
 
 } // namespace elfldr::util
\ No newline at end of file
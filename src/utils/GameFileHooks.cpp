@@ -0,0 +1,413 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/CodeUtils.h>
+#include <utils/CycleCounter.h>
+#include <utils/FileTrace.h>
+#include <utils/GameFileHooks.h>
+#include <utils/Hook.h>
+#include <utils/LazyLock.h>
+#include <utils/Log.h>
+#include <utils/SymbolDb.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		// int sceOpen(const char* filename, int flag, ...).
+		// The optional mode is passed in a register like any other argument,
+		// so it can be passed along as one.
+		using OpenFunction = int (*)(const char*, int, int);
+		using CloseFunction = int (*)(int);
+		using ReadFunction = int (*)(int, void*, int);
+		using LseekFunction = int (*)(int, int, int);
+		using WriteFunction = int (*)(int, const void*, int);
+
+		// Sony's values for these.
+		constexpr int SceReadOnly = 0x0001;
+		constexpr int SceAccessMask = 0x0003;
+		constexpr int SceSeekSet = 0;
+		constexpr int SceSeekCur = 1;
+		constexpr int SceSeekEnd = 2;
+		constexpr int SceEio = 5;
+		constexpr int SceEbadf = 9;
+		constexpr int SceEmfile = 24;
+		constexpr int SceEinval = 22;
+
+		/**
+		 * Files opened from packs get fds from here up, well clear of the real ones.
+		 */
+		constexpr int PackFdBase = 0x7000;
+		constexpr uint32_t MaxOpenPackFiles = 32;
+
+		constexpr uint32_t UnknownPosition = 0xffffffff;
+
+		struct OpenPackFile {
+			/**
+			 * nullptr if this fd isn't in use.
+			 */
+			const PackEntry* entry;
+			uint32_t pack;
+			uint32_t position;
+		};
+
+		void* gOpenAddress = nullptr;
+		OpenFunction gOriginalOpen = nullptr;
+		const OverlayFs* gOverlay = nullptr;
+
+		void* gCloseAddress = nullptr;
+		void* gReadAddress = nullptr;
+		void* gLseekAddress = nullptr;
+		CloseFunction gOriginalClose = nullptr;
+		ReadFunction gOriginalRead = nullptr;
+		LseekFunction gOriginalLseek = nullptr;
+		const PackSet* gPacks = nullptr;
+
+		// The game can open files from more than one thread,
+		// and a pack's fd is shared between all the files in it.
+		LazyLock gPackLock;
+
+		OpenPackFile gOpenPackFiles[MaxOpenPackFiles] {};
+
+		// The game's fd for each pack, opened the first time it's read from,
+		// and where it was left, so reading on from there doesn't need a seek.
+		int gPackFds[PackSet::MaxPacks];
+		uint32_t gPackFdPositions[PackSet::MaxPacks];
+
+		bool IsPackFd(int fd) {
+			return gPacks && fd >= PackFdBase && fd < PackFdBase + static_cast<int>(MaxOpenPackFiles);
+		}
+
+		/**
+		 * The open file for a pack fd, or nullptr if it's been closed.
+		 * Call with the lock held; another thread can close it until then.
+		 */
+		OpenPackFile* OpenPackFileFor(int fd) {
+			auto* file = &gOpenPackFiles[fd - PackFdBase];
+			return file->entry ? file : nullptr;
+		}
+
+		/**
+		 * The game's fd for a pack. Call with the lock held.
+		 */
+		int PackFd(uint32_t pack) {
+			if(gPackFds[pack] < 0) {
+				gPackFds[pack] = gOriginalOpen(gPacks->Pack(pack).Path(), SceReadOnly, 0);
+				gPackFdPositions[pack] = 0;
+				if(gPackFds[pack] < 0)
+					ELFLDR_LOG_ERROR(Fio, "Couldn't open pack %s (%d)", gPacks->Pack(pack).Path(), gPackFds[pack]);
+			}
+
+			return gPackFds[pack];
+		}
+
+		int OpenPacked(const char* path, uint32_t pack, const PackEntry* entry) {
+			LazyLockGuard lock(gPackLock);
+			if(!lock)
+				return -SceEmfile;
+
+			for(uint32_t i = 0; i < MaxOpenPackFiles; ++i) {
+				if(gOpenPackFiles[i].entry)
+					continue;
+
+				gOpenPackFiles[i] = { entry, pack, 0 };
+				ELFLDR_LOG_TRACE(Fio, "Pack: %s -> %s (fd %d)", path, gPacks->Pack(pack).Path(), PackFdBase + static_cast<int>(i));
+				return PackFdBase + static_cast<int>(i);
+			}
+
+			ELFLDR_LOG_ERROR(Fio, "Too many files open from packs (max %u) to open %s", MaxOpenPackFiles, path);
+			return -SceEmfile;
+		}
+
+		int OpenFile(const char* path, int flags, int mode, FileTraceSource& source) {
+			char redirected[MaxPath];
+
+			if(!path)
+				return gOriginalOpen(path, flags, mode);
+
+			// Loose files win over packs, so a file can be changed without repacking.
+			if(gOverlay->Resolve(path, &redirected[0], sizeof(redirected))) {
+				ELFLDR_LOG_TRACE(Fio, "Overlay: %s -> %s", path, &redirected[0]);
+				source = FileTraceSource::Overlay;
+				return gOriginalOpen(&redirected[0], flags, mode);
+			}
+
+			if(gPacks && (flags & SceAccessMask) == SceReadOnly) {
+				uint32_t pack;
+				if(auto* entry = gPacks->Find(path, pack); entry) {
+					source = FileTraceSource::Pack;
+					return OpenPacked(path, pack, entry);
+				}
+			}
+
+			return gOriginalOpen(path, flags, mode);
+		}
+
+		int CloseFile(int fd) {
+			if(!IsPackFd(fd))
+				return gOriginalClose(fd);
+
+			LazyLockGuard lock(gPackLock);
+			if(!lock)
+				return -SceEio;
+
+			auto* file = OpenPackFileFor(fd);
+			if(!file)
+				return -SceEbadf;
+
+			file->entry = nullptr;
+			return 0;
+		}
+
+		int ReadFile(int fd, void* buffer, int length) {
+			if(!IsPackFd(fd))
+				return gOriginalRead(fd, buffer, length);
+
+			if(length < 0)
+				return -SceEinval;
+
+			LazyLockGuard lock(gPackLock);
+			if(!lock)
+				return -SceEio;
+
+			auto* file = OpenPackFileFor(fd);
+			if(!file)
+				return -SceEbadf;
+
+			const auto size = file->entry->size;
+			const auto left = file->position < size ? size - file->position : 0;
+			const auto wanted = static_cast<uint32_t>(length) < left ? static_cast<uint32_t>(length) : left;
+			if(wanted == 0)
+				return 0;
+
+			const auto packFd = PackFd(file->pack);
+			if(packFd < 0)
+				return packFd;
+
+			// One ranged read of the pack; sequential reads don't even need the seek.
+			auto& packPosition = gPackFdPositions[file->pack];
+			const auto offset = file->entry->offset + file->position;
+			if(packPosition != offset) {
+				if(gOriginalLseek(packFd, static_cast<int>(offset), SceSeekSet) != static_cast<int>(offset)) {
+					packPosition = UnknownPosition;
+					return -SceEio;
+				}
+				packPosition = offset;
+			}
+
+			const auto read = gOriginalRead(packFd, buffer, static_cast<int>(wanted));
+			if(read < 0) {
+				packPosition = UnknownPosition;
+				return read;
+			}
+
+			packPosition += read;
+			file->position += read;
+			return read;
+		}
+
+		int SeekFile(int fd, int offset, int whence) {
+			if(!IsPackFd(fd))
+				return gOriginalLseek(fd, offset, whence);
+
+			LazyLockGuard lock(gPackLock);
+			if(!lock)
+				return -SceEio;
+
+			auto* file = OpenPackFileFor(fd);
+			if(!file)
+				return -SceEbadf;
+
+			int64_t position;
+			switch(whence) {
+				case SceSeekSet: position = offset; break;
+				case SceSeekCur: position = static_cast<int64_t>(file->position) + offset; break;
+				case SceSeekEnd: position = static_cast<int64_t>(file->entry->size) + offset; break;
+				default: return -SceEinval;
+			}
+
+			if(position < 0 || position > 0x7fffffff)
+				return -SceEinval;
+
+			file->position = static_cast<uint32_t>(position);
+			return static_cast<int>(position);
+		}
+
+		// The hooks themselves. These only trace calls; the work's done above.
+
+		int OpenHook(const char* path, int flags, int mode) {
+			if(FileTraceWantsFlush())
+				FlushFileTrace();
+
+			const auto start = ReadCycleCounter();
+			auto source = FileTraceSource::Game;
+			const auto fd = OpenFile(path, flags, mode, source);
+			TraceFileOpen(path, source, fd, start, ReadCycleCounter());
+			return fd;
+		}
+
+		int CloseHook(int fd) {
+			const auto start = ReadCycleCounter();
+			const auto result = CloseFile(fd);
+			TraceFileOp(FileTraceOp::Close, fd, 0, result, start, ReadCycleCounter());
+
+			// Between files is the least disruptive time to write the trace out.
+			if(FileTraceWantsFlush())
+				FlushFileTrace();
+			return result;
+		}
+
+		int ReadHook(int fd, void* buffer, int length) {
+			const auto start = ReadCycleCounter();
+			const auto result = ReadFile(fd, buffer, length);
+			TraceFileOp(FileTraceOp::Read, fd, static_cast<uint32_t>(length), result, start, ReadCycleCounter());
+			return result;
+		}
+
+		int LseekHook(int fd, int offset, int whence) {
+			const auto start = ReadCycleCounter();
+			const auto result = SeekFile(fd, offset, whence);
+			TraceFileOp(FileTraceOp::Seek, fd, static_cast<uint32_t>(offset), result, start, ReadCycleCounter());
+			return result;
+		}
+
+		/**
+		 * Hook the rest of the game's file functions, so files can be read from packs,
+		 * and reads traced.
+		 */
+		bool InstallIoHooks(const PackSet& packs) {
+			const auto closeAddress = FindSymbol("sceClose");
+			const auto readAddress = FindSymbol("sceRead");
+			const auto lseekAddress = FindSymbol("sceLseek");
+			if(closeAddress == 0 || readAddress == 0 || lseekAddress == 0) {
+				ELFLDR_LOG_WARNING(Fio, "sceClose/sceRead/sceLseek aren't known for %s; packs won't be used, and only opens are traced", GetGameVersionData().GameID().CStr());
+				return false;
+			}
+
+			// The pack lock is made the first time the game takes it; see LazyLock.
+			for(auto& fd : gPackFds)
+				fd = -1;
+			for(auto& file : gOpenPackFiles)
+				file.entry = nullptr;
+			gPacks = packs.Count() != 0 ? &packs : nullptr;
+
+			BeginHookBatch();
+			gOriginalClose = HookFunction<CloseFunction>(Ptr(closeAddress), CloseHook);
+			gOriginalRead = HookFunction<ReadFunction>(Ptr(readAddress), ReadHook);
+			gOriginalLseek = HookFunction<LseekFunction>(Ptr(lseekAddress), LseekHook);
+			EndHookBatch();
+
+			gCloseAddress = gOriginalClose ? Ptr(closeAddress) : nullptr;
+			gReadAddress = gOriginalRead ? Ptr(readAddress) : nullptr;
+			gLseekAddress = gOriginalLseek ? Ptr(lseekAddress) : nullptr;
+
+			if(!gCloseAddress || !gReadAddress || !gLseekAddress) {
+				ELFLDR_LOG_ERROR(Fio, "Couldn't hook the game's file functions; packs won't be used, and only opens are traced");
+				return false;
+			}
+
+			return true;
+		}
+
+		void RemoveIoHooks() {
+			// Stop handing out packed files first.
+			gPacks = nullptr;
+
+			if(gCloseAddress)
+				UnhookFunction(gCloseAddress);
+			if(gReadAddress)
+				UnhookFunction(gReadAddress);
+			if(gLseekAddress)
+				UnhookFunction(gLseekAddress);
+
+			// The fds were set up before anything was hooked.
+			if(gOriginalClose) {
+				for(auto& fd : gPackFds) {
+					if(fd >= 0)
+						gOriginalClose(fd);
+					fd = -1;
+				}
+			}
+
+			gPackLock.Destroy();
+
+			gCloseAddress = nullptr;
+			gReadAddress = nullptr;
+			gLseekAddress = nullptr;
+			gOriginalClose = nullptr;
+			gOriginalRead = nullptr;
+			gOriginalLseek = nullptr;
+		}
+
+		/**
+		 * Write the file trace with the game's own functions, now they're hooked.
+		 */
+		void SetUpTraceIo() {
+			// sceWrite isn't hooked, and without the other hooks sceClose isn't either,
+			// so the game's functions are the originals.
+			const auto writeAddress = FindSymbol("sceWrite");
+			const auto closeAddress = FindSymbol("sceClose");
+			if(writeAddress == 0 || closeAddress == 0) {
+				ELFLDR_LOG_WARNING(Fio, "sceWrite/sceClose aren't known for %s; the file trace can't be written", GetGameVersionData().GameID().CStr());
+				return;
+			}
+
+			const auto close = gOriginalClose ? gOriginalClose : reinterpret_cast<CloseFunction>(Ptr(closeAddress));
+			SetFileTraceIo({ gOriginalOpen, reinterpret_cast<WriteFunction>(Ptr(writeAddress)), close });
+		}
+
+	} // namespace
+
+	bool InstallGameFileHooks(const OverlayFs& overlay, const PackSet& packs) {
+		if(gOpenAddress)
+			RemoveGameFileHooks();
+
+		const auto address = FindSymbol("sceOpen");
+		if(address == 0) {
+			ELFLDR_LOG_WARNING(Fio, "sceOpen isn't known for %s; mods won't be overlaid", GetGameVersionData().GameID().CStr());
+			return false;
+		}
+
+		// Set up the packs before hooking sceOpen; the hook can run as soon as it's written,
+		// and can only hand out packed files once the others are hooked too.
+		if((packs.Count() != 0 || FileTraceEnabled()) && !InstallIoHooks(packs))
+			RemoveIoHooks();
+
+		gOverlay = &overlay;
+
+		gOriginalOpen = HookFunction<OpenFunction>(Ptr(address), OpenHook);
+		if(!gOriginalOpen) {
+			ELFLDR_LOG_ERROR(Fio, "Couldn't hook sceOpen at %p", Ptr(address));
+			RemoveIoHooks();
+			gOverlay = nullptr;
+			return false;
+		}
+
+		gOpenAddress = Ptr(address);
+
+		if(FileTraceEnabled())
+			SetUpTraceIo();
+		return true;
+	}
+
+	void RemoveGameFileHooks() {
+		if(!gOpenAddress)
+			return;
+
+		// The trace is written with the original functions, which go away with the hooks.
+		FlushFileTrace();
+		SetFileTraceIo({});
+
+		UnhookFunction(gOpenAddress);
+		RemoveIoHooks();
+		gOpenAddress = nullptr;
+		gOriginalOpen = nullptr;
+		gOverlay = nullptr;
+	}
+
+} // namespace elfldr::util
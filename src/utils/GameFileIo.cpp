@@ -0,0 +1,103 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/CodeUtils.h>
+#include <utils/GameFileIo.h>
+#include <utils/SymbolDb.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		GameFileIo gIo {};
+
+		// The result of the last call, for sync().
+		int gLastResult = 0;
+
+		template <class T>
+		void Find(T& function, const char* name) {
+			function = reinterpret_cast<T>(Ptr(FindSymbol(name)));
+		}
+
+		int Open(const char* path, int flags) {
+			return gLastResult = gIo.open ? gIo.open(path, flags, 0) : -1;
+		}
+
+		int Close(int fd) {
+			return gLastResult = gIo.close ? gIo.close(fd) : -1;
+		}
+
+		int Read(int fd, void* buffer, int length) {
+			return gLastResult = gIo.read ? gIo.read(fd, buffer, length) : -1;
+		}
+
+		int Write(int fd, const void* buffer, int length) {
+			return gLastResult = gIo.write ? gIo.write(fd, buffer, length) : -1;
+		}
+
+		int Lseek(int fd, int offset, int whence) {
+			return gLastResult = gIo.lseek ? gIo.lseek(fd, offset, whence) : -1;
+		}
+
+		int Dopen(const char* path) {
+			return gLastResult = gIo.dopen ? gIo.dopen(path) : -1;
+		}
+
+		int Dclose(int fd) {
+			return gLastResult = gIo.dclose ? gIo.dclose(fd) : -1;
+		}
+
+		int Dread(int fd, io_dirent_t* entry) {
+			return gLastResult = gIo.dread ? gIo.dread(fd, entry) : -1;
+		}
+
+		void SetBlockMode(int) {
+		}
+
+		// Every call has finished by the time it returns.
+		int Sync(int, int* result) {
+			if(result)
+				*result = gLastResult;
+			return FIO_COMPLETE;
+		}
+
+		const FioBackend gGameFioBackend {
+			.open = Open,
+			.close = Close,
+			.read = Read,
+			.write = Write,
+			.lseek = Lseek,
+
+			.dopen = Dopen,
+			.dclose = Dclose,
+			.dread = Dread,
+
+			.setBlockMode = SetBlockMode,
+			.sync = Sync
+		};
+
+	} // namespace
+
+	GameFileIo FindGameFileIo() {
+		GameFileIo io {};
+		Find(io.open, "sceOpen");
+		Find(io.close, "sceClose");
+		Find(io.read, "sceRead");
+		Find(io.write, "sceWrite");
+		Find(io.lseek, "sceLseek");
+		Find(io.dopen, "sceDopen");
+		Find(io.dclose, "sceDclose");
+		Find(io.dread, "sceDread");
+		return io;
+	}
+
+	void UseGameFileIo(const GameFileIo& io) {
+		gIo = io;
+		SetFioBackend(gGameFioBackend);
+	}
+
+} // namespace elfldr::util
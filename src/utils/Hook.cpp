@@ -6,23 +6,41 @@
  */
 
 #include <kernel.h>
-#include <mlstd/Allocator.h>
+#include <mlstd/Assert.h>
 #include <stdint.h>
 #include <string.h>
+#include <utils/CodeUtils.h>
 #include <utils/Hook.h>
+#include <utils/HookRelocator.h>
+#include <utils/HookSite.h>
+#include <utils/Log.h>
 #include <utils/MipsIEncoder.h>
+#include <utils/PatchJournal.h>
+#include <utils/TrampolinePool.h>
+#include <utils/Utils.h>
 
 namespace elfldr::util::detail {
 
-	constexpr static uint32_t callTemplate[] {
-		mips::nop(), // will be replaced by lui t0, top_word
-		mips::nop(), // will be replaced by ori t0, t0, bot_word
-		mips::jr(mips::Reg::T0),
-		mips::nop() // NOP out the branch delay slot (wasting an instruction...)
-	};
+	// Hook batch state. While a batch is open, cache flushes are deferred
+	// until the batch ends.
+	static uint32_t gHookBatchDepth = 0;
+	static bool gHookBatchNeedsFlush = false;
 
-	uint32_t* AllocTrampoline() {
-		return static_cast<uint32_t*>(mlstd::AllocAligned(sizeof(callTemplate) * 2));
+	void FreeSmallTrampoline(void* trampoline) {
+		FreeTrampolineSlot(trampoline, TrampolineSlot::Small);
+	}
+
+	void FreeLargeTrampoline(void* trampoline) {
+		FreeTrampolineSlot(trampoline, TrampolineSlot::Large);
+	}
+
+	void FlushHookedCode() {
+		if(gHookBatchDepth != 0) {
+			gHookBatchNeedsFlush = true;
+			return;
+		}
+
+		FlushCache(CPU_DATA_CACHE | CPU_INSTRUCTION_CACHE);
 	}
 
 	void* HookFunctionBase(void* dest, const void* hook) {
@@ -33,40 +51,95 @@ namespace elfldr::util::detail {
 		if(dest == nullptr || hook == nullptr)
 			return nullptr;
 
-		// Allocate aligned memory for the trampoline.
+		auto* destInstPtr = reinterpret_cast<uint32_t*>(dest);
+
+		// Allocate the trampoline.
 		// This memory is allocated before we do anything with the function,
 		// so hooking the allocator is doable.
-		auto* trampolineBuf = AllocTrampoline();
-		auto* destInstPtr = reinterpret_cast<uint32_t*>(dest);
+		//
+		// Most prologues relocate into a small slot. Ones with branches
+		// need room for stubs, so they get relocated again into a large one.
+		auto slot = TrampolineSlot::Small;
+		auto* trampolineBuf = AllocTrampolineSlot(slot);
+
+		auto Plan = [&]() {
+			return PlanHook(&destInstPtr[0], reinterpret_cast<uintptr_t>(dest), reinterpret_cast<uintptr_t>(hook), reinterpret_cast<uintptr_t>(trampolineBuf));
+		};
+
+		auto [site, relocated] = Plan();
+
+		if(relocated.error == RelocateError::None && relocated.length * sizeof(uint32_t) > TrampolineSlotSize(slot)) {
+			FreeTrampolineSlot(trampolineBuf, slot);
+			slot = TrampolineSlot::Large;
+			trampolineBuf = AllocTrampolineSlot(slot);
+			relocated = Plan().relocated;
+		}
+
+		if(relocated.error != RelocateError::None) {
+			ELFLDR_LOG_WARNING(Hook, "Refusing to hook %p: %s", dest, RelocateErrorString(relocated.error));
+			FreeTrampolineSlot(trampolineBuf, slot);
+			return nullptr;
+		}
+
+		// The trampoline runs the relocated original instructions,
+		// then jumps back into the rest of the function.
+		memcpy(&trampolineBuf[0], &relocated.code[0], relocated.length * sizeof(uint32_t));
+
+		// Then write the hook site into the function. This goes through the journal,
+		// which also takes ownership of the trampoline, so unhooking frees it.
+		uint32_t hookCode[callTemplate.Length];
+		const uintptr_t hookSlots[] { reinterpret_cast<uintptr_t>(hook) };
+
+		if(site == HookSite::Jump)
+			jumpTemplate.LinkAt(&hookCode[0], reinterpret_cast<uintptr_t>(dest), hookSlots);
+		else
+			callTemplate.LinkAt(&hookCode[0], reinterpret_cast<uintptr_t>(dest), hookSlots);
 
-		// Copy out the instructions from the original function,
-		// into our safekeeping buffer.
-		// Then, copy the call template into the function.
-		memcpy(&trampolineBuf[0], &destInstPtr[0], sizeof(callTemplate));
-		memcpy(&destInstPtr[0], &callTemplate[0], sizeof(callTemplate));
+		WriteMemory(&destInstPtr[0], &hookCode[0], HookSiteLength(site) * sizeof(uint32_t), { trampolineBuf, slot == TrampolineSlot::Small ? FreeSmallTrampoline : FreeLargeTrampoline });
 
-		// Place the instructions to load the hook address.
-		destInstPtr[0] = mips::lui(mips::Reg::T0, ((uintptr_t)hook >> 16));
-		destInstPtr[1] = mips::ori(mips::Reg::T0, mips::Reg::T0, (uintptr_t)hook & 0xFFFF);
+		ELFLDR_LOG_TRACE(Hook, "Hooked %p -> %p (trampoline %p)", dest, hook, trampolineBuf);
 
-		// MLSTD_VERIFY(trampolineBuf != nullptr && "Failed to allocate trampoline buffer.");
+		// Flush D/I cache (or let the batch do it), and then return the trampoline.
+		FlushHookedCode();
+		return trampolineBuf;
+	}
 
-		memcpy(&trampolineBuf[sizeof(callTemplate) / sizeof(uint32_t)], &callTemplate[0], sizeof(callTemplate));
+	void* HookVirtualBase(void* vtable, uint32_t slot, const void* hook) {
+		MLSTD_ASSERT(vtable != nullptr && hook != nullptr);
+		if(vtable == nullptr || hook == nullptr)
+			return nullptr;
 
-		// Calculate the start of the original function's instructions.
-		const uintptr_t tramp_dest = (uintptr_t)dest + (sizeof(callTemplate));
+		auto& entry = static_cast<GnuVtablePointer*>(vtable)[slot];
+		auto* original = entry.function_ptr;
 
-		// Place instructions to load the
-		trampolineBuf[sizeof(callTemplate) / sizeof(uint32_t)] = mips::lui(mips::Reg::T0, tramp_dest >> 16);
-		trampolineBuf[sizeof(callTemplate) / sizeof(uint32_t) + 1] = mips::ori(mips::Reg::T0, mips::Reg::T0, tramp_dest & 0xFFFF);
+		WriteMemory32(reinterpret_cast<uint32_t*>(&entry.function_ptr), static_cast<uint32_t>(reinterpret_cast<uintptr_t>(hook)));
+		return original;
+	}
 
-		// Flush D/I cache, just in case, and then return the trampoline.
+} // namespace elfldr::util::detail
+
+namespace elfldr::util {
+
+	void BeginHookBatch() {
+		++detail::gHookBatchDepth;
+	}
+
+	void EndHookBatch() {
+		MLSTD_ASSERT(detail::gHookBatchDepth != 0);
+		if(--detail::gHookBatchDepth != 0 || !detail::gHookBatchNeedsFlush)
+			return;
+
+		detail::gHookBatchNeedsFlush = false;
 		FlushCache(CPU_DATA_CACHE | CPU_INSTRUCTION_CACHE);
-		return trampolineBuf;
 	}
 
-	// definitely enough information to implement a Unhook routine,
-	// just pass in the function + tramp ptr, copy the original tramp bytes
-	// back to the function, free it, bam. unhooked
+	bool UnhookFunction(void* funcptr) {
+		// The journal has the original instructions, and owns the trampoline.
+		return RevertJournalAt(funcptr);
+	}
+
+	bool UnhookVirtual(void* vtable, uint32_t slot) {
+		return RevertJournalAt(&static_cast<GnuVtablePointer*>(vtable)[slot].function_ptr);
+	}
 
-} // namespace elfldr::detail
\ No newline at end of file
+} // namespace elfldr::util
\ No newline at end of file
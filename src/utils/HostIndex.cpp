@@ -0,0 +1,40 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The ELF's shared index of host:.
+
+#include <utils/DirectoryIndex.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		/**
+		 * Enough for the top level of host:, and a few mods.
+		 * (128 KB; each entry is 16 bytes.)
+		 */
+		constexpr uint32_t HostIndexSlots = 4096;
+		constexpr uint32_t HostIndexStringSize = 64 * 1024;
+
+		DirectoryIndex::Entry gHostIndexSlots[HostIndexSlots];
+		char gHostIndexStrings[HostIndexStringSize];
+
+		DirectoryIndex gHostIndex { gHostIndexSlots, gHostIndexStrings };
+		bool gHostIndexed = false;
+
+	} // namespace
+
+	DirectoryIndex& GetHostIndex() {
+		if(!gHostIndexed) {
+			gHostIndexed = true;
+			gHostIndex.AddRoot("host:", 0);
+		}
+
+		return gHostIndex;
+	}
+
+} // namespace elfldr::util
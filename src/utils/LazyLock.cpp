@@ -0,0 +1,45 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <kernel.h>
+#include <utils/LazyLock.h>
+
+namespace elfldr::util {
+
+	bool LazyLock::Lock() {
+		if(sema < 0) {
+			// The EE has no atomics, so two threads taking it
+			// for the first time can only be kept apart like this.
+			const auto interrupts = DI();
+			if(sema < 0) {
+				ee_sema_t params {};
+				params.init_count = 1;
+				params.max_count = 1;
+				sema = CreateSema(&params);
+			}
+			if(interrupts)
+				EI();
+
+			if(sema < 0)
+				return false;
+		}
+
+		WaitSema(sema);
+		return true;
+	}
+
+	void LazyLock::Unlock() {
+		SignalSema(sema);
+	}
+
+	void LazyLock::Destroy() {
+		if(sema >= 0)
+			DeleteSema(sema);
+		sema = -1;
+	}
+
+} // namespace elfldr::util
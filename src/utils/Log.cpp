@@ -0,0 +1,215 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <string.h>
+#include <utils/Log.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		constexpr uint32_t ChannelCount = static_cast<uint32_t>(LogChannel::Count);
+		constexpr uint32_t LevelCount = static_cast<uint32_t>(LogLevel::Count);
+
+		constexpr const char* LevelNames[LevelCount] {
+			"trace",
+			"debug",
+			"info",
+			"warning",
+			"error"
+		};
+
+		/**
+		 * Per-channel lowest level. LevelCount means off.
+		 * Everything compiled in starts out enabled.
+		 */
+		uint8_t gChannelLevels[ChannelCount] {};
+
+		constexpr uint32_t InitialMask(uint32_t level) {
+			if(level < ELFLDR_LOG_MIN_LEVEL)
+				return 0;
+			return static_cast<uint32_t>(ELFLDR_LOG_CHANNELS) & ((1ull << ChannelCount) - 1);
+		}
+
+		void RebuildMasks() {
+			for(uint32_t level = 0; level < LevelCount; ++level) {
+				uint32_t mask = 0;
+				for(uint32_t channel = 0; channel < ChannelCount; ++channel)
+					if(level >= gChannelLevels[channel])
+						mask |= 1u << channel;
+				detail::gLogMasks[level] = mask & InitialMask(level);
+			}
+		}
+
+		constexpr char ToLower(char c) {
+			if(c >= 'A' && c <= 'Z')
+				return static_cast<char>(c - 'A' + 'a');
+			return c;
+		}
+
+		/**
+		 * Compare a [begin, end) span of text with a name, ignoring case.
+		 */
+		constexpr bool NameEquals(const char* begin, const char* end, const char* name) {
+			for(; begin != end; ++begin, ++name)
+				if(*name == '\0' || ToLower(*begin) != *name)
+					return false;
+			return *name == '\0';
+		}
+
+		static_assert(NameEquals("Erl", "Erl" + 3, "erl"));
+		static_assert(!NameEquals("Er", "Er" + 2, "erl") && !NameEquals("Erls", "Erls" + 4, "erl"));
+
+		constexpr bool IsSeparator(char c) {
+			return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+
+		/**
+		 * Apply one `channel=level` setting.
+		 */
+		bool ApplySetting(const char* begin, const char* end) {
+			const char* equals = begin;
+			while(equals != end && *equals != '=')
+				++equals;
+
+			if(equals == end)
+				return false;
+
+			uint32_t level = LevelCount;
+			if(!NameEquals(equals + 1, end, "off")) {
+				level = 0;
+				while(level < LevelCount && !NameEquals(equals + 1, end, LevelNames[level]))
+					++level;
+				if(level == LevelCount)
+					return false;
+			}
+
+			if(NameEquals(begin, equals, "*")) {
+				for(auto& channelLevel : gChannelLevels)
+					channelLevel = static_cast<uint8_t>(level);
+				return true;
+			}
+
+			for(uint32_t channel = 0; channel < ChannelCount; ++channel) {
+				if(NameEquals(begin, equals, LogChannelName(static_cast<LogChannel>(channel)))) {
+					gChannelLevels[channel] = static_cast<uint8_t>(level);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	} // namespace
+
+	namespace detail {
+
+		uint32_t gLogMasks[LevelCount] {
+			InitialMask(0),
+			InitialMask(1),
+			InitialMask(2),
+			InitialMask(3),
+			InitialMask(4)
+		};
+
+		static_assert(LevelCount == 5, "Update gLogMasks' initializer");
+
+		void LogWrite(LogChannel channel, LogLevel level, const char* format, ...) {
+			// "[channel] level: ", so the message itself is only formatted once, by DebugOutV().
+			char prefix[48];
+			size_t length = 0;
+			auto Append = [&](const char* text) {
+				for(; *text && length < sizeof(prefix) - 1; ++text)
+					prefix[length++] = *text;
+			};
+
+			Append("[");
+			Append(LogChannelName(channel));
+			Append("] ");
+			if(level == LogLevel::Warning)
+				Append("warning: ");
+			else if(level == LogLevel::Error)
+				Append("error: ");
+			prefix[length] = '\0';
+
+			__builtin_va_list val;
+			__builtin_va_start(val, format);
+			DebugOutV(&prefix[0], format, val);
+			__builtin_va_end(val);
+		}
+
+#ifdef ELFLDR_LOG_TOKENIZED
+		void LogFrame::Put32(uint32_t value) {
+			if(length + sizeof(value) > sizeof(data))
+				return;
+			memcpy(&data[length], &value, sizeof(value));
+			length += sizeof(value);
+		}
+
+		void LogFrame::Put64(uint64_t value) {
+			if(length + sizeof(value) > sizeof(data))
+				return;
+			memcpy(&data[length], &value, sizeof(value));
+			length += sizeof(value);
+		}
+
+		void LogFrame::PutString(const char* string) {
+			if(length + 1 > sizeof(data))
+				return;
+
+			if(!string)
+				string = "(null)";
+
+			// Truncate to what fits (and what the length byte can hold).
+			uint32_t stringLength = 0;
+			while(string[stringLength] && stringLength < 255 && length + 1 + stringLength < sizeof(data))
+				++stringLength;
+
+			data[length] = static_cast<uint8_t>(stringLength);
+			memcpy(&data[length + 1], string, stringLength);
+			length += 1 + stringLength;
+		}
+#endif
+
+	} // namespace detail
+
+	void LogSetLevel(LogChannel channel, LogLevel level) {
+		gChannelLevels[static_cast<uint32_t>(channel)] = static_cast<uint8_t>(level);
+		RebuildMasks();
+	}
+
+	void LogDisable(LogChannel channel) {
+		gChannelLevels[static_cast<uint32_t>(channel)] = LevelCount;
+		RebuildMasks();
+	}
+
+	bool LogConfigure(const char* config) {
+		bool ok = true;
+
+		while(*config) {
+			while(*config && IsSeparator(*config))
+				++config;
+
+			const char* begin = config;
+			while(*config && !IsSeparator(*config))
+				++config;
+
+			if(begin == config)
+				break;
+
+			if(!ApplySetting(begin, config)) {
+				DebugOut("Bad log setting \"%.*s\"", static_cast<int>(config - begin), begin);
+				ok = false;
+			}
+		}
+
+		RebuildMasks();
+		return ok;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,131 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/CodeUtils.h>
+#include <utils/FileTrace.h>
+#include <utils/FioFile.h>
+#include <utils/GameFileHooks.h>
+#include <utils/GameFileIo.h>
+#include <utils/Hook.h>
+#include <utils/LazyLock.h>
+#include <utils/Log.h>
+#include <utils/ModFiles.h>
+#include <utils/OverlayFs.h>
+#include <utils/PackFile.h>
+#include <utils/SymbolDb.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		// int sceOpen(const char* filename, int flag, ...); see GameFileHooks.cpp.
+		using OpenFunction = int (*)(const char*, int, int);
+
+		constexpr auto ModListPath = "host:mods.txt";
+
+		// Tracing is on when this file is there. What's in it doesn't matter.
+		constexpr auto TraceSwitchPath = "host:filetrace.txt";
+		constexpr auto TracePath = "host:filetrace.bin";
+
+		OverlayFs gOverlay;
+		PackSet gPacks;
+
+		void* gOpenAddress = nullptr;
+		OpenFunction gOriginalOpen = nullptr;
+
+		// True until the first open has loaded the mods.
+		bool gWaiting = false;
+
+		// Opens on other threads wait on this while the first one loads the mods.
+		LazyLock gSetupLock;
+
+		bool TraceWanted() {
+			FioFile file;
+			file.Open(TraceSwitchPath, FIO_O_RDONLY);
+			return static_cast<bool>(file);
+		}
+
+		/**
+		 * Load the mods, start the file trace if it's wanted, and hook them in.
+		 * Call with sceOpen unhooked.
+		 */
+		void LoadMods() {
+			UseGameFileIo(FindGameFileIo());
+
+			if(TraceWanted() && StartFileTrace(TracePath))
+				ELFLDR_LOG_INFO(Fio, "Tracing file access to %s", TracePath);
+
+			const auto loaded = LoadModOverlay(gOverlay, gPacks, ModListPath);
+			if(!loaded)
+				ELFLDR_LOG_INFO(Fio, "No mods to load");
+
+			if(loaded || FileTraceEnabled())
+				InstallGameFileHooks(gOverlay, gPacks);
+		}
+
+		int FirstOpenHook(const char* path, int flags, int mode) {
+			{
+				LazyLockGuard lock(gSetupLock);
+
+				// Without the lock, loading the mods isn't safe; try again on the next open.
+				if(!lock && gWaiting)
+					return gOriginalOpen(path, flags, mode);
+
+				if(gWaiting) {
+					gWaiting = false;
+					UnhookFunction(gOpenAddress);
+					LoadMods();
+				}
+			}
+
+			// The game's sceOpen, through the game file hooks if they were installed.
+			return reinterpret_cast<OpenFunction>(gOpenAddress)(path, flags, mode);
+		}
+
+	} // namespace
+
+	bool InstallModFiles() {
+		if(gOpenAddress)
+			return true;
+
+		const auto address = FindSymbol("sceOpen");
+		if(address == 0) {
+			ELFLDR_LOG_WARNING(Fio, "sceOpen isn't known for %s; mods won't be loaded", GetGameVersionData().GameID().CStr());
+			return false;
+		}
+
+		gOriginalOpen = HookFunction<OpenFunction>(Ptr(address), FirstOpenHook);
+		if(!gOriginalOpen) {
+			ELFLDR_LOG_ERROR(Fio, "Couldn't hook sceOpen at %p", Ptr(address));
+			return false;
+		}
+
+		gOpenAddress = Ptr(address);
+		gWaiting = true;
+		return true;
+	}
+
+	void RemoveModFiles() {
+		if(!gOpenAddress)
+			return;
+
+		if(gWaiting)
+			UnhookFunction(gOpenAddress);
+		else
+			RemoveGameFileHooks();
+
+		StopFileTrace();
+		gOverlay.Clear();
+		gPacks.Clear();
+		gSetupLock.Destroy();
+
+		gWaiting = false;
+		gOpenAddress = nullptr;
+		gOriginalOpen = nullptr;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,294 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <string.h>
+#include <utils/OverlayFs.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		constexpr uint32_t SlotCountFor(uint32_t entries) {
+			// At most 3/4 full.
+			uint32_t slots = 16;
+			while(slots * 3 < entries * 4)
+				slots <<= 1;
+			return slots;
+		}
+
+		static_assert(SlotCountFor(0) == 16 && SlotCountFor(12) == 16 && SlotCountFor(13) == 32);
+
+		constexpr uint32_t BloomBlockBits = OverlayFs::BloomBlockBytes * 8;
+		constexpr uint32_t BloomBlockWords = OverlayFs::BloomBlockBytes / sizeof(uint32_t);
+
+		constexpr uint32_t BloomBlockCountFor(uint32_t entries) {
+			uint32_t blocks = 1;
+			while(blocks * BloomBlockBits < entries * OverlayFs::BloomBitsPerFile)
+				blocks <<= 1;
+			return blocks;
+		}
+
+		static_assert(BloomBlockCountFor(0) == 1 && BloomBlockCountFor(42) == 1 && BloomBlockCountFor(43) == 2);
+
+		/**
+		 * Which block of the bloom filter a hash goes in. This is from a remix of
+		 * the hash, so it doesn't line up with the table slot (or the bits in the block).
+		 */
+		constexpr uint32_t BloomBlock(uint32_t hash, uint32_t blockMask) {
+			return ((hash * 0x9e3779b1) >> 16) & blockMask;
+		}
+
+		/**
+		 * The four bits of a block a hash sets, from 9-bit slices of it.
+		 */
+		constexpr uint32_t BloomBit(uint32_t hash, uint32_t i) {
+			constexpr uint32_t Shifts[] { 0, 9, 18, 23 };
+			return (hash >> Shifts[i]) & (BloomBlockBits - 1);
+		}
+
+		constexpr uint32_t BloomBitsPerHash = 4;
+
+	} // namespace
+
+	OverlayFs::~OverlayFs() {
+		Clear();
+	}
+
+	bool OverlayFs::Build(const DirectoryIndex& index, mlstd::Span<const uint32_t> buildRoots) {
+		Clear();
+
+		if(buildRoots.Size() > DirectoryIndex::MaxRoots)
+			buildRoots = buildRoots.Subspan(0, DirectoryIndex::MaxRoots);
+
+		// The rank (position in buildRoots) of every index root; MaxRoots if it isn't used.
+		uint8_t rank[DirectoryIndex::MaxRoots];
+		for(auto& r : rank)
+			r = DirectoryIndex::MaxRoots;
+		for(uint32_t i = 0; i < buildRoots.Size(); ++i)
+			if(buildRoots[i] < index.RootCount() && rank[buildRoots[i]] == DirectoryIndex::MaxRoots)
+				rank[buildRoots[i]] = static_cast<uint8_t>(i);
+
+		// Size everything up first, so it can all go in one block.
+		uint32_t files = 0;
+		uint32_t stringSize = 0;
+
+		index.ForEach([&](const DirectoryIndex::Entry& entry) {
+			if(entry.Directory() || rank[entry.root] == DirectoryIndex::MaxRoots)
+				return;
+			++files;
+			stringSize += entry.pathLength + 1;
+		});
+
+		for(uint32_t i = 0; i < buildRoots.Size(); ++i)
+			if(buildRoots[i] < index.RootCount() && rank[buildRoots[i]] == i)
+				stringSize += static_cast<uint32_t>(strlen(index.RootPath(buildRoots[i]))) + 1;
+
+		// The bloom filter goes first, aligned to a cache line,
+		// then the table, then the strings.
+		const auto slotCount = SlotCountFor(files);
+		const auto bloomBlocks = BloomBlockCountFor(files);
+		const auto bloomSize = bloomBlocks * BloomBlockBytes;
+
+		block = mlstd::Alloc(BloomBlockBytes + bloomSize + slotCount * sizeof(Entry) + stringSize);
+		if(!block)
+			return false;
+
+		bloom = reinterpret_cast<uint32_t*>((reinterpret_cast<uintptr_t>(block) + BloomBlockBytes - 1) & ~static_cast<uintptr_t>(BloomBlockBytes - 1));
+		bloomBlockMask = bloomBlocks - 1;
+		memset(bloom, 0, bloomSize);
+
+		slots = reinterpret_cast<Entry*>(reinterpret_cast<uint8_t*>(bloom) + bloomSize);
+		slotMask = slotCount - 1;
+		memset(slots, 0, slotCount * sizeof(Entry));
+
+		auto* strings = reinterpret_cast<char*>(&slots[slotCount]);
+		auto CopyString = [&](const char* string, uint32_t length) {
+			auto* copy = strings;
+			memcpy(copy, string, length);
+			copy[length] = '\0';
+			strings += length + 1;
+			return copy;
+		};
+
+		// Overlay roots are numbered by priority.
+		uint8_t overlayRoot[DirectoryIndex::MaxRoots] {};
+		for(uint32_t i = 0; i < buildRoots.Size(); ++i) {
+			const auto root = buildRoots[i];
+			if(root >= index.RootCount() || rank[root] != i)
+				continue;
+
+			auto* path = index.RootPath(root);
+			overlayRoot[root] = static_cast<uint8_t>(rootCount);
+			roots[rootCount++] = CopyString(path, static_cast<uint32_t>(strlen(path)));
+		}
+
+		index.ForEach([&](const DirectoryIndex::Entry& entry) {
+			if(entry.Directory() || rank[entry.root] == DirectoryIndex::MaxRoots)
+				return;
+
+			const auto root = overlayRoot[entry.root];
+			auto slot = entry.hash & slotMask;
+
+			while(slots[slot].path) {
+				auto& existing = slots[slot];
+				if(existing.hash == entry.hash && PathEquals(existing.path, existing.pathLength, entry.path, entry.pathLength)) {
+					// A higher priority mod has this file too; it wins.
+					// (Every index entry was counted in stringSize, so there's room for the copy.)
+					if(root < existing.root) {
+						existing.path = CopyString(entry.path, entry.pathLength);
+						existing.root = root;
+					}
+					return;
+				}
+				slot = (slot + 1) & slotMask;
+			}
+
+			slots[slot] = { CopyString(entry.path, entry.pathLength), entry.hash, entry.pathLength, root };
+			BloomAdd(entry.hash);
+			++count;
+		});
+
+		return true;
+	}
+
+	const OverlayFs::Entry* OverlayFs::Find(const char* path) const {
+		if(count == 0)
+			return nullptr;
+
+		path = HostRelativePath(path);
+		if(!path)
+			return nullptr;
+
+		const auto length = strlen(path);
+		const auto hash = PathHash(path, length);
+		++stats.lookups;
+
+		// Most paths aren't overridden; this is where those should stop.
+		if(!BloomMayContain(hash)) {
+			++stats.bloomRejects;
+			return nullptr;
+		}
+
+		if(NegativeCached(hash)) {
+			++stats.negativeCacheHits;
+			return nullptr;
+		}
+
+		++stats.tableLookups;
+
+		bool hashSeen = false;
+		for(auto slot = hash & slotMask; slots[slot].path; slot = (slot + 1) & slotMask) {
+			const auto& entry = slots[slot];
+			if(entry.hash != hash)
+				continue;
+
+			if(PathEquals(entry.path, entry.pathLength, path, length)) {
+				++stats.found;
+				return &entry;
+			}
+			hashSeen = true;
+		}
+
+		// Only remember the hash if no file has it at all,
+		// so the cache never hides a file with a colliding hash.
+		if(!hashSeen)
+			CacheNegative(hash);
+		return nullptr;
+	}
+
+	bool OverlayFs::Resolve(const char* path, char* out, size_t outSize) const {
+		auto* entry = Find(path);
+		if(!entry)
+			return false;
+
+		auto* root = roots[entry->root];
+		const auto rootLength = strlen(root);
+		const bool separator = rootLength != 0 && root[rootLength - 1] != ':' && !IsPathSeparator(root[rootLength - 1]);
+
+		const auto length = rootLength + separator + entry->pathLength;
+		if(length + 1 > outSize)
+			return false;
+
+		memcpy(out, root, rootLength);
+		if(separator)
+			out[rootLength] = '/';
+		memcpy(&out[rootLength + separator], entry->path, entry->pathLength + 1);
+		return true;
+	}
+
+	bool OverlayFs::BloomMayContain(uint32_t hash) const {
+		auto* words = &bloom[BloomBlock(hash, bloomBlockMask) * BloomBlockWords];
+		for(uint32_t i = 0; i < BloomBitsPerHash; ++i) {
+			const auto bit = BloomBit(hash, i);
+			if(!(words[bit / 32] & (1u << (bit % 32))))
+				return false;
+		}
+		return true;
+	}
+
+	void OverlayFs::BloomAdd(uint32_t hash) {
+		auto* words = &bloom[BloomBlock(hash, bloomBlockMask) * BloomBlockWords];
+		for(uint32_t i = 0; i < BloomBitsPerHash; ++i) {
+			const auto bit = BloomBit(hash, i);
+			words[bit / 32] |= 1u << (bit % 32);
+		}
+	}
+
+	bool OverlayFs::NegativeCached(uint32_t hash) const {
+		// Another thread can be halfway through changing the count; clamp it here, where it's used.
+		const auto cached = negativeCount < NegativeCacheSize ? negativeCount : NegativeCacheSize;
+
+		for(uint32_t i = 0; i < cached; ++i) {
+			if(negativeCache[i] != hash)
+				continue;
+
+			// Move it to the front.
+			for(; i != 0; --i)
+				negativeCache[i] = negativeCache[i - 1];
+			negativeCache[0] = hash;
+			return true;
+		}
+
+		return false;
+	}
+
+	void OverlayFs::CacheNegative(uint32_t hash) const {
+		auto cached = negativeCount < NegativeCacheSize ? negativeCount : NegativeCacheSize;
+
+		// The least recently used one falls off the end.
+		if(cached < NegativeCacheSize)
+			++cached;
+
+		for(auto i = cached - 1; i != 0; --i)
+			negativeCache[i] = negativeCache[i - 1];
+		negativeCache[0] = hash;
+
+		// Only counted once it's there, so lookups never check a slot that was never filled in.
+		negativeCount = cached;
+	}
+
+	void OverlayFs::Clear() {
+		if(block)
+			mlstd::Free(block);
+
+		block = nullptr;
+		slots = nullptr;
+		slotMask = 0;
+		count = 0;
+
+		bloom = nullptr;
+		bloomBlockMask = 0;
+		negativeCount = 0;
+		stats = {};
+
+		for(auto& root : roots)
+			root = nullptr;
+		rootCount = 0;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,115 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <stdio.h>
+#include <utils/FioFile.h>
+#include <utils/Log.h>
+#include <utils/OverlayFs.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		/**
+		 * Room for indexing the mods. This is only needed while the overlay is
+		 * built, so it's allocated then, and freed once the overlay has what it needs.
+		 * That's room for about 24k files and folders between all the mods.
+		 */
+		constexpr uint32_t ModIndexSlots = 32768;
+		constexpr uint32_t ModIndexStringSize = 512 * 1024;
+
+		constexpr bool IsSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		bool IsPack(const char* name, size_t length) {
+			constexpr char Extension[] = ".pak";
+			constexpr auto ExtensionLength = sizeof(Extension) - 1;
+			return length > ExtensionLength && PathEquals(&name[length - ExtensionLength], ExtensionLength, &Extension[0], ExtensionLength);
+		}
+
+	} // namespace
+
+	bool LoadModOverlay(OverlayFs& overlay, PackSet& packs, const char* listPath) {
+		overlay.Clear();
+		packs.Clear();
+
+		FioFile file;
+		file.Open(listPath, FIO_O_RDONLY);
+		if(!file)
+			return false;
+
+		mlstd::StdAllocator<uint8_t> allocator;
+		auto list = file.ReadAll(allocator);
+		file.Close();
+		if(!list)
+			return false;
+
+		auto* slots = static_cast<DirectoryIndex::Entry*>(mlstd::Alloc(ModIndexSlots * sizeof(DirectoryIndex::Entry)));
+		auto* strings = static_cast<char*>(mlstd::Alloc(ModIndexStringSize));
+		if(!slots || !strings) {
+			ELFLDR_LOG_ERROR(Fio, "Not enough memory to index mods");
+			if(slots)
+				mlstd::Free(slots);
+			if(strings)
+				mlstd::Free(strings);
+			return false;
+		}
+
+		DirectoryIndex index { { slots, ModIndexSlots }, { strings, ModIndexStringSize } };
+		uint32_t roots[DirectoryIndex::MaxRoots];
+		uint32_t rootCount = 0;
+
+		// One mod per line. The text is NUL terminated, so lines can be cut in place.
+		auto* line = const_cast<char*>(list.Text().CStr());
+		while(*line) {
+			auto* end = line;
+			while(*end && *end != '\n')
+				++end;
+			auto* next = *end ? end + 1 : end;
+
+			while(IsSpace(*line))
+				++line;
+			while(end != line && IsSpace(end[-1]))
+				--end;
+			*end = '\0';
+
+			if(*line != '\0' && *line != '#') {
+				char root[MaxPath];
+				snprintf(&root[0], sizeof(root), "host:mods/%s", line);
+
+				if(IsPack(line, end - line)) {
+					packs.Mount(&root[0]);
+				} else if(rootCount == DirectoryIndex::MaxRoots) {
+					ELFLDR_LOG_WARNING(Fio, "Too many mods (max %u); ignoring %s", DirectoryIndex::MaxRoots, line);
+				} else if(const auto indexed = index.AddRoot(&root[0]); indexed == DirectoryIndex::NoRoot) {
+					ELFLDR_LOG_WARNING(Fio, "Mod %s isn't there (looked for %s)", line, &root[0]);
+				} else {
+					roots[rootCount++] = indexed;
+				}
+			}
+
+			line = next;
+		}
+
+		const bool built = overlay.Build(index, { &roots[0], rootCount });
+
+		mlstd::Free(slots);
+		mlstd::Free(strings);
+
+		if(!built) {
+			ELFLDR_LOG_ERROR(Fio, "Not enough memory for the mod overlay");
+			return false;
+		}
+
+		ELFLDR_LOG_INFO(Fio, "%u files overridden by %u mods, and %u packs", overlay.Count(), overlay.RootCount(), packs.Count());
+		return overlay.Count() != 0 || packs.Count() != 0;
+	}
+
+} // namespace elfldr::util
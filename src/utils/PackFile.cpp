@@ -0,0 +1,153 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <string.h>
+#include <utils/BufferedFioReader.h>
+#include <utils/FioFile.h>
+#include <utils/Log.h>
+#include <utils/PackFile.h>
+
+namespace elfldr::util {
+
+	PackFile::~PackFile() {
+		Close();
+	}
+
+	bool PackFile::Open(const char* packPath) {
+		Close();
+
+		FioFile file;
+		file.Open(packPath, FIO_O_RDONLY);
+		if(!file) {
+			ELFLDR_LOG_WARNING(Fio, "Couldn't open pack %s", packPath);
+			return false;
+		}
+
+		// The header and table of contents are small reads, and usually
+		// come in the same block: one read, instead of one each.
+		BufferedFioReader reader { file };
+		if(!reader.Good()) {
+			ELFLDR_LOG_ERROR(Fio, "Not enough memory to read %s", packPath);
+			return false;
+		}
+
+		PackHeader header {};
+		if(!reader.ReadExact(&header, sizeof(header)) || header.magic != PackHeader::Magic) {
+			ELFLDR_LOG_ERROR(Fio, "%s isn't a pack", packPath);
+			return false;
+		}
+
+		if(header.version != PackHeader::CurrentVersion) {
+			ELFLDR_LOG_ERROR(Fio, "%s is a version %u pack; only version %u is supported", packPath, header.version, PackHeader::CurrentVersion);
+			return false;
+		}
+
+		const auto fileSize = static_cast<uint32_t>(reader.Size());
+		const auto entriesSize = header.count * sizeof(PackEntry);
+		if(header.count > fileSize / sizeof(PackEntry) || header.tocSize < entriesSize || header.tocSize > fileSize - sizeof(header)) {
+			ELFLDR_LOG_ERROR(Fio, "%s has a broken table of contents", packPath);
+			return false;
+		}
+
+		// The table of contents, then a copy of the pack's path.
+		const auto pathLength = strlen(packPath);
+		block = mlstd::Alloc(header.tocSize + pathLength + 1);
+		if(!block) {
+			ELFLDR_LOG_ERROR(Fio, "Not enough memory for the table of contents of %s", packPath);
+			return false;
+		}
+
+		auto* toc = static_cast<uint8_t*>(block);
+		if(!reader.ReadExact(toc, header.tocSize)) {
+			ELFLDR_LOG_ERROR(Fio, "Couldn't read the table of contents of %s", packPath);
+			Close();
+			return false;
+		}
+
+		auto* tocEntries = reinterpret_cast<const PackEntry*>(toc);
+		auto* tocPaths = reinterpret_cast<const char*>(&toc[entriesSize]);
+		const auto pathsSize = header.tocSize - entriesSize;
+
+		// Check it all now, so lookups can trust it.
+		bool good = header.count == 0 || (pathsSize != 0 && tocPaths[pathsSize - 1] == '\0');
+		for(uint32_t i = 0; good && i < header.count; ++i) {
+			const auto& entry = tocEntries[i];
+			good = entry.pathOffset < pathsSize && entry.offset % PackAlignment == 0 && entry.offset <= fileSize && entry.size <= fileSize - entry.offset && (i == 0 || tocEntries[i - 1].hash <= entry.hash);
+		}
+
+		if(!good) {
+			ELFLDR_LOG_ERROR(Fio, "%s has a broken table of contents", packPath);
+			Close();
+			return false;
+		}
+
+		auto* pathCopy = reinterpret_cast<char*>(&toc[header.tocSize]);
+		memcpy(pathCopy, packPath, pathLength + 1);
+
+		entries = tocEntries;
+		paths = tocPaths;
+		count = header.count;
+		path = pathCopy;
+
+		ELFLDR_LOG_INFO(Fio, "%s: %u files", path, count);
+		return true;
+	}
+
+	const PackEntry* PackFile::Find(const char* gamePath) const {
+		if(count == 0)
+			return nullptr;
+
+		gamePath = HostRelativePath(gamePath);
+		if(!gamePath)
+			return nullptr;
+
+		return FindPackEntry(entries, count, paths, gamePath, strlen(gamePath));
+	}
+
+	void PackFile::Close() {
+		if(block)
+			mlstd::Free(block);
+
+		block = nullptr;
+		entries = nullptr;
+		paths = nullptr;
+		count = 0;
+		path = nullptr;
+	}
+
+	bool PackSet::Mount(const char* path) {
+		if(count == MaxPacks) {
+			ELFLDR_LOG_WARNING(Fio, "Too many packs (max %u); ignoring %s", MaxPacks, path);
+			return false;
+		}
+
+		if(!packs[count].Open(path))
+			return false;
+
+		++count;
+		return true;
+	}
+
+	const PackEntry* PackSet::Find(const char* path, uint32_t& pack) const {
+		for(uint32_t i = 0; i < count; ++i) {
+			if(auto* entry = packs[i].Find(path); entry) {
+				pack = i;
+				return entry;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void PackSet::Clear() {
+		for(uint32_t i = 0; i < count; ++i)
+			packs[i].Close();
+		count = 0;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,221 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <kernel.h>
+#include <mlstd/Allocator.h>
+#include <mlstd/Assert.h>
+#include <string.h>
+#include <utils/PatchJournal.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		/**
+		 * Size of a normal arena chunk (including the header).
+		 * Entries larger than this get a chunk of their own.
+		 */
+		constexpr uint32_t ChunkSize = 4096;
+
+		/**
+		 * Max size of a single journaled write.
+		 */
+		constexpr uint32_t MaxEntryLength = 0xffff;
+
+		enum EntryFlags : uint8_t {
+			EntryFlag_Reverted = 0x1,
+
+			/**
+			 * A JournalOwnedBlock follows the entry header.
+			 */
+			EntryFlag_Owned = 0x2
+		};
+
+		struct Chunk {
+			Chunk* prev;
+			uint32_t size;
+			uint32_t used;
+		};
+
+		/**
+		 * Journal entry header. The original bytes (and the owned block,
+		 * if there is one) follow it in the arena.
+		 */
+		struct Entry {
+			Entry* prev;
+			JournalPosition position;
+			uintptr_t address;
+			uint16_t length;
+			uint8_t flags;
+
+			JournalOwnedBlock* Owned() {
+				return reinterpret_cast<JournalOwnedBlock*>(this + 1);
+			}
+
+			uint8_t* Bytes() {
+				auto* bytes = reinterpret_cast<uint8_t*>(this + 1);
+				if(flags & EntryFlag_Owned)
+					bytes += sizeof(JournalOwnedBlock);
+				return bytes;
+			}
+
+			bool Overlaps(const Entry& other) const {
+				return address < other.address + other.length && other.address < address + length;
+			}
+		};
+
+		constexpr uint32_t AlignEntry(uint32_t size) {
+			return (size + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+		}
+
+		Chunk* gTailChunk = nullptr;
+		Entry* gTailEntry = nullptr;
+		JournalPosition gNextPosition = 0;
+		JournalStats gStats {};
+
+		uint8_t* AllocEntryStorage(uint32_t size) {
+			constexpr auto HeaderSize = AlignEntry(sizeof(Chunk));
+
+			if(!gTailChunk || gTailChunk->size - gTailChunk->used < size) {
+				auto chunkSize = HeaderSize + size > ChunkSize ? HeaderSize + size : ChunkSize;
+				auto* chunk = static_cast<Chunk*>(mlstd::Alloc(chunkSize));
+				MLSTD_VERIFY(chunk != nullptr && "Could not allocate patch journal chunk");
+
+				chunk->prev = gTailChunk;
+				chunk->size = chunkSize;
+				chunk->used = HeaderSize;
+				gTailChunk = chunk;
+				gStats.arenaBytes += chunkSize;
+			}
+
+			auto* storage = reinterpret_cast<uint8_t*>(gTailChunk) + gTailChunk->used;
+			gTailChunk->used += size;
+			return storage;
+		}
+
+		Entry* AppendEntry(void* dest, uint32_t length, const JournalOwnedBlock& owned) {
+			MLSTD_VERIFY(length <= MaxEntryLength && "Journaled write is too large");
+
+			const bool hasOwned = owned.block != nullptr;
+			auto* entry = reinterpret_cast<Entry*>(AllocEntryStorage(AlignEntry(sizeof(Entry) + (hasOwned ? sizeof(JournalOwnedBlock) : 0) + length)));
+
+			entry->prev = gTailEntry;
+			entry->position = gNextPosition++;
+			entry->address = reinterpret_cast<uintptr_t>(dest);
+			entry->length = static_cast<uint16_t>(length);
+			entry->flags = hasOwned ? EntryFlag_Owned : 0;
+			if(hasOwned)
+				*entry->Owned() = owned;
+
+			memcpy(entry->Bytes(), dest, length);
+
+			gTailEntry = entry;
+			++gStats.entries;
+			gStats.savedBytes += length;
+			return entry;
+		}
+
+		/**
+		 * Write an entry's saved bytes back.
+		 */
+		void RestoreEntry(Entry& entry) {
+			// Aligned words go back with a single store, to match WriteMemory32().
+			if(entry.length == sizeof(uint32_t) && (entry.address & 3) == 0) {
+				uint32_t word;
+				memcpy(&word, entry.Bytes(), sizeof(word));
+				*reinterpret_cast<volatile uint32_t*>(entry.address) = word;
+				return;
+			}
+
+			memcpy(reinterpret_cast<void*>(entry.address), entry.Bytes(), entry.length);
+		}
+
+		/**
+		 * Check if any applied entry newer than the span overlaps an applied entry in it.
+		 */
+		bool SpanIsShadowed(JournalSpan span) {
+			for(auto* newer = gTailEntry; newer && newer->position >= span.end; newer = newer->prev) {
+				if(newer->flags & EntryFlag_Reverted)
+					continue;
+
+				for(auto* entry = newer->prev; entry && entry->position >= span.begin; entry = entry->prev) {
+					if(entry->position >= span.end || (entry->flags & EntryFlag_Reverted))
+						continue;
+					if(entry->Overlaps(*newer))
+						return true;
+				}
+			}
+
+			return false;
+		}
+
+	} // namespace
+
+	JournalPosition GetJournalPosition() {
+		return gNextPosition;
+	}
+
+	void WriteMemory(void* dest, const void* src, uint32_t length, JournalOwnedBlock owned) {
+		AppendEntry(dest, length, owned);
+		memcpy(dest, src, length);
+	}
+
+	void WriteMemory32(uint32_t* dest, uint32_t value) {
+		MLSTD_ASSERT((reinterpret_cast<uintptr_t>(dest) & 3) == 0);
+		AppendEntry(dest, sizeof(uint32_t), {});
+		*static_cast<volatile uint32_t*>(dest) = value;
+	}
+
+	void FillMemory(void* dest, uint8_t value, uint32_t length) {
+		AppendEntry(dest, length, {});
+		memset(dest, value, length);
+	}
+
+	bool RevertJournal(JournalSpan span) {
+		if(SpanIsShadowed(span))
+			return false;
+
+		bool reverted = false;
+
+		// Newest first, so writes to the same bytes within the span unwind properly.
+		for(auto* entry = gTailEntry; entry && entry->position >= span.begin; entry = entry->prev) {
+			if(entry->position >= span.end || (entry->flags & EntryFlag_Reverted))
+				continue;
+
+			RestoreEntry(*entry);
+			entry->flags |= EntryFlag_Reverted;
+			++gStats.revertedEntries;
+			reverted = true;
+
+			if(entry->flags & EntryFlag_Owned) {
+				auto* owned = entry->Owned();
+				owned->release(owned->block);
+			}
+		}
+
+		// Reverted entries are usually code.
+		if(reverted)
+			FlushCache(CPU_DATA_CACHE | CPU_INSTRUCTION_CACHE);
+
+		return true;
+	}
+
+	bool RevertJournalAt(void* dest) {
+		const auto address = reinterpret_cast<uintptr_t>(dest);
+
+		for(auto* entry = gTailEntry; entry; entry = entry->prev)
+			if(entry->address == address && !(entry->flags & EntryFlag_Reverted))
+				return RevertJournal({ entry->position, entry->position + 1 });
+
+		return false;
+	}
+
+	JournalStats GetJournalStats() {
+		return gStats;
+	}
+
+} // namespace elfldr::util
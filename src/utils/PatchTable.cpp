@@ -0,0 +1,71 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The patch table interpreter.
+
+#include <mlstd/Assert.h>
+#include <utils/CodeUtils.h>
+#include <utils/Log.h>
+#include <utils/PatchJournal.h>
+#include <utils/PatchTable.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	uint32_t VerifyPatchRecords(const PatchRecord* records, uint32_t count) {
+		// This is done as a separate pass over the whole list before anything
+		// gets written, so a table is either applied completely, or not at all.
+		// The live game is just an image of all of memory.
+		return VerifyPatchRecords(records, count, nullptr, 0);
+	}
+
+	void ApplyPatchRecords(const PatchRecord* records, uint32_t count) {
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto& record = records[i];
+			auto* addr = Ptr(record.address);
+
+			switch(record.op) {
+				case PatchOp::WriteString:
+					WriteString(addr, record.string);
+					break;
+
+				case PatchOp::ReplaceString:
+					ReplaceString(addr, record.string);
+					break;
+
+				case PatchOp::Write8: {
+					auto value = static_cast<uint8_t>(record.value);
+					WriteMemory(addr, &value, sizeof(value));
+				} break;
+
+				case PatchOp::Write32:
+					WriteMemory(addr, &record.value, sizeof(record.value));
+					break;
+
+				case PatchOp::NopFill:
+					MLSTD_ASSERT(IsInstructionAligned(addr));
+					FillMemory(addr, 0x0, record.value * sizeof(uint32_t));
+					break;
+			}
+		}
+	}
+
+	PatchTableResult ApplyPatchTable(const PatchTable* tables, uint32_t count, const GameVersionData& data) {
+		auto* table = FindPatchTable(tables, count, data);
+		if(!table)
+			return PatchTableResult::NoTable;
+
+		if(auto bad = VerifyPatchRecords(table->records, table->recordCount); bad != table->recordCount) {
+			ELFLDR_LOG_ERROR(Patch, "Patch record %u (address 0x%08x) does not match the expected original bytes. Refusing to apply patch table.", bad, table->records[bad].address);
+			return PatchTableResult::Mismatch;
+		}
+
+		ApplyPatchRecords(table->records, table->recordCount);
+		return PatchTableResult::Applied;
+	}
+
+} // namespace elfldr::util
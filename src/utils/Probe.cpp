@@ -0,0 +1,206 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <utils/Hook.h>
+#include <utils/HookRelocator.h>
+#include <utils/Log.h>
+#include <utils/MipsAssembler.h>
+#include <utils/MipsIDecoder.h>
+#include <utils/MipsIEncoder.h>
+#include <utils/PatchJournal.h>
+#include <utils/Probe.h>
+#include <utils/TrampolinePool.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+		using namespace mips;
+
+		// The probe site is a j to the thunk, and its delay slot.
+		constexpr uint32_t ProbeSiteLength = 2;
+
+		// The thunk saves ra in a quadword of its own, so it survives the jal
+		// to the dispatcher.
+		constexpr int16_t ThunkFrameSize = 16;
+
+		// The dispatcher frame is the context, then the thunk return address.
+		constexpr int16_t DispatcherFrameSize = sizeof(ProbeContext) + 16;
+		constexpr int16_t DispatcherReturnOffset = sizeof(ProbeContext);
+
+		constexpr int16_t GprOffset(Reg reg) {
+			return offsetof(ProbeContext, gpr) + static_cast<uint32_t>(reg) * sizeof(ProbeRegister);
+		}
+
+		constexpr int16_t FprOffset(uint32_t fpr) {
+			return offsetof(ProbeContext, fpr) + fpr * sizeof(float);
+		}
+
+		constexpr uint32_t ThunkDataIndex = 4;
+		constexpr uint32_t ThunkResumeIndex = ThunkDataIndex + 3;
+
+		// Per-probe thunk. Relocation slot 0 is the dispatcher.
+		//
+		// The jal leaves ra pointing at the data words (callback, user, pc), which
+		// the dispatcher reads, and it returns past them to restore ra. After that
+		// come the relocated instructions, and the jump back.
+		constexpr static auto thunkTemplate = Assemble<[](Assembler& a) {
+			a.Emit(addiu(Reg::SP, Reg::SP, -ThunkFrameSize));
+			a.Emit(sq(Reg::RA, 0, Reg::SP));
+			a.CallTo(0);
+
+			a.Emit(0); // callback
+			a.Emit(0); // user
+			a.Emit(0); // pc
+
+			a.Emit(lq(Reg::RA, 0, Reg::SP));
+			a.Emit(addiu(Reg::SP, Reg::SP, ThunkFrameSize));
+		}>();
+
+		static_assert(thunkTemplate.Length == ThunkResumeIndex + 2);
+
+		// Shared by every probe. Saves everything into a ProbeContext on the stack,
+		// calls the callback, and restores everything from it.
+		// This is position independent; it runs from where the compiler put it.
+		constexpr static auto dispatcher = Assemble<[](Assembler& a) {
+			a.Emit(addiu(Reg::SP, Reg::SP, -DispatcherFrameSize));
+
+			for(uint32_t i = 1; i < 31; ++i) {
+				const auto reg = static_cast<Reg>(i);
+				if(reg != Reg::SP)
+					a.Emit(sq(reg, GprOffset(reg), Reg::SP));
+			}
+
+			// ra here points into the thunk. The probed code's ra and sp
+			// are in (and above) the thunk's frame.
+			a.Emit(sq(Reg::RA, DispatcherReturnOffset, Reg::SP));
+			a.Emit(lq(Reg::T0, DispatcherFrameSize, Reg::SP));
+			a.Emit(sq(Reg::T0, GprOffset(Reg::RA), Reg::SP));
+			a.Emit(addiu(Reg::T0, Reg::SP, DispatcherFrameSize + ThunkFrameSize));
+			a.Emit(sq(Reg::T0, GprOffset(Reg::SP), Reg::SP));
+
+			a.Emit(pmfhi(Reg::T0));
+			a.Emit(sq(Reg::T0, offsetof(ProbeContext, hi), Reg::SP));
+			a.Emit(pmflo(Reg::T0));
+			a.Emit(sq(Reg::T0, offsetof(ProbeContext, lo), Reg::SP));
+			a.Emit(mfsa(Reg::T0));
+			a.Emit(sw(Reg::T0, offsetof(ProbeContext, sa), Reg::SP));
+
+			for(uint32_t i = 0; i < 32; ++i)
+				a.Emit(swc1(i, FprOffset(i), Reg::SP));
+
+			a.Emit(lw(Reg::T0, 8, Reg::RA));
+			a.Emit(sw(Reg::T0, offsetof(ProbeContext, pc), Reg::SP));
+			a.Emit(lw(Reg::T9, 0, Reg::RA));
+			a.Emit(lw(Reg::A1, 4, Reg::RA));
+			a.Jalr(Reg::T9, daddu(Reg::A0, Reg::SP, Reg::R0));
+
+			// Restore, picking up anything the callback changed.
+			for(uint32_t i = 0; i < 32; ++i)
+				a.Emit(lwc1(i, FprOffset(i), Reg::SP));
+
+			a.Emit(lw(Reg::T0, offsetof(ProbeContext, sa), Reg::SP));
+			a.Emit(mtsa(Reg::T0));
+			a.Emit(lq(Reg::T0, offsetof(ProbeContext, hi), Reg::SP));
+			a.Emit(pmthi(Reg::T0));
+			a.Emit(lq(Reg::T0, offsetof(ProbeContext, lo), Reg::SP));
+			a.Emit(pmtlo(Reg::T0));
+
+			// The thunk restores ra from its frame.
+			a.Emit(lq(Reg::T0, GprOffset(Reg::RA), Reg::SP));
+			a.Emit(sq(Reg::T0, DispatcherFrameSize, Reg::SP));
+
+			for(uint32_t i = 1; i < 31; ++i) {
+				const auto reg = static_cast<Reg>(i);
+				if(reg != Reg::SP && reg != Reg::K0 && reg != Reg::K1)
+					a.Emit(lq(reg, GprOffset(reg), Reg::SP));
+			}
+
+			a.Emit(lq(Reg::RA, DispatcherReturnOffset, Reg::SP));
+			a.Emit(addiu(Reg::RA, Reg::RA, (ThunkResumeIndex - ThunkDataIndex) * sizeof(uint32_t)));
+			a.Jr(Reg::RA, addiu(Reg::SP, Reg::SP, DispatcherFrameSize));
+		}>();
+
+		static_assert(dispatcher.code[0] == addiu(Reg::SP, Reg::SP, -DispatcherFrameSize));
+		static_assert(dispatcher.code[dispatcher.Length - 2] == jr(Reg::RA));
+
+		constexpr static auto siteTemplate = Assemble<[](Assembler& a) {
+			a.JumpTo(0);
+		}>();
+
+		static_assert(siteTemplate.Length == ProbeSiteLength);
+
+		// Room left in the thunk for the relocated instructions.
+		constexpr uint32_t MaxProbeRelocatedLength = TrampolineSlotSize(TrampolineSlot::Large) / sizeof(uint32_t) - thunkTemplate.Length;
+
+		void FreeProbeThunk(void* thunk) {
+			FreeTrampolineSlot(thunk, TrampolineSlot::Large);
+		}
+
+	} // namespace
+
+	bool InstallProbe(void* address, ProbeCallback callback, void* user) {
+		MLSTD_ASSERT(address != nullptr && callback != nullptr);
+		if(address == nullptr || callback == nullptr)
+			return false;
+
+		auto* site = static_cast<uint32_t*>(address);
+		const auto siteAddress = reinterpret_cast<uintptr_t>(address);
+
+		// A probe in a delay slot would run the thunk instead of the branch target.
+		if(mips::Decode(site[-1], siteAddress - sizeof(uint32_t)).HasDelaySlot()) {
+			ELFLDR_LOG_WARNING(Hook, "Refusing to probe %p: %s", address, "Address is in a delay slot");
+			return false;
+		}
+
+		auto* thunk = AllocTrampolineSlot(TrampolineSlot::Large);
+		const auto thunkAddress = reinterpret_cast<uintptr_t>(thunk);
+		const auto codeAddress = thunkAddress + thunkTemplate.Size;
+		const auto siteEnd = siteAddress + ProbeSiteLength * sizeof(uint32_t);
+
+		// Both the site and the jump back have to be a plain j: anything longer
+		// would need a scratch register, and every register is live here.
+		if(!util::detail::JumpReaches(siteAddress, thunkAddress) || !util::detail::JumpReaches(codeAddress + ProbeSiteLength * sizeof(uint32_t), siteEnd)) {
+			ELFLDR_LOG_WARNING(Hook, "Refusing to probe %p: %s", address, RelocateErrorString(RelocateError::OutOfSegment));
+			FreeProbeThunk(thunk);
+			return false;
+		}
+
+		const auto relocated = RelocatePrologue(&site[0], ProbeSiteLength, siteAddress, codeAddress);
+		if(relocated.error != RelocateError::None) {
+			ELFLDR_LOG_WARNING(Hook, "Refusing to probe %p: %s", address, RelocateErrorString(relocated.error));
+			FreeProbeThunk(thunk);
+			return false;
+		}
+
+		MLSTD_ASSERT(relocated.length <= MaxProbeRelocatedLength);
+
+		const uintptr_t thunkSlots[] { reinterpret_cast<uintptr_t>(&dispatcher.code[0]) };
+		thunkTemplate.Link(thunk, thunkSlots);
+		thunk[ThunkDataIndex + 0] = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(callback));
+		thunk[ThunkDataIndex + 1] = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(user));
+		thunk[ThunkDataIndex + 2] = static_cast<uint32_t>(siteAddress);
+		memcpy(&thunk[thunkTemplate.Length], &relocated.code[0], relocated.length * sizeof(uint32_t));
+
+		// Journal the site, handing the thunk over to it.
+		uint32_t siteCode[ProbeSiteLength];
+		const uintptr_t siteSlots[] { thunkAddress };
+		siteTemplate.LinkAt(&siteCode[0], siteAddress, siteSlots);
+		WriteMemory(&site[0], &siteCode[0], sizeof(siteCode), { thunk, FreeProbeThunk });
+
+		util::detail::FlushHookedCode();
+		return true;
+	}
+
+	bool RemoveProbe(void* address) {
+		return RevertJournalAt(address);
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,126 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Getting the profile report out of the game. Like the report itself,
+// this doesn't touch the hardware, so it can be built on the host.
+
+#include <mlstd/Allocator.h>
+#include <string.h>
+#include <utils/CodeUtils.h>
+#include <utils/GameFileIo.h>
+#include <utils/GameVersion.h>
+#include <utils/Hook.h>
+#include <utils/Log.h>
+#include <utils/Profiler.h>
+#include <utils/SymbolDb.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		// int scePadRead(int port, int slot, unsigned char* rdata).
+		using PadReadFunction = int (*)(int, int, uint8_t*);
+
+		// Buttons are bytes 2 and 3 of what scePadRead() reads, and a held button is 0.
+		constexpr uint16_t PadSelect = 0x0001;
+		constexpr uint16_t PadL3 = 0x0002;
+		constexpr uint16_t PadR3 = 0x0004;
+		constexpr uint16_t DumpCombo = PadSelect | PadL3 | PadR3;
+
+		void* gPadReadAddress = nullptr;
+		PadReadFunction gOriginalPadRead = nullptr;
+
+		// So holding the combo down only dumps once.
+		bool gComboHeld = false;
+
+		int PadReadHook(int port, int slot, uint8_t* data) {
+			const auto result = gOriginalPadRead(port, slot, data);
+			if(port != 0 || slot != 0 || result == 0 || !data || data[0] != 0)
+				return result;
+
+			const auto held = static_cast<uint16_t>(~(data[2] | data[3] << 8));
+			const bool combo = (held & DumpCombo) == DumpCombo;
+			if(combo && !gComboHeld)
+				DumpProfile();
+
+			gComboHeld = combo;
+			return result;
+		}
+
+	} // namespace
+
+	void DumpProfile(const char* path) {
+		uint32_t count;
+		const auto* entries = GetProfileEntries(count);
+
+		// Header, and one line per function.
+		constexpr size_t ReportLineSize = 128;
+		const size_t size = (count + 2) * ReportLineSize;
+
+		auto* report = static_cast<char*>(mlstd::Alloc(size));
+		if(!report)
+			return;
+
+		const auto length = FormatProfileReport(entries, count, report, size);
+
+		// Sony's open flags are the same as fio's.
+		const auto io = FindGameFileIo();
+		if(io.open && io.write && io.close) {
+			const auto fd = io.open(path, FIO_O_CREAT | FIO_O_TRUNC | FIO_O_WRONLY, 0);
+			if(fd >= 0) {
+				io.write(fd, report, static_cast<int>(length));
+				io.close(fd);
+			} else {
+				ELFLDR_LOG_ERROR(Profiler, "Couldn't open %s (%d)", path, fd);
+			}
+		} else {
+			ELFLDR_LOG_WARNING(Profiler, "sceOpen/sceWrite/sceClose aren't known for %s; the profile only goes to the debug output", GetGameVersionData().GameID().CStr());
+		}
+
+		for(char* line = report; *line;) {
+			char* next = strchr(line, '\n');
+			if(next)
+				*next++ = '\0';
+			DebugOut("%s", line);
+			line = next ? next : line + strlen(line);
+		}
+
+		mlstd::Free(report);
+	}
+
+	bool InstallProfileDumpCombo() {
+		if(gPadReadAddress)
+			return true;
+
+		const auto address = FindSymbol("scePadRead");
+		if(address == 0) {
+			ELFLDR_LOG_WARNING(Profiler, "scePadRead isn't known for %s; call DumpProfile() to get the profile", GetGameVersionData().GameID().CStr());
+			return false;
+		}
+
+		gComboHeld = false;
+		gOriginalPadRead = HookFunction<PadReadFunction>(Ptr(address), PadReadHook);
+		if(!gOriginalPadRead) {
+			ELFLDR_LOG_ERROR(Profiler, "Couldn't hook scePadRead at %p", Ptr(address));
+			return false;
+		}
+
+		gPadReadAddress = Ptr(address);
+		ELFLDR_LOG_INFO(Profiler, "Press Select+L3+R3 to write the profile to host:profile.txt");
+		return true;
+	}
+
+	void RemoveProfileDumpCombo() {
+		if(!gPadReadAddress)
+			return;
+
+		UnhookFunction(gPadReadAddress);
+		gPadReadAddress = nullptr;
+		gOriginalPadRead = nullptr;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,207 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <mlstd/Assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <utils/Hook.h>
+#include <utils/Log.h>
+#include <utils/MipsAssembler.h>
+#include <utils/MipsIEncoder.h>
+#include <utils/Profiler.h>
+#include <utils/TrampolinePool.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+		using namespace mips;
+
+		// COP0 Count: increments every EE core cycle.
+		constexpr uint32_t Cop0Count = 9;
+
+		// Max depth of nested profiled calls. Deeper calls aren't counted.
+		constexpr uint32_t MaxShadowDepth = 128;
+
+		struct ShadowFrame {
+			uint32_t returnAddress;
+			uint32_t entry;
+			uint32_t start;
+			uint32_t pad;
+		};
+
+		constexpr int16_t ShadowFrameSize = sizeof(ShadowFrame);
+
+		struct ShadowStack {
+			ShadowFrame* top;
+			ShadowFrame* end;
+		};
+
+		// One spare frame past the end, which the entry stub can scribble on
+		// when the stack is full.
+		ShadowFrame gShadowFrames[MaxShadowDepth + 1] {};
+		ShadowStack gShadowStack { &gShadowFrames[0], &gShadowFrames[MaxShadowDepth] };
+
+		ProfileEntry gEntries[MaxProfiledFunctions] {};
+		uint32_t gEntryCount = 0;
+
+		// The entry and exit stubs, shared by every profiled function.
+		uint32_t* gStubs = nullptr;
+
+		// Per-function thunk, hooked over the function.
+		// Relocation slot 0 is the entry stub, slot 1 the function's ProfileEntry.
+		constexpr static auto thunkTemplate = Assemble<[](Assembler& a) {
+			a.LoadAddress(Reg::V1, 1);
+			a.JumpTo(0);
+		}>();
+
+		// Entry stub. v1 is the ProfileEntry. Only uses v0, v1 and at,
+		// which are free at function entry.
+		//
+		// Relocation slot 0 is the shadow stack, slot 1 the exit stub.
+		constexpr static auto enterStub = Assemble<[](Assembler& a) {
+			auto full = a.NewLabel();
+
+			a.LoadAddress(Reg::AT, 0);
+			a.Emit(lw(Reg::V0, offsetof(ShadowStack, top), Reg::AT));
+			a.Emit(sw(Reg::V1, offsetof(ShadowFrame, entry), Reg::V0));
+			a.Emit(lw(Reg::AT, offsetof(ShadowStack, end), Reg::AT));
+
+			// Either way, v1 becomes the trampoline to the original function.
+			a.Branch(beq(Reg::V0, Reg::AT, 0), full, lw(Reg::V1, offsetof(ProfileEntry, trampoline), Reg::V1));
+
+			a.Emit(sw(Reg::RA, offsetof(ShadowFrame, returnAddress), Reg::V0));
+			a.Emit(addiu(Reg::V0, Reg::V0, ShadowFrameSize));
+			a.LoadAddress(Reg::AT, 0);
+			a.Emit(sw(Reg::V0, offsetof(ShadowStack, top), Reg::AT));
+
+			// Return into the exit stub.
+			a.LoadAddress(Reg::RA, 1);
+
+			// Read the counter as late as possible.
+			a.Emit(mfc0(Reg::AT, Cop0Count));
+			a.Emit(sw(Reg::AT, static_cast<int16_t>(offsetof(ShadowFrame, start)) - ShadowFrameSize, Reg::V0));
+
+			a.Bind(full);
+			a.Jr(Reg::V1);
+		}>();
+
+		// Exit stub. v0/v1 and f0/f1 hold the return value; everything else
+		// caller-saved is free.
+		//
+		// Relocation slot 0 is the shadow stack, slot 1 RecordCall().
+		constexpr int16_t ExitFrameSize = 48;
+
+		constexpr static auto exitStub = Assemble<[](Assembler& a) {
+			// Read the counter as early as possible.
+			a.Emit(mfc0(Reg::T9, Cop0Count));
+
+			a.LoadAddress(Reg::AT, 0);
+			a.Emit(lw(Reg::T8, offsetof(ShadowStack, top), Reg::AT));
+			a.Emit(addiu(Reg::T8, Reg::T8, -ShadowFrameSize));
+			a.Emit(sw(Reg::T8, offsetof(ShadowStack, top), Reg::AT));
+
+			a.Emit(addiu(Reg::SP, Reg::SP, -ExitFrameSize));
+			a.Emit(sq(Reg::V0, 0, Reg::SP));
+			a.Emit(sq(Reg::V1, 16, Reg::SP));
+			a.Emit(swc1(0, 32, Reg::SP));
+			a.Emit(swc1(1, 36, Reg::SP));
+			a.Emit(lw(Reg::RA, offsetof(ShadowFrame, returnAddress), Reg::T8));
+			a.Emit(sw(Reg::RA, 40, Reg::SP));
+
+			a.Emit(lw(Reg::A0, offsetof(ShadowFrame, entry), Reg::T8));
+			a.Emit(lw(Reg::A1, offsetof(ShadowFrame, start), Reg::T8));
+			a.Emit(daddu(Reg::A2, Reg::T9, Reg::R0));
+			a.LoadAddress(Reg::T9, 1);
+			a.Jalr(Reg::T9);
+
+			a.Emit(lw(Reg::RA, 40, Reg::SP));
+			a.Emit(lq(Reg::V0, 0, Reg::SP));
+			a.Emit(lq(Reg::V1, 16, Reg::SP));
+			a.Emit(lwc1(0, 32, Reg::SP));
+			a.Emit(lwc1(1, 36, Reg::SP));
+			a.Jr(Reg::RA, addiu(Reg::SP, Reg::SP, ExitFrameSize));
+		}>();
+
+		void RecordCall(ProfileEntry* entry, uint32_t start, uint32_t end) {
+			RecordProfiledCall(*entry, start, end);
+		}
+
+		bool SetupStubs() {
+			if(gStubs)
+				return true;
+
+			gStubs = static_cast<uint32_t*>(mlstd::Alloc(enterStub.Size + exitStub.Size));
+			if(!gStubs)
+				return false;
+
+			auto* exitCode = &gStubs[enterStub.Length];
+			const uintptr_t enterSlots[] { reinterpret_cast<uintptr_t>(&gShadowStack), reinterpret_cast<uintptr_t>(exitCode) };
+			const uintptr_t exitSlots[] { reinterpret_cast<uintptr_t>(&gShadowStack), reinterpret_cast<uintptr_t>(&RecordCall) };
+
+			enterStub.Link(&gStubs[0], enterSlots);
+			exitStub.Link(exitCode, exitSlots);
+			return true;
+		}
+
+		void FreeThunk(void* thunk) {
+			FreeTrampolineSlot(thunk, TrampolineSlot::Small);
+		}
+
+	} // namespace
+
+	bool ProfileFunction(void* function, const char* name) {
+		if(gEntryCount == MaxProfiledFunctions) {
+			ELFLDR_LOG_WARNING(Profiler, "Not profiling %s: profile table is full", name);
+			return false;
+		}
+
+		if(!SetupStubs())
+			return false;
+
+		// The first function profiled also sets up a way to get the report out.
+		if(gEntryCount == 0)
+			InstallProfileDumpCombo();
+
+		auto& entry = gEntries[gEntryCount];
+		entry = {};
+		entry.name = name;
+		entry.function = function;
+
+		auto* thunk = AllocTrampolineSlot(TrampolineSlot::Small);
+		const uintptr_t thunkSlots[] { reinterpret_cast<uintptr_t>(&gStubs[0]), reinterpret_cast<uintptr_t>(&entry) };
+		thunkTemplate.Link(thunk, thunkSlots);
+
+		// Hooking flushes the caches (or the hook batch does), which
+		// covers the stubs and the thunk too.
+		entry.trampoline = util::detail::HookFunctionBase(function, thunk);
+		if(!entry.trampoline) {
+			FreeThunk(thunk);
+			return false;
+		}
+
+		++gEntryCount;
+		return true;
+	}
+
+	void ResetProfile() {
+		for(uint32_t i = 0; i < gEntryCount; ++i) {
+			auto& entry = gEntries[i];
+			entry.calls = 0;
+			entry.maxCycles = 0;
+			entry.cycles = 0;
+			memset(&entry.histogram[0], 0, sizeof(entry.histogram));
+		}
+	}
+
+	const ProfileEntry* GetProfileEntries(uint32_t& count) {
+		count = gEntryCount;
+		return &gEntries[0];
+	}
+
+} // namespace elfldr::util
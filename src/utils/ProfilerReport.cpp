@@ -0,0 +1,91 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Profile report formatting. This is kept apart from the profiler itself,
+// and only uses compiler builtins, so it can be built on the host.
+
+#include <utils/Profiler.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		struct ReportWriter {
+			char* buffer;
+			size_t size;
+			size_t length;
+
+			void Append(const char* format, ...) {
+				if(length + 1 >= size)
+					return;
+
+				__builtin_va_list val;
+				__builtin_va_start(val, format);
+				const auto written = __builtin_vsnprintf(&buffer[length], size - length, format, val);
+				__builtin_va_end(val);
+
+				if(written > 0)
+					length += static_cast<size_t>(written);
+				if(length >= size)
+					length = size - 1;
+			}
+
+			/**
+			 * Append a right-aligned 64-bit number.
+			 * (Not all printf implementations we run on have %llu.)
+			 */
+			void AppendU64(uint64_t value, int width) {
+				char digits[21] {};
+				char* p = &digits[sizeof(digits) - 1];
+
+				do {
+					*--p = static_cast<char>('0' + value % 10);
+					value /= 10;
+				} while(value);
+
+				Append("%*s", width, p);
+			}
+		};
+
+	} // namespace
+
+	size_t FormatProfileReport(const ProfileEntry* entries, uint32_t count, char* buffer, size_t size) {
+		if(size == 0)
+			return 0;
+
+		buffer[0] = '\0';
+		if(count > MaxProfiledFunctions)
+			count = MaxProfiledFunctions;
+
+		// Sort by total cycles, most expensive first.
+		uint16_t order[MaxProfiledFunctions];
+		for(uint32_t i = 0; i < count; ++i) {
+			uint32_t j = i;
+			while(j > 0 && entries[order[j - 1]].cycles < entries[i].cycles) {
+				order[j] = order[j - 1];
+				--j;
+			}
+			order[j] = static_cast<uint16_t>(i);
+		}
+
+		ReportWriter writer { buffer, size, 0 };
+		writer.Append("%-31s %10s %16s %12s %12s %14s %12s %12s\n", "Function", "Calls", "Total cycles", "Avg cycles", "Max cycles", "Total us", "p50 <=", "p90 <=");
+
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto& entry = entries[order[i]];
+
+			writer.Append("%-31.31s %10u ", entry.name ? entry.name : "?", entry.calls);
+			writer.AppendU64(entry.cycles, 16);
+			writer.Append(" %12u %12u ", entry.calls ? static_cast<uint32_t>(entry.cycles / entry.calls) : 0, entry.maxCycles);
+			writer.AppendU64(entry.cycles * 1000000 / EeClockHz, 14);
+			writer.Append(" %12u %12u\n", ProfilePercentileBound(entry, 50), ProfilePercentileBound(entry, 90));
+		}
+
+		return writer.length;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,113 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/CodeUtils.h>
+#include <utils/SigScan.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		/**
+		 * The core scan loop.
+		 *
+		 * \tparam OnMatch bool(uintptr_t address). Return false to stop scanning.
+		 */
+		template <class OnMatch>
+		void ScanImpl(const void* begin, const void* end, const SignatureScanner& scanner, uint32_t alignment, OnMatch&& onMatch) {
+			MLSTD_ASSERT(IsPowOf2(alignment));
+
+			const auto* ptr = static_cast<const uint8_t*>(begin);
+			const auto* endPtr = static_cast<const uint8_t*>(end);
+			const auto length = scanner.signature.length;
+
+			if(endPtr < ptr || static_cast<uint32_t>(endPtr - ptr) < length)
+				return;
+
+			// Last position a full signature can start at.
+			const auto* last = endPtr - length;
+
+			const auto lastIndex = scanner.anchorLength - 1;
+			const auto lastByte = scanner.signature.bytes[lastIndex];
+			const auto lastMask = scanner.signature.masks[lastIndex];
+			const auto alignMask = static_cast<uintptr_t>(alignment - 1);
+
+			// Only aligned windows can match, so every shift is rounded up to the next one.
+			auto AlignUp = [alignMask](const uint8_t* p) {
+				return reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(p) + alignMask) & ~alignMask);
+			};
+
+			ptr = AlignUp(ptr);
+
+			if(alignment >= sizeof(uint32_t) && scanner.wordMask != 0) {
+				// One load and compare per window. The word is inside the
+				// signature, so it's inside the range too.
+				for(; ptr <= last; ptr += alignment) {
+					uint32_t word;
+					__builtin_memcpy(&word, __builtin_assume_aligned(ptr + scanner.wordOffset, sizeof(uint32_t)), sizeof(word));
+
+					if((word & scanner.wordMask) == scanner.wordValue && scanner.MatchesAt(ptr)) {
+						if(!onMatch(reinterpret_cast<uintptr_t>(ptr)))
+							return;
+					}
+				}
+				return;
+			}
+
+			while(ptr <= last) {
+				const auto c = ptr[lastIndex];
+
+				// Check the last byte of the window first; it's already loaded,
+				// and rejects most windows without touching the rest.
+				if((c & lastMask) == lastByte && scanner.MatchesAt(ptr)) {
+					if(!onMatch(reinterpret_cast<uintptr_t>(ptr)))
+						return;
+				}
+
+				ptr = AlignUp(ptr + scanner.skip[c]);
+			}
+		}
+
+	} // namespace
+
+	uint32_t SigScan(const void* begin, const void* end, const SignatureScanner& scanner, uintptr_t* matches, uint32_t maxMatches, uint32_t alignment) {
+		uint32_t count = 0;
+
+		ScanImpl(begin, end, scanner, alignment, [&](uintptr_t address) {
+			if(count < maxMatches)
+				matches[count] = address;
+			++count;
+			return true;
+		});
+
+		return count;
+	}
+
+	uintptr_t SigScanFirst(const void* begin, const void* end, const SignatureScanner& scanner, uint32_t alignment) {
+		uintptr_t match = 0;
+
+		ScanImpl(begin, end, scanner, alignment, [&](uintptr_t address) {
+			match = address;
+			return false;
+		});
+
+		return match;
+	}
+
+	uintptr_t SigScanUnique(const void* begin, const void* end, const SignatureScanner& scanner, uint32_t alignment) {
+		uintptr_t match = 0;
+		uint32_t count = 0;
+
+		ScanImpl(begin, end, scanner, alignment, [&](uintptr_t address) {
+			match = address;
+			return ++count < 2;
+		});
+
+		return count == 1 ? match : 0;
+	}
+
+} // namespace elfldr::util
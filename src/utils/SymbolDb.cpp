@@ -0,0 +1,156 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/FioFile.h>
+#include <utils/Log.h>
+#include <utils/SymbolDb.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+#include "Symbols/SymbolTables.inl"
+
+		// A loaded database is kept in a fixed buffer, since it's
+		// loaded before the allocator (which needs it) is set up.
+		// The whole thing (header and all) is read in one go.
+		constexpr uint32_t MaxLoadedSymbols = 1024;
+
+		struct alignas(64) LoadedDatabase {
+			SymbolDbHeader header;
+			SymbolEntry entries[MaxLoadedSymbols];
+		};
+
+		static_assert(__builtin_offsetof(LoadedDatabase, entries) == sizeof(SymbolDbHeader), "Entries have to follow the header, like in the file");
+
+		LoadedDatabase gLoaded {};
+		uint32_t gLoadedCount = 0;
+
+#ifndef ERL
+		// The load in progress.
+		// (Loading needs fio, which only the ELF has.)
+		FioFile gLoadFile;
+		FioReadRequest gLoadRequest;
+		const char* gLoadPath = nullptr;
+
+		/**
+		 * Check the database once it's been read.
+		 *
+		 * \param[in] read How much the read got.
+		 */
+		bool CheckLoadedDatabase(int read) {
+			const auto& header = gLoaded.header;
+			if(read < static_cast<int>(sizeof(header)) || header.magic != SymbolDbHeader::Magic || header.version != SymbolDbHeader::CurrentVersion) {
+				ELFLDR_LOG_WARNING(Loader, "%s is not a symbol database", gLoadPath);
+				return false;
+			}
+
+			if(header.count > MaxLoadedSymbols) {
+				ELFLDR_LOG_WARNING(Loader, "%s has too many symbols (%u, max %u)", gLoadPath, header.count, MaxLoadedSymbols);
+				return false;
+			}
+
+			// fio can come up short. If it did, get the rest.
+			const auto size = static_cast<int>(sizeof(header) + header.count * sizeof(SymbolEntry));
+			if(read < size && gLoadFile.ReadFully(reinterpret_cast<uint8_t*>(&gLoaded) + read, size - read) != size - read) {
+				ELFLDR_LOG_WARNING(Loader, "%s is truncated", gLoadPath);
+				return false;
+			}
+
+			// Lookups binary search, so make sure it's actually sorted.
+			for(uint32_t i = 1; i < header.count; ++i) {
+				if(gLoaded.entries[i - 1].hash >= gLoaded.entries[i].hash) {
+					ELFLDR_LOG_WARNING(Loader, "%s is not sorted", gLoadPath);
+					return false;
+				}
+			}
+
+			gLoadedCount = header.count;
+			ELFLDR_LOG_INFO(Loader, "Loaded %u symbols from %s", gLoadedCount, gLoadPath);
+			return true;
+		}
+#endif
+
+	} // namespace
+
+	const SymbolTable* FindSymbolTable(Game game, GameRegion region, GameVersion version) {
+		for(const auto& table : SymbolTables)
+			if(table.game == game && table.region == region && table.version == version)
+				return &table;
+		return nullptr;
+	}
+
+#ifndef ERL
+	bool LoadSymbolDatabase(const char* path) {
+		return BeginLoadSymbolDatabase(path) && FinishLoadSymbolDatabase();
+	}
+
+	bool BeginLoadSymbolDatabase(const char* path) {
+		// Don't pull the buffer out from under an earlier load.
+		gLoadRequest.Wait();
+
+		gLoadedCount = 0;
+		gLoadPath = path;
+
+		gLoadFile.Open(path, FIO_O_RDONLY);
+		if(!gLoadFile)
+			return false;
+
+		// Ask for as much as there could be; the header says how much there actually is.
+		if(!gLoadFile.ReadAsync(gLoadRequest, &gLoaded, sizeof(gLoaded))) {
+			gLoadFile.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool FinishLoadSymbolDatabase() {
+		if(!gLoadFile)
+			return false;
+
+		const auto loaded = CheckLoadedDatabase(gLoadRequest.Wait());
+		gLoadFile.Close();
+		return loaded;
+	}
+#endif
+
+	uintptr_t FindSymbol(uint32_t hash) {
+		if(auto address = FindSymbolIn(&gLoaded.entries[0], gLoadedCount, hash); address != 0)
+			return address;
+
+		const auto& verData = GetGameVersionData();
+		if(auto* table = FindSymbolTable(verData.game, verData.region, verData.version); table)
+			return FindSymbolIn(table->entries, table->count, hash);
+
+		return 0;
+	}
+
+	uint32_t BindFunctions(const SymbolBinding* bindings, uint32_t count) {
+		uint32_t bound = 0;
+
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto& binding = bindings[i];
+			const auto address = FindSymbol(binding.hash);
+
+			if(address == 0) {
+				if(binding.required)
+					ELFLDR_LOG_WARNING(Loader, "Symbol %s isn't known for %s", binding.name, GetGameVersionData().GameID().CStr());
+				else
+					ELFLDR_LOG_DEBUG(Loader, "Optional symbol %s isn't known for %s", binding.name, GetGameVersionData().GameID().CStr());
+				continue;
+			}
+
+			binding.bind(binding.target, address);
+			++bound;
+		}
+
+		return bound;
+	}
+
+} // namespace elfldr::util
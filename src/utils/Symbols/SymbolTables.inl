@@ -0,0 +1,22 @@
+// Generated by symdbgen from Symbols.csv. Do not edit.
+// Regenerate with `cmake --build build-tools -t symdb`.
+
+constexpr SymbolEntry ssx_us_1_0_Symbols[] {
+	{ 0x13400ab9, 0x0023a998 }, // MEM_free
+	{ 0x2674e78d, 0x0023b2a0 }, // MEM_init
+	{ 0x700040d8, 0x0023a448 }, // MEM_alloc
+	{ 0xcd114e58, 0x0018a280 }, // initheapdebug
+	{ 0xe76fb4aa, 0x0018ac08 }, // printf
+};
+
+constexpr SymbolEntry ssxdvd_us_1_0_Symbols[] {
+	{ 0x13400ab9, 0x002ccfc0 }, // MEM_free
+	{ 0x2674e78d, 0x002cd798 }, // MEM_init
+	{ 0x700040d8, 0x002ccf70 }, // MEM_alloc
+	{ 0xcd114e58, 0x002cd798 }, // initheapdebug
+};
+
+constexpr SymbolTable SymbolTables[] {
+	{ Game::SSXOG, GameRegion::NTSC, GameVersion::SSXOG_10, &ssx_us_1_0_Symbols[0], 5 },
+	{ Game::SSXDVD, GameRegion::NTSC, GameVersion::SSXDVD_10, &ssxdvd_us_1_0_Symbols[0], 4 },
+};
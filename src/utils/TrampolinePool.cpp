@@ -0,0 +1,98 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <mlstd/Allocator.h>
+#include <mlstd/Assert.h>
+#include <utils/TrampolinePool.h>
+
+namespace elfldr::util {
+
+	namespace {
+
+		constexpr uint32_t SlabSize = 8192;
+		constexpr uint32_t CacheLineSize = 64;
+
+		/**
+		 * A free slot. Freed slots are threaded through their own memory.
+		 */
+		struct FreeSlot {
+			FreeSlot* next;
+		};
+
+		FreeSlot* gFreeLists[2] {};
+
+		// The slab currently being carved up.
+		uint8_t* gSlabCursor = nullptr;
+		uint8_t* gSlabEnd = nullptr;
+
+		TrampolinePoolStats gStats {};
+
+		void NewSlab() {
+			// The EE has no concept of non-executable memory,
+			// so any heap memory works. Over-allocate to align it to a cache line.
+			auto* raw = static_cast<uint8_t*>(mlstd::Alloc(SlabSize + CacheLineSize));
+			MLSTD_VERIFY(raw != nullptr && "Could not allocate trampoline slab");
+
+			auto aligned = (reinterpret_cast<uintptr_t>(raw) + CacheLineSize - 1) & ~static_cast<uintptr_t>(CacheLineSize - 1);
+			gSlabCursor = reinterpret_cast<uint8_t*>(aligned);
+			gSlabEnd = gSlabCursor + SlabSize;
+			++gStats.slabs;
+		}
+
+		uint8_t* CarveSlot(uint32_t size) {
+			// Slots are carved at their own alignment, so large slots never straddle a line.
+			auto aligned = [&]() {
+				return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(gSlabCursor) + size - 1) & ~static_cast<uintptr_t>(size - 1));
+			};
+
+			if(!gSlabCursor || aligned() + size > gSlabEnd)
+				NewSlab();
+
+			auto* slot = aligned();
+
+			// A small slot skipped over by aligning is still good for something.
+			if(slot != gSlabCursor) {
+				auto* skipped = reinterpret_cast<FreeSlot*>(gSlabCursor);
+				skipped->next = gFreeLists[static_cast<uint8_t>(TrampolineSlot::Small)];
+				gFreeLists[static_cast<uint8_t>(TrampolineSlot::Small)] = skipped;
+			}
+
+			gSlabCursor = slot + size;
+			return slot;
+		}
+
+	} // namespace
+
+	uint32_t* AllocTrampolineSlot(TrampolineSlot slot) {
+		auto& freeList = gFreeLists[static_cast<uint8_t>(slot)];
+		++gStats.slotsInUse;
+
+		if(freeList) {
+			auto* freeSlot = freeList;
+			freeList = freeSlot->next;
+			return reinterpret_cast<uint32_t*>(freeSlot);
+		}
+
+		return reinterpret_cast<uint32_t*>(CarveSlot(TrampolineSlotSize(slot)));
+	}
+
+	void FreeTrampolineSlot(void* ptr, TrampolineSlot slot) {
+		if(!ptr)
+			return;
+
+		auto& freeList = gFreeLists[static_cast<uint8_t>(slot)];
+		auto* freeSlot = static_cast<FreeSlot*>(ptr);
+		freeSlot->next = freeList;
+		freeList = freeSlot;
+		--gStats.slotsInUse;
+	}
+
+	TrampolinePoolStats GetTrampolinePoolStats() {
+		return gStats;
+	}
+
+} // namespace elfldr::util
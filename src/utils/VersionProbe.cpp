@@ -5,17 +5,16 @@
  * under the terms of the MIT license.
  */
 
-#include <utils/FioDirectory.h>
+#include <utils/DirectoryIndex.h>
 #include <utils/GameVersion.h>
 
 namespace elfldr::util {
 
 	void AutodetectGameVersion() {
-		util::FioDirectory dir("host:");
-		bool gameDetected = false;
+		auto& index = GetHostIndex();
 		auto& versionData = GetGameVersionData();
 
-		if(!dir.Good()) {
+		if(index.RootCount() == 0) {
 			// Older PCSX2 versions do not support dopen() on the HostFS device,
 			// for reasons that are kinda unknown to me.
 			//
@@ -27,43 +26,32 @@ namespace elfldr::util {
 				;
 		}
 
-		dir.Iterate([&](io_dirent_t& ent) {
-			auto TryGame = [&](Game game, GameRegion region, GameVersion version) {
-				// DebugOut("trying \"%s\"", GameBinaryFor(game, region, version).CStr());
-				if(mlstd::StrCaseMatch(mlstd::StringView(ent.name), GameBinaryFor(game, region, version))) {
-					versionData.game = game;
-					versionData.region = region;
-					versionData.version = version;
-					gameDetected = true;
-					return true;
-				}
+		// host: was walked once when it was indexed, so each of these is a local lookup.
+		auto TryGame = [&](Game game, GameRegion region, GameVersion version) {
+			if(!index.Exists(HostIndexRoot, GameBinaryFor(game, region, version)))
 				return false;
-			};
-
-			// util::DebugOut("%s stat mode 0x%08x attr 0x%08x", ent.name, ent.stat.mode, ent.stat.attr);
-
-			// This is a hack but if this works it works
-			// if(ELFLDR_FIO_ISREG(ent)) {
-			if(TryGame(Game::SSXOG, GameRegion::NTSC, GameVersion::SSXOG_10))
-				return false;
-			if(TryGame(Game::SSXDVD, GameRegion::NTSC, GameVersion::SSXDVD_10))
-				return false;
-			if(TryGame(Game::SSXDVD, GameRegion::NotApplicable, GameVersion::SSXDVD_JAMPACK_DEMO))
-				return false;
-			if(TryGame(Game::SSX3, GameRegion::NTSC, GameVersion::SSX3_OPSM2_DEMO))
-				return false;
-			if(TryGame(Game::SSX3, GameRegion::NotApplicable, GameVersion::SSX3_KR_DEMO))
-				return false;
-			if(TryGame(Game::SSX3, GameRegion::NTSC, GameVersion::SSX3_10))
-				return false;
-			//}
 
+			versionData.game = game;
+			versionData.region = region;
+			versionData.version = version;
 			return true;
-		});
-
-		// Mark invalid game if the above loop did not detect any game.
-		if(!gameDetected)
-			versionData.game = Game::Invalid;
+		};
+
+		if(TryGame(Game::SSXOG, GameRegion::NTSC, GameVersion::SSXOG_10))
+			return;
+		if(TryGame(Game::SSXDVD, GameRegion::NTSC, GameVersion::SSXDVD_10))
+			return;
+		if(TryGame(Game::SSXDVD, GameRegion::NotApplicable, GameVersion::SSXDVD_JAMPACK_DEMO))
+			return;
+		if(TryGame(Game::SSX3, GameRegion::NTSC, GameVersion::SSX3_OPSM2_DEMO))
+			return;
+		if(TryGame(Game::SSX3, GameRegion::NotApplicable, GameVersion::SSX3_KR_DEMO))
+			return;
+		if(TryGame(Game::SSX3, GameRegion::NTSC, GameVersion::SSX3_10))
+			return;
+
+		// Mark invalid game if none of the above were there.
+		versionData.game = Game::Invalid;
 	}
 
 } // namespace elfldr::util
\ No newline at end of file
@@ -16,6 +16,7 @@
 #ifndef NDEBUG
 __attribute__((weak)) void mlstdAssertionFailure(const char* exp, const char* function, const char* file, unsigned line) {
 	elfldr::util::DebugOut("MLSTD_ASSERT(%s) failed. File: %s:%d Function %s", exp, file, line, function);
+	elfldr::util::DebugFlush();
 	while(true)
 		;
 }
@@ -23,6 +24,7 @@ __attribute__((weak)) void mlstdAssertionFailure(const char* exp, const char* fu
 
 __attribute__((weak)) void mlstdVerifyFailure(const char* exp, const char* file, unsigned line) {
 	elfldr::util::DebugOut("MLSTD_VERIFY(%s) failed. File: %s:%d", exp, file, line);
+	elfldr::util::DebugFlush();
 	while(true)
 		;
 }
@@ -11,9 +11,13 @@
 #include <string.h>
 
 #include <utils/FioFile.h>
+#include <utils/Log.h>
 
 #ifdef ERL
 	#include <sdk/GameApi.h>
+#else
+	#include <utils/FioAsync.h>
+	#include <utils/FioBackend.h>
 #endif
 
 // internal symbol from MLSTD
@@ -29,9 +33,152 @@ namespace elfldr::util {
 
 	FioFile logFile;
 
+#ifndef ERL
+	namespace {
+
+		// Log lines are batched into a buffer, and written to the log file in
+		// big chunks, instead of a write (or two) and a sync per line.
+		//
+		// There are two buffers: while one is being written (asynchronously),
+		// lines go into the other. fio only has one operation in flight at a time,
+		// and every fio call waits for the previous one to complete first,
+		// so once the next write has been issued, the last buffer is free again.
+		constexpr uint32_t LogBufferSize = 8192;
+
+		/**
+		 * Once a buffer has this much in it, it's written out.
+		 */
+		constexpr uint32_t LogFlushThreshold = LogBufferSize * 3 / 4;
+
+		struct LogBuffer {
+			char data[LogBufferSize];
+			uint32_t length;
+		};
+
+		LogBuffer logBuffers[2] {};
+		uint32_t activeLogBuffer = 0;
+
+		/**
+		 * Crash-safe mode: every line is written, and synced, immediately.
+		 */
+		bool logSyncMode = false;
+
+		/**
+		 * Write the active buffer out, and switch to the other one.
+		 *
+		 * \param[in] wait Wait for the write to complete.
+		 */
+		void WriteLogBuffer(bool wait) {
+			auto& buffer = logBuffers[activeLogBuffer];
+			if(buffer.length == 0)
+				return;
+
+			if(!wait)
+				Fio().setBlockMode(FIO_NOWAIT);
+
+			logFile.Write(&buffer.data[0], buffer.length);
+
+			if(!wait)
+				Fio().setBlockMode(FIO_WAIT);
+			else
+				Fio().sync(FIO_WAIT, nullptr);
+
+			activeLogBuffer ^= 1;
+			logBuffers[activeLogBuffer].length = 0;
+		}
+
+		/**
+		 * Make room for length bytes in the active buffer.
+		 * Once they're filled in, call CommitLog().
+		 */
+		char* ReserveLog(uint32_t length) {
+			if(logBuffers[activeLogBuffer].length + length > LogBufferSize)
+				WriteLogBuffer(logSyncMode);
+
+			auto& buffer = logBuffers[activeLogBuffer];
+			auto* out = &buffer.data[buffer.length];
+			buffer.length += length;
+			return out;
+		}
+
+		void CommitLog() {
+			if(logSyncMode) {
+				WriteLogBuffer(true);
+				return;
+			}
+
+			// Writing now would mean waiting on a read someone wanted to overlap
+			// with other work. There's still room, so leave it until later.
+			if(FioReadInFlight())
+				return;
+
+			if(logBuffers[activeLogBuffer].length >= LogFlushThreshold)
+				WriteLogBuffer(false);
+		}
+
+	#ifdef ELFLDR_LOG_TOKENIZED
+		void PutFrameHeader(char* out, uint32_t id, uint32_t payloadLength) {
+			const uint8_t header[LogFrameHeaderSize] {
+				static_cast<uint8_t>(id), static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id >> 16), static_cast<uint8_t>(id >> 24),
+				static_cast<uint8_t>(payloadLength), static_cast<uint8_t>(payloadLength >> 8)
+			};
+			memcpy(out, &header[0], sizeof(header));
+		}
+
+		void AppendLogLine(const char* line) {
+			const auto length = static_cast<uint32_t>(strlen(line));
+
+			auto* out = ReserveLog(LogFrameHeaderSize + length);
+			PutFrameHeader(out, LogTextFrameId, length);
+			memcpy(&out[LogFrameHeaderSize], line, length);
+			CommitLog();
+		}
+	#else
+		void AppendLogLine(const char* line) {
+			const auto length = static_cast<uint32_t>(strlen(line));
+
+			auto* out = ReserveLog(length + 1);
+			memcpy(out, line, length);
+			out[length] = '\n';
+			CommitLog();
+		}
+	#endif
+
+	} // namespace
+#endif
+
+#ifdef ELFLDR_LOG_TOKENIZED
+	namespace detail {
+
+		void LogWriteFrame(uint32_t id, LogFrame& frame) {
+			if(!logFile.Good())
+				return;
+
+			auto* out = ReserveLog(frame.length);
+			PutFrameHeader(reinterpret_cast<char*>(&frame.data[0]), id, frame.length - LogFrameHeaderSize);
+			memcpy(out, &frame.data[0], frame.length);
+			CommitLog();
+		}
+
+	} // namespace detail
+
+	void DebugInit() {
+		logFile.Open("host:modloader.bin", FIO_O_CREAT | FIO_O_APPEND | FIO_O_RDWR);
+		if(!logFile.Good())
+			return;
+
+		// Mark the start of this boot's log.
+		const LogBootPayload boot { LogBootPayload::Magic, LogBootPayload::CurrentVersion };
+		auto* out = ReserveLog(LogFrameHeaderSize + sizeof(boot));
+		PutFrameHeader(out, LogBootFrameId, sizeof(boot));
+		memcpy(&out[LogFrameHeaderSize], &boot, sizeof(boot));
+		CommitLog();
+	}
+#else
 	void DebugInit() {
 		logFile.Open("host:modloader.log", FIO_O_CREAT | FIO_O_APPEND | FIO_O_RDWR);
 	}
+#endif
 
 	// This code is messy since it needs to only use gcc builtins
 	// to work across erl/elf boundaries, alongside some Platform Soup
@@ -41,36 +188,65 @@ namespace elfldr::util {
 	// please don't hate me.
 
 	void DebugOut(const char* format, ...) {
-		char buf[256] {};
-
 		__builtin_va_list val;
 		__builtin_va_start(val, format);
+		DebugOutV("", format, val);
+		__builtin_va_end(val);
+	}
+
+	void DebugOutV(const char* prefix, const char* format, __builtin_va_list val) {
+		char buf[512] {};
 
 #define DEBUGOUT_PREFIX "[Ml] "
+#define DEBUGOUT_TRUNCATED "..."
 
 		LITERAL_STRCPY(&buf[0], DEBUGOUT_PREFIX);
-		VSNPRINTF_OFFSET(buf, sizeof(buf), LITERAL_STRLEN(DEBUGOUT_PREFIX));
+		size_t offset = LITERAL_STRLEN(DEBUGOUT_PREFIX);
+
+		// The prefix is short; anything past a quarter of the line is cut.
+		for(; *prefix && offset < sizeof(buf) / 4; ++prefix)
+			buf[offset++] = *prefix;
+
+		const auto written = VSNPRINTF_OFFSET(buf, sizeof(buf), offset);
+		if(written > 0 && static_cast<size_t>(written) >= sizeof(buf) - offset)
+			LITERAL_STRCPY(&buf[sizeof(buf) - sizeof(DEBUGOUT_TRUNCATED)], DEBUGOUT_TRUNCATED);
 
 #ifndef ERL
 		//printf("%s\n", buf);
 		mlstd_printf("%s\n", buf);
 
 		// Write messages to the logfile if it opened successfully
-		if(logFile.Good()) {
-			logFile.WriteLine(buf);
-			fioSync(FIO_WAIT, nullptr);
-		}
+		if(logFile.Good())
+			AppendLogLine(&buf[0]);
 #else
 		// I could *probably* search through the binary for puts(),
 		// but this is fine (and just as safe).
 		bx::printf("%s\n", buf);
 #endif
-		__builtin_va_end(val);
 	}
 
-	void DebugClose() {
+	void DebugFlush() {
+#ifndef ERL
 		if(logFile.Good())
+			WriteLogBuffer(true);
+#endif
+	}
+
+	void DebugSetSyncMode(bool sync) {
+#ifndef ERL
+		logSyncMode = sync;
+		if(sync)
+			DebugFlush();
+#else
+		static_cast<void>(sync);
+#endif
+	}
+
+	void DebugClose() {
+		if(logFile.Good()) {
+			DebugFlush();
 			logFile.Close();
+		}
 	}
 
 } // namespace elfldr::util
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Helpers for the host benchmarks.
+
+#ifndef ELFLDR_TOOLS_BENCH_H
+#define ELFLDR_TOOLS_BENCH_H
+
+#include <stdint.h>
+
+#include <chrono>
+#include <vector>
+
+namespace elfldr::bench {
+
+	/**
+	 * Run fn() repeatedly for about a second, and return the
+	 * best time one run took, in nanoseconds.
+	 */
+	template <class Fn>
+	inline double BestTimeNs(Fn&& fn) {
+		using Clock = std::chrono::steady_clock;
+
+		double best = 1e300;
+		const auto stop = Clock::now() + std::chrono::seconds(1);
+
+		do {
+			const auto start = Clock::now();
+			fn();
+			const auto time = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			if(time < best)
+				best = time;
+		} while(Clock::now() < stop);
+
+		return best;
+	}
+
+	/**
+	 * A deterministic random number generator (xorshift32),
+	 * so every run benchmarks the same data.
+	 */
+	struct Random {
+		uint32_t state = 0x2545f491;
+
+		uint32_t Next() {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	};
+
+	/**
+	 * Make something which looks like game .text: instruction words with a
+	 * mix of opcodes like EE GCC output, and some nops. Little endian.
+	 */
+	inline std::vector<uint8_t> MakeCode(uint32_t size, Random& random) {
+		// addiu, lw, sw, lui, jal, beq, SPECIAL (twice), bne, sq, sd, ld
+		constexpr uint32_t opcodes[] { 0x09, 0x23, 0x2b, 0x0f, 0x03, 0x04, 0x00, 0x00, 0x05, 0x1f, 0x3f, 0x37 };
+
+		std::vector<uint8_t> code(size);
+		for(uint32_t i = 0; i + 4 <= size; i += 4) {
+			const auto r = random.Next();
+			auto word = (opcodes[r % (sizeof(opcodes) / sizeof(opcodes[0]))] << 26) | (r >> 6 & 0x03ffffff);
+			if(r % 7 == 0)
+				word = 0;
+			for(uint32_t j = 0; j < 4; ++j)
+				code[i + j] = static_cast<uint8_t>(word >> (j * 8));
+		}
+		return code;
+	}
+
+	/**
+	 * Keep the compiler from optimizing a result away.
+	 */
+	template <class T>
+	inline void KeepAlive(const T& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+} // namespace elfldr::bench
+
+#endif // ELFLDR_TOOLS_BENCH_H
@@ -0,0 +1,53 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Decoding a game-sized (4 MB) .text with mips::Decode().
+
+#include <stdio.h>
+#include <string.h>
+
+#include <utils/MipsIDecoder.h>
+
+#include "Bench.h"
+
+using namespace elfldr;
+using namespace elfldr::util;
+
+int main() {
+	constexpr uint32_t Size = 4 * 1024 * 1024;
+	constexpr uint32_t TextAddress = 0x00100000;
+
+	bench::Random random;
+	const auto code = bench::MakeCode(Size, random);
+
+	std::vector<uint32_t> words(Size / 4);
+	memcpy(words.data(), code.data(), Size);
+
+	// What a decoder user does with each word: look at the class,
+	// and at the target of branches and jumps.
+	uint32_t classes[256] {};
+	const auto ns = bench::BestTimeNs([&]() {
+		memset(&classes[0], 0, sizeof(classes));
+		uint32_t targets = 0;
+
+		for(uint32_t i = 0; i < words.size(); ++i) {
+			const auto insn = mips::Decode(words[i], TextAddress + i * 4);
+			++classes[static_cast<uint8_t>(insn.opClass)];
+			targets ^= insn.target;
+		}
+
+		bench::KeepAlive(targets);
+	});
+
+	uint32_t invalid = 0;
+	for(const auto word : words)
+		invalid += !mips::Decode(word).Valid();
+
+	printf("decoded %zu instructions (4 MB) in %.3f ms, %.2f ns per instruction\n", words.size(), ns / 1e6, ns / words.size());
+	printf("%u of them don't decode (reserved opcodes, or fields the EE doesn't use)\n", invalid);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Overlay lookups with a big mod installed: 20000 files (200 folders of
+// 100), as the game opens files. Most opens are misses (files no mod has),
+// so those matter most:
+//
+//	- miss: 100000 different paths no mod has,
+//	- repeat: the same 8 missing paths over and over, like the game
+//	  checking for the same few files,
+//	- hit: paths the mod does have, spelled the way the game spells them.
+//
+// The index column is a plain DirectoryIndex::Find() of the same paths:
+// the hash table probe the overlay would do with no bloom filter or miss cache.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <utils/DirectoryIndex.h>
+#include <utils/OverlayFs.h>
+
+#include "Bench.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr uint32_t Folders = 200;
+	constexpr uint32_t FilesPerFolder = 100;
+	constexpr uint32_t Lookups = 100000;
+
+	// Room for 20000 files and their folders, at most 3/4 full.
+	util::DirectoryIndex::Entry gSlots[32768];
+	char gStrings[1024 * 1024];
+
+	/**
+	 * Lookups of `distinct` different paths, over and over. Path n is the
+	 * format with n % Folders and n / Folders (a folder and a file).
+	 */
+	std::vector<std::string> MakePaths(const char* format, uint32_t distinct) {
+		std::vector<std::string> paths;
+		char path[64];
+		for(uint32_t i = 0; i < Lookups; ++i) {
+			const auto n = i % distinct;
+			snprintf(&path[0], sizeof(path), format, n % Folders, n / Folders);
+			paths.push_back(&path[0]);
+		}
+		return paths;
+	}
+
+} // namespace
+
+int main() {
+	util::DirectoryIndex index { gSlots, gStrings };
+	const auto root = index.AddEmptyRoot("host:mods/big");
+
+	char path[64];
+	index.Insert(root, "data", 0, util::DirectoryIndex::Entry::DirectoryFlag);
+	for(uint32_t folder = 0; folder < Folders; ++folder) {
+		snprintf(&path[0], sizeof(path), "data/dir%03u", folder);
+		index.Insert(root, &path[0], 0, util::DirectoryIndex::Entry::DirectoryFlag);
+
+		for(uint32_t file = 0; file < FilesPerFolder; ++file) {
+			snprintf(&path[0], sizeof(path), "data/dir%03u/file%03u.big", folder, file);
+			index.Insert(root, &path[0], 1, 0);
+		}
+	}
+
+	util::OverlayFs overlay;
+	const uint32_t roots[] { root };
+	if(!overlay.Build(index, roots)) {
+		printf("couldn't build the overlay\n");
+		return 1;
+	}
+
+	printf("%u files overridden\n", overlay.Count());
+	printf("%-8s %12s %12s %9s\n", "lookups", "overlay ns", "index ns", "resolved");
+
+	auto Run = [&](const char* name, const std::vector<std::string>& paths) {
+		uint32_t found = 0;
+		const auto overlayTime = bench::BestTimeNs([&]() {
+			found = 0;
+			for(const auto& path : paths)
+				found += overlay.Find(path.c_str()) != nullptr;
+		});
+
+		const auto indexTime = bench::BestTimeNs([&]() {
+			uint32_t indexFound = 0;
+			for(const auto& path : paths)
+				indexFound += index.Exists(root, util::HostRelativePath(path.c_str()));
+			bench::KeepAlive(indexFound);
+		});
+
+		printf("%-8s %12.1f %12.1f %9u\n", name, overlayTime / paths.size(), indexTime / paths.size(), found);
+	};
+
+	const auto misses = MakePaths("host:data\\game\\asset%03u_%03u.dat", Lookups);
+	Run("miss", misses);
+	Run("repeat", MakePaths("host:data/ui/frontend%u_%u.ssh", 8));
+	Run("hit", MakePaths("host:DATA\\DIR%03u\\FILE%03u.BIG", Folders * FilesPerFolder));
+
+	// How many misses the bloom filter let through to the table.
+	overlay.Clear();
+	overlay.Build(index, roots);
+	for(const auto& miss : misses)
+		overlay.Find(miss.c_str());
+
+	const auto& stats = overlay.GetStats();
+	printf("bloom filter false positives: %.2f%% (%u of %u misses)\n", 100.0 * stats.tableLookups / stats.lookups, stats.tableLookups, stats.lookups);
+	return 0;
+}
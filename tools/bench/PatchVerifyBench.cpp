@@ -0,0 +1,73 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Verifying the original bytes of several hundred patch records,
+// spread over a game-sized image, like ApplyPatchTable() does.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <utils/PatchTable.h>
+
+#include "Bench.h"
+
+using namespace elfldr;
+
+int main() {
+	constexpr uint32_t ImageAddress = 0x00100000;
+	constexpr uint32_t ImageSize = 4 * 1024 * 1024;
+
+	bench::Random random;
+	std::vector<uint8_t> image(ImageSize);
+	for(auto& byte : image)
+		byte = static_cast<uint8_t>(random.Next());
+
+	// The shipped tables are mostly short strings, with some words and nop fills.
+	static const char* const strings[] {
+		"host:",
+		"data/models/%s.wdx",
+		"host:data/modules/sio2man.irx",
+		"data/char/marisol_body.mpf"
+	};
+
+	for(const uint32_t count : { 100u, 300u, 800u }) {
+		std::vector<util::PatchRecord> records;
+		uint64_t bytes = 0;
+
+		for(uint32_t i = 0; i < count; ++i) {
+			const auto address = ImageAddress + (random.Next() % (ImageSize - 256) & ~3u);
+			util::PatchRecord record;
+
+			switch(i % 4) {
+				case 0: record = util::patch::String(address, strings[(i / 4) % 4]); break;
+				case 1: record = util::patch::String(address + 1, strings[(i / 4) % 4]); break; // not word aligned
+				case 2: record = util::patch::Word(address, 0); break;
+				default: record = util::patch::Nop(address, 1 + i % 8); break;
+			}
+
+			const auto size = util::PatchRecordSize(record);
+			bytes += size;
+			records.push_back(record.Expect(util::PatchDigest(&image[record.address - ImageAddress], size)));
+		}
+
+		uint32_t result = 0;
+		const auto ns = bench::BestTimeNs([&]() {
+			result = util::VerifyPatchRecords(records.data(), count, image.data(), ImageAddress);
+			bench::KeepAlive(result);
+		});
+
+		if(result != count) {
+			fprintf(stderr, "verification failed at record %u\n", result);
+			return 1;
+		}
+
+		printf("%4u ranges (%6llu bytes): %9.0f ns, %6.1f ns/range\n", count, static_cast<unsigned long long>(bytes), ns, ns / count);
+	}
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Scanning game-sized .text (3 and 4 MB) for signatures, against a naive
+// masked scan. The buffer is made of plausible MIPS instruction words
+// (random bytes would make skipping look better than it is), with a
+// few matches of each signature put in.
+//
+// Code is scanned for word aligned matches; the unaligned column is the
+// skip table scan, which anything else (e.g. strings) uses.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <utils/SigScan.h>
+
+#include "Bench.h"
+
+using namespace elfldr;
+
+namespace {
+
+	/**
+	 * Put a match of a signature in at a few places.
+	 */
+	void PlantMatches(std::vector<uint8_t>& text, const util::Signature& signature, bench::Random& random) {
+		for(uint32_t i = 0; i < 8; ++i) {
+			const auto offset = random.Next() % (text.size() - signature.length) & ~3u;
+			for(uint32_t j = 0; j < signature.length; ++j)
+				text[offset + j] = (text[offset + j] & ~signature.masks[j]) | signature.bytes[j];
+		}
+	}
+
+	uint32_t NaiveScan(const uint8_t* begin, const uint8_t* end, const util::Signature& signature, uint32_t alignment) {
+		uint32_t count = 0;
+		for(auto* ptr = begin; ptr + signature.length <= end; ptr += alignment) {
+			uint32_t i = 0;
+			while(i < signature.length && signature.MatchesAt(i, ptr[i]))
+				++i;
+			count += i == signature.length;
+		}
+		return count;
+	}
+
+} // namespace
+
+int main() {
+	const char* const patterns[] {
+		// lui v0, ?; lw v0, ?(v0); beq/bne v0, ?, +5 (little endian)
+		"?? ?? 02 3C ?? ?? 42 8C 05 00 4? 1?",
+		// a function prologue: addiu sp, sp, -?; sd ra, ?(sp)
+		"?? ?? BD 27 ?? ?? BF FF",
+		// a string, which doesn't look like code at all
+		"68 6F 73 74 30 3A",
+		// mostly wildcards
+		"?? ?? ?? ?? ?? ?? ?? ?? 08 00 E0 03"
+	};
+
+	bench::Random random;
+
+	for(const uint32_t size : { 3u * 1024 * 1024, 4u * 1024 * 1024 }) {
+		auto text = bench::MakeCode(size, random);
+		for(const auto* pattern : patterns)
+			PlantMatches(text, util::Signature(pattern), random);
+
+		const auto* begin = text.data();
+		const auto* end = begin + text.size();
+
+		printf("%u MB of .text:\n", size / (1024 * 1024));
+		printf("  %-38s %7s %9s %9s %11s %9s\n", "signature", "matches", "ms", "naive ms", "unaligned", "naive ms");
+
+		for(const auto* pattern : patterns) {
+			const util::Signature signature(pattern);
+			const util::SignatureScanner scanner(signature);
+
+			double ns[2];
+			double naiveNs[2];
+			uint32_t matches = 0;
+
+			for(const uint32_t alignment : { 4u, 1u }) {
+				const auto i = alignment == 4 ? 0 : 1;
+
+				ns[i] = bench::BestTimeNs([&]() {
+					matches = util::SigScan(begin, end, scanner, nullptr, 0, alignment);
+					bench::KeepAlive(matches);
+				});
+
+				uint32_t naiveMatches = 0;
+				naiveNs[i] = bench::BestTimeNs([&]() {
+					naiveMatches = NaiveScan(begin, end, signature, alignment);
+					bench::KeepAlive(naiveMatches);
+				});
+
+				if(matches != naiveMatches) {
+					fprintf(stderr, "\"%s\": %u matches, the naive scan found %u\n", pattern, matches, naiveMatches);
+					return 1;
+				}
+
+				// Report the aligned count.
+				if(alignment == 4)
+					printf("  %-38s %7u %9.3f %9.3f", pattern, matches, ns[0] / 1e6, naiveNs[0] / 1e6);
+			}
+
+			printf(" %11.3f %9.3f\n", ns[1] / 1e6, naiveNs[1] / 1e6);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,406 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// logdecode - turns a binary (tokenized) log back into text.
+//
+// Usage:
+//	logdecode <elfldr.logfmt> <modloader.bin> [out.txt]
+//
+// elfldr.logfmt is the format table, dumped from the elfldr_logfmt section
+// of the ELF that wrote the log (the build does this when ELFLDR_LOG_BINARY is on).
+// It has to come from the same build as the log.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <utils/Log.h>
+#include <utils/LogFormat.h>
+
+namespace {
+
+	using namespace elfldr;
+
+	bool ReadFile(const char* path, std::vector<uint8_t>& data) {
+		auto* file = fopen(path, "rb");
+		if(!file) {
+			fprintf(stderr, "could not open \"%s\"\n", path);
+			return false;
+		}
+
+		uint8_t buffer[4096];
+		size_t read;
+		while((read = fread(&buffer[0], 1, sizeof(buffer), file)) != 0)
+			data.insert(data.end(), &buffer[0], &buffer[read]);
+
+		fclose(file);
+		return true;
+	}
+
+	uint32_t Get16(const uint8_t* data) {
+		return data[0] | (data[1] << 8);
+	}
+
+	uint32_t Get32(const uint8_t* data) {
+		return Get16(data) | (Get16(data + 2) << 16);
+	}
+
+	uint64_t Get64(const uint8_t* data) {
+		return Get32(data) | (static_cast<uint64_t>(Get32(data + 4)) << 32);
+	}
+
+	/**
+	 * Reads a frame's arguments, in the order its signature says.
+	 */
+	struct ArgReader {
+		const char* signature;
+		const uint8_t* data;
+		uint32_t length;
+
+		uint32_t position {};
+		bool ok { true };
+
+		/**
+		 * Take the next argument, which must have the given code.
+		 */
+		bool Next(util::LogArgCode code) {
+			if(!ok || *signature != static_cast<char>(code)) {
+				ok = false;
+				return false;
+			}
+
+			++signature;
+			return true;
+		}
+
+		const uint8_t* Take(uint32_t size) {
+			if(!ok || position + size > length) {
+				ok = false;
+				return nullptr;
+			}
+
+			auto* out = &data[position];
+			position += size;
+			return out;
+		}
+
+		bool Int32(uint32_t& value) {
+			if(!Next(util::LogArgCode::Int32))
+				return false;
+			auto* bytes = Take(sizeof(uint32_t));
+			return bytes && ((value = Get32(bytes)), true);
+		}
+
+		bool Int64(uint64_t& value) {
+			if(!Next(util::LogArgCode::Int64))
+				return false;
+			auto* bytes = Take(sizeof(uint64_t));
+			return bytes && ((value = Get64(bytes)), true);
+		}
+
+		bool Double(double& value) {
+			if(!Next(util::LogArgCode::Double))
+				return false;
+			auto* bytes = Take(sizeof(uint64_t));
+			if(!bytes)
+				return false;
+
+			const auto bits = Get64(bytes);
+			memcpy(&value, &bits, sizeof(value));
+			return true;
+		}
+
+		bool Pointer(uint32_t& value) {
+			if(!Next(util::LogArgCode::Pointer))
+				return false;
+			auto* bytes = Take(sizeof(uint32_t));
+			return bytes && ((value = Get32(bytes)), true);
+		}
+
+		bool String(std::string& value) {
+			if(!Next(util::LogArgCode::String))
+				return false;
+
+			auto* length = Take(1);
+			if(!length)
+				return false;
+
+			auto* chars = Take(*length);
+			if(!chars)
+				return false;
+
+			value.assign(reinterpret_cast<const char*>(chars), *length);
+			return true;
+		}
+	};
+
+	template <class... Args>
+	void Append(std::string& out, const std::string& spec, Args... args) {
+		char buffer[1024];
+		snprintf(&buffer[0], sizeof(buffer), spec.c_str(), args...);
+		out += &buffer[0];
+	}
+
+	/**
+	 * Format a record's format string with a frame's arguments,
+	 * one conversion at a time, with the host's printf.
+	 */
+	std::string Format(const char* format, ArgReader& args) {
+		std::string out;
+
+		while(*format) {
+			if(*format != '%') {
+				out += *format++;
+				continue;
+			}
+
+			if(format[1] == '%') {
+				out += '%';
+				format += 2;
+				continue;
+			}
+
+			// Flags, width and precision are kept (with * widths read from
+			// the arguments); length modifiers are replaced to suit the host.
+			std::string spec = "%";
+			std::vector<int> stars;
+			++format;
+
+			while(*format && strchr("-+ #0", *format))
+				spec += *format++;
+
+			for(int part = 0; part < 2; ++part) {
+				if(part == 1) {
+					if(*format != '.')
+						break;
+					spec += *format++;
+				}
+
+				if(*format == '*') {
+					uint32_t value = 0;
+					args.Int32(value);
+					stars.push_back(static_cast<int>(value));
+					spec += '*';
+					++format;
+				} else {
+					while(*format >= '0' && *format <= '9')
+						spec += *format++;
+				}
+			}
+
+			while(*format && strchr("hljztL", *format))
+				++format;
+
+			const char conversion = *format;
+			if(conversion == '\0')
+				break;
+			++format;
+
+			auto AppendStarred = [&](const std::string& spec, auto value) {
+				if(stars.size() == 2)
+					Append(out, spec, stars[0], stars[1], value);
+				else if(stars.size() == 1)
+					Append(out, spec, stars[0], value);
+				else
+					Append(out, spec, value);
+			};
+
+			switch(conversion) {
+				case 'd':
+				case 'i':
+				case 'u':
+				case 'x':
+				case 'X':
+				case 'o':
+				case 'c':
+					if(*args.signature == static_cast<char>(util::LogArgCode::Int64)) {
+						uint64_t value = 0;
+						if(args.Int64(value))
+							AppendStarred(spec + "ll" + conversion, value);
+					} else {
+						uint32_t value = 0;
+						if(!args.Int32(value))
+							break;
+
+						if(conversion == 'd' || conversion == 'i' || conversion == 'c')
+							AppendStarred(spec + conversion, static_cast<int32_t>(value));
+						else
+							AppendStarred(spec + conversion, value);
+					}
+					break;
+
+				case 'f':
+				case 'F':
+				case 'e':
+				case 'E':
+				case 'g':
+				case 'G':
+				case 'a':
+				case 'A': {
+					double value = 0;
+					if(args.Double(value))
+						AppendStarred(spec + conversion, value);
+				} break;
+
+				case 's': {
+					std::string value;
+					if(args.String(value))
+						AppendStarred(spec + 's', value.c_str());
+				} break;
+
+				case 'p': {
+					// Pointers are 32 bits on the EE, whatever they are here.
+					uint32_t value = 0;
+					if(args.Pointer(value)) {
+						out += "0x";
+						AppendStarred(spec + 'x', value);
+					}
+				} break;
+
+				default:
+					args.ok = false;
+					break;
+			}
+
+			if(!args.ok) {
+				out += "<bad argument>";
+				break;
+			}
+		}
+
+		return out;
+	}
+
+	struct Decoder {
+		std::vector<uint8_t> table;
+		FILE* out;
+
+		/**
+		 * Get the record a format ID refers to, or nullptr if it isn't valid.
+		 */
+		const util::LogRecordHeader* FindRecord(uint32_t id) const {
+			if(id % alignof(util::LogRecordHeader) != 0 || id + sizeof(util::LogRecordHeader) > table.size())
+				return nullptr;
+
+			auto* record = reinterpret_cast<const util::LogRecordHeader*>(&table[id]);
+			const auto minimumSize = sizeof(util::LogRecordHeader) + record->argCount + 2u;
+			if(record->size < minimumSize || id + record->size > table.size())
+				return nullptr;
+
+			// Both strings have to be terminated inside the record.
+			const auto formatStart = id + sizeof(util::LogRecordHeader) + record->argCount + 1;
+			if(table[formatStart - 1] != '\0' || memchr(&table[formatStart], '\0', id + record->size - formatStart) == nullptr)
+				return nullptr;
+
+			return record;
+		}
+
+		void DecodeRecord(uint32_t id, const uint8_t* payload, uint32_t length) {
+			auto* record = FindRecord(id);
+			if(!record) {
+				fprintf(out, "[Ml] <unknown format id 0x%08x; is the format table from the same build?>\n", id);
+				return;
+			}
+
+			auto* signature = reinterpret_cast<const char*>(record + 1);
+			auto* format = signature + record->argCount + 1;
+
+			ArgReader args { signature, payload, length };
+			auto text = Format(format, args);
+
+			const char* prefix = "";
+			switch(static_cast<util::LogLevel>(record->level)) {
+				case util::LogLevel::Warning:
+					prefix = "warning: ";
+					break;
+				case util::LogLevel::Error:
+					prefix = "error: ";
+					break;
+				default:
+					break;
+			}
+
+			fprintf(out, "[Ml] [%s] %s%s\n", util::LogChannelName(static_cast<util::LogChannel>(record->channel)), prefix, text.c_str());
+		}
+
+		bool Decode(const std::vector<uint8_t>& log) {
+			size_t position = 0;
+
+			while(position + util::LogFrameHeaderSize <= log.size()) {
+				const auto id = Get32(&log[position]);
+				const auto length = Get16(&log[position + 4]);
+				position += util::LogFrameHeaderSize;
+
+				if(position + length > log.size()) {
+					fprintf(stderr, "log is truncated (last frame is incomplete)\n");
+					return false;
+				}
+
+				auto* payload = &log[position];
+				position += length;
+
+				switch(id) {
+					case util::LogTextFrameId:
+						fprintf(out, "%.*s\n", static_cast<int>(length), reinterpret_cast<const char*>(payload));
+						break;
+
+					case util::LogBootFrameId: {
+						util::LogBootPayload boot {};
+						if(length >= sizeof(boot))
+							memcpy(&boot, payload, sizeof(boot));
+
+						if(boot.magic != util::LogBootPayload::Magic || boot.version != util::LogBootPayload::CurrentVersion) {
+							fprintf(stderr, "not a binary log, or an unsupported version of one\n");
+							return false;
+						}
+
+						fprintf(out, "---- ModLoader started ----\n");
+					} break;
+
+					default:
+						DecodeRecord(id, payload, length);
+						break;
+				}
+			}
+
+			if(position != log.size())
+				fprintf(stderr, "log is truncated (last frame is incomplete)\n");
+			return true;
+		}
+	};
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "usage: %s <elfldr.logfmt> <modloader.bin> [out.txt]\n", argv[0]);
+		return 1;
+	}
+
+	Decoder decoder;
+	std::vector<uint8_t> log;
+
+	if(!ReadFile(argv[1], decoder.table) || !ReadFile(argv[2], log))
+		return 1;
+
+	decoder.out = stdout;
+	if(argc > 3) {
+		decoder.out = fopen(argv[3], "w");
+		if(!decoder.out) {
+			fprintf(stderr, "could not open \"%s\" for writing\n", argv[3]);
+			return 1;
+		}
+	}
+
+	const bool ok = decoder.Decode(log);
+
+	if(decoder.out != stdout)
+		fclose(decoder.out);
+	return ok ? 0 : 1;
+}
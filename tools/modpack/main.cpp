@@ -0,0 +1,217 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// modpack - packs a folder of files into a mod pack (see utils/PackFormat.h).
+//
+// Usage:
+//	modpack create <folder> <out.pak>	- Pack every file under a folder.
+//										  Paths in the pack are relative to it.
+//	modpack list <pack>					- List the files in a pack.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <utils/PackFormat.h>
+
+namespace {
+
+	using namespace elfldr;
+	namespace fs = std::filesystem;
+
+	struct PackedFile {
+		fs::path source;
+		std::string path;
+		util::PackEntry entry;
+	};
+
+	bool ReadFile(const char* path, std::vector<uint8_t>& data) {
+		auto* file = fopen(path, "rb");
+		if(!file) {
+			fprintf(stderr, "could not open \"%s\"\n", path);
+			return false;
+		}
+
+		uint8_t buffer[4096];
+		size_t read;
+		while((read = fread(&buffer[0], 1, sizeof(buffer), file)) != 0)
+			data.insert(data.end(), &buffer[0], &buffer[read]);
+
+		fclose(file);
+		return true;
+	}
+
+	bool Pad(FILE* out, uint64_t& offset, uint64_t to) {
+		static const uint8_t zeros[util::PackAlignment] {};
+		const auto padding = to - offset;
+		offset = to;
+		return fwrite(&zeros[0], 1, padding, out) == padding;
+	}
+
+	int Create(int argc, char** argv) {
+		if(argc < 4) {
+			fprintf(stderr, "usage: %s create <folder> <out.pak>\n", argv[0]);
+			return 1;
+		}
+
+		const fs::path root = argv[2];
+		std::error_code error;
+		if(!fs::is_directory(root, error)) {
+			fprintf(stderr, "\"%s\" isn't a folder\n", argv[2]);
+			return 1;
+		}
+
+		std::vector<PackedFile> files;
+		for(auto it = fs::recursive_directory_iterator(root, error); !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+			if(!it->is_regular_file())
+				continue;
+
+			auto& file = files.emplace_back();
+			file.source = it->path();
+			file.path = it->path().lexically_relative(root).generic_string();
+			file.entry.hash = util::PathHash(file.path.data(), file.path.size());
+			file.entry.size = static_cast<uint32_t>(it->file_size());
+		}
+
+		if(error) {
+			fprintf(stderr, "could not read \"%s\": %s\n", argv[2], error.message().c_str());
+			return 1;
+		}
+
+		// The files go in the pack in path order, so files in the same folder
+		// (which tend to be loaded together) are near each other.
+		std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.path < b.path; });
+
+		uint32_t pathsSize = 0;
+		for(auto& file : files) {
+			file.entry.pathOffset = pathsSize;
+			pathsSize += static_cast<uint32_t>(file.path.size()) + 1;
+		}
+
+		const auto tocSize = static_cast<uint32_t>(files.size() * sizeof(util::PackEntry)) + pathsSize;
+		uint64_t offset = util::PackAlign(sizeof(util::PackHeader) + tocSize);
+		for(auto& file : files) {
+			file.entry.offset = static_cast<uint32_t>(offset);
+			offset = util::PackAlign(static_cast<uint32_t>(offset + file.entry.size));
+			if(offset > 0xffffffff) {
+				fprintf(stderr, "too much to fit in one pack (4GB max)\n");
+				return 1;
+			}
+		}
+
+		// The table of contents is sorted by hash (then path), for the binary search.
+		std::vector<const PackedFile*> toc;
+		for(const auto& file : files)
+			toc.push_back(&file);
+		std::sort(toc.begin(), toc.end(), [](const PackedFile* a, const PackedFile* b) { return a->entry.hash != b->entry.hash ? a->entry.hash < b->entry.hash : a->path < b->path; });
+
+		// The game doesn't care about case, so a host that does could have two files
+		// the game can't tell apart.
+		for(size_t i = 1; i < toc.size(); ++i) {
+			const auto& a = *toc[i - 1];
+			const auto& b = *toc[i];
+			if(a.entry.hash == b.entry.hash && util::PathEquals(a.path.data(), a.path.size(), b.path.data(), b.path.size())) {
+				fprintf(stderr, "\"%s\" and \"%s\" are the same file to the game\n", a.path.c_str(), b.path.c_str());
+				return 1;
+			}
+		}
+
+		auto* out = fopen(argv[3], "wb");
+		if(!out) {
+			fprintf(stderr, "could not open \"%s\" for writing\n", argv[3]);
+			return 1;
+		}
+
+		// Written as-is; the EE and the host are both little endian.
+		util::PackHeader header { util::PackHeader::Magic, util::PackHeader::CurrentVersion, static_cast<uint32_t>(files.size()), tocSize };
+		bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+		for(const auto* file : toc)
+			ok = ok && fwrite(&file->entry, sizeof(file->entry), 1, out) == 1;
+		for(const auto& file : files)
+			ok = ok && fwrite(file.path.c_str(), 1, file.path.size() + 1, out) == file.path.size() + 1;
+
+		offset = sizeof(header) + tocSize;
+		std::vector<uint8_t> data;
+		for(const auto& file : files) {
+			data.clear();
+			if(!ok || !Pad(out, offset, file.entry.offset) || !ReadFile(file.source.string().c_str(), data) || data.size() != file.entry.size) {
+				ok = false;
+				break;
+			}
+
+			ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+			offset += data.size();
+		}
+
+		fclose(out);
+		if(!ok) {
+			fprintf(stderr, "could not write \"%s\"\n", argv[3]);
+			return 1;
+		}
+
+		printf("%zu files, %llu bytes\n", files.size(), static_cast<unsigned long long>(offset));
+		return 0;
+	}
+
+	int List(int argc, char** argv) {
+		if(argc < 3) {
+			fprintf(stderr, "usage: %s list <pack>\n", argv[0]);
+			return 1;
+		}
+
+		std::vector<uint8_t> pack;
+		if(!ReadFile(argv[2], pack))
+			return 1;
+
+		util::PackHeader header {};
+		if(pack.size() >= sizeof(header))
+			memcpy(&header, pack.data(), sizeof(header));
+
+		if(header.magic != util::PackHeader::Magic || header.version != util::PackHeader::CurrentVersion || header.tocSize > pack.size() - sizeof(header) || header.count > header.tocSize / sizeof(util::PackEntry)) {
+			fprintf(stderr, "\"%s\" isn't a version %u pack\n", argv[2], util::PackHeader::CurrentVersion);
+			return 1;
+		}
+
+		std::vector<util::PackEntry> entries(header.count);
+		memcpy(entries.data(), &pack[sizeof(header)], entries.size() * sizeof(util::PackEntry));
+
+		const auto* paths = reinterpret_cast<const char*>(&pack[sizeof(header) + entries.size() * sizeof(util::PackEntry)]);
+		const auto pathsSize = header.tocSize - entries.size() * sizeof(util::PackEntry);
+
+		for(const auto& entry : entries) {
+			if(entry.pathOffset >= pathsSize || !memchr(&paths[entry.pathOffset], '\0', pathsSize - entry.pathOffset)) {
+				fprintf(stderr, "broken table of contents\n");
+				return 1;
+			}
+			printf("0x%08x %10u %10u %s\n", entry.hash, entry.offset, entry.size, &paths[entry.pathOffset]);
+		}
+
+		return 0;
+	}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <create|list>\n", argv[0]);
+		return 1;
+	}
+
+	if(!strcmp(argv[1], "create"))
+		return Create(argc, argv);
+	if(!strcmp(argv[1], "list"))
+		return List(argc, argv);
+
+	fprintf(stderr, "unknown command \"%s\"\n", argv[1]);
+	return 1;
+}
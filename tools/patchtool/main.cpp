@@ -0,0 +1,350 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// patchtool - dumps and sanity checks the ElfLdr patch tables.
+//
+// Usage:
+//	patchtool dump						- Print every table.
+//	patchtool verify					- Check tables for overlapping or misaligned records.
+//	patchtool digest <game id> <elf>	- Print the original-bytes digest of every record,
+//										  for filling in PatchRecord::Expect().
+//	patchtool check <game id> <elf>		- Check the digests in the tables against a game binary.
+//	patchtool hash <hex bytes>			- Print the digest of some bytes, for records whose original
+//										  bytes are known without an ELF (e.g. "63643a00" for "cd:").
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "HostFSTable.h"
+#include "MemoryClearTable.h"
+
+namespace {
+
+	using namespace elfldr;
+
+	struct NamedTableList {
+		const char* name;
+		const util::PatchTable* tables;
+		uint32_t count;
+	};
+
+	template <size_t N>
+	constexpr NamedTableList MakeList(const char* name, const util::PatchTable (&tables)[N]) {
+		return { name, &tables[0], N };
+	}
+
+	constexpr NamedTableList gTableLists[] {
+		MakeList("hostfs", patches::HostFsTables),
+		MakeList("memclr", patches::MemoryClearTables)
+	};
+
+	const char* GameName(util::Game game) {
+		switch(game) {
+			case util::Game::SSXOG:
+				return "ssx";
+			case util::Game::SSXDVD:
+				return "ssxdvd";
+			case util::Game::SSX3:
+				return "ssx3";
+			default:
+				return "invalid";
+		}
+	}
+
+	const char* RegionName(util::GameRegion region) {
+		switch(region) {
+			case util::GameRegion::NTSC:
+				return "us";
+			case util::GameRegion::PAL:
+				return "eu";
+			case util::GameRegion::NTSCJ:
+				return "jp";
+			case util::GameRegion::NotApplicable:
+				return "notapplicable";
+		}
+		return "?";
+	}
+
+	const char* VersionName(util::GameVersion version) {
+		switch(version) {
+			case util::GameVersion::SSXOG_10:
+			case util::GameVersion::SSXDVD_10:
+			case util::GameVersion::SSX3_10:
+				return "1.0";
+			case util::GameVersion::SSXDVD_JAMPACK_DEMO:
+				return "jamd";
+			case util::GameVersion::SSX3_KR_DEMO:
+				return "krd";
+			case util::GameVersion::SSX3_OPSM2_DEMO:
+				return "opmd";
+		}
+		return "?";
+	}
+
+	void DumpRecord(const util::PatchRecord& record) {
+		switch(record.op) {
+			case util::PatchOp::WriteString:
+				printf("  0x%08x  string   \"%s\"\n", record.address, record.string);
+				break;
+			case util::PatchOp::ReplaceString:
+				printf("  0x%08x  replace  \"%s\"\n", record.address, record.string);
+				break;
+			case util::PatchOp::Write8:
+				printf("  0x%08x  byte     0x%02x\n", record.address, record.value);
+				break;
+			case util::PatchOp::Write32:
+				printf("  0x%08x  word     0x%08x\n", record.address, record.value);
+				break;
+			case util::PatchOp::NopFill:
+				printf("  0x%08x  nop      %u\n", record.address, record.value);
+				break;
+		}
+	}
+
+	template <class Fn>
+	void ForEachTable(Fn&& fn) {
+		for(const auto& list : gTableLists)
+			for(uint32_t i = 0; i < list.count; ++i)
+				fn(list.name, list.tables[i]);
+	}
+
+	int Dump() {
+		ForEachTable([](const char* name, const util::PatchTable& table) {
+			printf("%s %s/%s/%s (%u records)\n", name, GameName(table.game), RegionName(table.region), VersionName(table.version), table.recordCount);
+			for(uint32_t i = 0; i < table.recordCount; ++i)
+				DumpRecord(table.records[i]);
+		});
+		return 0;
+	}
+
+	int Verify() {
+		int errors = 0;
+		int warnings = 0;
+
+		ForEachTable([&](const char* name, const util::PatchTable& table) {
+			for(uint32_t i = 0; i < table.recordCount; ++i) {
+				const auto& record = table.records[i];
+				auto size = util::PatchRecordSize(record);
+
+				if((record.op == util::PatchOp::Write32 || record.op == util::PatchOp::NopFill) && (record.address & 3)) {
+					printf("error: %s %s/%s/%s: record %u at 0x%08x is not word aligned\n", name, GameName(table.game), RegionName(table.region), VersionName(table.version), i, record.address);
+					++errors;
+				}
+
+				// Overlaps are almost always a copy-paste mistake.
+				for(uint32_t j = i + 1; j < table.recordCount; ++j) {
+					const auto& other = table.records[j];
+					if(record.address < other.address + util::PatchRecordSize(other) && other.address < record.address + size) {
+						printf("warning: %s %s/%s/%s: records %u and %u overlap (0x%08x, 0x%08x)\n", name, GameName(table.game), RegionName(table.region), VersionName(table.version), i, j, record.address, other.address);
+						++warnings;
+					}
+				}
+			}
+		});
+
+		printf("%d error(s), %d warning(s)\n", errors, warnings);
+		return errors ? 1 : 0;
+	}
+
+	/**
+	 * The loadable segments of a game ELF, so records can be
+	 * looked up by their (virtual) address.
+	 */
+	struct ElfImage {
+		struct Segment {
+			uint32_t vaddr;
+			std::vector<uint8_t> bytes;
+		};
+
+		bool Load(const char* path) {
+			auto* fp = fopen(path, "rb");
+			if(!fp)
+				return false;
+
+			std::vector<uint8_t> file;
+			uint8_t buf[4096];
+			size_t n;
+			while((n = fread(&buf[0], 1, sizeof(buf), fp)) > 0)
+				file.insert(file.end(), &buf[0], &buf[n]);
+			fclose(fp);
+
+			auto u16 = [&](size_t off) { return static_cast<uint32_t>(file[off] | (file[off + 1] << 8)); };
+			auto u32 = [&](size_t off) { return u16(off) | (u16(off + 2) << 16); };
+
+			if(file.size() < 0x34 || memcmp(&file[0], "\x7f" "ELF", 4) != 0)
+				return false;
+
+			auto phoff = u32(0x1c);
+			auto phentsize = u16(0x2a);
+			auto phnum = u16(0x2c);
+
+			for(uint32_t i = 0; i < phnum; ++i) {
+				auto ph = phoff + i * phentsize;
+				if(ph + 0x20 > file.size())
+					return false;
+
+				// PT_LOAD
+				if(u32(ph) != 1)
+					continue;
+
+				auto offset = u32(ph + 0x04);
+				auto filesz = u32(ph + 0x10);
+				auto memsz = u32(ph + 0x14);
+				if(offset + filesz > file.size())
+					return false;
+
+				Segment segment { u32(ph + 0x08), std::vector<uint8_t>(memsz, 0) };
+				memcpy(segment.bytes.data(), &file[offset], filesz);
+				segments.push_back(std::move(segment));
+			}
+
+			return true;
+		}
+
+		const uint8_t* Find(uint32_t address, uint32_t length) const {
+			for(const auto& segment : segments)
+				if(address >= segment.vaddr && address + length <= segment.vaddr + segment.bytes.size())
+					return &segment.bytes[address - segment.vaddr];
+			return nullptr;
+		}
+
+		std::vector<Segment> segments;
+	};
+
+	bool ParseGameId(const char* id, util::Game& game, util::GameRegion& region, util::GameVersion& version) {
+		// Versions only make sense for the game they belong to
+		// (every release is "1.0").
+		struct GameVersionPair {
+			util::Game game;
+			util::GameVersion version;
+		};
+
+		constexpr GameVersionPair versions[] {
+			{ util::Game::SSXOG, util::GameVersion::SSXOG_10 },
+			{ util::Game::SSXDVD, util::GameVersion::SSXDVD_10 },
+			{ util::Game::SSXDVD, util::GameVersion::SSXDVD_JAMPACK_DEMO },
+			{ util::Game::SSX3, util::GameVersion::SSX3_10 },
+			{ util::Game::SSX3, util::GameVersion::SSX3_OPSM2_DEMO },
+			{ util::Game::SSX3, util::GameVersion::SSX3_KR_DEMO }
+		};
+
+		// Brute force, but there's only a handful of valid combinations.
+		for(const auto& pair : versions)
+			for(auto r : { util::GameRegion::NTSC, util::GameRegion::PAL, util::GameRegion::NTSCJ, util::GameRegion::NotApplicable }) {
+				char buf[64];
+				snprintf(&buf[0], sizeof(buf), "%s/%s/%s", GameName(pair.game), RegionName(r), VersionName(pair.version));
+				if(!strcmp(&buf[0], id)) {
+					game = pair.game;
+					region = r;
+					version = pair.version;
+					return true;
+				}
+			}
+		return false;
+	}
+
+	/**
+	 * Shared driver for digest and check.
+	 */
+	int WithGameTables(int argc, char** argv, bool check) {
+		if(argc < 4) {
+			fprintf(stderr, "usage: %s %s <game id> <elf>\n", argv[0], argv[1]);
+			return 1;
+		}
+
+		util::GameVersionData data {};
+		if(!ParseGameId(argv[2], data.game, data.region, data.version)) {
+			fprintf(stderr, "invalid game id \"%s\"\n", argv[2]);
+			return 1;
+		}
+
+		ElfImage image;
+		if(!image.Load(argv[3])) {
+			fprintf(stderr, "could not load ELF \"%s\"\n", argv[3]);
+			return 1;
+		}
+
+		int errors = 0;
+		for(const auto& list : gTableLists) {
+			auto* table = util::FindPatchTable(list.tables, list.count, data);
+			if(!table)
+				continue;
+
+			printf("%s (%u records)\n", list.name, table->recordCount);
+			for(uint32_t i = 0; i < table->recordCount; ++i) {
+				const auto& record = table->records[i];
+				auto size = util::PatchRecordDigestSize(record);
+				auto* bytes = image.Find(record.address, size);
+
+				if(!bytes) {
+					printf("  error: record %u (0x%08x, %u bytes) is outside of the ELF image\n", i, record.address, size);
+					++errors;
+					continue;
+				}
+
+				auto digest = util::PatchDigest(bytes, size);
+				if(!check) {
+					if(record.digestSize)
+						printf("  0x%08x  .Expect(0x%08x, %u)\n", record.address, digest, size);
+					else
+						printf("  0x%08x  .Expect(0x%08x)\n", record.address, digest);
+				} else if((record.flags & util::PatchFlag_HasDigest) && record.digest != digest) {
+					printf("  error: record %u (0x%08x) expects 0x%08x, ELF has 0x%08x\n", i, record.address, record.digest, digest);
+					++errors;
+				}
+			}
+		}
+
+		if(check)
+			printf("%d error(s)\n", errors);
+		return errors ? 1 : 0;
+	}
+
+	int Hash(int argc, char** argv) {
+		if(argc < 3) {
+			fprintf(stderr, "usage: %s hash <hex bytes>\n", argv[0]);
+			return 1;
+		}
+
+		std::vector<uint8_t> bytes;
+		for(auto* p = argv[2]; *p; p += 2) {
+			unsigned byte;
+			if(!p[1] || sscanf(p, "%2x", &byte) != 1) {
+				fprintf(stderr, "invalid hex bytes \"%s\"\n", argv[2]);
+				return 1;
+			}
+			bytes.push_back(static_cast<uint8_t>(byte));
+		}
+
+		printf(".Expect(0x%08x, %zu)\n", util::PatchDigest(bytes.data(), static_cast<uint32_t>(bytes.size())), bytes.size());
+		return 0;
+	}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <dump|verify|digest|check|hash>\n", argv[0]);
+		return 1;
+	}
+
+	if(!strcmp(argv[1], "dump"))
+		return Dump();
+	if(!strcmp(argv[1], "verify"))
+		return Verify();
+	if(!strcmp(argv[1], "digest"))
+		return WithGameTables(argc, argv, false);
+	if(!strcmp(argv[1], "check"))
+		return WithGameTables(argc, argv, true);
+	if(!strcmp(argv[1], "hash"))
+		return Hash(argc, argv);
+
+	fprintf(stderr, "unknown command \"%s\"\n", argv[1]);
+	return 1;
+}
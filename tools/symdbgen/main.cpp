@@ -0,0 +1,259 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// symdbgen - builds the symbol database from its CSV source.
+//
+// Usage:
+//	symdbgen inl <csv> <out.inl>				- Generate the compiled-in tables (SymbolTables.inl).
+//	symdbgen bin <csv> <game id> <out.symdb>	- Write a binary database for one game version,
+//												  for LoadSymbolDatabase().
+//	symdbgen hash <name>...						- Print the hash of symbol names.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <utils/SymbolDb.h>
+
+namespace {
+
+	using namespace elfldr;
+
+	struct GameVersionInfo {
+		const char* id;
+		const char* game;
+		const char* region;
+		const char* version;
+	};
+
+	// Every game ID the CSV can use, with the enumerator names to emit.
+	constexpr GameVersionInfo gGameVersions[] {
+		{ "ssx/us/1.0", "SSXOG", "NTSC", "SSXOG_10" },
+		{ "ssx/eu/1.0", "SSXOG", "PAL", "SSXOG_10" },
+		{ "ssx/jp/1.0", "SSXOG", "NTSCJ", "SSXOG_10" },
+		{ "ssxdvd/us/1.0", "SSXDVD", "NTSC", "SSXDVD_10" },
+		{ "ssxdvd/eu/1.0", "SSXDVD", "PAL", "SSXDVD_10" },
+		{ "ssxdvd/jp/1.0", "SSXDVD", "NTSCJ", "SSXDVD_10" },
+		{ "ssxdvd/notapplicable/jamd", "SSXDVD", "NotApplicable", "SSXDVD_JAMPACK_DEMO" },
+		{ "ssx3/us/1.0", "SSX3", "NTSC", "SSX3_10" },
+		{ "ssx3/eu/1.0", "SSX3", "PAL", "SSX3_10" },
+		{ "ssx3/jp/1.0", "SSX3", "NTSCJ", "SSX3_10" },
+		{ "ssx3/notapplicable/opmd", "SSX3", "NotApplicable", "SSX3_OPSM2_DEMO" },
+		{ "ssx3/notapplicable/krd", "SSX3", "NotApplicable", "SSX3_KR_DEMO" }
+	};
+
+	const GameVersionInfo* FindGameVersion(const std::string& id) {
+		for(const auto& info : gGameVersions)
+			if(id == info.id)
+				return &info;
+		return nullptr;
+	}
+
+	struct Symbol {
+		std::string name;
+		uint32_t hash;
+		uint32_t address;
+	};
+
+	struct VersionSymbols {
+		const GameVersionInfo* info;
+		std::vector<Symbol> symbols;
+	};
+
+	std::string Trim(const std::string& str) {
+		auto begin = str.find_first_not_of(" \t\r\n");
+		if(begin == std::string::npos)
+			return {};
+		auto end = str.find_last_not_of(" \t\r\n");
+		return str.substr(begin, end - begin + 1);
+	}
+
+	/**
+	 * Parse the CSV into per-version symbol lists, sorted by hash.
+	 */
+	bool ParseCsv(const char* path, std::vector<VersionSymbols>& versions) {
+		auto* file = fopen(path, "r");
+		if(!file) {
+			fprintf(stderr, "could not open \"%s\"\n", path);
+			return false;
+		}
+
+		char line[512];
+		int lineNumber = 0;
+		bool ok = true;
+
+		while(fgets(&line[0], sizeof(line), file)) {
+			++lineNumber;
+			auto text = Trim(line);
+			if(text.empty() || text[0] == '#')
+				continue;
+
+			auto firstComma = text.find(',');
+			auto secondComma = firstComma == std::string::npos ? std::string::npos : text.find(',', firstComma + 1);
+			if(secondComma == std::string::npos) {
+				fprintf(stderr, "%s:%d: expected \"game id, symbol, address\"\n", path, lineNumber);
+				ok = false;
+				continue;
+			}
+
+			auto id = Trim(text.substr(0, firstComma));
+			auto name = Trim(text.substr(firstComma + 1, secondComma - firstComma - 1));
+			auto addressText = Trim(text.substr(secondComma + 1));
+
+			auto* info = FindGameVersion(id);
+			if(!info) {
+				fprintf(stderr, "%s:%d: unknown game id \"%s\"\n", path, lineNumber, id.c_str());
+				ok = false;
+				continue;
+			}
+
+			char* end = nullptr;
+			auto address = strtoul(addressText.c_str(), &end, 0);
+			if(name.empty() || !end || *end != '\0' || address == 0 || address > 0xffffffff) {
+				fprintf(stderr, "%s:%d: bad symbol or address\n", path, lineNumber);
+				ok = false;
+				continue;
+			}
+
+			auto it = std::find_if(versions.begin(), versions.end(), [&](const VersionSymbols& v) { return v.info == info; });
+			if(it == versions.end()) {
+				versions.push_back({ info, {} });
+				it = versions.end() - 1;
+			}
+
+			it->symbols.push_back({ name, util::SymbolHash(name.c_str()), static_cast<uint32_t>(address) });
+		}
+
+		fclose(file);
+
+		for(auto& version : versions) {
+			auto& symbols = version.symbols;
+			std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) { return a.hash < b.hash; });
+
+			for(size_t i = 1; i < symbols.size(); ++i) {
+				if(symbols[i].hash != symbols[i - 1].hash)
+					continue;
+
+				if(symbols[i].name == symbols[i - 1].name)
+					fprintf(stderr, "%s: %s is defined twice\n", version.info->id, symbols[i].name.c_str());
+				else
+					fprintf(stderr, "%s: %s and %s have the same hash; rename one\n", version.info->id, symbols[i - 1].name.c_str(), symbols[i].name.c_str());
+				ok = false;
+			}
+		}
+
+		return ok;
+	}
+
+	std::string TableName(const GameVersionInfo& info) {
+		std::string name = info.id;
+		for(auto& c : name)
+			if(c == '/' || c == '.')
+				c = '_';
+		return name + "_Symbols";
+	}
+
+	int GenerateInl(int argc, char** argv) {
+		if(argc < 4) {
+			fprintf(stderr, "usage: %s inl <csv> <out.inl>\n", argv[0]);
+			return 1;
+		}
+
+		std::vector<VersionSymbols> versions;
+		if(!ParseCsv(argv[2], versions))
+			return 1;
+
+		auto* out = fopen(argv[3], "w");
+		if(!out) {
+			fprintf(stderr, "could not open \"%s\" for writing\n", argv[3]);
+			return 1;
+		}
+
+		fprintf(out, "// Generated by symdbgen from Symbols.csv. Do not edit.\n");
+		fprintf(out, "// Regenerate with `cmake --build build-tools -t symdb`.\n\n");
+
+		for(const auto& version : versions) {
+			fprintf(out, "constexpr SymbolEntry %s[] {\n", TableName(*version.info).c_str());
+			for(const auto& symbol : version.symbols)
+				fprintf(out, "\t{ 0x%08x, 0x%08x }, // %s\n", symbol.hash, symbol.address, symbol.name.c_str());
+			fprintf(out, "};\n\n");
+		}
+
+		fprintf(out, "constexpr SymbolTable SymbolTables[] {\n");
+		for(const auto& version : versions) {
+			const auto& info = *version.info;
+			fprintf(out, "\t{ Game::%s, GameRegion::%s, GameVersion::%s, &%s[0], %zu },\n", info.game, info.region, info.version, TableName(info).c_str(), version.symbols.size());
+		}
+		fprintf(out, "};\n");
+
+		fclose(out);
+		return 0;
+	}
+
+	int GenerateBinary(int argc, char** argv) {
+		if(argc < 5) {
+			fprintf(stderr, "usage: %s bin <csv> <game id> <out.symdb>\n", argv[0]);
+			return 1;
+		}
+
+		std::vector<VersionSymbols> versions;
+		if(!ParseCsv(argv[2], versions))
+			return 1;
+
+		auto it = std::find_if(versions.begin(), versions.end(), [&](const VersionSymbols& v) { return !strcmp(v.info->id, argv[3]); });
+		if(it == versions.end()) {
+			fprintf(stderr, "no symbols for \"%s\"\n", argv[3]);
+			return 1;
+		}
+
+		auto* out = fopen(argv[4], "wb");
+		if(!out) {
+			fprintf(stderr, "could not open \"%s\" for writing\n", argv[4]);
+			return 1;
+		}
+
+		// The EE is little endian, like every host we care about.
+		util::SymbolDbHeader header { util::SymbolDbHeader::Magic, util::SymbolDbHeader::CurrentVersion, static_cast<uint32_t>(it->symbols.size()), 0 };
+		fwrite(&header, sizeof(header), 1, out);
+
+		for(const auto& symbol : it->symbols) {
+			util::SymbolEntry entry { symbol.hash, symbol.address };
+			fwrite(&entry, sizeof(entry), 1, out);
+		}
+
+		fclose(out);
+		return 0;
+	}
+
+	int Hash(int argc, char** argv) {
+		for(int i = 2; i < argc; ++i)
+			printf("0x%08x %s\n", util::SymbolHash(argv[i]), argv[i]);
+		return 0;
+	}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <inl|bin|hash>\n", argv[0]);
+		return 1;
+	}
+
+	if(!strcmp(argv[1], "inl"))
+		return GenerateInl(argc, argv);
+	if(!strcmp(argv[1], "bin"))
+		return GenerateBinary(argc, argv);
+	if(!strcmp(argv[1], "hash"))
+		return Hash(argc, argv);
+
+	fprintf(stderr, "unknown command \"%s\"\n", argv[1]);
+	return 1;
+}
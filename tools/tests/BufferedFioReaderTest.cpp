@@ -0,0 +1,210 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The buffered reader, and how many fio calls it saves opening a pack.
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <utils/BufferedFioReader.h>
+#include <utils/FioFile.h>
+#include <utils/PackFile.h>
+
+#include "MockFio.h"
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr uint32_t FileSize = 4096;
+
+	std::vector<uint8_t> Bytes(uint32_t size, uint8_t seed) {
+		std::vector<uint8_t> bytes(size);
+		for(uint32_t i = 0; i < size; ++i)
+			bytes[i] = static_cast<uint8_t>(seed + i * 7 + (i >> 8));
+		return bytes;
+	}
+
+	/**
+	 * A pack of files, like modpack makes.
+	 */
+	std::vector<uint8_t> MakePack(const std::vector<std::string>& files) {
+		std::vector<util::PackEntry> entries;
+		std::string paths;
+		for(const auto& path : files) {
+			entries.push_back({ util::PathHash(path.data(), path.size()), static_cast<uint32_t>(paths.size()), 0, 16 });
+			paths += path;
+			paths += '\0';
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.hash < b.hash; });
+
+		const util::PackHeader header { util::PackHeader::Magic, util::PackHeader::CurrentVersion, static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(entries.size() * sizeof(util::PackEntry) + paths.size()) };
+		auto offset = util::PackAlign(sizeof(header) + header.tocSize);
+		for(auto& entry : entries) {
+			entry.offset = offset;
+			offset = util::PackAlign(offset + entry.size);
+		}
+
+		std::vector<uint8_t> pack(offset);
+		memcpy(&pack[0], &header, sizeof(header));
+		memcpy(&pack[sizeof(header)], entries.data(), entries.size() * sizeof(util::PackEntry));
+		memcpy(&pack[sizeof(header) + entries.size() * sizeof(util::PackEntry)], paths.data(), paths.size());
+		return pack;
+	}
+
+	/**
+	 * A mock with "data.bin" in it, open.
+	 */
+	struct Fixture {
+		test::MockFio fio;
+		util::FioFile file;
+		std::vector<uint8_t> data = Bytes(FileSize, 5);
+
+		Fixture() {
+			fio.AddFile("host:data.bin", data);
+			file.Open("host:data.bin", FIO_O_RDONLY);
+			fio.calls = 0;
+		}
+	};
+
+} // namespace
+
+ELFLDR_TEST(SmallReadsShareABlock) {
+	Fixture fixture;
+	util::BufferedFioReader reader { fixture.file };
+
+	uint8_t buffer[16];
+	bool same = true;
+	for(uint32_t i = 0; i < FileSize / sizeof(buffer); ++i) {
+		ELFLDR_CHECK(reader.ReadExact(&buffer[0], sizeof(buffer)));
+		same = same && !memcmp(&buffer[0], &fixture.data[i * sizeof(buffer)], sizeof(buffer));
+	}
+	ELFLDR_CHECK(same);
+
+	// 256 reads, one fio call.
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 1u);
+	ELFLDR_CHECK_EQ(reader.GetStats().rpcCalls, 1u);
+	ELFLDR_CHECK_EQ(reader.GetStats().bufferHits, 255u);
+	ELFLDR_CHECK_EQ(reader.Read(&buffer[0], sizeof(buffer)), 0);
+}
+
+ELFLDR_TEST(SeeksInsideTheBlockAreFree) {
+	Fixture fixture;
+	util::BufferedFioReader reader { fixture.file };
+
+	uint8_t byte;
+	reader.Seek(10);
+	ELFLDR_CHECK(reader.ReadExact(&byte, 1) && byte == fixture.data[10]);
+	reader.Seek(100);
+	ELFLDR_CHECK(reader.ReadExact(&byte, 1) && byte == fixture.data[100]);
+	reader.Seek(10);
+	ELFLDR_CHECK(reader.ReadExact(&byte, 1) && byte == fixture.data[10]);
+	reader.Skip(1000);
+	ELFLDR_CHECK(reader.ReadExact(&byte, 1) && byte == fixture.data[1011]);
+	ELFLDR_CHECK_EQ(reader.Tell(), 1012u);
+
+	// The first read seeks to 10, and reads the rest of the file.
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 2u);
+}
+
+ELFLDR_TEST(BigReadsSkipTheBuffer) {
+	Fixture fixture;
+	util::BufferedFioReader reader { fixture.file, 256 };
+
+	std::vector<uint8_t> buffer(1000);
+	ELFLDR_CHECK(reader.ReadExact(buffer.data(), buffer.size()));
+	ELFLDR_CHECK(!memcmp(buffer.data(), fixture.data.data(), buffer.size()));
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 1u);
+	ELFLDR_CHECK_EQ(reader.GetStats().bytesRead, 1000u);
+}
+
+// Any mix of reads, peeks and seeks gets the file's bytes, short reads from the host and all.
+ELFLDR_TEST(MatchesTheFile) {
+	Fixture fixture;
+	fixture.fio.maxReadLength = 40;
+	util::BufferedFioReader reader { fixture.file, 64 };
+
+	uint32_t state = 12345;
+	auto Next = [&](uint32_t range) {
+		state = state * 1103515245 + 12345;
+		return (state >> 8) % range;
+	};
+
+	uint32_t position = 0;
+	uint8_t buffer[200];
+	bool same = true;
+	for(uint32_t i = 0; i < 2000 && same; ++i) {
+		switch(Next(4)) {
+			case 0:
+				position = Next(FileSize + 10);
+				reader.Seek(position);
+				break;
+
+			case 1: {
+				const auto length = Next(sizeof(buffer));
+				const auto expected = position < FileSize ? std::min(length, FileSize - position) : 0;
+				same = reader.Read(&buffer[0], length) == static_cast<int>(expected) && !memcmp(&buffer[0], &fixture.data[std::min(position, FileSize)], expected);
+				position += expected;
+				break;
+			}
+
+			case 2: {
+				const auto length = Next(64) + 1;
+				const auto* peeked = reader.Peek(length);
+				same = position + length > FileSize ? !peeked : peeked && !memcmp(peeked, &fixture.data[position], length);
+				break;
+			}
+
+			case 3:
+				same = reader.Size() == static_cast<int>(FileSize);
+				break;
+		}
+
+		same = same && reader.Tell() == position;
+	}
+
+	ELFLDR_CHECK(same);
+}
+
+// Opening a pack used to take 7 fio calls: open, the header, three seeks
+// for its size, the table of contents, and close. Now it takes 4.
+ELFLDR_TEST(OpeningAPack) {
+	test::MockFio fio;
+	fio.AddFile("host:mods/a.pak", MakePack({ "data/a.txt", "data/b.txt", "data/models/alaska.big" }));
+
+	util::PackSet packs;
+	ELFLDR_CHECK(packs.Mount("host:mods/a.pak"));
+	ELFLDR_CHECK_EQ(fio.calls, 4u);
+	ELFLDR_CHECK_EQ(fio.reads, 1u);
+	ELFLDR_CHECK_EQ(fio.OpenFiles(), 0u);
+
+	uint32_t pack;
+	ELFLDR_CHECK(packs.Find("host:data/models/alaska.big", pack));
+}
+
+// A table of contents bigger than a block still loads whole.
+ELFLDR_TEST(OpeningABigPack) {
+	std::vector<std::string> files;
+	for(uint32_t i = 0; i < 3000; ++i)
+		files.push_back("data/file" + std::to_string(i) + ".bin");
+
+	test::MockFio fio;
+	fio.AddFile("host:mods/big.pak", MakePack(files));
+
+	util::PackSet packs;
+	ELFLDR_CHECK(packs.Mount("host:mods/big.pak"));
+	ELFLDR_CHECK_EQ(packs.Pack(0).Count(), 3000u);
+
+	uint32_t pack;
+	ELFLDR_CHECK(packs.Find("host:data/file0.bin", pack));
+	ELFLDR_CHECK(packs.Find("host:data/file2999.bin", pack));
+}
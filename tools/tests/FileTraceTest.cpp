@@ -0,0 +1,239 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The file tracer: when it flushes, and what it writes.
+//
+// The trace is written with stand-ins for the game's file functions,
+// which go to MockFio. Time is MockKernel's cycle counter.
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <utils/FileTrace.h>
+#include <utils/FioBackend.h>
+#include <utils/Profiler.h>
+
+#include "MockFio.h"
+#include "MockKernel.h"
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr auto TracePath = "host:filetrace.bin";
+
+	// Where the game's functions would write to.
+	int GameOpen(const char* path, int flags, int) {
+		return util::Fio().open(path, flags);
+	}
+
+	int GameWrite(int fd, const void* buffer, int length) {
+		return util::Fio().write(fd, buffer, length);
+	}
+
+	int GameClose(int fd) {
+		return util::Fio().close(fd);
+	}
+
+	constexpr util::FileTraceIo GameIo { GameOpen, GameWrite, GameClose };
+
+	struct Chunk {
+		util::FileTraceChunkHeader header;
+		std::vector<util::FileTraceRecord> records;
+		std::vector<std::string> names;
+	};
+
+	/**
+	 * Split a trace into its chunks. Stops at anything that doesn't parse.
+	 */
+	std::vector<Chunk> ParseTrace(const std::vector<uint8_t>& data) {
+		std::vector<Chunk> chunks;
+		size_t position = 0;
+
+		auto Take = [&](void* out, size_t size) {
+			if(data.size() - position < size)
+				return false;
+			if(size != 0)
+				memcpy(out, &data[position], size);
+			position += size;
+			return true;
+		};
+
+		while(position < data.size()) {
+			Chunk chunk;
+			if(!Take(&chunk.header, sizeof(chunk.header)) || chunk.header.magic != util::FileTraceChunkHeader::Magic)
+				break;
+
+			chunk.records.resize(chunk.header.recordCount);
+			std::vector<util::FileTraceName> names(chunk.header.nameCount);
+			std::vector<char> paths(chunk.header.pathsSize);
+			if(!Take(chunk.records.data(), chunk.records.size() * sizeof(util::FileTraceRecord)) || !Take(names.data(), names.size() * sizeof(util::FileTraceName)) || !Take(paths.data(), paths.size()))
+				break;
+
+			for(const auto& name : names)
+				chunk.names.push_back(name.pathOffset < paths.size() ? &paths[name.pathOffset] : "(bad offset)");
+			chunks.push_back(std::move(chunk));
+		}
+
+		return chunks;
+	}
+
+	/**
+	 * A read of fd 3, starting now and taking a cycle.
+	 */
+	void TraceRead() {
+		const auto start = test::gCycleCounter;
+		util::TraceFileOp(util::FileTraceOp::Read, 3, 16, 16, start, start + 1);
+	}
+
+	/**
+	 * Tracing to host:filetrace.bin from cycle 1000, with the game's file functions.
+	 */
+	struct Fixture {
+		test::MockFio fio;
+
+		Fixture() {
+			test::ResetSemaphores();
+			test::gCycleCounter = 1000;
+			util::StartFileTrace(TracePath);
+			util::SetFileTraceIo(GameIo);
+		}
+
+		~Fixture() {
+			util::StopFileTrace();
+			util::SetFileTraceIo({});
+		}
+
+		std::vector<Chunk> Trace() const {
+			const auto* data = fio.File(TracePath);
+			return data ? ParseTrace(*data) : std::vector<Chunk> {};
+		}
+	};
+
+} // namespace
+
+ELFLDR_TEST(NothingToFlushAtFirst) {
+	Fixture fixture;
+	test::gCycleCounter += util::EeClockHz * 10;
+	ELFLDR_CHECK(!util::FileTraceWantsFlush());
+}
+
+ELFLDR_TEST(FlushesWhenIdle) {
+	Fixture fixture;
+	TraceRead();
+
+	test::gCycleCounter += util::EeClockHz / 4;
+	ELFLDR_CHECK(!util::FileTraceWantsFlush());
+
+	test::gCycleCounter += util::EeClockHz / 4;
+	ELFLDR_CHECK(util::FileTraceWantsFlush());
+
+	util::FlushFileTrace();
+	ELFLDR_CHECK(!util::FileTraceWantsFlush());
+	ELFLDR_CHECK_EQ(fixture.Trace().size(), 1u);
+}
+
+// A game which never stops touching files still has its trace written.
+ELFLDR_TEST(FlushesEveryFewSeconds) {
+	Fixture fixture;
+
+	for(uint32_t i = 0; i < 49; ++i) {
+		TraceRead();
+		test::gCycleCounter += util::EeClockHz / 10;
+		ELFLDR_CHECK(!util::FileTraceWantsFlush());
+	}
+
+	TraceRead();
+	test::gCycleCounter += util::EeClockHz / 10;
+	ELFLDR_CHECK(util::FileTraceWantsFlush());
+}
+
+ELFLDR_TEST(FlushesWhenGettingFull) {
+	Fixture fixture;
+
+	for(uint32_t i = 0; i < util::FileTraceCapacity / 4 * 3 - 1; ++i)
+		TraceRead();
+	ELFLDR_CHECK(!util::FileTraceWantsFlush());
+
+	TraceRead();
+	ELFLDR_CHECK(util::FileTraceWantsFlush());
+}
+
+ELFLDR_TEST(ChunksAreAppended) {
+	Fixture fixture;
+	fixture.fio.AddFile(TracePath, std::vector<uint8_t>(100, 0xee));
+
+	util::TraceFileOpen("host:DATA\\MODELS\\ALASKA.BIG", util::FileTraceSource::Pack, 3, 1000, 1100);
+	TraceRead();
+	util::FlushFileTrace();
+
+	test::gCycleCounter += 5000;
+	util::TraceFileOpen("host:data/a.txt", util::FileTraceSource::Overlay, 4, test::gCycleCounter, test::gCycleCounter + 10);
+	util::TraceFileOp(util::FileTraceOp::Close, 3, 0, 0, test::gCycleCounter + 20, test::gCycleCounter + 30);
+	util::FlushFileTrace();
+
+	// What was there before is replaced by the first chunk.
+	const auto chunks = fixture.Trace();
+	ELFLDR_CHECK_EQ(chunks.size(), 2u);
+	if(chunks.size() != 2)
+		return;
+
+	ELFLDR_CHECK_EQ(chunks[0].header.version, util::FileTraceChunkHeader::CurrentVersion);
+	ELFLDR_CHECK_EQ(chunks[0].header.clockHz, util::EeClockHz);
+	ELFLDR_CHECK_EQ(chunks[0].records.size(), 2u);
+	ELFLDR_CHECK(chunks[0].names == std::vector<std::string> { "DATA\\MODELS\\ALASKA.BIG" });
+	ELFLDR_CHECK_EQ(chunks[0].records[0].op, util::FileTraceOp::Open);
+	ELFLDR_CHECK_EQ(chunks[0].records[0].source, util::FileTraceSource::Pack);
+	ELFLDR_CHECK_EQ(chunks[0].records[0].cycles, 100u);
+	ELFLDR_CHECK_EQ(chunks[0].records[1].op, util::FileTraceOp::Read);
+	ELFLDR_CHECK_EQ(chunks[0].records[1].hash, chunks[0].records[0].hash);
+
+	// The second only names the file first opened since.
+	ELFLDR_CHECK_EQ(chunks[1].records.size(), 2u);
+	ELFLDR_CHECK(chunks[1].names == std::vector<std::string> { "data/a.txt" });
+	ELFLDR_CHECK_EQ(chunks[1].records[0].time, 5000u);
+	ELFLDR_CHECK_EQ(chunks[1].records[1].op, util::FileTraceOp::Close);
+	ELFLDR_CHECK_EQ(chunks[1].records[1].offset, 16u);
+	ELFLDR_CHECK_EQ(fixture.fio.OpenFiles(), 0u);
+}
+
+// Until the hooks hand over the game's functions, the trace stays in the ring.
+ELFLDR_TEST(NothingWrittenWithoutIo) {
+	Fixture fixture;
+	util::SetFileTraceIo({});
+
+	TraceRead();
+	util::FlushFileTrace();
+	ELFLDR_CHECK(!fixture.fio.File(TracePath));
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 0u);
+
+	util::SetFileTraceIo(GameIo);
+	util::FlushFileTrace();
+	const auto chunks = fixture.Trace();
+	ELFLDR_CHECK_EQ(chunks.size(), 1u);
+	ELFLDR_CHECK(chunks.size() == 1 && chunks[0].records.size() == 1);
+}
+
+// Semaphores made before ExecPS2() are gone once the game runs,
+// so the lock is only made when the game first traces something.
+ELFLDR_TEST(LockIsMadeByTheGame) {
+	Fixture fixture;
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+
+	TraceRead();
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 1u);
+	ELFLDR_CHECK(!test::AnySemaphoreTaken());
+
+	// Stopping writes what's left, and deletes the lock.
+	util::StopFileTrace();
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+	ELFLDR_CHECK(!util::FileTraceEnabled());
+	ELFLDR_CHECK_EQ(fixture.Trace().size(), 1u);
+}
@@ -0,0 +1,182 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <vector>
+
+#include <utils/FioAsync.h>
+#include <utils/FioFile.h>
+
+#include "MockFio.h"
+#include "Test.h"
+
+using namespace elfldr;
+using util::FioReadRequest;
+
+namespace {
+
+	constexpr uint32_t FileSize = 100;
+
+	/**
+	 * A mock with "data.bin" (bytes 0 to 99) in it.
+	 */
+	struct Fixture {
+		test::MockFio fio;
+		util::FioFile file;
+
+		explicit Fixture(uint32_t latencyPolls) {
+			std::vector<uint8_t> data(FileSize);
+			for(uint32_t i = 0; i < FileSize; ++i)
+				data[i] = static_cast<uint8_t>(i);
+			fio.AddFile("host:data.bin", std::move(data));
+			fio.latencyPolls = latencyPolls;
+
+			file.Open("host:data.bin", FIO_O_RDONLY);
+		}
+	};
+
+} // namespace
+
+ELFLDR_TEST(QueuedReadsRunInOrder) {
+	Fixture fixture(3);
+	uint8_t a[40];
+	uint8_t b[40];
+	uint8_t c[40];
+	FioReadRequest ra;
+	FioReadRequest rb;
+	FioReadRequest rc;
+
+	// The first read goes out straight away; the others wait for it.
+	ELFLDR_CHECK(fixture.file.ReadAsync(ra, &a[0], sizeof(a)));
+	ELFLDR_CHECK(util::FioReadInFlight());
+	ELFLDR_CHECK(fixture.file.ReadAsync(rb, &b[0], sizeof(b)));
+	ELFLDR_CHECK(fixture.file.ReadAsync(rc, &c[0], sizeof(c)));
+	ELFLDR_CHECK(ra.state == FioReadRequest::State::InFlight);
+	ELFLDR_CHECK(rb.state == FioReadRequest::State::Queued);
+	ELFLDR_CHECK(rc.state == FioReadRequest::State::Queued);
+
+	// Each poll is one round of "not done yet", until the latency is used up.
+	uint32_t polls = 0;
+	while(!ra.Done())
+		++polls;
+	ELFLDR_CHECK_EQ(polls, 3u);
+	ELFLDR_CHECK_EQ(ra.result, 40);
+	ELFLDR_CHECK_EQ(a[39], 39u);
+
+	// Finishing one read starts the next.
+	ELFLDR_CHECK(rb.state == FioReadRequest::State::InFlight);
+
+	// Waiting for the last waits for everything before it, and the file runs out on it.
+	ELFLDR_CHECK_EQ(util::FioWait(rc), 20);
+	ELFLDR_CHECK_EQ(rb.result, 40);
+	ELFLDR_CHECK_EQ(b[0], 40u);
+	ELFLDR_CHECK_EQ(c[19], 99u);
+	ELFLDR_CHECK(!util::FioReadInFlight());
+
+	ELFLDR_CHECK_EQ(fixture.fio.reads, 3u);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+}
+
+ELFLDR_TEST(PollMovesTheQueueAlong) {
+	Fixture fixture(2);
+	uint8_t a[10];
+	uint8_t b[10];
+	FioReadRequest ra;
+	FioReadRequest rb;
+
+	fixture.file.ReadAsync(ra, &a[0], sizeof(a));
+	fixture.file.ReadAsync(rb, &b[0], sizeof(b));
+
+	// What a caller doing other work between polls would see.
+	uint32_t polls = 0;
+	while(util::FioReadInFlight()) {
+		util::FioPoll();
+		++polls;
+	}
+
+	// 2 polls of latency and a completing poll each.
+	ELFLDR_CHECK_EQ(polls, 6u);
+	ELFLDR_CHECK(ra.state == FioReadRequest::State::Done);
+	ELFLDR_CHECK(rb.state == FioReadRequest::State::Done);
+	ELFLDR_CHECK_EQ(rb.result, 10);
+	ELFLDR_CHECK_EQ(b[9], 19u);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+}
+
+ELFLDR_TEST(ShortReads) {
+	Fixture fixture(1);
+	fixture.fio.maxReadLength = 16;
+
+	uint8_t buffer[64];
+	FioReadRequest request;
+	fixture.file.ReadAsync(request, &buffer[0], sizeof(buffer));
+	ELFLDR_CHECK_EQ(request.Wait(), 16);
+	ELFLDR_CHECK_EQ(buffer[15], 15u);
+}
+
+// fio keeps only the last result, so a synchronous call has to settle the read first.
+ELFLDR_TEST(SyncCallsSettleTheReadInFlight) {
+	Fixture fixture(5);
+	uint8_t buffer[10];
+	FioReadRequest request;
+
+	fixture.file.ReadAsync(request, &buffer[0], sizeof(buffer));
+	ELFLDR_CHECK(request.Pending());
+
+	ELFLDR_CHECK_EQ(fixture.file.Tell(), 10u);
+	ELFLDR_CHECK(request.state == FioReadRequest::State::Done);
+	ELFLDR_CHECK_EQ(request.result, 10);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+
+	// Same for a sync read.
+	FioReadRequest second;
+	fixture.file.ReadAsync(second, &buffer[0], 5);
+	uint8_t more[5];
+	ELFLDR_CHECK_EQ(fixture.file.Read(&more[0], sizeof(more)), 5);
+	ELFLDR_CHECK_EQ(second.result, 5);
+	ELFLDR_CHECK_EQ(buffer[0], 10u);
+	ELFLDR_CHECK_EQ(more[0], 15u);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+}
+
+ELFLDR_TEST(BadFile) {
+	test::MockFio fio;
+	util::FioFile file;
+	file.Open("host:missing.bin", FIO_O_RDONLY);
+	ELFLDR_CHECK(!file);
+
+	uint8_t buffer[4];
+	FioReadRequest request;
+	ELFLDR_CHECK(!file.ReadAsync(request, &buffer[0], sizeof(buffer)));
+	ELFLDR_CHECK_EQ(request.Wait(), -1);
+	ELFLDR_CHECK_EQ(fio.reads, 0u);
+}
+
+ELFLDR_TEST(RequestCantBeQueuedTwice) {
+	Fixture fixture(1);
+	uint8_t buffer[4];
+	FioReadRequest request;
+	ELFLDR_CHECK(util::FioQueueRead(request, 3, &buffer[0], sizeof(buffer)));
+	ELFLDR_CHECK(!util::FioQueueRead(request, 3, &buffer[0], sizeof(buffer)));
+	util::FioWaitAll();
+	ELFLDR_CHECK_EQ(request.result, 4);
+}
+
+// A request going away waits for its read, so fio doesn't write into a dead buffer.
+ELFLDR_TEST(DestructorWaits) {
+	Fixture fixture(4);
+	{
+		uint8_t buffer[8];
+		FioReadRequest first;
+		FioReadRequest second;
+		fixture.file.ReadAsync(first, &buffer[0], 4);
+		fixture.file.ReadAsync(second, &buffer[4], 4);
+	}
+
+	ELFLDR_CHECK(!util::FioReadInFlight());
+	ELFLDR_CHECK_EQ(fixture.fio.reads, 2u);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+}
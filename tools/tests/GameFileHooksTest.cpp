@@ -0,0 +1,441 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The game file hooks, serving files from the overlay and packs.
+//
+// The game's sceOpen/sceClose/sceRead/sceLseek are stand-ins which go to
+// MockFio, and hooking one just remembers the hook, so the test can call
+// it like the game would.
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <utils/DirectoryIndex.h>
+#include <utils/FileTrace.h>
+#include <utils/FioBackend.h>
+#include <utils/GameFileHooks.h>
+#include <utils/GameVersion.h>
+#include <utils/Hook.h>
+#include <utils/SymbolDb.h>
+
+#include "MockFio.h"
+#include "MockKernel.h"
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr int PackFdBase = 0x7000;
+
+	// Sony's values.
+	constexpr int SceReadOnly = 0x0001;
+	constexpr int SceWriteOnly = 0x0002;
+	constexpr int SceEmfile = 24;
+	constexpr int SceEinval = 22;
+	constexpr int SceEbadf = 9;
+
+	// Where the game's functions "are".
+	constexpr uintptr_t OpenAddress = 0x00100000;
+	constexpr uintptr_t CloseAddress = 0x00100100;
+	constexpr uintptr_t ReadAddress = 0x00100200;
+	constexpr uintptr_t LseekAddress = 0x00100300;
+
+	std::map<std::string, uintptr_t> gSymbols;
+	std::map<uintptr_t, const void*> gHooks;
+
+	struct GameCalls {
+		uint32_t opens;
+		uint32_t reads;
+		uint32_t seeks;
+	} gCalls;
+
+	int GameOpen(const char* path, int flags, int) {
+		++gCalls.opens;
+		return util::Fio().open(path, flags);
+	}
+
+	int GameClose(int fd) {
+		return util::Fio().close(fd);
+	}
+
+	int GameRead(int fd, void* buffer, int length) {
+		++gCalls.reads;
+		return util::Fio().read(fd, buffer, length);
+	}
+
+	int GameLseek(int fd, int offset, int whence) {
+		++gCalls.seeks;
+		return util::Fio().lseek(fd, offset, whence);
+	}
+
+	// Not hooked, so the symbol is the function itself.
+	int GameWrite(int fd, const void* buffer, int length) {
+		return util::Fio().write(fd, buffer, length);
+	}
+
+	/**
+	 * Call the hook on a game function, like the game would.
+	 */
+	template <class... Args>
+	int Call(uintptr_t address, Args... args) {
+		auto it = gHooks.find(address);
+		if(it == gHooks.end())
+			return -1000;
+		return reinterpret_cast<int (*)(Args...)>(const_cast<void*>(it->second))(args...);
+	}
+
+	int Open(const char* path, int flags = SceReadOnly) {
+		return Call<const char*, int, int>(OpenAddress, path, flags, 0);
+	}
+
+	int Close(int fd) {
+		return Call<int>(CloseAddress, fd);
+	}
+
+	int Read(int fd, void* buffer, int length) {
+		return Call<int, void*, int>(ReadAddress, fd, buffer, length);
+	}
+
+	int Lseek(int fd, int offset, int whence) {
+		return Call<int, int, int>(LseekAddress, fd, offset, whence);
+	}
+
+	std::vector<uint8_t> Bytes(uint32_t size, uint8_t seed) {
+		std::vector<uint8_t> bytes(size);
+		for(uint32_t i = 0; i < size; ++i)
+			bytes[i] = static_cast<uint8_t>(seed + i * 7);
+		return bytes;
+	}
+
+	/**
+	 * Make a pack, like modpack does.
+	 */
+	std::vector<uint8_t> MakePack(std::vector<std::pair<std::string, std::vector<uint8_t>>> files) {
+		std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+			const auto aHash = util::PathHash(a.first.data(), a.first.size());
+			const auto bHash = util::PathHash(b.first.data(), b.first.size());
+			return aHash != bHash ? aHash < bHash : a.first < b.first;
+		});
+
+		std::vector<util::PackEntry> entries;
+		std::string paths;
+		for(const auto& [path, data] : files) {
+			entries.push_back({ util::PathHash(path.data(), path.size()), static_cast<uint32_t>(paths.size()), 0, static_cast<uint32_t>(data.size()) });
+			paths += path;
+			paths += '\0';
+		}
+
+		const util::PackHeader header { util::PackHeader::Magic, util::PackHeader::CurrentVersion, static_cast<uint32_t>(files.size()), static_cast<uint32_t>(entries.size() * sizeof(util::PackEntry) + paths.size()) };
+		auto offset = util::PackAlign(sizeof(header) + header.tocSize);
+		for(uint32_t i = 0; i < entries.size(); ++i) {
+			entries[i].offset = offset;
+			offset = util::PackAlign(offset + entries[i].size);
+		}
+
+		std::vector<uint8_t> pack(offset);
+		memcpy(&pack[0], &header, sizeof(header));
+		memcpy(&pack[sizeof(header)], entries.data(), entries.size() * sizeof(util::PackEntry));
+		memcpy(&pack[sizeof(header) + entries.size() * sizeof(util::PackEntry)], paths.data(), paths.size());
+		for(uint32_t i = 0; i < entries.size(); ++i)
+			std::copy(files[i].second.begin(), files[i].second.end(), pack.begin() + entries[i].offset);
+		return pack;
+	}
+
+	/**
+	 * A game with a loose mod (host:mods/loose) over a pack (host:mods/base.pak).
+	 */
+	struct Fixture {
+		test::MockFio fio;
+
+		util::DirectoryIndex::Entry slots[16] {};
+		char strings[512] {};
+		util::DirectoryIndex index { slots, strings };
+
+		util::OverlayFs overlay;
+		util::PackSet packs;
+
+		std::vector<uint8_t> alaska = Bytes(5000, 1);
+
+		Fixture() {
+			gSymbols = { { "sceOpen", OpenAddress }, { "sceClose", CloseAddress }, { "sceRead", ReadAddress }, { "sceLseek", LseekAddress } };
+			gCalls = {};
+
+			fio.AddFile("host:data/models/alaska.big", Bytes(100, 9));
+			fio.AddFile("host:mods/loose/data/a.txt", Bytes(6, 2));
+			fio.AddFile("host:mods/base.pak", MakePack({ { "data/a.txt", Bytes(10, 3) }, { "data/models/alaska.big", alaska }, { "empty.bin", {} } }));
+
+			const auto loose = index.AddEmptyRoot("host:mods/loose");
+			index.Insert(loose, "data/a.txt", 6, 0);
+			const uint32_t roots[] { loose };
+			overlay.Build(index, roots);
+
+			packs.Mount("host:mods/base.pak");
+		}
+
+		~Fixture() {
+			util::RemoveGameFileHooks();
+		}
+	};
+
+} // namespace
+
+// What the hooks need from the rest of the loader.
+namespace elfldr::util {
+
+	namespace detail {
+
+		void* HookFunctionBase(void* dest, const void* hook) {
+			const auto address = reinterpret_cast<uintptr_t>(dest);
+			gHooks[address] = hook;
+			switch(address) {
+				case OpenAddress: return reinterpret_cast<void*>(GameOpen);
+				case CloseAddress: return reinterpret_cast<void*>(GameClose);
+				case ReadAddress: return reinterpret_cast<void*>(GameRead);
+				case LseekAddress: return reinterpret_cast<void*>(GameLseek);
+				default: return nullptr;
+			}
+		}
+
+	} // namespace detail
+
+	bool UnhookFunction(void* funcptr) {
+		return gHooks.erase(reinterpret_cast<uintptr_t>(funcptr)) != 0;
+	}
+
+	void BeginHookBatch() {
+	}
+
+	void EndHookBatch() {
+	}
+
+	uintptr_t FindSymbol(uint32_t hash) {
+		for(const auto& [name, address] : gSymbols)
+			if(SymbolHash(name.c_str()) == hash)
+				return address;
+		return 0;
+	}
+
+	GameVersionData& GetGameVersionData() {
+		static GameVersionData data {};
+		return data;
+	}
+
+	mlstd::StringView GameVersionData::GameID() const {
+		return "test";
+	}
+
+} // namespace elfldr::util
+
+ELFLDR_TEST(LooseFilesWinOverPacks) {
+	Fixture fixture;
+	ELFLDR_CHECK(util::InstallGameFileHooks(fixture.overlay, fixture.packs));
+	ELFLDR_CHECK_EQ(gHooks.size(), 4u);
+
+	uint8_t buffer[32];
+	const auto fd = Open("host:DATA\\A.TXT");
+	ELFLDR_CHECK(fd >= 0 && fd < PackFdBase);
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], sizeof(buffer)), 6);
+	ELFLDR_CHECK(!memcmp(&buffer[0], Bytes(6, 2).data(), 6));
+	ELFLDR_CHECK_EQ(Close(fd), 0);
+}
+
+ELFLDR_TEST(PackedFiles) {
+	Fixture fixture;
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	// Opening a packed file doesn't touch the host.
+	const auto fd = Open("host:DATA\\MODELS\\ALASKA.BIG");
+	ELFLDR_CHECK_EQ(fd, PackFdBase);
+	ELFLDR_CHECK_EQ(gCalls.opens, 0u);
+
+	ELFLDR_CHECK_EQ(Lseek(fd, 0, 2), 5000);
+	ELFLDR_CHECK_EQ(Lseek(fd, 0, 0), 0);
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[1000];
+	int read;
+	while((read = Read(fd, &buffer[0], sizeof(buffer))) > 0)
+		data.insert(data.end(), &buffer[0], &buffer[read]);
+	ELFLDR_CHECK(data == fixture.alaska);
+
+	// The pack is opened once, and read on from where the last read left it.
+	ELFLDR_CHECK_EQ(gCalls.opens, 1u);
+	ELFLDR_CHECK_EQ(gCalls.reads, 5u);
+	ELFLDR_CHECK_EQ(gCalls.seeks, 1u);
+
+	ELFLDR_CHECK_EQ(Lseek(fd, -10, 1), 4990);
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], 100), 10);
+	ELFLDR_CHECK(!memcmp(&buffer[0], &fixture.alaska[4990], 10));
+
+	// Past the end.
+	ELFLDR_CHECK_EQ(Lseek(fd, 9000, 0), 9000);
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], 10), 0);
+
+	ELFLDR_CHECK_EQ(Lseek(fd, -1, 0), -SceEinval);
+	ELFLDR_CHECK_EQ(Lseek(fd, 0, 7), -SceEinval);
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], -1), -SceEinval);
+
+	const auto empty = Open("empty.bin");
+	ELFLDR_CHECK_EQ(empty, PackFdBase + 1);
+	ELFLDR_CHECK_EQ(Read(empty, &buffer[0], 10), 0);
+
+	ELFLDR_CHECK_EQ(Close(fd), 0);
+	ELFLDR_CHECK_EQ(Close(empty), 0);
+	ELFLDR_CHECK_EQ(fixture.fio.overlapped, 0u);
+}
+
+ELFLDR_TEST(WritesArentServedFromPacks) {
+	Fixture fixture;
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	const auto fd = Open("host:data/models/alaska.big", SceWriteOnly);
+	ELFLDR_CHECK(fd >= 0 && fd < PackFdBase);
+	ELFLDR_CHECK_EQ(gCalls.opens, 1u);
+}
+
+ELFLDR_TEST(TooManyPackedFiles) {
+	Fixture fixture;
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	std::vector<int> fds;
+	for(uint32_t i = 0; i < 32; ++i)
+		fds.push_back(Open("empty.bin"));
+	ELFLDR_CHECK_EQ(fds.back(), PackFdBase + 31);
+	ELFLDR_CHECK_EQ(Open("empty.bin"), -SceEmfile);
+
+	// Closing one frees its fd up again.
+	Close(fds[5]);
+	ELFLDR_CHECK_EQ(Open("empty.bin"), PackFdBase + 5);
+}
+
+// Another thread can close a packed file while this one waits for the lock.
+ELFLDR_TEST(ClosedWhileWaitingForTheLock) {
+	Fixture fixture;
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	static int fd;
+	fd = Open("host:data/models/alaska.big");
+	ELFLDR_CHECK_EQ(fd, PackFdBase);
+
+	uint8_t buffer[16];
+	test::gBeforeWaitSema = [] { Close(fd); };
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], sizeof(buffer)), -SceEbadf);
+
+	fd = Open("host:data/models/alaska.big");
+	test::gBeforeWaitSema = [] { Close(fd); };
+	ELFLDR_CHECK_EQ(Lseek(fd, 0, 2), -SceEbadf);
+
+	fd = Open("host:data/models/alaska.big");
+	test::gBeforeWaitSema = [] { Close(fd); };
+	ELFLDR_CHECK_EQ(Close(fd), -SceEbadf);
+
+	// None of them went to the game.
+	ELFLDR_CHECK_EQ(gCalls.opens + gCalls.reads + gCalls.seeks, 0u);
+}
+
+// Semaphores made before ExecPS2() are gone once the game runs,
+// so the pack lock is only made when the game first needs it.
+ELFLDR_TEST(PackLockIsMadeByTheGame) {
+	Fixture fixture;
+	test::ResetSemaphores();
+
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+
+	// ExecPS2().
+	test::ResetSemaphores();
+
+	const auto fd = Open("host:data/models/alaska.big");
+	ELFLDR_CHECK_EQ(fd, PackFdBase);
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 1u);
+
+	uint8_t buffer[16];
+	ELFLDR_CHECK_EQ(Read(fd, &buffer[0], sizeof(buffer)), 16);
+	ELFLDR_CHECK(!test::AnySemaphoreTaken());
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 1u);
+
+	// Removing the hooks closes the pack, and deletes the lock.
+	const auto filesOpen = fixture.fio.OpenFiles();
+	util::RemoveGameFileHooks();
+	ELFLDR_CHECK_EQ(fixture.fio.OpenFiles(), filesOpen - 1);
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+	ELFLDR_CHECK(gHooks.empty());
+}
+
+ELFLDR_TEST(NoSemaphores) {
+	Fixture fixture;
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	test::gCreateSemaFails = true;
+	ELFLDR_CHECK_EQ(Open("host:data/models/alaska.big"), -SceEmfile);
+	test::gCreateSemaFails = false;
+
+	// Loose files and the game's own don't need it.
+	ELFLDR_CHECK(Open("host:data/a.txt") >= 0);
+}
+
+ELFLDR_TEST(OnlyOverlayWithoutReadHooks) {
+	Fixture fixture;
+	gSymbols.erase("sceRead");
+
+	ELFLDR_CHECK(util::InstallGameFileHooks(fixture.overlay, fixture.packs));
+	ELFLDR_CHECK_EQ(gHooks.size(), 1u);
+
+	// Packed files aren't served, so the game looks for its own (and there isn't one).
+	ELFLDR_CHECK(Open("empty.bin") < 0);
+	ELFLDR_CHECK(Open("host:data/a.txt") >= 0);
+}
+
+ELFLDR_TEST(NothingWithoutOpen) {
+	Fixture fixture;
+	gSymbols.erase("sceOpen");
+
+	ELFLDR_CHECK(!util::InstallGameFileHooks(fixture.overlay, fixture.packs));
+	ELFLDR_CHECK(gHooks.empty());
+}
+
+// The trace is written with the game's own functions, since fio's don't
+// work once the game has rebooted the IOP, and removing the hooks writes
+// what's left, while those are still around.
+ELFLDR_TEST(TraceIsWrittenWithTheGamesFunctions) {
+	Fixture fixture;
+	gSymbols["sceWrite"] = reinterpret_cast<uintptr_t>(&GameWrite);
+	util::StartFileTrace("host:filetrace.bin");
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	uint8_t buffer[16];
+	const auto fd = Open("host:data/models/alaska.big");
+	Read(fd, &buffer[0], sizeof(buffer));
+	Close(fd);
+	ELFLDR_CHECK(!fixture.fio.File("host:filetrace.bin"));
+
+	util::RemoveGameFileHooks();
+	const auto* trace = fixture.fio.File("host:filetrace.bin");
+	ELFLDR_CHECK(trace && trace->size() > sizeof(util::FileTraceChunkHeader));
+
+	// Without the hooks there's nothing to write it with.
+	const auto size = trace ? trace->size() : 0;
+	util::StopFileTrace();
+	ELFLDR_CHECK_EQ(trace ? trace->size() : 0, size);
+}
+
+ELFLDR_TEST(TraceIsntWrittenWithoutWrite) {
+	Fixture fixture;
+	util::StartFileTrace("host:filetrace.bin");
+	util::InstallGameFileHooks(fixture.overlay, fixture.packs);
+
+	Close(Open("host:data/a.txt"));
+	util::RemoveGameFileHooks();
+	util::StopFileTrace();
+	ELFLDR_CHECK(!fixture.fio.File("host:filetrace.bin"));
+}
@@ -0,0 +1,201 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Prologue relocation, on the prologue shapes EE GCC generates.
+// The addresses are real functions from the symbol database
+// (src/utils/Symbols/Symbols.csv), so segment and range checks see
+// the same numbers they would in the game.
+
+#include <utils/HookRelocator.h>
+
+#include "Test.h"
+
+using namespace elfldr;
+using namespace elfldr::util;
+using namespace elfldr::util::mips;
+
+namespace {
+
+	// SSX (NTSC 1.0)
+	constexpr uintptr_t SSX_MEM_alloc = 0x0023a448;
+	constexpr uintptr_t SSX_MEM_free = 0x0023a998;
+	constexpr uintptr_t SSX_printf = 0x0018ac08;
+	constexpr uintptr_t SSX_initheapdebug = 0x0018a280;
+
+	// SSX Tricky (NTSC 1.0)
+	constexpr uintptr_t SSXDVD_MEM_alloc = 0x002ccf70;
+
+	// Trampolines are allocated from the game heap, where ElfLdr itself also lives.
+	constexpr uintptr_t Trampoline = 0x01e00000;
+
+	template <uint32_t N>
+	RelocatedCode Relocate(const uint32_t (&stolen)[N], uintptr_t source, uintptr_t destination = Trampoline) {
+		return RelocatePrologue(&stolen[0], N, source, destination);
+	}
+
+	/**
+	 * Where a branch in the relocated code goes.
+	 */
+	uintptr_t BranchTarget(const RelocatedCode& code, uint32_t index, uintptr_t destination = Trampoline) {
+		return Decode(code.code[index], destination + index * 4).target;
+	}
+
+	/**
+	 * The first instruction of the stub a relocated branch goes to.
+	 */
+	uint32_t StubOf(const RelocatedCode& code, uint32_t index) {
+		return code.code[(BranchTarget(code, index) - Trampoline) / 4];
+	}
+
+} // namespace
+
+// A plain prologue: frame, saves, and an argument moved to a saved register.
+ELFLDR_TEST(PlainPrologue) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x40), sd(Reg::S1, 0x20, Reg::SP), sd(Reg::RA, 0x30, Reg::SP), daddu(Reg::S1, Reg::A0, Reg::R0) };
+
+	const auto code = Relocate(stolen, SSX_MEM_alloc);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.length, 6u);
+	for(uint32_t i = 0; i < 4; ++i)
+		ELFLDR_CHECK_EQ(code.code[i], stolen[i]);
+	ELFLDR_CHECK_EQ(code.code[4], j(SSX_MEM_alloc + 16));
+	ELFLDR_CHECK_EQ(code.code[5], nop());
+
+	// A two instruction (j) hook site only steals the first two.
+	const auto shortCode = RelocatePrologue(&stolen[0], 2, SSXDVD_MEM_alloc, Trampoline);
+	ELFLDR_CHECK_EQ(shortCode.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(shortCode.length, 4u);
+	ELFLDR_CHECK_EQ(shortCode.code[2], j(SSXDVD_MEM_alloc + 8));
+}
+
+// printf() spills its variadic arguments first thing.
+ELFLDR_TEST(VarargsPrologue) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x80), sd(Reg::A1, 0x48, Reg::SP), sd(Reg::A2, 0x50, Reg::SP), sd(Reg::A3, 0x58, Reg::SP) };
+
+	const auto code = Relocate(stolen, SSX_printf);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.code[4], j(SSX_printf + 16));
+}
+
+// An in-range branch: MEM_free(nullptr) returns early, to a jr ra past the stolen instructions.
+ELFLDR_TEST(EarlyOutBranch) {
+	constexpr uint32_t stolen[] { beq(Reg::A0, Reg::R0, 0x40), nop(), addiu(Reg::SP, Reg::SP, -0x20), sd(Reg::RA, 0x10, Reg::SP) };
+
+	const auto code = Relocate(stolen, SSX_MEM_free);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.length, 8u);
+
+	// Same condition and delay slot, branching to a stub at the end which jumps to the real target.
+	ELFLDR_CHECK_EQ(code.code[0] & 0xffff0000, stolen[0] & 0xffff0000);
+	ELFLDR_CHECK_EQ(code.code[1], nop());
+	ELFLDR_CHECK_EQ(BranchTarget(code, 0), Trampoline + 6 * 4);
+	ELFLDR_CHECK_EQ(code.code[6], j(SSX_MEM_free + 4 + 0x40));
+	ELFLDR_CHECK_EQ(code.code[7], nop());
+
+	// The fall through path still gets back to the function.
+	ELFLDR_CHECK_EQ(code.code[4], j(SSX_MEM_free + 16));
+}
+
+// A branch backwards, out of the function (a tail loop, or a shared epilogue before it).
+ELFLDR_TEST(BackwardBranch) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x10), bne(Reg::A0, Reg::R0, -0x100), sd(Reg::RA, 0, Reg::SP), nop() };
+
+	const auto code = Relocate(stolen, SSX_initheapdebug);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.code[2], stolen[2]); // the delay slot stays put
+	ELFLDR_CHECK_EQ(StubOf(code, 1), j(SSX_initheapdebug + 8 - 0x100));
+}
+
+// A call to a helper in the prologue keeps working from the trampoline.
+ELFLDR_TEST(CallInPrologue) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x10), jal(0x0023a448), sd(Reg::RA, 0, Reg::SP), nop() };
+
+	const auto code = Relocate(stolen, SSX_MEM_free);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.code[1], stolen[1]);
+
+	// Unless the trampoline is in a different 256MB segment.
+	ELFLDR_CHECK_EQ(Relocate(stolen, SSX_MEM_free, 0x20000000).error, RelocateError::OutOfSegment);
+}
+
+// The PIC get-PC idiom, at the start of the prologue:
+// bal .+8; nop; lui gp, hi; addiu gp, gp, lo (and later, addu gp, gp, ra).
+ELFLDR_TEST(GetPcAtStart) {
+	constexpr uint32_t stolen[] { bal(4), nop(), lui(Reg::GP, 0x0001), addiu(Reg::GP, Reg::GP, -0x7ff0) };
+
+	const auto code = Relocate(stolen, SSX_MEM_alloc);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.length, 7u);
+
+	// ra has to be the original address, or gp ends up relative to the trampoline.
+	ELFLDR_CHECK_EQ(code.code[0], lui(Reg::RA, (SSX_MEM_alloc + 8) >> 16));
+	ELFLDR_CHECK_EQ(code.code[1], ori(Reg::RA, Reg::RA, (SSX_MEM_alloc + 8) & 0xffff));
+	ELFLDR_CHECK_EQ(code.code[2], nop());
+	ELFLDR_CHECK_EQ(code.code[3], stolen[2]);
+	ELFLDR_CHECK_EQ(code.code[4], stolen[3]);
+	ELFLDR_CHECK_EQ(code.code[5], j(SSX_MEM_alloc + 16));
+}
+
+// The same, after the frame is set up, so the bal's target is right after the stolen instructions.
+ELFLDR_TEST(GetPcAtEnd) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x20), sd(Reg::RA, 0x10, Reg::SP), bal(4), sd(Reg::GP, 0, Reg::SP) };
+
+	const auto code = Relocate(stolen, SSXDVD_MEM_alloc);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.length, 7u);
+	ELFLDR_CHECK_EQ(code.code[2], lui(Reg::RA, (SSXDVD_MEM_alloc + 16) >> 16));
+	ELFLDR_CHECK_EQ(code.code[3], ori(Reg::RA, Reg::RA, (SSXDVD_MEM_alloc + 16) & 0xffff));
+	ELFLDR_CHECK_EQ(code.code[4], stolen[3]);
+	ELFLDR_CHECK_EQ(code.code[5], j(SSXDVD_MEM_alloc + 16));
+}
+
+// A real call with bal still returns into the trampoline.
+ELFLDR_TEST(BalCall) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x10), bal(0x200), sd(Reg::RA, 0, Reg::SP), nop() };
+
+	const auto code = Relocate(stolen, SSX_printf);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.code[1] & 0xffff0000, stolen[1] & 0xffff0000);
+	ELFLDR_CHECK_EQ(StubOf(code, 1), j(SSX_printf + 8 + 0x200));
+}
+
+ELFLDR_TEST(FarTrampoline) {
+	constexpr uint32_t stolen[] { addiu(Reg::SP, Reg::SP, -0x40), sd(Reg::S1, 0x20, Reg::SP), sd(Reg::RA, 0x30, Reg::SP), daddu(Reg::S1, Reg::A0, Reg::R0) };
+
+	// Out of j range, so the jump back goes through t0.
+	const auto code = Relocate(stolen, SSX_MEM_alloc, 0x30000000);
+	ELFLDR_CHECK_EQ(code.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(code.length, 8u);
+	ELFLDR_CHECK_EQ(code.code[4], lui(Reg::T0, (SSX_MEM_alloc + 16) >> 16));
+	ELFLDR_CHECK_EQ(code.code[5], ori(Reg::T0, Reg::T0, (SSX_MEM_alloc + 16) & 0xffff));
+	ELFLDR_CHECK_EQ(code.code[6], jr(Reg::T0));
+}
+
+ELFLDR_TEST(RefusedPrologues) {
+	// A leaf which returns straight away.
+	constexpr uint32_t tooShort[] { jr(Reg::RA), addiu(Reg::V0, Reg::R0, 1), nop(), nop() };
+	ELFLDR_CHECK_EQ(Relocate(tooShort, SSX_MEM_free).error, RelocateError::FunctionTooShort);
+
+	// The last stolen instruction's delay slot isn't stolen.
+	constexpr uint32_t splitDelaySlot[] { addiu(Reg::SP, Reg::SP, -0x10), sd(Reg::RA, 0, Reg::SP), nop(), bne(Reg::A0, Reg::R0, 0x20) };
+	ELFLDR_CHECK_EQ(Relocate(splitDelaySlot, SSX_MEM_free).error, RelocateError::DelaySlotOutside);
+
+	// A loop over the stolen instructions themselves.
+	constexpr uint32_t intoStolen[] { addiu(Reg::A0, Reg::A0, -1), bne(Reg::A0, Reg::R0, -8), nop(), nop() };
+	ELFLDR_CHECK_EQ(Relocate(intoStolen, SSX_MEM_free).error, RelocateError::BranchIntoStolen);
+
+	constexpr uint32_t branchInDelaySlot[] { beq(Reg::A0, Reg::R0, 0x40), b(0x40), nop(), nop() };
+	ELFLDR_CHECK_EQ(Relocate(branchInDelaySlot, SSX_MEM_free).error, RelocateError::BranchInDelaySlot);
+
+	// Branch likely to after its delay slot skips the delay slot when not taken, so it's no get-PC.
+	constexpr uint32_t likely[] { beql(Reg::A0, Reg::R0, 4), nop(), nop(), nop() };
+	ELFLDR_CHECK_EQ(Relocate(likely, SSX_MEM_free).error, RelocateError::BranchIntoStolen);
+}
+
+// It's all constexpr, so hook stubs can be checked at compile time too.
+constexpr uint32_t getPc[] { bal(4), nop() };
+static_assert(RelocatePrologue(&getPc[0], 2, SSX_MEM_alloc, Trampoline).length == 5);
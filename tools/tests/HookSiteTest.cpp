@@ -0,0 +1,110 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <utils/HookSite.h>
+
+#include "Test.h"
+
+using namespace elfldr::util;
+using namespace elfldr::util::detail;
+using namespace elfldr::util::mips;
+
+namespace {
+
+	constexpr uintptr_t Function = 0x0023a448; // SSX MEM_alloc
+	constexpr uintptr_t Hook = 0x01000200;     // somewhere in an ERL
+	constexpr uintptr_t Trampoline = 0x01e00000;
+
+	constexpr uint32_t plainPrologue[] { addiu(Reg::SP, Reg::SP, -0x40), sd(Reg::S1, 0x20, Reg::SP), sd(Reg::RA, 0x30, Reg::SP), daddu(Reg::S1, Reg::A0, Reg::R0) };
+
+} // namespace
+
+ELFLDR_TEST(SameSegmentUsesJump) {
+	ELFLDR_CHECK_EQ(SelectHookSite(Function, Hook), HookSite::Jump);
+	ELFLDR_CHECK_EQ(SelectHookSite(0x00200000, 0x01f00000), HookSite::Jump);
+
+	// Both ends of the first segment.
+	ELFLDR_CHECK_EQ(SelectHookSite(0x00000000, 0x0ffffffc), HookSite::Jump);
+	ELFLDR_CHECK_EQ(SelectHookSite(0x0ffffff8, 0x00000000), HookSite::Jump);
+}
+
+// j's target is in the segment of its delay slot, not the j itself.
+ELFLDR_TEST(SegmentBoundary) {
+	// The j is in the last word of a segment, so its delay slot is in the next one.
+	ELFLDR_CHECK_EQ(SelectHookSite(0x0ffffffc, 0x00000000), HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(SelectHookSite(0x0ffffffc, 0x10000000), HookSite::Jump);
+
+	// The j is at the start of a segment.
+	ELFLDR_CHECK_EQ(SelectHookSite(0x10000000, 0x0ffffffc), HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(SelectHookSite(0x10000000, 0x1ffffffc), HookSite::Jump);
+
+	// Other segments, e.g. the uncached mirror of RAM.
+	ELFLDR_CHECK_EQ(SelectHookSite(Function, 0x20000000 | Hook), HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(SelectHookSite(0x20000000 | Function, 0x20000000 | Hook), HookSite::Jump);
+}
+
+ELFLDR_TEST(UnalignedHookUsesLoadJump) {
+	ELFLDR_CHECK_EQ(SelectHookSite(Function, Hook + 2), HookSite::LoadJump);
+}
+
+ELFLDR_TEST(SiteCode) {
+	ELFLDR_CHECK_EQ(HookSiteLength(HookSite::Jump), 2u);
+	ELFLDR_CHECK_EQ(HookSiteLength(HookSite::LoadJump), 4u);
+
+	const uintptr_t slots[] { Hook };
+	uint32_t code[4] {};
+
+	jumpTemplate.LinkAt(&code[0], Function, slots);
+	ELFLDR_CHECK_EQ(code[0], j(Hook));
+	ELFLDR_CHECK_EQ(code[1], nop());
+
+	callTemplate.LinkAt(&code[0], Function, slots);
+	ELFLDR_CHECK_EQ(code[0], lui(Reg::T0, Hook >> 16));
+	ELFLDR_CHECK_EQ(code[1], ori(Reg::T0, Reg::T0, Hook & 0xffff));
+	ELFLDR_CHECK_EQ(code[2], jr(Reg::T0));
+	ELFLDR_CHECK_EQ(code[3], nop());
+}
+
+ELFLDR_TEST(PlanStealsTwoInRange) {
+	const auto plan = PlanHook(&plainPrologue[0], Function, Hook, Trampoline);
+	ELFLDR_CHECK_EQ(plan.site, HookSite::Jump);
+	ELFLDR_CHECK_EQ(plan.relocated.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(plan.relocated.length, 4u);
+	ELFLDR_CHECK_EQ(plan.relocated.code[2], j(Function + 8));
+
+	const auto far = PlanHook(&plainPrologue[0], Function, 0x20000000 | Hook, Trampoline);
+	ELFLDR_CHECK_EQ(far.site, HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(far.relocated.code[4], j(Function + 16));
+}
+
+// A j site would steal a branch without its delay slot, so the long site is used instead.
+ELFLDR_TEST(DelaySlotOutsideFallsBack) {
+	constexpr uint32_t prologue[] { addiu(Reg::SP, Reg::SP, -0x20), beq(Reg::A0, Reg::R0, 0x40), sd(Reg::RA, 0x10, Reg::SP), nop() };
+
+	ELFLDR_CHECK_EQ(RelocatePrologue(&prologue[0], 2, Function, Trampoline).error, RelocateError::DelaySlotOutside);
+
+	const auto plan = PlanHook(&prologue[0], Function, Hook, Trampoline);
+	ELFLDR_CHECK_EQ(plan.site, HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(plan.relocated.error, RelocateError::None);
+	ELFLDR_CHECK_EQ(plan.relocated.code[2], prologue[2]);
+}
+
+// Other errors don't fall back; the long site wouldn't help.
+ELFLDR_TEST(OtherErrorsDontFallBack) {
+	constexpr uint32_t tooShort[] { jr(Reg::RA), nop(), nop(), nop() };
+	const auto plan = PlanHook(&tooShort[0], Function, Hook, Trampoline);
+	ELFLDR_CHECK_EQ(plan.site, HookSite::Jump);
+	ELFLDR_CHECK_EQ(plan.relocated.error, RelocateError::FunctionTooShort);
+
+	// Splitting a delay slot with the long site too is still refused.
+	constexpr uint32_t splitAtEnd[] { addiu(Reg::SP, Reg::SP, -0x20), beq(Reg::A0, Reg::R0, 0x40), nop(), bne(Reg::A1, Reg::R0, 0x40) };
+	const auto split = PlanHook(&splitAtEnd[0], Function, Hook, Trampoline);
+	ELFLDR_CHECK_EQ(split.site, HookSite::LoadJump);
+	ELFLDR_CHECK_EQ(split.relocated.error, RelocateError::DelaySlotOutside);
+}
+
+static_assert(PlanHook(&plainPrologue[0], Function, Hook, Trampoline).site == HookSite::Jump);
@@ -0,0 +1,190 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Runtime log settings, and how log lines are handed to DebugOut.
+//
+// This links the real Log.cpp, and catches what it writes here instead of
+// taking HostLog.cpp's DebugOut().
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <utils/Log.h>
+#include <utils/Utils.h>
+
+#include "Test.h"
+
+using namespace elfldr;
+using util::LogChannel;
+using util::LogLevel;
+
+namespace {
+
+	struct Line {
+		std::string prefix;
+		const char* format;
+		std::string text;
+	};
+
+	std::vector<Line> gLines;
+
+	bool Enabled(LogChannel channel, LogLevel level) {
+		return util::LogEnabled(channel, level);
+	}
+
+	/**
+	 * Everything on, down to the lowest level compiled in.
+	 */
+	void Reset() {
+		util::LogConfigure("*=trace");
+		gLines.clear();
+	}
+
+	// Trace is compiled out of release builds.
+	constexpr auto LowestLevel = static_cast<LogLevel>(ELFLDR_LOG_MIN_LEVEL);
+
+} // namespace
+
+namespace elfldr::util {
+
+	void DebugOutV(const char* prefix, const char* format, va_list val) {
+		char text[1024];
+		vsnprintf(&text[0], sizeof(text), format, val);
+		gLines.push_back({ prefix, format, text });
+	}
+
+	void DebugOut(const char* format, ...) {
+		va_list val;
+		va_start(val, format);
+		DebugOutV("", format, val);
+		va_end(val);
+	}
+
+} // namespace elfldr::util
+
+ELFLDR_TEST(LevelsAndOff) {
+	Reset();
+	ELFLDR_CHECK(util::LogConfigure("erl=warning"));
+	ELFLDR_CHECK(!Enabled(LogChannel::Erl, LogLevel::Info));
+	ELFLDR_CHECK(Enabled(LogChannel::Erl, LogLevel::Warning));
+	ELFLDR_CHECK(Enabled(LogChannel::Erl, LogLevel::Error));
+
+	// Other channels are left alone.
+	ELFLDR_CHECK(Enabled(LogChannel::Fio, LowestLevel));
+
+	ELFLDR_CHECK(util::LogConfigure("erl=off"));
+	ELFLDR_CHECK(!Enabled(LogChannel::Erl, LogLevel::Error));
+	ELFLDR_CHECK(Enabled(LogChannel::Fio, LogLevel::Error));
+	ELFLDR_CHECK(gLines.empty());
+}
+
+ELFLDR_TEST(Wildcards) {
+	Reset();
+	ELFLDR_CHECK(util::LogConfigure("*=info"));
+	for(uint32_t channel = 0; channel < static_cast<uint32_t>(LogChannel::Count); ++channel) {
+		ELFLDR_CHECK(!Enabled(static_cast<LogChannel>(channel), LogLevel::Debug));
+		ELFLDR_CHECK(Enabled(static_cast<LogChannel>(channel), LogLevel::Info));
+	}
+
+	// Later settings win over earlier ones.
+	ELFLDR_CHECK(util::LogConfigure("*=off,hook=error"));
+	ELFLDR_CHECK(!Enabled(LogChannel::General, LogLevel::Error));
+	ELFLDR_CHECK(Enabled(LogChannel::Hook, LogLevel::Error));
+	ELFLDR_CHECK(!Enabled(LogChannel::Hook, LogLevel::Warning));
+
+	ELFLDR_CHECK(util::LogConfigure("hook=error *=warning"));
+	ELFLDR_CHECK(Enabled(LogChannel::Hook, LogLevel::Warning));
+}
+
+ELFLDR_TEST(CaseIsIgnored) {
+	Reset();
+	ELFLDR_CHECK(util::LogConfigure("ERL=Error, Fio=OFF"));
+	ELFLDR_CHECK(!Enabled(LogChannel::Erl, LogLevel::Warning));
+	ELFLDR_CHECK(Enabled(LogChannel::Erl, LogLevel::Error));
+	ELFLDR_CHECK(!Enabled(LogChannel::Fio, LogLevel::Error));
+}
+
+ELFLDR_TEST(Separators) {
+	Reset();
+	ELFLDR_CHECK(util::LogConfigure("  erl=error,,\tfio=error\r\nhook=error\n"));
+	ELFLDR_CHECK(!Enabled(LogChannel::Erl, LogLevel::Warning));
+	ELFLDR_CHECK(!Enabled(LogChannel::Fio, LogLevel::Warning));
+	ELFLDR_CHECK(!Enabled(LogChannel::Hook, LogLevel::Warning));
+	ELFLDR_CHECK(Enabled(LogChannel::Patch, LogLevel::Warning));
+
+	ELFLDR_CHECK(util::LogConfigure(""));
+	ELFLDR_CHECK(util::LogConfigure(" , "));
+	ELFLDR_CHECK(gLines.empty());
+}
+
+// Bad settings are reported and skipped; the good ones around them still apply.
+ELFLDR_TEST(BadSettings) {
+	Reset();
+	ELFLDR_CHECK(!util::LogConfigure("bogus=info,erl=error,fio=loud,hook,patch=,=info,*=errors"));
+	ELFLDR_CHECK(!Enabled(LogChannel::Erl, LogLevel::Warning));
+	ELFLDR_CHECK(Enabled(LogChannel::Fio, LowestLevel));
+	ELFLDR_CHECK(Enabled(LogChannel::Hook, LowestLevel));
+	ELFLDR_CHECK(Enabled(LogChannel::Patch, LowestLevel));
+
+	const char* bad[] { "bogus=info", "fio=loud", "hook", "patch=", "=info", "*=errors" };
+	ELFLDR_CHECK_EQ(gLines.size(), sizeof(bad) / sizeof(bad[0]));
+	for(size_t i = 0; i < gLines.size() && i < sizeof(bad) / sizeof(bad[0]); ++i)
+		ELFLDR_CHECK(gLines[i].text == std::string("Bad log setting \"") + bad[i] + "\"");
+
+	// A name only matches all of itself.
+	ELFLDR_CHECK(!util::LogConfigure("er=error,erls=error,info=erl"));
+	ELFLDR_CHECK(Enabled(LogChannel::Erl, LogLevel::Error) && !Enabled(LogChannel::Erl, LogLevel::Warning));
+}
+
+ELFLDR_TEST(SetLevelAndDisable) {
+	Reset();
+	util::LogSetLevel(LogChannel::Patch, LogLevel::Warning);
+	ELFLDR_CHECK(!Enabled(LogChannel::Patch, LogLevel::Info));
+	ELFLDR_CHECK(Enabled(LogChannel::Patch, LogLevel::Warning));
+
+	util::LogDisable(LogChannel::Patch);
+	ELFLDR_CHECK(!Enabled(LogChannel::Patch, LogLevel::Error));
+	ELFLDR_CHECK(Enabled(LogChannel::Loader, LogLevel::Error));
+}
+
+// The channel and level go in front, and the caller's format string and
+// arguments are passed straight through, to be formatted once.
+ELFLDR_TEST(LinesAreFormattedOnce) {
+	Reset();
+	constexpr auto format = "Loaded %s at %p (%d bytes)";
+	util::detail::LogWrite(LogChannel::Erl, LogLevel::Warning, format, "test.erl", reinterpret_cast<void*>(0x100000), 1234);
+	util::detail::LogWrite(LogChannel::Fio, LogLevel::Error, "%s", "no");
+	util::detail::LogWrite(LogChannel::Profiler, LogLevel::Info, "%d%%", 50);
+
+	ELFLDR_CHECK_EQ(gLines.size(), 3u);
+	if(gLines.size() != 3)
+		return;
+
+	ELFLDR_CHECK(gLines[0].prefix == "[erl] warning: ");
+	ELFLDR_CHECK(gLines[0].format == format);
+	ELFLDR_CHECK(gLines[0].text == "Loaded test.erl at 0x100000 (1234 bytes)");
+
+	ELFLDR_CHECK(gLines[1].prefix == "[fio] error: ");
+	ELFLDR_CHECK(gLines[1].text == "no");
+
+	ELFLDR_CHECK(gLines[2].prefix == "[profiler] ");
+	ELFLDR_CHECK(gLines[2].text == "50%");
+}
+
+// Long messages aren't cut short on the way to DebugOutV().
+ELFLDR_TEST(LongLines) {
+	Reset();
+	const std::string message(600, 'x');
+	util::detail::LogWrite(LogChannel::General, LogLevel::Info, "%s", message.c_str());
+
+	ELFLDR_CHECK_EQ(gLines.size(), 1u);
+	if(gLines.size() == 1)
+		ELFLDR_CHECK(gLines[0].text == message);
+}
@@ -0,0 +1,144 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The encoders, against machine words from outside of this codebase.
+//
+// MIPS I-III words are what LLVM's assembler (llvm-mc -triple=mips64el
+// -mcpu=mips3 -show-encoding) produces. LLVM doesn't know the R5900,
+// so its words are assembled by hand from the field layouts in the
+// EE Core Instruction Set Manual, and the lq/sq ones are checked against
+// what EE GCC saves and restores ra with.
+
+#include <utils/MipsIDecoder.h>
+#include <utils/MipsIEncoder.h>
+
+#include "Test.h"
+
+using namespace elfldr::util::mips;
+
+ELFLDR_TEST(BasicInstructions) {
+	ELFLDR_CHECK_EQ(nop(), 0x00000000u);
+	ELFLDR_CHECK_EQ(jr(Reg::RA), 0x03e00008u);
+	ELFLDR_CHECK_EQ(jalr(Reg::T9), 0x0320f809u);
+	ELFLDR_CHECK_EQ(addiu(Reg::SP, Reg::SP, -48), 0x27bdffd0u);
+	ELFLDR_CHECK_EQ(lui(Reg::T0, 0x20), 0x3c080020u);
+	ELFLDR_CHECK_EQ(ori(Reg::T0, Reg::T0, 0x8000), 0x35088000u);
+}
+
+ELFLDR_TEST(Jumps) {
+	ELFLDR_CHECK_EQ(j(0x00123450), 0x08048d14u);
+	ELFLDR_CHECK_EQ(jal(0x0023a448), 0x0c08e912u);
+
+	// The checked versions encode the same, from anywhere in the segment.
+	ELFLDR_CHECK_EQ(jTo(0x00100000, 0x00123450), j(0x00123450));
+	ELFLDR_CHECK_EQ(jalTo(0x0ffffff0, 0x0023a448), jal(0x0023a448));
+	static_assert(jTo(0x00100000, 0x00123450) == 0x08048d14);
+}
+
+ELFLDR_TEST(Branches) {
+	ELFLDR_CHECK_EQ(beq(Reg::A0, Reg::R0, 64), 0x10800010u);
+	ELFLDR_CHECK_EQ(bne(Reg::A0, Reg::R0, -256), 0x1480ffc0u);
+	ELFLDR_CHECK_EQ(beql(Reg::A0, Reg::A1, 16), 0x50850004u);
+	ELFLDR_CHECK_EQ(bnel(Reg::V0, Reg::R0, -8), 0x5440fffeu);
+	ELFLDR_CHECK_EQ(bltzl(Reg::A0, 32), 0x04820008u);
+	ELFLDR_CHECK_EQ(bgezl(Reg::A0, 32), 0x04830008u);
+	ELFLDR_CHECK_EQ(b(64), 0x10000010u);
+	ELFLDR_CHECK_EQ(bal(8), 0x04110002u);
+}
+
+ELFLDR_TEST(BranchTargets) {
+	constexpr uint32_t pc = 0x0023a448;
+
+	ELFLDR_CHECK_EQ(branchTo(beq(Reg::A0, Reg::R0, 0), pc, pc + 4 + 64), beq(Reg::A0, Reg::R0, 64));
+	ELFLDR_CHECK_EQ(branchTo(bne(Reg::A0, Reg::R0, 0), pc, pc + 4 - 256), bne(Reg::A0, Reg::R0, -256));
+
+	// The ends of the +-128KB range.
+	ELFLDR_CHECK_EQ(branchOffset(pc, pc + 4 + 0x1fffc), 0x7fffu);
+	ELFLDR_CHECK_EQ(branchOffset(pc, pc + 4 - 0x20000), 0x8000u);
+
+	// Further than an int16 byte offset, which the plain encoders can't do.
+	const auto far = branchTo(b(0), pc, pc + 4 + 0x10000);
+	ELFLDR_CHECK_EQ(far, 0x10004000u);
+	ELFLDR_CHECK_EQ(Decode(far, pc).target, pc + 4 + 0x10000);
+}
+
+ELFLDR_TEST(DoublewordInstructions) {
+	ELFLDR_CHECK_EQ(daddu(Reg::S0, Reg::A0, Reg::R0), 0x0080802du);
+	ELFLDR_CHECK_EQ(dsll(Reg::V0, Reg::V1, 4), 0x00031138u);
+	ELFLDR_CHECK_EQ(dsrl(Reg::V0, Reg::V1, 31), 0x000317fau);
+	ELFLDR_CHECK_EQ(dsll32(Reg::V0, Reg::V1, 0), 0x0003103cu);
+	ELFLDR_CHECK_EQ(dsrl32(Reg::V0, Reg::V1, 16), 0x0003143eu);
+	ELFLDR_CHECK_EQ(ld(Reg::RA, 48, Reg::SP), 0xdfbf0030u);
+	ELFLDR_CHECK_EQ(sd(Reg::S0, -16, Reg::SP), 0xffb0fff0u);
+}
+
+ELFLDR_TEST(Cop0AndSync) {
+	ELFLDR_CHECK_EQ(mfc0(Reg::V0, 9), 0x40024800u); // Count
+	ELFLDR_CHECK_EQ(mtc0(Reg::V0, 12), 0x40826000u); // Status
+	ELFLDR_CHECK_EQ(sync(), 0x0000000fu); // sync.l
+}
+
+ELFLDR_TEST(QuadwordLoadStore) {
+	// sq ra, 0(sp) / lq ra, 0(sp)
+	ELFLDR_CHECK_EQ(sq(Reg::RA, 0, Reg::SP), 0x7fbf0000u);
+	ELFLDR_CHECK_EQ(lq(Reg::RA, 0, Reg::SP), 0x7bbf0000u);
+	ELFLDR_CHECK_EQ(lq(Reg::T0, 16, Reg::A1), 0x78a80010u);
+	ELFLDR_CHECK_EQ(sq(Reg::T0, -32, Reg::A0), 0x7c88ffe0u);
+}
+
+ELFLDR_TEST(MultimediaInstructions) {
+	// 011100 rs rt rd sa funct; MMI0 is funct 001000, MMI2 001001, MMI3 101001.
+	ELFLDR_CHECK_EQ(por(Reg::V0, Reg::A0, Reg::R0), 0x708014a9u); // 128-bit move
+	ELFLDR_CHECK_EQ(pnor(Reg::V0, Reg::A0, Reg::A1), 0x708514e9u);
+	ELFLDR_CHECK_EQ(pextlw(Reg::T0, Reg::A0, Reg::A1), 0x70854488u);
+	ELFLDR_CHECK_EQ(paddw(Reg::V0, Reg::A0, Reg::A1), 0x70851008u);
+	ELFLDR_CHECK_EQ(psubw(Reg::V0, Reg::A0, Reg::A1), 0x70851048u);
+	ELFLDR_CHECK_EQ(pand(Reg::V0, Reg::A0, Reg::A1), 0x70851489u);
+	ELFLDR_CHECK_EQ(pxor(Reg::V0, Reg::A0, Reg::A1), 0x708514c9u);
+	ELFLDR_CHECK_EQ(pcpyld(Reg::V0, Reg::A0, Reg::A1), 0x70851389u);
+	ELFLDR_CHECK_EQ(pcpyud(Reg::V0, Reg::A0, Reg::A1), 0x708513a9u);
+	ELFLDR_CHECK_EQ(pmfhi(Reg::V0), 0x70001209u);
+	ELFLDR_CHECK_EQ(pmflo(Reg::V0), 0x70001249u);
+	ELFLDR_CHECK_EQ(pmthi(Reg::A0), 0x70800229u);
+	ELFLDR_CHECK_EQ(pmtlo(Reg::A0), 0x70800269u);
+	ELFLDR_CHECK_EQ(plzcw(Reg::V0, Reg::A0), 0x70801004u);
+}
+
+ELFLDR_TEST(Pipeline1MultiplyDivide) {
+	ELFLDR_CHECK_EQ(mult1(Reg::V0, Reg::A0, Reg::A1), 0x70851018u);
+	ELFLDR_CHECK_EQ(multu1(Reg::V0, Reg::A0, Reg::A1), 0x70851019u);
+	ELFLDR_CHECK_EQ(div1(Reg::A0, Reg::A1), 0x7085001au);
+	ELFLDR_CHECK_EQ(divu1(Reg::A0, Reg::A1), 0x7085001bu);
+	ELFLDR_CHECK_EQ(mfhi1(Reg::V0), 0x70001010u);
+	ELFLDR_CHECK_EQ(mthi1(Reg::A0), 0x70800011u);
+	ELFLDR_CHECK_EQ(mflo1(Reg::V0), 0x70001012u);
+	ELFLDR_CHECK_EQ(mtlo1(Reg::A0), 0x70800013u);
+}
+
+ELFLDR_TEST(ShiftAmountRegister) {
+	ELFLDR_CHECK_EQ(mfsa(Reg::V0), 0x00001028u);
+	ELFLDR_CHECK_EQ(mtsa(Reg::A0), 0x00800029u);
+}
+
+// Generated sequences: a quadword memcpy loop body, like fast replacement routines use.
+ELFLDR_TEST(QuadwordCopySequence) {
+	const uint32_t loop[] {
+		lq(Reg::T0, 0, Reg::A1),
+		addiu(Reg::A2, Reg::A2, -16),
+		addiu(Reg::A1, Reg::A1, 16),
+		sq(Reg::T0, 0, Reg::A0),
+		bne(Reg::A2, Reg::R0, -20),
+		addiu(Reg::A0, Reg::A0, 16)
+	};
+
+	const uint32_t expected[] { 0x78a80000, 0x24c6fff0, 0x24a50010, 0x7c880000, 0x14c0fffb, 0x24840010 };
+	for(uint32_t i = 0; i < 6; ++i)
+		ELFLDR_CHECK_EQ(loop[i], expected[i]);
+
+	// The branch goes back to the lq.
+	ELFLDR_CHECK_EQ(Decode(loop[4], 0x00100010).target, 0x00100000u);
+}
@@ -0,0 +1,366 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Setting up the mods on the game's first open.
+//
+// The game's file functions are stand-ins which go to MockFio. Their
+// symbols point at dispatchers, which call the hook on a function when
+// there is one (like the patched function would), and the function itself
+// when there isn't. Hooking returns the function itself, as the trampoline.
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <utils/FileTrace.h>
+#include <utils/FioBackend.h>
+#include <utils/GameVersion.h>
+#include <utils/Hook.h>
+#include <utils/ModFiles.h>
+#include <utils/PackFormat.h>
+#include <utils/SymbolDb.h>
+
+#include "MockFio.h"
+#include "MockKernel.h"
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr int PackFdBase = 0x7000;
+
+	// Sony's values.
+	constexpr int SceReadOnly = 0x0001;
+
+	std::map<std::string, uintptr_t> gSymbols;
+	std::map<uintptr_t, const void*> gHooks;
+
+	struct GameCalls {
+		uint32_t opens;
+		uint32_t reads;
+	} gCalls;
+
+	int GameOpen(const char* path, int flags, int) {
+		++gCalls.opens;
+		return test::MockFio::Backend().open(path, flags);
+	}
+
+	int GameClose(int fd) {
+		return test::MockFio::Backend().close(fd);
+	}
+
+	int GameRead(int fd, void* buffer, int length) {
+		++gCalls.reads;
+		return test::MockFio::Backend().read(fd, buffer, length);
+	}
+
+	int GameWrite(int fd, const void* buffer, int length) {
+		return test::MockFio::Backend().write(fd, buffer, length);
+	}
+
+	int GameLseek(int fd, int offset, int whence) {
+		return test::MockFio::Backend().lseek(fd, offset, whence);
+	}
+
+	int GameDopen(const char* path) {
+		return test::MockFio::Backend().dopen(path);
+	}
+
+	int GameDclose(int fd) {
+		return test::MockFio::Backend().dclose(fd);
+	}
+
+	int GameDread(int fd, io_dirent_t* entry) {
+		return test::MockFio::Backend().dread(fd, entry);
+	}
+
+	/**
+	 * Call the hook on a game function if it has one, or the function itself.
+	 */
+	template <class... Args>
+	int CallGame(int (*function)(Args...), void* self, Args... args) {
+		auto it = gHooks.find(reinterpret_cast<uintptr_t>(self));
+		if(it == gHooks.end())
+			return function(args...);
+		return reinterpret_cast<int (*)(Args...)>(const_cast<void*>(it->second))(args...);
+	}
+
+	// The game's functions, as the game (and the loader) calls them.
+	int SceOpen(const char* path, int flags, int mode) {
+		return CallGame(GameOpen, reinterpret_cast<void*>(SceOpen), path, flags, mode);
+	}
+
+	int SceClose(int fd) {
+		return CallGame(GameClose, reinterpret_cast<void*>(SceClose), fd);
+	}
+
+	int SceRead(int fd, void* buffer, int length) {
+		return CallGame(GameRead, reinterpret_cast<void*>(SceRead), fd, buffer, length);
+	}
+
+	int SceWrite(int fd, const void* buffer, int length) {
+		return CallGame(GameWrite, reinterpret_cast<void*>(SceWrite), fd, buffer, length);
+	}
+
+	int SceLseek(int fd, int offset, int whence) {
+		return CallGame(GameLseek, reinterpret_cast<void*>(SceLseek), fd, offset, whence);
+	}
+
+	int SceDopen(const char* path) {
+		return CallGame(GameDopen, reinterpret_cast<void*>(SceDopen), path);
+	}
+
+	int SceDclose(int fd) {
+		return CallGame(GameDclose, reinterpret_cast<void*>(SceDclose), fd);
+	}
+
+	int SceDread(int fd, io_dirent_t* entry) {
+		return CallGame(GameDread, reinterpret_cast<void*>(SceDread), fd, entry);
+	}
+
+	template <class T>
+	uintptr_t Address(T* function) {
+		return reinterpret_cast<uintptr_t>(function);
+	}
+
+	std::vector<uint8_t> Bytes(uint32_t size, uint8_t seed) {
+		std::vector<uint8_t> bytes(size);
+		for(uint32_t i = 0; i < size; ++i)
+			bytes[i] = static_cast<uint8_t>(seed + i * 7);
+		return bytes;
+	}
+
+	std::vector<uint8_t> Text(const std::string& text) {
+		return { text.begin(), text.end() };
+	}
+
+	/**
+	 * A pack of one file, like modpack makes.
+	 */
+	std::vector<uint8_t> MakePack(const std::string& path, const std::vector<uint8_t>& data) {
+		const util::PackHeader header { util::PackHeader::Magic, util::PackHeader::CurrentVersion, 1, static_cast<uint32_t>(sizeof(util::PackEntry) + path.size() + 1) };
+		const auto offset = util::PackAlign(sizeof(header) + header.tocSize);
+		const util::PackEntry entry { util::PathHash(path.data(), path.size()), 0, offset, static_cast<uint32_t>(data.size()) };
+
+		std::vector<uint8_t> pack(util::PackAlign(offset + data.size()));
+		memcpy(&pack[0], &header, sizeof(header));
+		memcpy(&pack[sizeof(header)], &entry, sizeof(entry));
+		memcpy(&pack[sizeof(header) + sizeof(entry)], path.c_str(), path.size() + 1);
+		std::copy(data.begin(), data.end(), pack.begin() + offset);
+		return pack;
+	}
+
+	/**
+	 * A game with a loose mod (host:mods/loose) and a pack (host:mods/base.pak) listed.
+	 */
+	struct Fixture {
+		test::MockFio fio;
+
+		Fixture() {
+			test::ResetSemaphores();
+			gHooks.clear();
+			gCalls = {};
+			gSymbols = {
+				{ "sceOpen", Address(SceOpen) },
+				{ "sceClose", Address(SceClose) },
+				{ "sceRead", Address(SceRead) },
+				{ "sceWrite", Address(SceWrite) },
+				{ "sceLseek", Address(SceLseek) },
+				{ "sceDopen", Address(SceDopen) },
+				{ "sceDclose", Address(SceDclose) },
+				{ "sceDread", Address(SceDread) }
+			};
+
+			fio.AddFile("host:mods.txt", Text("loose\nbase.pak\n"));
+			fio.AddFile("host:data/a.txt", Bytes(4, 1));
+			fio.AddFile("host:mods/loose/data/a.txt", Bytes(6, 2));
+			fio.AddFile("host:mods/base.pak", MakePack("data/b.txt", Bytes(10, 3)));
+		}
+
+		~Fixture() {
+			util::RemoveModFiles();
+		}
+	};
+
+} // namespace
+
+// What the mod setup needs from the rest of the loader.
+namespace elfldr::util {
+
+	namespace detail {
+
+		void* HookFunctionBase(void* dest, const void* hook) {
+			const auto address = reinterpret_cast<uintptr_t>(dest);
+			gHooks[address] = hook;
+
+			if(address == Address(SceOpen))
+				return reinterpret_cast<void*>(GameOpen);
+			if(address == Address(SceClose))
+				return reinterpret_cast<void*>(GameClose);
+			if(address == Address(SceRead))
+				return reinterpret_cast<void*>(GameRead);
+			if(address == Address(SceLseek))
+				return reinterpret_cast<void*>(GameLseek);
+			return nullptr;
+		}
+
+	} // namespace detail
+
+	bool UnhookFunction(void* funcptr) {
+		return gHooks.erase(reinterpret_cast<uintptr_t>(funcptr)) != 0;
+	}
+
+	void BeginHookBatch() {
+	}
+
+	void EndHookBatch() {
+	}
+
+	uintptr_t FindSymbol(uint32_t hash) {
+		for(const auto& [name, address] : gSymbols)
+			if(SymbolHash(name.c_str()) == hash)
+				return address;
+		return 0;
+	}
+
+	GameVersionData& GetGameVersionData() {
+		static GameVersionData data {};
+		return data;
+	}
+
+	mlstd::StringView GameVersionData::GameID() const {
+		return "test";
+	}
+
+} // namespace elfldr::util
+
+// Before the game runs, its file functions don't work yet.
+ELFLDR_TEST(NothingIsReadUntilTheFirstOpen) {
+	Fixture fixture;
+	ELFLDR_CHECK(util::InstallModFiles());
+	ELFLDR_CHECK_EQ(gHooks.size(), 1u);
+	ELFLDR_CHECK(gHooks.count(Address(SceOpen)) == 1);
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 0u);
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+}
+
+ELFLDR_TEST(FirstOpenLoadsTheMods) {
+	Fixture fixture;
+	util::InstallModFiles();
+
+	uint8_t buffer[32];
+	const auto fd = SceOpen("host:DATA\\A.TXT", SceReadOnly, 0);
+	ELFLDR_CHECK(fd >= 0 && fd < PackFdBase);
+	ELFLDR_CHECK_EQ(gHooks.size(), 4u);
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 1u);
+	ELFLDR_CHECK(!test::AnySemaphoreTaken());
+
+	// The first open itself gets the mod's copy.
+	ELFLDR_CHECK_EQ(SceRead(fd, &buffer[0], sizeof(buffer)), 6);
+	ELFLDR_CHECK(!memcmp(&buffer[0], Bytes(6, 2).data(), 6));
+	ELFLDR_CHECK_EQ(SceClose(fd), 0);
+
+	// Packed files are served without opening them.
+	const auto opens = gCalls.opens;
+	const auto packed = SceOpen("host:DATA\\B.TXT", SceReadOnly, 0);
+	ELFLDR_CHECK_EQ(packed, PackFdBase);
+	ELFLDR_CHECK_EQ(gCalls.opens, opens);
+	ELFLDR_CHECK_EQ(SceRead(packed, &buffer[0], sizeof(buffer)), 10);
+	ELFLDR_CHECK(!memcmp(&buffer[0], Bytes(10, 3).data(), 10));
+	ELFLDR_CHECK_EQ(SceClose(packed), 0);
+}
+
+ELFLDR_TEST(NoModsNoHooks) {
+	Fixture fixture;
+	fixture.fio.AddFile("host:mods.txt", Text("# nothing yet\n"));
+	util::InstallModFiles();
+
+	const auto fd = SceOpen("host:data/a.txt", SceReadOnly, 0);
+	ELFLDR_CHECK(fd >= 0);
+	ELFLDR_CHECK(gHooks.empty());
+
+	uint8_t buffer[8];
+	ELFLDR_CHECK_EQ(SceRead(fd, &buffer[0], sizeof(buffer)), 4);
+	ELFLDR_CHECK_EQ(SceClose(fd), 0);
+}
+
+ELFLDR_TEST(EmptyModListNoHooks) {
+	Fixture fixture;
+	fixture.fio.AddFile("host:mods.txt", {});
+	util::InstallModFiles();
+
+	ELFLDR_CHECK(SceOpen("host:data/a.txt", SceReadOnly, 0) >= 0);
+	ELFLDR_CHECK(gHooks.empty());
+}
+
+ELFLDR_TEST(NeedsSceOpen) {
+	Fixture fixture;
+	gSymbols.erase("sceOpen");
+	ELFLDR_CHECK(!util::InstallModFiles());
+	ELFLDR_CHECK(gHooks.empty());
+}
+
+ELFLDR_TEST(RemoveBeforeTheFirstOpen) {
+	Fixture fixture;
+	util::InstallModFiles();
+	util::RemoveModFiles();
+	ELFLDR_CHECK(gHooks.empty());
+
+	// The game's open is its own again.
+	ELFLDR_CHECK(SceOpen("host:data/a.txt", SceReadOnly, 0) >= 0);
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 1u);
+}
+
+ELFLDR_TEST(RemoveAfterTheFirstOpen) {
+	Fixture fixture;
+	util::InstallModFiles();
+	SceClose(SceOpen("host:data/a.txt", SceReadOnly, 0));
+
+	util::RemoveModFiles();
+	ELFLDR_CHECK(gHooks.empty());
+	ELFLDR_CHECK_EQ(test::LiveSemaphores(), 0u);
+
+	// And it can be installed again.
+	ELFLDR_CHECK(util::InstallModFiles());
+	ELFLDR_CHECK_EQ(gHooks.size(), 1u);
+}
+
+// host:filetrace.txt turns the trace on, even without mods.
+ELFLDR_TEST(TraceWithoutMods) {
+	Fixture fixture;
+	fixture.fio.AddFile("host:mods.txt", {});
+	fixture.fio.AddFile("host:filetrace.txt", {});
+	util::InstallModFiles();
+	ELFLDR_CHECK(!util::FileTraceEnabled());
+
+	uint8_t buffer[8];
+	const auto fd = SceOpen("host:data/a.txt", SceReadOnly, 0);
+	ELFLDR_CHECK(util::FileTraceEnabled());
+	ELFLDR_CHECK_EQ(gHooks.size(), 4u);
+	ELFLDR_CHECK_EQ(SceRead(fd, &buffer[0], sizeof(buffer)), 4);
+	ELFLDR_CHECK_EQ(SceClose(fd), 0);
+
+	// Removing it all writes the trace, with the game's functions.
+	util::RemoveModFiles();
+	ELFLDR_CHECK(!util::FileTraceEnabled());
+	const auto* trace = fixture.fio.File("host:filetrace.bin");
+	ELFLDR_CHECK(trace && trace->size() > sizeof(util::FileTraceChunkHeader));
+}
+
+ELFLDR_TEST(NoTraceUnlessAskedFor) {
+	Fixture fixture;
+	util::InstallModFiles();
+	SceClose(SceOpen("host:DATA\\A.TXT", SceReadOnly, 0));
+	ELFLDR_CHECK(!util::FileTraceEnabled());
+
+	util::RemoveModFiles();
+	ELFLDR_CHECK(!fixture.fio.File("host:filetrace.bin"));
+}
@@ -0,0 +1,245 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <utils/DirectoryIndex.h>
+#include <utils/OverlayFs.h>
+
+#include "Test.h"
+
+using namespace elfldr;
+using util::DirectoryIndex;
+using util::OverlayFs;
+
+namespace {
+
+	constexpr uint8_t Directory = DirectoryIndex::Entry::DirectoryFlag;
+
+	struct Index {
+		DirectoryIndex::Entry slots[64] {};
+		char strings[4096] {};
+		DirectoryIndex index { slots, strings };
+	};
+
+	/**
+	 * Two mods, as AddRoot() would have indexed them: foo, then bar.
+	 */
+	struct Mods : Index {
+		uint32_t foo;
+		uint32_t bar;
+
+		Mods() {
+			foo = index.AddEmptyRoot("host:mods/foo");
+			index.Insert(foo, "data", 0, Directory);
+			index.Insert(foo, "data/A.big", 9, 0);
+			index.Insert(foo, "data/only_foo.txt", 1, 0);
+			index.Insert(foo, "data/models", 0, Directory);
+			index.Insert(foo, "data/models/alaska.big", 9, 0);
+
+			bar = index.AddEmptyRoot("host:mods/bar/");
+			index.Insert(bar, "DATA", 0, Directory);
+			index.Insert(bar, "DATA/a.BIG", 10, 0);
+			index.Insert(bar, "DATA/only_bar.txt", 2, 0);
+		}
+	};
+
+	bool Resolves(const OverlayFs& overlay, const char* path, const char* expected) {
+		char out[util::MaxPath];
+		return overlay.Resolve(path, &out[0], sizeof(out)) && !strcmp(&out[0], expected);
+	}
+
+} // namespace
+
+ELFLDR_TEST(IndexInsertAndFind) {
+	Index index;
+	const auto root = index.index.AddEmptyRoot("host:");
+	ELFLDR_CHECK_EQ(root, 0u);
+	ELFLDR_CHECK_EQ(index.index.RootCount(), 1u);
+
+	ELFLDR_CHECK(index.index.Insert(root, "data/Models/Board.SSH", 77, 0));
+	ELFLDR_CHECK(index.index.Insert(root, "data/Models", 0, Directory));
+
+	// Again, differently spelled: it's the same file, so it's left alone.
+	ELFLDR_CHECK(index.index.Insert(root, "DATA\\MODELS\\BOARD.SSH", 1, 0));
+	ELFLDR_CHECK_EQ(index.index.Count(), 2u);
+
+	ELFLDR_CHECK_EQ(index.index.Size(root, "data\\models\\board.ssh"), 77);
+	ELFLDR_CHECK_EQ(index.index.Size(root, "/data/models/board.ssh"), 77);
+	ELFLDR_CHECK(!strcmp(index.index.Find(root, "DATA/MODELS/BOARD.SSH")->path, "data/Models/Board.SSH"));
+	ELFLDR_CHECK(index.index.Find(root, "data/models")->Directory());
+	ELFLDR_CHECK_EQ(index.index.Size(root, "data/models/other.ssh"), -1);
+
+	// Roots are separate.
+	const auto other = index.index.AddEmptyRoot("host:mods/foo");
+	ELFLDR_CHECK_EQ(other, 1u);
+	ELFLDR_CHECK(!index.index.Exists(other, "data/models/board.ssh"));
+	ELFLDR_CHECK(!strcmp(index.index.RootPath(other), "host:mods/foo"));
+}
+
+ELFLDR_TEST(IndexFull) {
+	DirectoryIndex::Entry slots[4] {};
+	char strings[64] {};
+	DirectoryIndex index { slots, strings };
+	const auto root = index.AddEmptyRoot("host:");
+
+	// At most 3/4 of the slots are used.
+	ELFLDR_CHECK(index.Insert(root, "a", 0, 0));
+	ELFLDR_CHECK(index.Insert(root, "b", 0, 0));
+	ELFLDR_CHECK(index.Insert(root, "c", 0, 0));
+	ELFLDR_CHECK(!index.Insert(root, "d", 0, 0));
+	ELFLDR_CHECK(index.Exists(root, "c"));
+
+	// Out of room for strings.
+	char bigStrings[8] {};
+	DirectoryIndex small { slots, bigStrings };
+	ELFLDR_CHECK_EQ(small.AddEmptyRoot("host:mods/foo"), DirectoryIndex::NoRoot);
+	ELFLDR_CHECK_EQ(small.RootCount(), 0u);
+
+	for(uint32_t i = 0; i < DirectoryIndex::MaxRoots; ++i)
+		index.AddEmptyRoot("");
+	ELFLDR_CHECK_EQ(index.AddEmptyRoot(""), DirectoryIndex::NoRoot);
+}
+
+ELFLDR_TEST(EarlierRootsWin) {
+	Mods mods;
+	OverlayFs overlay;
+	const uint32_t roots[] { mods.bar, mods.foo };
+	ELFLDR_CHECK(overlay.Build(mods.index, roots));
+
+	// Directories aren't overridden.
+	ELFLDR_CHECK_EQ(overlay.Count(), 4u);
+	ELFLDR_CHECK_EQ(overlay.RootCount(), 2u);
+	ELFLDR_CHECK(!strcmp(overlay.RootPath(0), "host:mods/bar/"));
+
+	ELFLDR_CHECK(Resolves(overlay, "host:data\\a.big", "host:mods/bar/DATA/a.BIG"));
+	ELFLDR_CHECK(Resolves(overlay, "host:data/only_foo.txt", "host:mods/foo/data/only_foo.txt"));
+	ELFLDR_CHECK(Resolves(overlay, "host:data/only_bar.txt", "host:mods/bar/DATA/only_bar.txt"));
+	ELFLDR_CHECK(!Resolves(overlay, "host:data/models", "host:mods/foo/data/models"));
+
+	// The other way around.
+	const uint32_t reversed[] { mods.foo, mods.bar };
+	ELFLDR_CHECK(overlay.Build(mods.index, reversed));
+	ELFLDR_CHECK(Resolves(overlay, "host:data\\a.big", "host:mods/foo/data/A.big"));
+	ELFLDR_CHECK(Resolves(overlay, "host:data/only_bar.txt", "host:mods/bar/DATA/only_bar.txt"));
+}
+
+ELFLDR_TEST(OnlyListedRoots) {
+	Mods mods;
+	OverlayFs overlay;
+
+	// A root listed twice only counts the first time; roots which don't exist are skipped.
+	const uint32_t roots[] { mods.foo, 7, mods.foo };
+	ELFLDR_CHECK(overlay.Build(mods.index, roots));
+	ELFLDR_CHECK_EQ(overlay.RootCount(), 1u);
+	ELFLDR_CHECK_EQ(overlay.Count(), 3u);
+	ELFLDR_CHECK(!Resolves(overlay, "host:data/only_bar.txt", "host:mods/bar/DATA/only_bar.txt"));
+}
+
+ELFLDR_TEST(PathFolding) {
+	Mods mods;
+	OverlayFs overlay;
+	const uint32_t roots[] { mods.foo, mods.bar };
+	overlay.Build(mods.index, roots);
+
+	// Case, separators, leading separators, and however the host device is spelled.
+	ELFLDR_CHECK(Resolves(overlay, "host0:\\DATA\\MODELS\\ALASKA.BIG", "host:mods/foo/data/models/alaska.big"));
+	ELFLDR_CHECK(Resolves(overlay, "host:/Data/Models/Alaska.big", "host:mods/foo/data/models/alaska.big"));
+	ELFLDR_CHECK(Resolves(overlay, "data/models/alaska.big", "host:mods/foo/data/models/alaska.big"));
+	ELFLDR_CHECK(Resolves(overlay, "\\data\\a.big", "host:mods/foo/data/A.big"));
+}
+
+ELFLDR_TEST(OtherDevicesAreLeftAlone) {
+	Mods mods;
+	OverlayFs overlay;
+	const uint32_t roots[] { mods.foo, mods.bar };
+	overlay.Build(mods.index, roots);
+
+	char out[util::MaxPath];
+	ELFLDR_CHECK(!overlay.Resolve("cdrom0:\\DATA\\A.BIG;1", &out[0], sizeof(out)));
+	ELFLDR_CHECK(!overlay.Resolve("mc0:data/a.big", &out[0], sizeof(out)));
+	ELFLDR_CHECK(!overlay.Resolve("host:data/b.big", &out[0], sizeof(out)));
+	ELFLDR_CHECK(overlay.Find("cdrom0:\\DATA\\A.BIG;1") == nullptr);
+}
+
+ELFLDR_TEST(ResolveOutTooSmall) {
+	Mods mods;
+	OverlayFs overlay;
+	const uint32_t roots[] { mods.foo };
+	overlay.Build(mods.index, roots);
+
+	// "host:mods/foo/data/A.big" is 24 characters.
+	char out[25];
+	ELFLDR_CHECK(!overlay.Resolve("host:data/a.big", &out[0], 24));
+	ELFLDR_CHECK(overlay.Resolve("host:data/a.big", &out[0], 25));
+	ELFLDR_CHECK(!strcmp(&out[0], "host:mods/foo/data/A.big"));
+}
+
+ELFLDR_TEST(MissesAndStats) {
+	// Enough files for the bloom filter to let some misses through.
+	static DirectoryIndex::Entry slots[2048];
+	static char strings[32 * 1024];
+	DirectoryIndex index { slots, strings };
+	const auto root = index.AddEmptyRoot("host:mods/big");
+
+	char path[40];
+	for(uint32_t i = 0; i < 1000; ++i) {
+		snprintf(&path[0], sizeof(path), "data/file%u.big", i);
+		index.Insert(root, &path[0], 0, 0);
+	}
+
+	OverlayFs overlay;
+	const uint32_t roots[] { root };
+	ELFLDR_CHECK(overlay.Build(index, roots));
+	ELFLDR_CHECK_EQ(overlay.Count(), 1000u);
+
+	char out[util::MaxPath];
+	char pastFilter[40] {};
+
+	constexpr uint32_t Misses = 10000;
+	for(uint32_t i = 0; i < Misses; ++i) {
+		snprintf(&path[0], sizeof(path), "host:data/miss%u.big", i);
+		const auto tableLookups = overlay.GetStats().tableLookups;
+		ELFLDR_CHECK(!overlay.Resolve(&path[0], &out[0], sizeof(out)));
+		if(pastFilter[0] == '\0' && overlay.GetStats().tableLookups != tableLookups)
+			strcpy(&pastFilter[0], &path[0]);
+	}
+
+	// Most misses stop at the bloom filter; well under 1% get through.
+	const auto stats = overlay.GetStats();
+	ELFLDR_CHECK_EQ(stats.lookups, Misses);
+	ELFLDR_CHECK_EQ(stats.found, 0u);
+	ELFLDR_CHECK_EQ(stats.bloomRejects + stats.negativeCacheHits + stats.tableLookups, Misses);
+	ELFLDR_CHECK(stats.tableLookups != 0);
+	ELFLDR_CHECK(stats.tableLookups < Misses / 100);
+
+	// A recent miss which got past the filter doesn't go to the table again.
+	// (It's been pushed out of the cache by now, so the first lookup puts it back.)
+	overlay.Resolve(&pastFilter[0], &out[0], sizeof(out));
+	overlay.Resolve(&pastFilter[0], &out[0], sizeof(out));
+	ELFLDR_CHECK_EQ(overlay.GetStats().negativeCacheHits, stats.negativeCacheHits + 1);
+
+	ELFLDR_CHECK(Resolves(overlay, "host:data/file999.big", "host:mods/big/data/file999.big"));
+	ELFLDR_CHECK_EQ(overlay.GetStats().found, 1u);
+}
+
+ELFLDR_TEST(ClearAndEmpty) {
+	Mods mods;
+	OverlayFs overlay;
+	const uint32_t roots[] { mods.foo };
+	overlay.Build(mods.index, roots);
+	overlay.Clear();
+
+	ELFLDR_CHECK_EQ(overlay.Count(), 0u);
+	ELFLDR_CHECK(overlay.Find("host:data/a.big") == nullptr);
+
+	// An overlay of nothing works, and finds nothing.
+	Index empty;
+	ELFLDR_CHECK(overlay.Build(empty.index, {}));
+	ELFLDR_CHECK(overlay.Find("host:data/a.big") == nullptr);
+}
@@ -0,0 +1,122 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <string.h>
+
+#include <utils/PatchTable.h>
+
+#include "HostFSTable.h"
+#include "MemoryClearTable.h"
+#include "Test.h"
+
+using namespace elfldr;
+using namespace elfldr::util::patch;
+
+namespace {
+
+	constexpr uint32_t ImageAddress = 0x00100000;
+
+	// A fake game image with some known bytes in it.
+	struct Image {
+		uint8_t bytes[0x100] {};
+
+		Image() {
+			memcpy(&bytes[0x10], "cd:\0\xaa", 5);
+			bytes[0x20] = 0x06;
+			const uint32_t word = 0x24060006; // li a2, 6
+			memcpy(&bytes[0x30], &word, sizeof(word));
+		}
+
+		uint32_t Digest(uint32_t offset, uint32_t size) const {
+			return util::PatchDigest(&bytes[offset], size);
+		}
+
+		uint32_t Verify(const util::PatchRecord* records, uint32_t count) const {
+			return util::VerifyPatchRecords(records, count, &bytes[0], ImageAddress);
+		}
+	};
+
+} // namespace
+
+ELFLDR_TEST(DigestOfUnalignedRangeMatchesAligned) {
+	alignas(4) uint8_t aligned[11] { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	alignas(4) uint8_t unaligned[12] { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+	ELFLDR_CHECK_EQ(util::PatchDigest(&unaligned[1], 11), util::PatchDigest(&aligned[0], 11));
+	ELFLDR_CHECK(util::PatchDigest(&aligned[0], 11) != util::PatchDigest(&aligned[0], 10));
+}
+
+ELFLDR_TEST(VerifyAcceptsMatchingRecords) {
+	Image image;
+	const util::PatchRecord records[] {
+		Replace(ImageAddress + 0x10, "host").Expect(image.Digest(0x10, 5)),
+		Byte(ImageAddress + 0x20, 4).Expect(image.Digest(0x20, 1)),
+		Word(ImageAddress + 0x30, 0x24060004).Expect(image.Digest(0x30, 4)),
+		Nop(ImageAddress + 0x40, 2) // no digest
+	};
+
+	ELFLDR_CHECK_EQ(image.Verify(&records[0], 4), 4u);
+}
+
+ELFLDR_TEST(VerifyFindsFirstMismatch) {
+	Image image;
+	const util::PatchRecord records[] {
+		Byte(ImageAddress + 0x20, 4).Expect(image.Digest(0x20, 1)),
+		Word(ImageAddress + 0x30, 0).Expect(image.Digest(0x30, 4) ^ 1),
+		Word(ImageAddress + 0x34, 0).Expect(0)
+	};
+
+	ELFLDR_CHECK_EQ(image.Verify(&records[0], 3), 1u);
+}
+
+ELFLDR_TEST(PartialDigestOnlyCoversItsPrefix) {
+	Image image;
+
+	// "host" writes 5 bytes, but only the 4 of "cd:" are known.
+	const auto record = Replace(ImageAddress + 0x10, "host").Expect(image.Digest(0x10, 4), 4);
+	ELFLDR_CHECK_EQ(util::PatchRecordSize(record), 5u);
+	ELFLDR_CHECK_EQ(util::PatchRecordDigestSize(record), 4u);
+	ELFLDR_CHECK_EQ(image.Verify(&record, 1), 1u);
+
+	image.bytes[0x14] = 0x55;
+	ELFLDR_CHECK_EQ(image.Verify(&record, 1), 1u);
+
+	image.bytes[0x12] = 'x';
+	ELFLDR_CHECK_EQ(image.Verify(&record, 1), 0u);
+}
+
+// The digests in the tables are for the original bytes their comments describe.
+ELFLDR_TEST(TableDigestsMatchKnownOriginalBytes) {
+	const auto& records = patches::hostfs::SSXOG_NTSC_10;
+
+	ELFLDR_CHECK_EQ(records[0].address, 0x002c4e70u);
+	ELFLDR_CHECK_EQ(records[0].digest, util::PatchDigest("cd:", 4));
+	ELFLDR_CHECK_EQ(util::PatchRecordDigestSize(records[0]), 4u);
+
+	const uint8_t six = 6;
+	ELFLDR_CHECK_EQ(records[1].address, 0x00238550u);
+	ELFLDR_CHECK_EQ(records[1].digest, util::PatchDigest(&six, 1));
+
+	const auto& ssx3 = patches::hostfs::SSX3_NTSC_10[2];
+	ELFLDR_CHECK_EQ(ssx3.address, 0x004a3ea0u);
+	ELFLDR_CHECK_EQ(ssx3.digest, util::PatchDigest(";", 1));
+}
+
+ELFLDR_TEST(TableDigestsFitTheirRecords) {
+	auto check = [](const util::PatchTable* tables, uint32_t count) {
+		for(uint32_t i = 0; i < count; ++i)
+			for(uint32_t j = 0; j < tables[i].recordCount; ++j) {
+				const auto& record = tables[i].records[j];
+				ELFLDR_CHECK(util::PatchRecordDigestSize(record) <= util::PatchRecordSize(record));
+				if(!(record.flags & util::PatchFlag_HasDigest))
+					ELFLDR_CHECK_EQ(record.digestSize, 0u);
+			}
+	};
+
+	check(&patches::HostFsTables[0], sizeof(patches::HostFsTables) / sizeof(patches::HostFsTables[0]));
+	check(&patches::MemoryClearTables[0], sizeof(patches::MemoryClearTables) / sizeof(patches::MemoryClearTables[0]));
+}
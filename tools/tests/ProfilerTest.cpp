@@ -0,0 +1,283 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The profile report, and getting it out of the game.
+//
+// Calls are recorded with a simulated cycle counter. The profile table is
+// the test's own, and the game's file functions and scePadRead are
+// stand-ins: the file functions go to MockFio, and the pad reads whatever
+// the test has "held".
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <utils/FioBackend.h>
+#include <utils/GameVersion.h>
+#include <utils/Hook.h>
+#include <utils/Profiler.h>
+#include <utils/SymbolDb.h>
+
+#include "MockFio.h"
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	constexpr auto ProfilePath = "host:profile.txt";
+
+	// Where scePadRead "is". It's only ever called through the hook.
+	constexpr uintptr_t PadReadAddress = 0x00100300;
+
+	// Select, L3 and R3, as held buttons.
+	constexpr uint16_t DumpCombo = 0x0007;
+
+	std::map<std::string, uintptr_t> gSymbols;
+	std::map<uintptr_t, const void*> gHooks;
+
+	std::vector<util::ProfileEntry> gEntries;
+
+	uint16_t gHeldButtons = 0;
+
+	int GameOpen(const char* path, int flags, int) {
+		return test::MockFio::Backend().open(path, flags);
+	}
+
+	int GameWrite(int fd, const void* buffer, int length) {
+		return test::MockFio::Backend().write(fd, buffer, length);
+	}
+
+	int GameClose(int fd) {
+		return test::MockFio::Backend().close(fd);
+	}
+
+	int GamePadRead(int, int, uint8_t* data) {
+		const auto buttons = static_cast<uint16_t>(~gHeldButtons);
+		data[0] = 0;
+		data[1] = 0x73;
+		data[2] = static_cast<uint8_t>(buttons);
+		data[3] = static_cast<uint8_t>(buttons >> 8);
+		return 1;
+	}
+
+	/**
+	 * A frame of the game reading the first pad, through the hook.
+	 */
+	void ReadPad(uint16_t held) {
+		gHeldButtons = held;
+		uint8_t data[32] {};
+		auto it = gHooks.find(PadReadAddress);
+		if(it != gHooks.end())
+			reinterpret_cast<int (*)(int, int, uint8_t*)>(const_cast<void*>(it->second))(0, 0, &data[0]);
+	}
+
+	/**
+	 * A profiled function, with calls taking these many cycles.
+	 */
+	util::ProfileEntry Entry(const char* name, const std::vector<uint32_t>& calls) {
+		util::ProfileEntry entry {};
+		entry.name = name;
+
+		uint32_t counter = 0xffff0000;
+		for(const auto cycles : calls) {
+			util::RecordProfiledCall(entry, counter, counter + cycles);
+			counter += cycles + 100;
+		}
+
+		return entry;
+	}
+
+	std::string Report(const std::vector<util::ProfileEntry>& entries, size_t size = 4096) {
+		std::vector<char> buffer(size);
+		const auto length = util::FormatProfileReport(entries.data(), static_cast<uint32_t>(entries.size()), buffer.data(), buffer.size());
+		return { buffer.data(), length };
+	}
+
+	std::vector<std::string> Lines(const std::string& text) {
+		std::vector<std::string> lines;
+		size_t start = 0;
+		while(start < text.size()) {
+			auto end = text.find('\n', start);
+			if(end == std::string::npos)
+				end = text.size();
+			lines.push_back(text.substr(start, end - start));
+			start = end + 1;
+		}
+		return lines;
+	}
+
+	struct Fixture {
+		test::MockFio fio;
+
+		Fixture() {
+			gSymbols = {
+				{ "sceOpen", reinterpret_cast<uintptr_t>(GameOpen) },
+				{ "sceWrite", reinterpret_cast<uintptr_t>(GameWrite) },
+				{ "sceClose", reinterpret_cast<uintptr_t>(GameClose) },
+				{ "scePadRead", PadReadAddress }
+			};
+			gHooks.clear();
+			gEntries = { Entry("Update", { 1000, 3000 }), Entry("Render", { 50000 }) };
+		}
+
+		~Fixture() {
+			util::RemoveProfileDumpCombo();
+		}
+
+		std::string Dumped() const {
+			const auto* data = fio.File(ProfilePath);
+			return data ? std::string(data->begin(), data->end()) : std::string {};
+		}
+	};
+
+} // namespace
+
+// What dumping the profile needs from the rest of the loader.
+namespace elfldr::util {
+
+	namespace detail {
+
+		void* HookFunctionBase(void* dest, const void* hook) {
+			const auto address = reinterpret_cast<uintptr_t>(dest);
+			gHooks[address] = hook;
+			return address == PadReadAddress ? reinterpret_cast<void*>(GamePadRead) : nullptr;
+		}
+
+	} // namespace detail
+
+	bool UnhookFunction(void* funcptr) {
+		return gHooks.erase(reinterpret_cast<uintptr_t>(funcptr)) != 0;
+	}
+
+	uintptr_t FindSymbol(uint32_t hash) {
+		for(const auto& [name, address] : gSymbols)
+			if(SymbolHash(name.c_str()) == hash)
+				return address;
+		return 0;
+	}
+
+	const ProfileEntry* GetProfileEntries(uint32_t& count) {
+		count = static_cast<uint32_t>(gEntries.size());
+		return gEntries.data();
+	}
+
+	GameVersionData& GetGameVersionData() {
+		static GameVersionData data {};
+		return data;
+	}
+
+	mlstd::StringView GameVersionData::GameID() const {
+		return "test";
+	}
+
+} // namespace elfldr::util
+
+ELFLDR_TEST(PercentileBound) {
+	// Nine calls of 10 cycles (bucket 3), and one of 5000 (bucket 12).
+	std::vector<uint32_t> calls(9, 10);
+	calls.push_back(5000);
+	const auto entry = Entry("f", calls);
+
+	ELFLDR_CHECK_EQ(entry.calls, 10u);
+	ELFLDR_CHECK_EQ(entry.maxCycles, 5000u);
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(entry, 50), 15u);
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(entry, 90), 15u);
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(entry, 91), 8191u);
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(entry, 100), 8191u);
+
+	// The bound is never below what was actually seen.
+	ELFLDR_CHECK(util::ProfilePercentileBound(entry, 100) >= entry.maxCycles);
+
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(util::ProfileEntry {}, 50), 0u);
+	ELFLDR_CHECK_EQ(util::ProfilePercentileBound(Entry("slow", { 0x80000000 }), 50), ~0u);
+}
+
+ELFLDR_TEST(ReportIsSortedByTotalCycles) {
+	const auto lines = Lines(Report({ Entry("Cheap", { 10, 10 }), Entry("Expensive", { 100000 }), Entry("Middle", { 400, 600 }) }));
+	ELFLDR_CHECK_EQ(lines.size(), 4u);
+	if(lines.size() != 4)
+		return;
+
+	ELFLDR_CHECK(lines[0].rfind("Function", 0) == 0);
+	ELFLDR_CHECK(lines[1].rfind("Expensive ", 0) == 0);
+	ELFLDR_CHECK(lines[2].rfind("Middle ", 0) == 0);
+	ELFLDR_CHECK(lines[3].rfind("Cheap ", 0) == 0);
+
+	// Calls, total, average, max, microseconds at 294.912MHz, p50 and p90.
+	char expected[256];
+	snprintf(&expected[0], sizeof(expected), "%-31s %10u %16u %12u %12u %14u %12u %12u", "Middle", 2u, 1000u, 500u, 600u, 3u, 511u, 1023u);
+	ELFLDR_CHECK(lines[2] == expected);
+}
+
+ELFLDR_TEST(ReportFitsTheBuffer) {
+	const auto full = Report({ Entry("Update", { 1000 }) });
+
+	std::vector<char> buffer(40, 'x');
+	const auto length = util::FormatProfileReport(nullptr, 0, buffer.data(), buffer.size());
+	ELFLDR_CHECK_EQ(length, 39u);
+	ELFLDR_CHECK_EQ(buffer[39], '\0');
+
+	const auto cut = Report({ Entry("Update", { 1000 }) }, 100);
+	ELFLDR_CHECK_EQ(cut.size(), 99u);
+	ELFLDR_CHECK(full.compare(0, cut.size(), cut) == 0);
+}
+
+// The report is written with the game's own file functions.
+ELFLDR_TEST(DumpWritesWithTheGamesFunctions) {
+	Fixture fixture;
+	fixture.fio.AddFile(ProfilePath, std::vector<uint8_t>(10000, 'x'));
+
+	util::DumpProfile();
+	ELFLDR_CHECK(fixture.Dumped() == Report(gEntries));
+	ELFLDR_CHECK_EQ(fixture.fio.OpenFiles(), 0u);
+}
+
+ELFLDR_TEST(NoFileWithoutWrite) {
+	Fixture fixture;
+	gSymbols.erase("sceWrite");
+
+	util::DumpProfile();
+	ELFLDR_CHECK(!fixture.fio.File(ProfilePath));
+	ELFLDR_CHECK_EQ(fixture.fio.calls, 0u);
+}
+
+ELFLDR_TEST(ComboDumpsOncePerPress) {
+	Fixture fixture;
+	ELFLDR_CHECK(util::InstallProfileDumpCombo());
+	ELFLDR_CHECK_EQ(gHooks.size(), 1u);
+
+	// Some of it isn't enough.
+	ReadPad(0x0006);
+	ELFLDR_CHECK(!fixture.fio.File(ProfilePath));
+
+	ReadPad(DumpCombo | 0x0100);
+	ELFLDR_CHECK(fixture.Dumped() == Report(gEntries));
+
+	// Holding it down doesn't write it again.
+	fixture.fio.AddFile(ProfilePath, {});
+	ReadPad(DumpCombo);
+	ELFLDR_CHECK(fixture.Dumped().empty());
+
+	// Letting go and pressing it again does.
+	ReadPad(0);
+	ReadPad(DumpCombo);
+	ELFLDR_CHECK(fixture.Dumped() == Report(gEntries));
+
+	util::RemoveProfileDumpCombo();
+	ELFLDR_CHECK(gHooks.empty());
+}
+
+ELFLDR_TEST(NoComboWithoutPadRead) {
+	Fixture fixture;
+	gSymbols.erase("scePadRead");
+	ELFLDR_CHECK(!util::InstallProfileDumpCombo());
+	ELFLDR_CHECK(gHooks.empty());
+}
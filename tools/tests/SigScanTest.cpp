@@ -0,0 +1,213 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include <utils/SigScan.h>
+
+#include "Test.h"
+
+using namespace elfldr;
+
+namespace {
+
+	/**
+	 * A buffer of pseudo-random bytes, with nothing special about it.
+	 */
+	struct Buffer {
+		alignas(16) uint8_t bytes[4096];
+
+		Buffer() {
+			uint32_t state = 0x12345678;
+			for(auto& byte : bytes) {
+				state = state * 1664525 + 1013904223;
+				byte = static_cast<uint8_t>(state >> 24);
+			}
+		}
+
+		void Put(uint32_t offset, const char* data, uint32_t length) {
+			memcpy(&bytes[offset], data, length);
+		}
+
+		uintptr_t Address(uint32_t offset) const {
+			return reinterpret_cast<uintptr_t>(&bytes[offset]);
+		}
+
+		const uint8_t* End() const {
+			return &bytes[sizeof(bytes)];
+		}
+	};
+
+	/**
+	 * Every match, the slow way.
+	 */
+	std::vector<uintptr_t> NaiveScan(const uint8_t* begin, const uint8_t* end, const util::Signature& signature, uint32_t alignment) {
+		std::vector<uintptr_t> matches;
+		for(auto* ptr = begin; ptr + signature.length <= end; ++ptr) {
+			if(reinterpret_cast<uintptr_t>(ptr) & (alignment - 1))
+				continue;
+
+			bool match = true;
+			for(uint32_t i = 0; i < signature.length && match; ++i)
+				match = signature.MatchesAt(i, ptr[i]);
+			if(match)
+				matches.push_back(reinterpret_cast<uintptr_t>(ptr));
+		}
+		return matches;
+	}
+
+	std::vector<uintptr_t> Scan(const uint8_t* begin, const uint8_t* end, const util::SignatureScanner& scanner, uint32_t alignment) {
+		std::vector<uintptr_t> matches(256);
+		const auto count = util::SigScan(begin, end, scanner, matches.data(), matches.size(), alignment);
+		matches.resize(count < matches.size() ? count : matches.size());
+		return matches;
+	}
+
+} // namespace
+
+ELFLDR_TEST(PatternParsing) {
+	constexpr util::Signature signature("3C 02 ?? ? 4? ?f");
+
+	static_assert(signature.length == 6);
+	ELFLDR_CHECK_EQ(signature.bytes[0], 0x3cu);
+	ELFLDR_CHECK_EQ(signature.masks[0], 0xffu);
+	ELFLDR_CHECK_EQ(signature.masks[2], 0x00u);
+	ELFLDR_CHECK_EQ(signature.masks[3], 0x00u);
+	ELFLDR_CHECK_EQ(signature.bytes[4], 0x40u);
+	ELFLDR_CHECK_EQ(signature.masks[4], 0xf0u);
+	ELFLDR_CHECK_EQ(signature.bytes[5], 0x0fu);
+	ELFLDR_CHECK_EQ(signature.masks[5], 0x0fu);
+}
+
+ELFLDR_TEST(WordScanUsesMostSpecificWord) {
+	constexpr util::SignatureScanner scanner("?? ?? 02 3C ?? ?? ?? ?? 08 00 E0 03 ?? ?");
+	ELFLDR_CHECK_EQ(scanner.wordOffset, 8u);
+	ELFLDR_CHECK_EQ(scanner.wordMask, 0xffffffffu);
+	ELFLDR_CHECK_EQ(scanner.wordValue, 0x03e00008u);
+
+	// Nothing to match in any whole word, so only the skip table can be used.
+	constexpr util::SignatureScanner wildcards("?? ?? ?? ?? ?? AA");
+	ELFLDR_CHECK_EQ(wildcards.wordMask, 0u);
+}
+
+ELFLDR_TEST(WildcardAtStart) {
+	Buffer buffer;
+	buffer.Put(1000, "\x11\x22\xde\xad\xbe\xef", 6);
+
+	constexpr util::SignatureScanner scanner("?? ?? DE AD BE EF");
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner, 1), buffer.Address(1000));
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner, 4), buffer.Address(1000));
+}
+
+ELFLDR_TEST(WildcardAtEnd) {
+	Buffer buffer;
+	buffer.Put(2000, "\xde\xad\xbe\xef\x11\x22", 6);
+
+	// Trailing wildcards don't count for skipping, but still have to fit in the buffer.
+	constexpr util::SignatureScanner scanner("DE AD BE EF ?? ??");
+	ELFLDR_CHECK_EQ(scanner.anchorLength, 4u);
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner), buffer.Address(2000));
+
+	buffer.Put(sizeof(buffer.bytes) - 5, "\xde\xad\xbe\xef\x11", 5);
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner, 1), buffer.Address(2000));
+}
+
+ELFLDR_TEST(AllWildcards) {
+	Buffer buffer;
+
+	// Matches everywhere it fits, at the right alignment.
+	constexpr util::SignatureScanner scanner("?? ?? ?? ??");
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], buffer.End(), scanner, nullptr, 0, 4), sizeof(buffer.bytes) / 4);
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], buffer.End(), scanner, nullptr, 0, 1), sizeof(buffer.bytes) - 3);
+	ELFLDR_CHECK_EQ(util::SigScanFirst(&buffer.bytes[1], buffer.End(), scanner, 4), buffer.Address(4));
+}
+
+ELFLDR_TEST(MatchAtEndOfBuffer) {
+	Buffer buffer;
+	const auto offset = static_cast<uint32_t>(sizeof(buffer.bytes) - 8);
+	buffer.Put(offset, "\x01\x02\x03\x04\x05\x06\x07\x08", 8);
+
+	constexpr util::SignatureScanner scanner("01 02 03 04 05 06 07 08");
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner), buffer.Address(offset));
+
+	// One byte short, and it can't match.
+	ELFLDR_CHECK_EQ(util::SigScanFirst(&buffer.bytes[0], buffer.End() - 1, scanner), 0u);
+}
+
+ELFLDR_TEST(MatchAtStartOfBuffer) {
+	Buffer buffer;
+	buffer.Put(0, "\x3c\x02\x00\x2d", 4);
+
+	constexpr util::SignatureScanner scanner("3C 02 ?? 2?");
+	ELFLDR_CHECK_EQ(util::SigScanFirst(&buffer.bytes[0], buffer.End(), scanner), buffer.Address(0));
+}
+
+ELFLDR_TEST(AlignmentIsEnforced) {
+	Buffer buffer;
+	buffer.Put(101, "\xca\xfe\xba\xbe", 4);
+
+	constexpr util::SignatureScanner scanner("CA FE BA BE");
+	ELFLDR_CHECK_EQ(util::SigScanFirst(&buffer.bytes[0], buffer.End(), scanner, 4), 0u);
+	ELFLDR_CHECK_EQ(util::SigScanFirst(&buffer.bytes[0], buffer.End(), scanner, 1), buffer.Address(101));
+}
+
+ELFLDR_TEST(CountsMatchesPastMax) {
+	Buffer buffer;
+	for(uint32_t i = 0; i < 5; ++i)
+		buffer.Put(512 + i * 64, "\xca\xfe\xba\xbe", 4);
+
+	constexpr util::SignatureScanner scanner("CA FE BA BE");
+	uintptr_t matches[2] {};
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], buffer.End(), scanner, &matches[0], 2), 5u);
+	ELFLDR_CHECK_EQ(matches[0], buffer.Address(512));
+	ELFLDR_CHECK_EQ(matches[1], buffer.Address(576));
+	ELFLDR_CHECK_EQ(util::SigScanUnique(&buffer.bytes[0], buffer.End(), scanner), 0u);
+}
+
+// Masked patterns have to find exactly what a naive scan does, including
+// overlapping matches, which a wrong skip table would jump over.
+ELFLDR_TEST(MatchesNaiveScan) {
+	Buffer buffer;
+	for(uint32_t i = 0; i < sizeof(buffer.bytes); i += 4)
+		buffer.bytes[i] = buffer.bytes[i] & 0x0f; // low bytes collide a lot more
+	buffer.Put(3000, "\x0a\x0a\x0a\x0a\x0a\x0a\x0a\x0a", 8);
+
+	const char* const patterns[] {
+		"0? ?? 0A",
+		"0A 0A 0A 0A",
+		"?A 0? ?? ??",
+		"0? ? ? 0? ? ?",
+		"?? 0A",
+		"0A",
+		"?? ?? ?? ?? 0A ?? 0? ??",
+		"?? ?? ?? ?? ?? ?? ?? ?? ??"
+	};
+
+	for(const auto* pattern : patterns) {
+		const util::Signature signature(pattern);
+		const util::SignatureScanner scanner(signature);
+
+		for(const uint32_t alignment : { 1u, 2u, 4u, 8u }) {
+			const auto expected = NaiveScan(&buffer.bytes[0], buffer.End(), signature, alignment);
+			const auto actual = Scan(&buffer.bytes[0], buffer.End(), scanner, alignment);
+			ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], buffer.End(), scanner, nullptr, 0, alignment), expected.size());
+			ELFLDR_CHECK(actual.size() == expected.size() || actual.size() == 256);
+			for(size_t i = 0; i < actual.size() && i < expected.size(); ++i)
+				ELFLDR_CHECK_EQ(actual[i], expected[i]);
+		}
+	}
+}
+
+ELFLDR_TEST(EmptyAndShortRanges) {
+	Buffer buffer;
+	constexpr util::SignatureScanner scanner("?? ?? ?? ??");
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], &buffer.bytes[0], scanner, nullptr, 0), 0u);
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[0], &buffer.bytes[3], scanner, nullptr, 0), 0u);
+	ELFLDR_CHECK_EQ(util::SigScan(&buffer.bytes[4], &buffer.bytes[0], scanner, nullptr, 0), 0u);
+}
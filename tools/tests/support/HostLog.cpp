@@ -0,0 +1,48 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// Logging, for loader sources built for the host. Log messages just go to stdout,
+// with every channel and level on.
+//
+// This is its own object so a test can link the real Log.cpp instead, and
+// catch what it writes with its own DebugOut()/DebugOutV().
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <utils/Log.h>
+#include <utils/Utils.h>
+
+namespace elfldr::util {
+
+	void DebugOutV(const char* prefix, const char* format, va_list val) {
+		fputs(prefix, stdout);
+		vprintf(format, val);
+		putchar('\n');
+	}
+
+	void DebugOut(const char* format, ...) {
+		va_list val;
+		va_start(val, format);
+		DebugOutV("", format, val);
+		va_end(val);
+	}
+
+	namespace detail {
+
+		uint32_t gLogMasks[static_cast<uint32_t>(LogLevel::Count)] { ~0u, ~0u, ~0u, ~0u, ~0u };
+
+		void LogWrite(LogChannel, LogLevel, const char* format, ...) {
+			va_list val;
+			va_start(val, format);
+			DebugOutV("", format, val);
+			va_end(val);
+		}
+
+	} // namespace detail
+
+} // namespace elfldr::util
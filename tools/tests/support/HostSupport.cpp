@@ -0,0 +1,39 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// What loader sources built for the host need from the rest of the loader:
+// the allocator and assertions. Logging is in HostLog.cpp.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mlstd/Allocator.h>
+#include <mlstd/Assert.h>
+
+#ifndef NDEBUG
+void mlstdAssertionFailure(const char* exp, const char* function, const char* file, unsigned line) {
+	fprintf(stderr, "MLSTD_ASSERT(%s) failed. File: %s:%u Function %s\n", exp, file, line, function);
+	abort();
+}
+#endif
+
+void mlstdVerifyFailure(const char* exp, const char* file, unsigned line) {
+	fprintf(stderr, "MLSTD_VERIFY(%s) failed. File: %s:%u\n", exp, file, line);
+	abort();
+}
+
+namespace mlstd {
+
+	void* Alloc(uint32_t size) {
+		return malloc(size);
+	}
+
+	void Free(void* ptr) {
+		free(ptr);
+	}
+
+} // namespace mlstd
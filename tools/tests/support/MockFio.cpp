@@ -0,0 +1,228 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "MockFio.h"
+
+namespace elfldr::test {
+
+	namespace {
+
+		MockFio* gMock = nullptr;
+
+	} // namespace
+
+	const util::FioBackend& MockFio::Backend() {
+		static const util::FioBackend backend {
+			.open = DoOpen,
+			.close = DoClose,
+			.read = DoRead,
+			.write = DoWrite,
+			.lseek = DoLseek,
+
+			.dopen = DoDopen,
+			.dclose = DoDclose,
+			.dread = DoDread,
+
+			.setBlockMode = DoSetBlockMode,
+			.sync = DoSync
+		};
+
+		return backend;
+	}
+
+	MockFio::MockFio() {
+		previous = util::detail::gFioBackend;
+		gMock = this;
+		util::SetFioBackend(Backend());
+	}
+
+	MockFio::~MockFio() {
+		gMock = nullptr;
+		util::detail::gFioBackend = previous;
+	}
+
+	void MockFio::AddFile(const std::string& path, std::vector<uint8_t> data) {
+		files[path] = std::move(data);
+	}
+
+	const std::vector<uint8_t>* MockFio::File(const std::string& path) const {
+		auto it = files.find(path);
+		return it != files.end() ? &it->second : nullptr;
+	}
+
+	void MockFio::Enter() {
+		++calls;
+		if(pending)
+			++overlapped;
+	}
+
+	int MockFio::DoOpen(const char* path, int flags) {
+		gMock->Enter();
+		auto it = gMock->files.find(path);
+		if(it == gMock->files.end()) {
+			if(!(flags & FIO_O_CREAT))
+				return gMock->lastResult = -1;
+			it = gMock->files.emplace(path, std::vector<uint8_t> {}).first;
+		}
+
+		if(flags & FIO_O_TRUNC)
+			it->second.clear();
+
+		const auto fd = gMock->nextFd++;
+		gMock->fds[fd] = { &it->second, 0, flags };
+		return gMock->lastResult = fd;
+	}
+
+	int MockFio::DoClose(int fd) {
+		gMock->Enter();
+		return gMock->lastResult = gMock->fds.erase(fd) ? 0 : -1;
+	}
+
+	int MockFio::DoRead(int fd, void* buffer, int length) {
+		gMock->Enter();
+		++gMock->reads;
+
+		auto it = gMock->fds.find(fd);
+		int result = -1;
+		if(it != gMock->fds.end() && length >= 0) {
+			auto& file = it->second;
+			auto left = static_cast<uint32_t>(file.data->size()) - file.position;
+			if(left > static_cast<uint32_t>(length))
+				left = length;
+			if(left > gMock->maxReadLength)
+				left = gMock->maxReadLength;
+
+			memcpy(buffer, file.data->data() + file.position, left);
+			file.position += left;
+			result = static_cast<int>(left);
+		}
+
+		gMock->lastResult = result;
+		if(gMock->blockMode == FIO_NOWAIT) {
+			gMock->pending = true;
+			gMock->pendingPolls = gMock->latencyPolls;
+			return 0;
+		}
+		return result;
+	}
+
+	int MockFio::DoWrite(int fd, const void* buffer, int length) {
+		gMock->Enter();
+		auto it = gMock->fds.find(fd);
+		if(it == gMock->fds.end() || !(it->second.flags & FIO_O_WRONLY) || length < 0)
+			return gMock->lastResult = -1;
+
+		auto& file = it->second;
+		if(file.flags & FIO_O_APPEND)
+			file.position = static_cast<uint32_t>(file.data->size());
+		if(file.position + length > file.data->size())
+			file.data->resize(file.position + length);
+
+		const auto* bytes = static_cast<const uint8_t*>(buffer);
+		std::copy(bytes, bytes + length, file.data->begin() + file.position);
+		file.position += length;
+		return gMock->lastResult = length;
+	}
+
+	int MockFio::DoLseek(int fd, int offset, int whence) {
+		gMock->Enter();
+		auto it = gMock->fds.find(fd);
+		if(it == gMock->fds.end())
+			return gMock->lastResult = -1;
+
+		auto& file = it->second;
+		int64_t position = offset;
+		if(whence == FIO_SEEK_CUR)
+			position += file.position;
+		else if(whence == FIO_SEEK_END)
+			position += file.data->size();
+
+		if(position < 0 || position > static_cast<int64_t>(file.data->size()))
+			return gMock->lastResult = -1;
+
+		file.position = static_cast<uint32_t>(position);
+		return gMock->lastResult = static_cast<int>(position);
+	}
+
+	int MockFio::DoDopen(const char* path) {
+		gMock->Enter();
+
+		// "host:" lists the top level; "host:foo" and "host:foo/" list foo.
+		std::string prefix = path;
+		if(!prefix.empty() && prefix.back() != ':' && prefix.back() != '/')
+			prefix += '/';
+
+		OpenDirectory directory {};
+		for(const auto& [filePath, data] : gMock->files) {
+			if(filePath.compare(0, prefix.size(), prefix) != 0 || filePath.size() == prefix.size())
+				continue;
+
+			const auto name = filePath.substr(prefix.size(), filePath.find('/', prefix.size()) - prefix.size());
+			const bool isDirectory = prefix.size() + name.size() != filePath.size();
+			if(directory.entries.empty() || directory.entries.back().name != name)
+				directory.entries.push_back({ name, isDirectory, isDirectory ? 0 : static_cast<uint32_t>(data.size()) });
+		}
+
+		if(directory.entries.empty())
+			return gMock->lastResult = -1;
+
+		const auto fd = gMock->nextFd++;
+		gMock->directories[fd] = std::move(directory);
+		return gMock->lastResult = fd;
+	}
+
+	int MockFio::DoDclose(int fd) {
+		gMock->Enter();
+		return gMock->lastResult = gMock->directories.erase(fd) ? 0 : -1;
+	}
+
+	int MockFio::DoDread(int fd, io_dirent_t* entry) {
+		gMock->Enter();
+		auto it = gMock->directories.find(fd);
+		if(it == gMock->directories.end())
+			return gMock->lastResult = -1;
+
+		auto& directory = it->second;
+		if(directory.next == directory.entries.size())
+			return gMock->lastResult = 0;
+
+		const auto& next = directory.entries[directory.next++];
+		*entry = {};
+		entry->stat.mode = next.directory ? 0x20 : 0x10;
+		entry->stat.size = next.size;
+		strncpy(&entry->name[0], next.name.c_str(), sizeof(entry->name) - 1);
+		return gMock->lastResult = 1;
+	}
+
+	void MockFio::DoSetBlockMode(int mode) {
+		gMock->blockMode = mode;
+	}
+
+	int MockFio::DoSync(int mode, int* result) {
+		// Like the PS2SDK, fioSync() refuses to work in waiting mode.
+		if(gMock->blockMode != FIO_NOWAIT)
+			return -1;
+
+		if(gMock->pending) {
+			++gMock->polls;
+			if(mode == FIO_NOWAIT && gMock->pendingPolls != 0) {
+				--gMock->pendingPolls;
+				return FIO_INCOMPLETE;
+			}
+			gMock->pending = false;
+		}
+
+		if(result)
+			*result = gMock->lastResult;
+		return FIO_COMPLETE;
+	}
+
+} // namespace elfldr::test
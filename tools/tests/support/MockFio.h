@@ -0,0 +1,137 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// An in-memory fio backend for host tests.
+//
+// It behaves like the PS2SDK's fio in the ways the loader depends on:
+// FIO_NOWAIT reads return straight away and finish some fioSync() polls
+// later, there's only ever one operation in flight, and only the last
+// operation's result is kept. Starting another call with a read still in
+// flight is a bug in the loader (real fio would block, and the read's
+// result would be lost), so the mock counts those.
+//
+// Files can be written too: FIO_O_CREAT makes a missing file,
+// FIO_O_TRUNC empties it, and FIO_O_APPEND writes go on the end.
+// Directories are whatever the files' paths have in them.
+
+#ifndef ELFLDR_TOOLS_MOCKFIO_H
+#define ELFLDR_TOOLS_MOCKFIO_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <utils/FioBackend.h>
+
+namespace elfldr::test {
+
+	struct MockFio {
+		/**
+		 * Install the mock as the fio backend, with no files.
+		 * Only one mock can be installed at a time.
+		 */
+		MockFio();
+		~MockFio();
+
+		MockFio(const MockFio&) = delete;
+		MockFio& operator=(const MockFio&) = delete;
+
+		void AddFile(const std::string& path, std::vector<uint8_t> data);
+
+		/**
+		 * A file's contents, or nullptr if there's no such file.
+		 */
+		const std::vector<uint8_t>* File(const std::string& path) const;
+
+		/**
+		 * The mock's functions, for stand-ins which have to reach them
+		 * whatever the fio backend is.
+		 */
+		static const util::FioBackend& Backend();
+
+		/**
+		 * How many fioSync(FIO_NOWAIT) polls a no-wait read takes to finish.
+		 */
+		uint32_t latencyPolls { 0 };
+
+		/**
+		 * Reads return at most this many bytes, like a short read from the host.
+		 */
+		uint32_t maxReadLength { ~0u };
+
+		// What the loader did.
+		uint32_t calls { 0 };
+		uint32_t reads { 0 };
+		uint32_t polls { 0 };
+		uint32_t overlapped { 0 };
+
+		/**
+		 * Is a no-wait read still going?
+		 */
+		bool Busy() const {
+			return pending;
+		}
+
+		/**
+		 * How many files are open.
+		 */
+		uint32_t OpenFiles() const {
+			return static_cast<uint32_t>(fds.size());
+		}
+
+	   private:
+		struct Open {
+			std::vector<uint8_t>* data;
+			uint32_t position;
+			int flags;
+		};
+
+		struct DirectoryEntry {
+			std::string name;
+			bool directory;
+			uint32_t size;
+		};
+
+		struct OpenDirectory {
+			std::vector<DirectoryEntry> entries;
+			size_t next;
+		};
+
+		static int DoOpen(const char* path, int flags);
+		static int DoClose(int fd);
+		static int DoRead(int fd, void* buffer, int length);
+		static int DoWrite(int fd, const void* buffer, int length);
+		static int DoLseek(int fd, int offset, int whence);
+		static int DoDopen(const char* path);
+		static int DoDclose(int fd);
+		static int DoDread(int fd, io_dirent_t* entry);
+		static void DoSetBlockMode(int mode);
+		static int DoSync(int mode, int* result);
+
+		/**
+		 * Count a call, and whether it was made over a read in flight.
+		 */
+		void Enter();
+
+		std::map<std::string, std::vector<uint8_t>> files;
+		std::map<int, Open> fds;
+		std::map<int, OpenDirectory> directories;
+		int nextFd { 3 };
+
+		int blockMode { FIO_WAIT };
+		bool pending { false };
+		uint32_t pendingPolls { 0 };
+		int lastResult { 0 };
+
+		const util::FioBackend* previous;
+	};
+
+} // namespace elfldr::test
+
+#endif // ELFLDR_TOOLS_MOCKFIO_H
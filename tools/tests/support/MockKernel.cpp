@@ -0,0 +1,118 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <kernel.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+
+#include <utils/CycleCounter.h>
+
+#include "MockKernel.h"
+
+namespace elfldr::test {
+
+	uint32_t gCycleCounter = 0;
+	bool gCreateSemaFails = false;
+	void (*gBeforeWaitSema)() = nullptr;
+
+	namespace {
+
+		struct Semaphore {
+			int count;
+			int maxCount;
+		};
+
+		std::map<int, Semaphore> gSemaphores;
+		int gNextSemaphore = 1;
+		bool gInterruptsEnabled = true;
+
+		Semaphore* Find(int id) {
+			auto it = gSemaphores.find(id);
+			return it != gSemaphores.end() ? &it->second : nullptr;
+		}
+
+	} // namespace
+
+	uint32_t LiveSemaphores() {
+		return static_cast<uint32_t>(gSemaphores.size());
+	}
+
+	bool AnySemaphoreTaken() {
+		for(const auto& [id, semaphore] : gSemaphores)
+			if(semaphore.count < semaphore.maxCount)
+				return true;
+		return false;
+	}
+
+	void ResetSemaphores() {
+		gSemaphores.clear();
+	}
+
+} // namespace elfldr::test
+
+using namespace elfldr::test;
+
+int CreateSema(ee_sema_t* sema) {
+	if(gCreateSemaFails)
+		return -1;
+
+	const auto id = gNextSemaphore++;
+	gSemaphores[id] = { sema->init_count, sema->max_count };
+	return id;
+}
+
+int DeleteSema(int id) {
+	return gSemaphores.erase(id) ? id : -1;
+}
+
+int WaitSema(int id) {
+	if(auto* before = gBeforeWaitSema) {
+		gBeforeWaitSema = nullptr;
+		before();
+	}
+
+	auto* semaphore = Find(id);
+	if(!semaphore)
+		return -1;
+
+	if(semaphore->count == 0) {
+		fprintf(stderr, "WaitSema(%d) would never return\n", id);
+		abort();
+	}
+
+	--semaphore->count;
+	return id;
+}
+
+int SignalSema(int id) {
+	auto* semaphore = Find(id);
+	if(!semaphore || semaphore->count == semaphore->maxCount)
+		return -1;
+
+	++semaphore->count;
+	return id;
+}
+
+int DI() {
+	const auto enabled = gInterruptsEnabled;
+	gInterruptsEnabled = false;
+	return enabled;
+}
+
+void EI() {
+	gInterruptsEnabled = true;
+}
+
+namespace elfldr::util {
+
+	uint32_t ReadCycleCounter() {
+		return elfldr::test::gCycleCounter;
+	}
+
+} // namespace elfldr::util
@@ -0,0 +1,53 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The EE kernel and cycle counter, for host tests.
+//
+// Tests are single threaded, so a WaitSema() which would block never
+// returns on the EE either (it's a deadlock); the mock aborts instead.
+
+#ifndef ELFLDR_TOOLS_MOCKKERNEL_H
+#define ELFLDR_TOOLS_MOCKKERNEL_H
+
+#include <stdint.h>
+
+namespace elfldr::test {
+
+	/**
+	 * What ReadCycleCounter() returns. Tests move it along themselves.
+	 */
+	extern uint32_t gCycleCounter;
+
+	/**
+	 * Make CreateSema() fail, like when the kernel is out of semaphores.
+	 */
+	extern bool gCreateSemaFails;
+
+	/**
+	 * Called the next time WaitSema() is, before it takes the semaphore,
+	 * like another thread getting to run first. It's only called once.
+	 */
+	extern void (*gBeforeWaitSema)();
+
+	/**
+	 * Semaphores made and not deleted yet.
+	 */
+	uint32_t LiveSemaphores();
+
+	/**
+	 * Is any semaphore taken right now?
+	 */
+	bool AnySemaphoreTaken();
+
+	/**
+	 * Forget every semaphore, like ExecPS2() does.
+	 */
+	void ResetSemaphores();
+
+} // namespace elfldr::test
+
+#endif // ELFLDR_TOOLS_MOCKKERNEL_H
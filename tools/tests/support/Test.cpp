@@ -0,0 +1,67 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Test.h"
+
+namespace elfldr::test {
+
+	namespace {
+
+		TestCase* gFirst = nullptr;
+		TestCase** gLast = &gFirst;
+		unsigned gFailures = 0;
+
+	} // namespace
+
+	TestCase::TestCase(const char* name, void (*fn)())
+		: name(name), fn(fn), next(nullptr) {
+		// Tests run in the order they're in the file.
+		*gLast = this;
+		gLast = &next;
+	}
+
+	void Fail(const char* file, unsigned line, const char* expression) {
+		fprintf(stderr, "%s:%u: check failed: %s\n", file, line, expression);
+		++gFailures;
+	}
+
+	void FailEqual(const char* file, unsigned line, const char* expression, uint64_t actual, uint64_t expected) {
+		fprintf(stderr, "%s:%u: check failed: %s (0x%llx, expected 0x%llx)\n", file, line, expression, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected));
+		++gFailures;
+	}
+
+} // namespace elfldr::test
+
+// Usage: <test> [name]. Only runs the named test, if one is given.
+int main(int argc, char** argv) {
+	using namespace elfldr::test;
+
+	unsigned run = 0;
+	unsigned failed = 0;
+
+	for(auto* test = gFirst; test; test = test->next) {
+		if(argc > 1 && strcmp(argv[1], test->name) != 0)
+			continue;
+
+		const auto before = gFailures;
+		test->fn();
+		++run;
+
+		if(gFailures != before) {
+			++failed;
+			fprintf(stderr, "FAIL %s\n", test->name);
+		} else {
+			printf("ok   %s\n", test->name);
+		}
+	}
+
+	printf("%u test(s), %u failed\n", run, failed);
+	return failed || !run ? 1 : 0;
+}
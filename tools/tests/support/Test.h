@@ -0,0 +1,58 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// A tiny host test harness.
+//
+//	ELFLDR_TEST(SomethingWorks) {
+//		ELFLDR_CHECK(Something());
+//		ELFLDR_CHECK_EQ(Answer(), 42);
+//	}
+//
+// Each test file is linked with Test.cpp, which runs every test it has,
+// and fails if any check did. Checks don't stop the test they're in.
+
+#ifndef ELFLDR_TOOLS_TEST_H
+#define ELFLDR_TOOLS_TEST_H
+
+#include <stdint.h>
+
+namespace elfldr::test {
+
+	struct TestCase {
+		const char* name;
+		void (*fn)();
+		TestCase* next;
+
+		TestCase(const char* name, void (*fn)());
+	};
+
+	void Fail(const char* file, unsigned line, const char* expression);
+	void FailEqual(const char* file, unsigned line, const char* expression, uint64_t actual, uint64_t expected);
+
+} // namespace elfldr::test
+
+#define ELFLDR_TEST(name)                                                \
+	static void elfldrTest_##name();                                     \
+	static ::elfldr::test::TestCase elfldrTestCase_##name { #name, &elfldrTest_##name }; \
+	static void elfldrTest_##name()
+
+#define ELFLDR_CHECK(x)                                        \
+	do {                                                       \
+		if(!(x))                                               \
+			::elfldr::test::Fail(__FILE__, __LINE__, #x);      \
+	} while(0)
+
+// Integers (and enums, and pointers) only; the values are printed on failure.
+#define ELFLDR_CHECK_EQ(actual, expected)                                                                                               \
+	do {                                                                                                                                \
+		const auto elfldrActual_ = (actual);                                                                                            \
+		const auto elfldrExpected_ = (expected);                                                                                        \
+		if(!(elfldrActual_ == elfldrExpected_))                                                                                         \
+			::elfldr::test::FailEqual(__FILE__, __LINE__, #actual " == " #expected, (uint64_t)(elfldrActual_), (uint64_t)(elfldrExpected_)); \
+	} while(0)
+
+#endif // ELFLDR_TOOLS_TEST_H
@@ -0,0 +1,39 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// The bits of the PS2SDK's kernel.h loader code built for the host uses.
+// MockKernel.cpp implements them.
+
+#ifndef ELFLDR_TOOLS_SDK_KERNEL_H
+#define ELFLDR_TOOLS_SDK_KERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct t_ee_sema {
+	int count;
+	int max_count;
+	int init_count;
+	int wait_threads;
+	unsigned int attr;
+	unsigned int option;
+} ee_sema_t;
+
+int CreateSema(ee_sema_t* sema);
+int DeleteSema(int sema_id);
+int WaitSema(int sema_id);
+int SignalSema(int sema_id);
+
+int DI(void);
+void EI(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ELFLDR_TOOLS_SDK_KERNEL_H
@@ -0,0 +1,300 @@
+/**
+ * SSX-Elfldr
+ *
+ * (C) 2021-2022 Lily/modeco80 <lily.modeco80@protonmail.ch>
+ * under the terms of the MIT license.
+ */
+
+// tracereport - reports on a file trace (see utils/FileTraceFormat.h).
+//
+// Usage:
+//	tracereport <filetrace.bin> [--top <n>] [--gap <ms>]
+//
+// The report has:
+//	- the files the game spent the most time on,
+//	- load phases: bursts of file access, split where the game didn't touch
+//	  a file for --gap milliseconds (500 by default),
+//	- redundant reads: parts of files which were read more than once.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/FileTraceFormat.h>
+
+namespace {
+
+	using namespace elfldr;
+
+	struct Trace {
+		uint32_t clockHz {};
+		uint32_t dropped {};
+		std::vector<util::FileTraceRecord> records;
+		std::unordered_map<uint32_t, std::string> names;
+	};
+
+	struct FileStats {
+		uint32_t hash {};
+		uint32_t opens {};
+		uint32_t reads {};
+		uint32_t seeks {};
+		uint64_t bytes {};
+		uint64_t cycles {};
+		uint64_t redundantBytes {};
+
+		// Ranges read so far, start -> end, not overlapping.
+		std::map<uint32_t, uint32_t> ranges;
+	};
+
+	bool ReadFile(const char* path, std::vector<uint8_t>& data) {
+		auto* file = fopen(path, "rb");
+		if(!file) {
+			fprintf(stderr, "could not open \"%s\"\n", path);
+			return false;
+		}
+
+		uint8_t buffer[4096];
+		size_t read;
+		while((read = fread(&buffer[0], 1, sizeof(buffer), file)) != 0)
+			data.insert(data.end(), &buffer[0], &buffer[read]);
+
+		fclose(file);
+		return true;
+	}
+
+	bool ParseTrace(const std::vector<uint8_t>& data, Trace& trace) {
+		size_t position = 0;
+
+		// A chunk cut short (the game was stopped while it was written) ends the trace.
+		auto Take = [&](void* out, size_t size) {
+			if(data.size() - position < size)
+				return false;
+			memcpy(out, &data[position], size);
+			position += size;
+			return true;
+		};
+
+		while(position < data.size()) {
+			util::FileTraceChunkHeader header;
+			if(!Take(&header, sizeof(header)) || header.magic != util::FileTraceChunkHeader::Magic) {
+				fprintf(stderr, "not a file trace, or it's corrupt (at offset %zu)\n", position);
+				return !trace.records.empty();
+			}
+
+			if(header.version != util::FileTraceChunkHeader::CurrentVersion) {
+				fprintf(stderr, "version %u traces aren't supported\n", header.version);
+				return false;
+			}
+
+			trace.clockHz = header.clockHz;
+			trace.dropped += header.dropped;
+
+			const auto first = trace.records.size();
+			trace.records.resize(first + header.recordCount);
+			std::vector<util::FileTraceName> names(header.nameCount);
+			std::vector<char> paths(header.pathsSize);
+
+			if(!Take(&trace.records[first], header.recordCount * sizeof(util::FileTraceRecord)) || !Take(names.data(), names.size() * sizeof(util::FileTraceName)) || !Take(paths.data(), paths.size())) {
+				fprintf(stderr, "the trace was cut short\n");
+				trace.records.resize(first);
+				break;
+			}
+
+			for(const auto& name : names)
+				if(name.pathOffset < paths.size() && memchr(&paths[name.pathOffset], '\0', paths.size() - name.pathOffset))
+					trace.names[name.hash] = &paths[name.pathOffset];
+		}
+
+		return true;
+	}
+
+	struct Reporter {
+		const Trace& trace;
+		uint32_t top;
+		double gapSeconds;
+
+		double Seconds(uint64_t cycles) const {
+			return static_cast<double>(cycles) / trace.clockHz;
+		}
+
+		double Milliseconds(uint64_t cycles) const {
+			return Seconds(cycles) * 1000.0;
+		}
+
+		std::string Name(uint32_t hash) const {
+			if(hash == 0)
+				return "(opened before tracing)";
+
+			if(auto it = trace.names.find(hash); it != trace.names.end())
+				return it->second;
+
+			char buffer[32];
+			snprintf(&buffer[0], sizeof(buffer), "(0x%08x)", hash);
+			return &buffer[0];
+		}
+
+		/**
+		 * Add a read to a file's ranges.
+		 * \return How many of the bytes had been read before.
+		 */
+		static uint64_t AddRange(FileStats& file, uint32_t start, uint32_t end) {
+			uint64_t redundant = 0;
+
+			// Start from the range before, in case it overlaps.
+			auto it = file.ranges.upper_bound(start);
+			if(it != file.ranges.begin())
+				--it;
+
+			while(it != file.ranges.end() && it->first <= end) {
+				if(it->second < start) {
+					++it;
+					continue;
+				}
+
+				redundant += std::min(end, it->second) - std::max(start, it->first);
+				start = std::min(start, it->first);
+				end = std::max(end, it->second);
+				it = file.ranges.erase(it);
+			}
+
+			file.ranges[start] = end;
+			return redundant;
+		}
+
+		void Run() {
+			std::unordered_map<uint32_t, FileStats> files;
+			uint64_t totalCycles = 0;
+			uint64_t totalBytes = 0;
+
+			for(const auto& record : trace.records) {
+				auto& file = files[record.hash];
+				file.hash = record.hash;
+				file.cycles += record.cycles;
+				totalCycles += record.cycles;
+
+				switch(record.op) {
+					case util::FileTraceOp::Open: ++file.opens; break;
+					case util::FileTraceOp::Seek: ++file.seeks; break;
+					case util::FileTraceOp::Read:
+						++file.reads;
+						if(record.result > 0) {
+							file.bytes += record.result;
+							totalBytes += record.result;
+							if(record.hash != 0)
+								file.redundantBytes += AddRange(file, record.offset, record.offset + record.result);
+						}
+						break;
+					default: break;
+				}
+			}
+
+			printf("%zu calls on %zu files, %.1f ms in file calls, %.1f MB read\n", trace.records.size(), files.size(), Milliseconds(totalCycles), totalBytes / 1048576.0);
+			if(trace.dropped)
+				printf("%u calls weren't traced (the ring was full)\n", trace.dropped);
+
+			std::vector<const FileStats*> sorted;
+			for(const auto& [hash, file] : files)
+				sorted.push_back(&file);
+
+			// Hottest files
+			std::sort(sorted.begin(), sorted.end(), [](const FileStats* a, const FileStats* b) { return a->cycles > b->cycles; });
+
+			printf("\nHottest files:\n");
+			printf("%10s %6s %6s %6s %12s  %s\n", "ms", "opens", "reads", "seeks", "bytes", "file");
+			for(uint32_t i = 0; i < sorted.size() && i < top; ++i) {
+				const auto& file = *sorted[i];
+				printf("%10.2f %6u %6u %6u %12llu  %s\n", Milliseconds(file.cycles), file.opens, file.reads, file.seeks, static_cast<unsigned long long>(file.bytes), Name(file.hash).c_str());
+			}
+
+			ReportPhases();
+
+			// Redundant reads
+			std::sort(sorted.begin(), sorted.end(), [](const FileStats* a, const FileStats* b) { return a->redundantBytes > b->redundantBytes; });
+
+			printf("\nRedundant reads (bytes read again):\n");
+			printf("%12s %12s %6s  %s\n", "again", "bytes", "opens", "file");
+			for(uint32_t i = 0; i < sorted.size() && i < top && sorted[i]->redundantBytes != 0; ++i) {
+				const auto& file = *sorted[i];
+				printf("%12llu %12llu %6u  %s\n", static_cast<unsigned long long>(file.redundantBytes), static_cast<unsigned long long>(file.bytes), file.opens, Name(file.hash).c_str());
+			}
+		}
+
+		void ReportPhases() const {
+			printf("\nLoad phases (split at %.0f ms idle):\n", gapSeconds * 1000.0);
+			printf("%10s %10s %10s %6s %12s  %s\n", "start s", "length ms", "io ms", "opens", "bytes", "first files");
+
+			const auto gap = static_cast<uint64_t>(gapSeconds * trace.clockHz);
+			size_t i = 0;
+
+			while(i < trace.records.size()) {
+				const auto start = trace.records[i].time;
+				auto end = start + trace.records[i].cycles;
+				uint64_t cycles = 0;
+				uint64_t bytes = 0;
+				uint32_t opens = 0;
+				std::string firstFiles;
+
+				for(; i < trace.records.size() && trace.records[i].time <= end + gap; ++i) {
+					const auto& record = trace.records[i];
+					end = std::max(end, record.time + record.cycles);
+					cycles += record.cycles;
+
+					if(record.op == util::FileTraceOp::Open) {
+						if(++opens <= 3)
+							firstFiles += (opens > 1 ? ", " : "") + Name(record.hash);
+					} else if(record.op == util::FileTraceOp::Read && record.result > 0) {
+						bytes += record.result;
+					}
+				}
+
+				if(opens > 3)
+					firstFiles += ", ...";
+				printf("%10.2f %10.1f %10.1f %6u %12llu  %s\n", Seconds(start), Milliseconds(end - start), Milliseconds(cycles), opens, static_cast<unsigned long long>(bytes), firstFiles.c_str());
+			}
+		}
+	};
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <filetrace.bin> [--top <n>] [--gap <ms>]\n", argv[0]);
+		return 1;
+	}
+
+	uint32_t top = 20;
+	double gapMs = 500.0;
+
+	for(int i = 2; i < argc; ++i) {
+		if(!strcmp(argv[i], "--top") && i + 1 < argc) {
+			top = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+		} else if(!strcmp(argv[i], "--gap") && i + 1 < argc) {
+			gapMs = strtod(argv[++i], nullptr);
+		} else {
+			fprintf(stderr, "unknown option \"%s\"\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<uint8_t> data;
+	if(!ReadFile(argv[1], data))
+		return 1;
+
+	Trace trace;
+	if(!ParseTrace(data, trace))
+		return 1;
+
+	if(trace.records.empty()) {
+		printf("nothing was traced\n");
+		return 0;
+	}
+
+	Reporter { trace, top, gapMs / 1000.0 }.Run();
+	return 0;
+}